@@ -442,7 +442,10 @@ bool GenerateAccumulatorWitness(const PublicCoin &coin, Accumulator& accumulator
     if (!IsTransactionInChain(txid, nHeightTest))
         return error("%s: mint tx %s is not in chain", __func__, txid.GetHex());
 
-    int nHeightMintAdded = mapBlockIndex[hashBlock]->nHeight;
+    CBlockIndex* pindexMint = LookupBlockIndex(hashBlock);
+    if (!pindexMint)
+        return error("%s: block %s of mint tx %s is not indexed", __func__, hashBlock.GetHex(), txid.GetHex());
+    int nHeightMintAdded = pindexMint->nHeight;
 
     //get the checkpoint added at the next multiple of 10
     int nHeightCheckpoint = nHeightMintAdded + (10 - (nHeightMintAdded % 10));
@@ -0,0 +1,210 @@
+// Copyright (c) 2016 The Bitcoin Core developers
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_ADDRESSINDEX_H
+#define BITCOIN_ADDRESSINDEX_H
+
+#include "amount.h"
+#include "crypto/common.h"
+#include "script/script.h"
+#include "serialize.h"
+#include "uint256.h"
+
+/** Address kinds stored in the address index (-addressindex) */
+enum AddressIndexType {
+    ADDRESS_INDEX_NONE = 0,
+    ADDRESS_INDEX_PUBKEYHASH = 1, //!< P2PKH and P2PK outputs (coinstake outputs pay to a pubkey)
+    ADDRESS_INDEX_SCRIPTHASH = 2  //!< P2SH
+};
+
+/**
+ * Serialize heights and positions big-endian, so that LevelDB iterates the entries
+ * of one address in block order.
+ */
+template <typename Stream>
+inline void SerializeBE32(Stream& s, uint32_t n)
+{
+    unsigned char buf[4];
+    WriteBE32(buf, n);
+    s.write((char*)buf, 4);
+}
+
+template <typename Stream>
+inline uint32_t UnserializeBE32(Stream& s)
+{
+    unsigned char buf[4];
+    s.read((char*)buf, 4);
+    return ReadBE32(buf);
+}
+
+/** One credit or debit of an address: 'a' + key -> amount (negative when spending) */
+struct CAddressIndexKey {
+    unsigned int type;
+    uint160 hashBytes;
+    int blockHeight;
+    unsigned int txindex;
+    uint256 txhash;
+    unsigned int index;
+    bool spending;
+
+    CAddressIndexKey(unsigned int addressType, const uint160& addressHash, int height, unsigned int blockindex,
+        const uint256& txid, unsigned int indexValue, bool isSpending)
+        : type(addressType), hashBytes(addressHash), blockHeight(height), txindex(blockindex),
+          txhash(txid), index(indexValue), spending(isSpending) {}
+
+    CAddressIndexKey() { SetNull(); }
+
+    void SetNull()
+    {
+        type = ADDRESS_INDEX_NONE;
+        hashBytes = 0;
+        blockHeight = 0;
+        txindex = 0;
+        txhash = 0;
+        index = 0;
+        spending = false;
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        return 1 + 20 + 4 + 4 + 32 + 4 + 1;
+    }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        ::Serialize(s, (unsigned char)type, nType, nVersion);
+        ::Serialize(s, hashBytes, nType, nVersion);
+        SerializeBE32(s, blockHeight);
+        SerializeBE32(s, txindex);
+        ::Serialize(s, txhash, nType, nVersion);
+        ::Serialize(s, index, nType, nVersion);
+        ::Serialize(s, spending, nType, nVersion);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        unsigned char chType;
+        ::Unserialize(s, chType, nType, nVersion);
+        type = chType;
+        ::Unserialize(s, hashBytes, nType, nVersion);
+        blockHeight = UnserializeBE32(s);
+        txindex = UnserializeBE32(s);
+        ::Unserialize(s, txhash, nType, nVersion);
+        ::Unserialize(s, index, nType, nVersion);
+        ::Unserialize(s, spending, nType, nVersion);
+    }
+};
+
+/** Prefix of CAddressIndexKey used to seek to the first entry of an address, optionally from a height */
+struct CAddressIndexIteratorKey {
+    unsigned int type;
+    uint160 hashBytes;
+    int blockHeight;
+    bool fHeight;
+
+    CAddressIndexIteratorKey(unsigned int addressType, const uint160& addressHash)
+        : type(addressType), hashBytes(addressHash), blockHeight(0), fHeight(false) {}
+
+    CAddressIndexIteratorKey(unsigned int addressType, const uint160& addressHash, int height)
+        : type(addressType), hashBytes(addressHash), blockHeight(height), fHeight(true) {}
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        return 1 + 20 + (fHeight ? 4 : 0);
+    }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        ::Serialize(s, (unsigned char)type, nType, nVersion);
+        ::Serialize(s, hashBytes, nType, nVersion);
+        if (fHeight)
+            SerializeBE32(s, blockHeight);
+    }
+};
+
+/** An unspent output of an address: 'u' + key -> value */
+struct CAddressUnspentKey {
+    unsigned int type;
+    uint160 hashBytes;
+    uint256 txhash;
+    unsigned int index;
+
+    CAddressUnspentKey(unsigned int addressType, const uint160& addressHash, const uint256& txid, unsigned int indexValue)
+        : type(addressType), hashBytes(addressHash), txhash(txid), index(indexValue) {}
+
+    CAddressUnspentKey() { SetNull(); }
+
+    void SetNull()
+    {
+        type = ADDRESS_INDEX_NONE;
+        hashBytes = 0;
+        txhash = 0;
+        index = 0;
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const
+    {
+        return 1 + 20 + 32 + 4;
+    }
+
+    template <typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const
+    {
+        ::Serialize(s, (unsigned char)type, nType, nVersion);
+        ::Serialize(s, hashBytes, nType, nVersion);
+        ::Serialize(s, txhash, nType, nVersion);
+        ::Serialize(s, index, nType, nVersion);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion)
+    {
+        unsigned char chType;
+        ::Unserialize(s, chType, nType, nVersion);
+        type = chType;
+        ::Unserialize(s, hashBytes, nType, nVersion);
+        ::Unserialize(s, txhash, nType, nVersion);
+        ::Unserialize(s, index, nType, nVersion);
+    }
+};
+
+struct CAddressUnspentValue {
+    CAmount satoshis;
+    CScript script;
+    int blockHeight;
+
+    CAddressUnspentValue(CAmount sats, const CScript& scriptPubKey, int height)
+        : satoshis(sats), script(scriptPubKey), blockHeight(height) {}
+
+    CAddressUnspentValue() { SetNull(); }
+
+    void SetNull()
+    {
+        satoshis = -1;
+        script.clear();
+        blockHeight = 0;
+    }
+
+    //! a null value in an index update means the entry is erased
+    bool IsNull() const
+    {
+        return satoshis == -1;
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(satoshis);
+        READWRITE(script);
+        READWRITE(blockHeight);
+    }
+};
+
+#endif // BITCOIN_ADDRESSINDEX_H
@@ -0,0 +1,109 @@
+// Copyright (c) 2015 The Bitcoin Core developers
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "utiltime.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace benchmark;
+
+std::map<std::string, BenchFunction>& BenchRunner::benchmarks()
+{
+    static std::map<std::string, BenchFunction> benchmarks_map;
+    return benchmarks_map;
+}
+
+BenchRunner::BenchRunner(const std::string& name, BenchFunction func)
+{
+    benchmarks().insert(std::make_pair(name, func));
+}
+
+std::vector<std::string> BenchRunner::List()
+{
+    std::vector<std::string> vNames;
+    for (BenchmarkMap::iterator it = benchmarks().begin(); it != benchmarks().end(); ++it)
+        vNames.push_back(it->first);
+    return vNames;
+}
+
+std::vector<BenchResult> BenchRunner::RunAll(const BenchOptions& options)
+{
+    std::vector<BenchResult> vResults;
+    std::cout << "# Benchmark, samples, iterations, min, median, p90, max" << std::endl;
+    for (BenchmarkMap::iterator it = benchmarks().begin(); it != benchmarks().end(); ++it) {
+        if (!options.strFilter.empty() && it->first.find(options.strFilter) == std::string::npos)
+            continue;
+        State state(it->first, options);
+        it->second(state);
+        BenchResult result = state.GetResult();
+        std::cout << result.name << ", " << result.nSamples << ", " << result.nIterations << ", "
+                  << result.dMin << ", " << result.dMedian << ", " << result.dP90 << ", " << result.dMax << std::endl;
+        vResults.push_back(result);
+    }
+    return vResults;
+}
+
+State::State(const std::string& nameIn, const BenchOptions& optionsIn) : options(optionsIn), fWarmup(true), nCount(0), nBatch(0),
+                                                                           nWarmupIterations(0), nWarmupStart(0), nBatchStart(0), name(nameIn)
+{
+}
+
+bool State::Checkpoint()
+{
+    int64_t nNow = GetTimeMicros();
+    if (nBatch == 0) {
+        // First call: start warming up with a single iteration
+        nWarmupStart = nBatchStart = nNow;
+        nBatch = nCount = 1;
+        return true;
+    }
+
+    if (fWarmup) {
+        nWarmupIterations += nCount;
+        int64_t nWarmupElapsed = nNow - nWarmupStart;
+        if (nWarmupElapsed < options.nWarmupMillis * 1000) {
+            nBatch *= 2;
+        } else {
+            fWarmup = false;
+            double dPerIteration = (double)std::max(nWarmupElapsed, (int64_t)1) / nWarmupIterations;
+            nBatch = std::max((uint64_t)1, (uint64_t)(options.nSampleMillis * 1000 / dPerIteration));
+        }
+    } else {
+        vSamples.push_back((nNow - nBatchStart) * 0.000001 / nCount);
+        if ((int)vSamples.size() >= std::max(options.nSamples, 1))
+            return false;
+    }
+
+    nCount = 1;
+    nBatchStart = GetTimeMicros();
+    return true;
+}
+
+BenchResult State::GetResult() const
+{
+    BenchResult result;
+    result.name = name;
+    if (vSamples.empty())
+        return result;
+
+    std::vector<double> vSorted(vSamples);
+    std::sort(vSorted.begin(), vSorted.end());
+    result.nSamples = vSorted.size();
+    result.nBatch = nBatch;
+    result.nIterations = nBatch * vSorted.size();
+    result.dMin = vSorted.front();
+    result.dMax = vSorted.back();
+    result.dMedian = vSorted.size() % 2 ? vSorted[vSorted.size() / 2] : (vSorted[vSorted.size() / 2 - 1] + vSorted[vSorted.size() / 2]) / 2;
+    // Nearest-rank percentile
+    result.dP90 = vSorted[std::min(vSorted.size() - 1, (vSorted.size() * 9 + 9) / 10 - 1)];
+    double dSum = 0;
+    for (unsigned int i = 0; i < vSorted.size(); i++)
+        dSum += vSorted[i];
+    result.dMean = dSum / vSorted.size();
+    return result;
+}
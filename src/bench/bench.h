@@ -0,0 +1,130 @@
+// Copyright (c) 2015 The Bitcoin Core developers
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BENCH_BENCH_H
+#define BITCOIN_BENCH_BENCH_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/function.hpp>
+#include <boost/preprocessor/cat.hpp>
+#include <boost/preprocessor/stringize.hpp>
+
+// Simple micro-benchmarking framework; API mostly matches a subset of the Google Benchmark
+// framework (see https://github.com/google/benchmark)
+// Why not use the Google Benchmark framework? Because adding Yet Another Dependency
+// (that uses cmake as its build system and has lots of features we don't need) isn't
+// worth it.
+
+/*
+ * Usage:
+
+static void CODE_TO_TIME(benchmark::State& state)
+{
+    ... do any setup needed...
+    while (state.KeepRunning()) {
+       ... do stuff you want to time...
+    }
+    ... do any cleanup needed...
+}
+
+BENCHMARK(CODE_TO_TIME);
+
+ */
+
+namespace benchmark
+{
+static const int64_t DEFAULT_BENCH_WARMUP_MS = 100;
+static const int64_t DEFAULT_BENCH_SAMPLE_MS = 10;
+static const int DEFAULT_BENCH_SAMPLES = 20;
+static const double DEFAULT_BENCH_TOLERANCE = 10.0;
+
+struct BenchOptions {
+    int64_t nWarmupMillis;  //!< wall time spent running the benchmark before measuring
+    int64_t nSampleMillis;  //!< target duration of one sample; sets the iterations per sample
+    int nSamples;           //!< number of samples to take
+    std::string strFilter;  //!< only run benchmarks whose name contains this
+
+    BenchOptions() : nWarmupMillis(DEFAULT_BENCH_WARMUP_MS), nSampleMillis(DEFAULT_BENCH_SAMPLE_MS), nSamples(DEFAULT_BENCH_SAMPLES) {}
+};
+
+/** Timing of one benchmark; all durations are seconds per iteration */
+struct BenchResult {
+    std::string name;
+    uint64_t nIterations;  //!< measured iterations (warm-up excluded)
+    uint64_t nBatch;       //!< iterations per sample
+    int nSamples;
+    double dMin;
+    double dMedian;
+    double dP90;
+    double dMax;
+    double dMean;
+
+    BenchResult() : nIterations(0), nBatch(0), nSamples(0), dMin(0), dMedian(0), dP90(0), dMax(0), dMean(0) {}
+};
+
+/**
+ * Drives the timing loop of one benchmark. The clock is read once per batch of
+ * iterations: during warm-up the batches double until the warm-up time is spent,
+ * which also estimates the cost of one iteration; afterwards every sample is a batch
+ * sized to take about nSampleMillis.
+ */
+class State
+{
+private:
+    const BenchOptions& options;
+    bool fWarmup;
+    uint64_t nCount;
+    uint64_t nBatch;
+    uint64_t nWarmupIterations;
+    int64_t nWarmupStart;
+    int64_t nBatchStart;
+    std::vector<double> vSamples;
+
+    bool Checkpoint();
+
+public:
+    std::string name;
+
+    State(const std::string& nameIn, const BenchOptions& optionsIn);
+
+    //! Returns true while the benchmark loop should run another iteration
+    bool KeepRunning()
+    {
+        if (nCount < nBatch) {
+            ++nCount;
+            return true;
+        }
+        return Checkpoint();
+    }
+
+    //! Summarize the samples taken so far
+    BenchResult GetResult() const;
+};
+
+typedef boost::function<void(State&)> BenchFunction;
+
+class BenchRunner
+{
+    typedef std::map<std::string, BenchFunction> BenchmarkMap;
+    static BenchmarkMap& benchmarks();
+
+public:
+    BenchRunner(const std::string& name, BenchFunction func);
+
+    static std::vector<std::string> List();
+    static std::vector<BenchResult> RunAll(const BenchOptions& options);
+};
+}
+
+// BENCHMARK(foo) expands to:  benchmark::BenchRunner bench_11foo("foo", foo);
+#define BENCHMARK(n) \
+    benchmark::BenchRunner BOOST_PP_CAT(bench_, BOOST_PP_CAT(__LINE__, n))(BOOST_PP_STRINGIZE(n), n);
+
+#endif // BITCOIN_BENCH_BENCH_H
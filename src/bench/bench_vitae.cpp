@@ -0,0 +1,160 @@
+// Copyright (c) 2015 The Bitcoin Core developers
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "clientversion.h"
+#include "crypto/quark.h"
+#include "crypto/sha256.h"
+#include "key.h"
+#include "util.h"
+#include "utilstrencodings.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <univalue.h>
+
+using namespace benchmark;
+
+static UniValue ResultsToJSON(const BenchOptions& options, const std::vector<BenchResult>& vResults)
+{
+    UniValue benchmarks(UniValue::VARR);
+    for (unsigned int i = 0; i < vResults.size(); i++) {
+        const BenchResult& result = vResults[i];
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("name", result.name));
+        entry.push_back(Pair("samples", result.nSamples));
+        entry.push_back(Pair("iterations", (uint64_t)result.nIterations));
+        entry.push_back(Pair("min", result.dMin));
+        entry.push_back(Pair("median", result.dMedian));
+        entry.push_back(Pair("p90", result.dP90));
+        entry.push_back(Pair("max", result.dMax));
+        entry.push_back(Pair("mean", result.dMean));
+        benchmarks.push_back(entry);
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("version", FormatFullVersion()));
+    obj.push_back(Pair("warmup_ms", options.nWarmupMillis));
+    obj.push_back(Pair("sample_ms", options.nSampleMillis));
+    obj.push_back(Pair("benchmarks", benchmarks));
+    return obj;
+}
+
+/**
+ * Compare the median of every benchmark with the same benchmark in a JSON file
+ * written by an earlier -json run. Returns the number of regressions.
+ */
+static int CompareWithBaseline(const std::string& strFile, double dTolerance, const std::vector<BenchResult>& vResults)
+{
+    std::ifstream file(strFile.c_str());
+    if (!file.is_open())
+        throw std::runtime_error("Cannot open baseline file " + strFile);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    UniValue baseline;
+    if (!baseline.read(ss.str()) || !baseline.isObject() || !baseline["benchmarks"].isArray())
+        throw std::runtime_error("Cannot parse baseline file " + strFile);
+
+    std::map<std::string, double> mapBaseline;
+    const UniValue& entries = baseline["benchmarks"];
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        if (entries[i]["name"].isStr() && entries[i]["median"].isNum())
+            mapBaseline[entries[i]["name"].get_str()] = entries[i]["median"].get_real();
+    }
+
+    int nRegressions = 0;
+    std::cout << "# Benchmark, baseline median, median, change %" << std::endl;
+    for (unsigned int i = 0; i < vResults.size(); i++) {
+        const BenchResult& result = vResults[i];
+        std::map<std::string, double>::const_iterator it = mapBaseline.find(result.name);
+        if (it == mapBaseline.end() || it->second <= 0)
+            continue;
+        double dChange = (result.dMedian / it->second - 1.0) * 100.0;
+        bool fRegression = dChange > dTolerance;
+        if (fRegression)
+            nRegressions++;
+        std::cout << result.name << ", " << it->second << ", " << result.dMedian << ", "
+                  << strprintf("%+.1f", dChange) << (fRegression ? ", REGRESSION" : "") << std::endl;
+    }
+    return nRegressions;
+}
+
+int main(int argc, char** argv)
+{
+    ParseParameters(argc, argv);
+
+    if (mapArgs.count("-?") || mapArgs.count("-help")) {
+        std::string strUsage = "Vitae Core bench_vitae utility version " + FormatFullVersion() + "\n\n" +
+                               "Usage:\n" +
+                               "  bench_vitae [options]\n";
+        strUsage += HelpMessageGroup("Options:");
+        strUsage += HelpMessageOpt("-?", "This help message");
+        strUsage += HelpMessageOpt("-list", "List the available benchmarks and exit");
+        strUsage += HelpMessageOpt("-filter=<str>", "Only run benchmarks whose name contains <str>");
+        strUsage += HelpMessageOpt("-warmup=<n>", strprintf("Milliseconds to run each benchmark before measuring (default: %d)", DEFAULT_BENCH_WARMUP_MS));
+        strUsage += HelpMessageOpt("-samples=<n>", strprintf("Number of samples per benchmark (default: %d)", DEFAULT_BENCH_SAMPLES));
+        strUsage += HelpMessageOpt("-sampletime=<n>", strprintf("Target milliseconds per sample (default: %d)", DEFAULT_BENCH_SAMPLE_MS));
+        strUsage += HelpMessageOpt("-json=<file>", "Write the results as JSON to <file>");
+        strUsage += HelpMessageOpt("-baseline=<file>", "Compare the medians with a JSON file written by an earlier -json run; exit with status 1 on a regression");
+        strUsage += HelpMessageOpt("-tolerance=<n>", strprintf("Percentage a median may exceed its baseline before it counts as a regression (default: %.0f)", DEFAULT_BENCH_TOLERANCE));
+        fprintf(stdout, "%s", strUsage.c_str());
+        return 0;
+    }
+
+    if (GetBoolArg("-list", false)) {
+        std::vector<std::string> vNames = BenchRunner::List();
+        for (unsigned int i = 0; i < vNames.size(); i++)
+            std::cout << vNames[i] << std::endl;
+        return 0;
+    }
+
+    BenchOptions options;
+    options.nWarmupMillis = std::max((int64_t)0, GetArg("-warmup", DEFAULT_BENCH_WARMUP_MS));
+    options.nSampleMillis = std::max((int64_t)1, GetArg("-sampletime", DEFAULT_BENCH_SAMPLE_MS));
+    options.nSamples = std::max(1, (int)GetArg("-samples", DEFAULT_BENCH_SAMPLES));
+    options.strFilter = GetArg("-filter", "");
+    double dTolerance = DEFAULT_BENCH_TOLERANCE;
+    if (mapArgs.count("-tolerance") && !ParseDouble(mapArgs["-tolerance"], &dTolerance)) {
+        fprintf(stderr, "Error: Invalid -tolerance '%s'\n", mapArgs["-tolerance"].c_str());
+        return 1;
+    }
+
+    ECC_Start();
+    SetupEnvironment();
+    fPrintToDebugLog = false; // don't want to write to debug.log file
+    SelectParams(CBaseChainParams::MAIN);
+    std::cout << "Using the '" << SHA256AutoDetect() << "' SHA256 implementation" << std::endl;
+    std::cout << "Using the '" << QuarkAutoDetect() << "' Quark implementation" << std::endl;
+
+    int nRet = 0;
+    try {
+        std::vector<BenchResult> vResults = BenchRunner::RunAll(options);
+
+        if (mapArgs.count("-json")) {
+            std::ofstream file(mapArgs["-json"].c_str());
+            if (!file.is_open())
+                throw std::runtime_error("Cannot write " + mapArgs["-json"]);
+            file << ResultsToJSON(options, vResults).write(4) << std::endl;
+        }
+
+        if (mapArgs.count("-baseline")) {
+            int nRegressions = CompareWithBaseline(mapArgs["-baseline"], dTolerance, vResults);
+            if (nRegressions > 0) {
+                fprintf(stderr, "%d benchmark(s) regressed by more than %.1f%%\n", nRegressions, dTolerance);
+                nRet = 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        nRet = 1;
+    }
+
+    ECC_Stop();
+    return nRet;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2016 The Bitcoin Core developers
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "main.h"
+#include "primitives/block.h"
+#include "random.h"
+#include "streams.h"
+
+#include <assert.h>
+
+//! Transactions in the synthetic block besides the coinbase
+static const unsigned int BLOCK_TRANSACTIONS = 1000;
+
+/**
+ * A context-free valid proof-of-work block after the zerocoin start: a coinbase and
+ * BLOCK_TRANSACTIONS one-in two-out pay-to-pubkey-hash transactions.
+ */
+static CBlock CreateTestBlock()
+{
+    CBlock block;
+    block.nVersion = Params().Zerocoin_HeaderVersion();
+    block.nTime = Params().Zerocoin_StartTime() + 1;
+    block.nBits = Params().ProofOfWorkLimit().GetCompact();
+
+    CMutableTransaction txCoinbase;
+    txCoinbase.vin.resize(1);
+    txCoinbase.vin[0].prevout.SetNull();
+    txCoinbase.vin[0].scriptSig = CScript() << 1 << OP_0;
+    txCoinbase.vout.resize(1);
+    txCoinbase.vout[0].nValue = 5 * COIN;
+    txCoinbase.vout[0].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 1) << OP_EQUALVERIFY << OP_CHECKSIG;
+    block.vtx.push_back(txCoinbase);
+
+    for (unsigned int i = 0; i < BLOCK_TRANSACTIONS; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(GetRandHash(), i % 4);
+        tx.vin[0].scriptSig = CScript() << std::vector<unsigned char>(72, 2) << std::vector<unsigned char>(33, 3);
+        tx.vout.resize(2);
+        for (unsigned int j = 0; j < tx.vout.size(); j++) {
+            tx.vout[j].nValue = (i + 1) * COIN / 100;
+            tx.vout[j].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, j) << OP_EQUALVERIFY << OP_CHECKSIG;
+        }
+        block.vtx.push_back(tx);
+    }
+    block.hashMerkleRoot = block.BuildMerkleTree();
+    return block;
+}
+
+static void CheckBlock_1000Tx(benchmark::State& state)
+{
+    const CBlock block = CreateTestBlock();
+    while (state.KeepRunning()) {
+        CValidationState validationState;
+        bool fValid = CheckBlock(block, validationState, false, true, false);
+        assert(fValid);
+    }
+}
+
+static void DeserializeBlock(benchmark::State& state)
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << CreateTestBlock();
+    while (state.KeepRunning()) {
+        CDataStream ss(stream);
+        CBlock block;
+        ss >> block;
+        assert(ss.empty());
+    }
+}
+
+static void SerializeBlock_RoundTrip(benchmark::State& state)
+{
+    CBlock block = CreateTestBlock();
+    while (state.KeepRunning()) {
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << block;
+        ss >> block;
+    }
+}
+
+static void SerializeTransaction_RoundTrip(benchmark::State& state)
+{
+    CBlock block = CreateTestBlock();
+    CTransaction tx = block.vtx[1];
+    while (state.KeepRunning()) {
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << tx;
+        ss >> tx;
+    }
+}
+
+BENCHMARK(CheckBlock_1000Tx);
+BENCHMARK(DeserializeBlock);
+BENCHMARK(SerializeBlock_RoundTrip);
+BENCHMARK(SerializeTransaction_RoundTrip);
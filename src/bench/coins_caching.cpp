@@ -0,0 +1,114 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "coins.h"
+#include "random.h"
+#include "uint256.h"
+
+#include <assert.h>
+#include <map>
+#include <vector>
+
+//! Coins touched per iteration
+static const unsigned int CACHE_COINS = 1000;
+
+namespace
+{
+/** In-memory stand-in for the coins database */
+class CCoinsViewMemory : public CCoinsView
+{
+    uint256 hashBestBlock;
+    std::map<uint256, CCoins> mapCoins;
+
+public:
+    bool GetCoins(const uint256& txid, CCoins& coins) const
+    {
+        std::map<uint256, CCoins>::const_iterator it = mapCoins.find(txid);
+        if (it == mapCoins.end())
+            return false;
+        coins = it->second;
+        return true;
+    }
+
+    bool HaveCoins(const uint256& txid) const
+    {
+        return mapCoins.count(txid) > 0;
+    }
+
+    uint256 GetBestBlock() const { return hashBestBlock; }
+
+    bool BatchWrite(CCoinsMap& mapCoinsIn, const uint256& hashBlock, const CCoinsRollingStats& statsDelta)
+    {
+        for (CCoinsMap::iterator it = mapCoinsIn.begin(); it != mapCoinsIn.end();) {
+            if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+                if (it->second.coins.IsPruned())
+                    mapCoins.erase(it->first);
+                else
+                    mapCoins[it->first] = it->second.coins;
+            }
+            mapCoinsIn.erase(it++);
+        }
+        hashBestBlock = hashBlock;
+        return true;
+    }
+};
+}
+
+static std::vector<uint256> AddCoins(CCoinsViewCache& cache)
+{
+    std::vector<uint256> vTxid;
+    for (unsigned int i = 0; i < CACHE_COINS; i++) {
+        vTxid.push_back(GetRandHash());
+        CCoinsModifier coins = cache.ModifyCoins(vTxid.back());
+        coins->nHeight = i;
+        coins->vout.resize(2);
+        for (unsigned int j = 0; j < coins->vout.size(); j++) {
+            coins->vout[j].nValue = (i + 1) * COIN;
+            coins->vout[j].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, j) << OP_EQUALVERIFY << OP_CHECKSIG;
+        }
+    }
+    return vTxid;
+}
+
+//! Pull coins that are not cached yet from the view below
+static void CCoinsViewCache_Fetch(benchmark::State& state)
+{
+    CCoinsViewMemory base;
+    std::vector<uint256> vTxid;
+    {
+        CCoinsViewCache cache(&base);
+        vTxid = AddCoins(cache);
+        cache.Flush();
+    }
+
+    while (state.KeepRunning()) {
+        CCoinsViewCache cache(&base);
+        for (unsigned int i = 0; i < vTxid.size(); i++) {
+            const CCoins* coins = cache.AccessCoins(vTxid[i]);
+            assert(coins != NULL);
+        }
+    }
+}
+
+//! Modify every coin in a child cache and flush the changes into its parent
+static void CCoinsViewCache_Flush(benchmark::State& state)
+{
+    CCoinsViewMemory base;
+    CCoinsViewCache parent(&base);
+    std::vector<uint256> vTxid = AddCoins(parent);
+
+    while (state.KeepRunning()) {
+        CCoinsViewCache cache(&parent);
+        for (unsigned int i = 0; i < vTxid.size(); i++) {
+            CCoinsModifier coins = cache.ModifyCoins(vTxid[i]);
+            coins->vout[0].nValue++;
+        }
+        cache.Flush();
+    }
+}
+
+BENCHMARK(CCoinsViewCache_Fetch);
+BENCHMARK(CCoinsViewCache_Flush);
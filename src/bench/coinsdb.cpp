@@ -0,0 +1,112 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "coins.h"
+#include "random.h"
+#include "txdb.h"
+
+#include <assert.h>
+#include <vector>
+
+//! Transactions in the database
+static const unsigned int DB_TRANSACTIONS = 10000;
+//! Outputs of the payout transaction
+static const unsigned int PAYOUT_OUTPUTS = 300;
+
+static CCoins MakeCoins(unsigned int nOutputs, int nHeight)
+{
+    CCoins coins;
+    coins.nVersion = 1;
+    coins.nHeight = nHeight;
+    coins.vout.resize(nOutputs);
+    for (unsigned int i = 0; i < nOutputs; i++) {
+        coins.vout[i].nValue = (i + 1) * COIN;
+        coins.vout[i].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, i) << OP_EQUALVERIFY << OP_CHECKSIG;
+    }
+    return coins;
+}
+
+/** Fill an in-memory coin database with two-output transactions and one payout transaction */
+static std::vector<uint256> FillCoinsDB(CCoinsViewDB& db, uint256& txidPayout)
+{
+    std::vector<uint256> vTxid;
+    CCoinsMap mapCoins;
+    for (unsigned int i = 0; i < DB_TRANSACTIONS; i++) {
+        vTxid.push_back(GetRandHash());
+        CCoinsCacheEntry& entry = mapCoins[vTxid.back()];
+        entry.coins = MakeCoins(2, i);
+        entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+    }
+    txidPayout = GetRandHash();
+    CCoinsCacheEntry& entry = mapCoins[txidPayout];
+    entry.coins = MakeCoins(PAYOUT_OUTPUTS, 1);
+    entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+    bool fOk = db.BatchWrite(mapCoins, GetRandHash(), CCoinsRollingStats());
+    assert(fOk);
+    return vTxid;
+}
+
+//! Look up transactions that are not cached, as the cache does when it misses
+static void CCoinsViewDB_Lookup(benchmark::State& state)
+{
+    CCoinsViewDB db(1 << 20, true, true);
+    uint256 txidPayout;
+    std::vector<uint256> vTxid = FillCoinsDB(db, txidPayout);
+
+    unsigned int i = 0;
+    while (state.KeepRunning()) {
+        CCoins coins;
+        bool fFound = db.GetCoins(vTxid[i++ % vTxid.size()], coins);
+        assert(fFound);
+    }
+}
+
+//! Spend one output of a payout transaction and restore it, as a block and its disconnection do
+static void CCoinsViewDB_SpendPayout(benchmark::State& state)
+{
+    CCoinsViewDB db(1 << 20, true, true);
+    uint256 txidPayout;
+    FillCoinsDB(db, txidPayout);
+    CCoins coinsPayout = MakeCoins(PAYOUT_OUTPUTS, 1);
+
+    unsigned int n = 0;
+    while (state.KeepRunning()) {
+        CCoinsMap mapCoins;
+        CCoinsCacheEntry& entry = mapCoins[txidPayout];
+        entry.coins = coinsPayout;
+        entry.coins.vout[n++ % PAYOUT_OUTPUTS].SetNull();
+        entry.flags = CCoinsCacheEntry::DIRTY;
+        db.BatchWrite(mapCoins, uint256(0), CCoinsRollingStats());
+        mapCoins[txidPayout].coins = coinsPayout;
+        db.BatchWrite(mapCoins, uint256(0), CCoinsRollingStats());
+    }
+}
+
+//! Flush a thousand changed transactions spread over the database
+static void CCoinsViewDB_Flush(benchmark::State& state)
+{
+    CCoinsViewDB db(1 << 20, true, true);
+    uint256 txidPayout;
+    std::vector<uint256> vTxid = FillCoinsDB(db, txidPayout);
+
+    unsigned int nOutput = 0;
+    while (state.KeepRunning()) {
+        CCoinsMap mapCoins;
+        for (unsigned int i = 0; i < 1000; i++) {
+            unsigned int nTx = GetRand(vTxid.size());
+            CCoinsCacheEntry& entry = mapCoins[vTxid[nTx]];
+            entry.coins = MakeCoins(2, nTx);
+            entry.coins.vout[nOutput].SetNull();
+            entry.flags = CCoinsCacheEntry::DIRTY;
+        }
+        db.BatchWrite(mapCoins, uint256(0), CCoinsRollingStats());
+        nOutput ^= 1;
+    }
+}
+
+BENCHMARK(CCoinsViewDB_Lookup);
+BENCHMARK(CCoinsViewDB_SpendPayout);
+BENCHMARK(CCoinsViewDB_Flush);
@@ -0,0 +1,73 @@
+// Copyright (c) 2016 The Bitcoin Core developers
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "crypto/sha256.h"
+#include "hash.h"
+#include "uint256.h"
+
+#include <vector>
+
+/* Number of bytes to hash per iteration */
+static const uint64_t BUFFER_SIZE = 1000 * 1000;
+
+static void SHA256_1MB(benchmark::State& state)
+{
+    uint8_t hash[CSHA256::OUTPUT_SIZE];
+    std::vector<uint8_t> in(BUFFER_SIZE, 0);
+    while (state.KeepRunning())
+        CSHA256().Write(begin_ptr(in), in.size()).Finalize(hash);
+}
+
+//! Double SHA256 of a 64 byte message, as done for every merkle tree node
+static void DoubleSHA256_64(benchmark::State& state)
+{
+    std::vector<uint8_t> in(64, 0);
+    uint256 hash;
+    while (state.KeepRunning()) {
+        hash = Hash(in.begin(), in.end());
+        in[0] = hash.begin()[0];
+    }
+}
+
+//! Double SHA256 of 1024 independent 64 byte messages, as done for one level of a large merkle tree
+static void SHA256D64_1024(benchmark::State& state)
+{
+    std::vector<uint8_t> in(64 * 1024, 0);
+    std::vector<uint8_t> out(32 * 1024);
+    while (state.KeepRunning()) {
+        SHA256D64(begin_ptr(out), begin_ptr(in), 1024);
+        in[0] = out[0];
+    }
+}
+
+//! Double SHA256 of a version 4 block header (PoS block hash)
+static void DoubleSHA256_Header(benchmark::State& state)
+{
+    std::vector<uint8_t> in(112, 0);
+    uint256 hash;
+    while (state.KeepRunning()) {
+        hash = Hash(in.begin(), in.end());
+        in[0] = hash.begin()[0];
+    }
+}
+
+//! Quark hash of an 80 byte block header (PoW block hash)
+static void HashQuark_Header(benchmark::State& state)
+{
+    std::vector<uint8_t> in(80, 0);
+    uint256 hash;
+    while (state.KeepRunning()) {
+        hash = HashQuark(in.begin(), in.end());
+        in[0] = hash.begin()[0];
+    }
+}
+
+BENCHMARK(SHA256_1MB);
+BENCHMARK(DoubleSHA256_64);
+BENCHMARK(SHA256D64_1024);
+BENCHMARK(DoubleSHA256_Header);
+BENCHMARK(HashQuark_Header);
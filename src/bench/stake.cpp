@@ -0,0 +1,31 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "kernel.h"
+#include "random.h"
+#include "streams.h"
+
+#include <limits>
+
+//! One kernel hash attempt per iteration, as the staking loop does for every input and timestamp
+static void CheckStake_Kernel(benchmark::State& state)
+{
+    CDataStream ssUniqueID(SER_NETWORK, 0);
+    ssUniqueID << COutPoint(GetRandHash(), 1);
+    uint256 bnTarget;
+    bnTarget.SetCompact(0x1e0fffff);
+    uint64_t nStakeModifier = GetRand(std::numeric_limits<uint64_t>::max());
+    unsigned int nTimeBlockFrom = 1530000000;
+    unsigned int nTimeTx = nTimeBlockFrom + 3600;
+    uint256 hashProofOfStake;
+
+    while (state.KeepRunning()) {
+        CheckStake(ssUniqueID, 1000 * COIN, nStakeModifier, bnTarget, nTimeBlockFrom, nTimeTx, hashProofOfStake);
+        nTimeTx++;
+    }
+}
+
+BENCHMARK(CheckStake_Kernel);
@@ -0,0 +1,51 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "libzerocoin/Accumulator.h"
+#include "libzerocoin/Coin.h"
+#include "libzerocoin/CoinSpend.h"
+
+#include <assert.h>
+
+using namespace libzerocoin;
+
+//! Number of coins accumulated ahead of the spent one; minting is slow, so keep it small
+static const unsigned int ACCUMULATED_COINS = 4;
+
+static void Accumulator_Accumulate(benchmark::State& state)
+{
+    const ZerocoinParams* params = Params().Zerocoin_Params(false);
+    PrivateCoin coin(params, CoinDenomination::ZQ_ONE);
+    Accumulator accumulator(params, CoinDenomination::ZQ_ONE);
+    while (state.KeepRunning())
+        accumulator.accumulate(coin.getPublicCoin());
+}
+
+static void CoinSpend_Verify(benchmark::State& state)
+{
+    const ZerocoinParams* params = Params().Zerocoin_Params(false);
+    std::vector<PrivateCoin> vCoins;
+    for (unsigned int i = 0; i < ACCUMULATED_COINS; i++)
+        vCoins.push_back(PrivateCoin(params, CoinDenomination::ZQ_ONE));
+
+    Accumulator accumulator(params, CoinDenomination::ZQ_ONE);
+    AccumulatorWitness witness(params, accumulator, vCoins[0].getPublicCoin());
+    for (unsigned int i = 0; i < vCoins.size(); i++) {
+        accumulator += vCoins[i].getPublicCoin();
+        if (i != 0)
+            witness += vCoins[i].getPublicCoin();
+    }
+
+    CoinSpend spend(params, params, vCoins[0], accumulator, 0, witness, 0, SpendType::SPEND);
+    while (state.KeepRunning()) {
+        bool fValid = spend.Verify(accumulator);
+        assert(fValid);
+    }
+}
+
+BENCHMARK(Accumulator_Accumulate);
+BENCHMARK(CoinSpend_Verify);
@@ -40,7 +40,9 @@ void ThreadBitPool()
             /*
                 cs_main is required for doing CMasternode.Check because something
                 is modifying the coins view without a mempool lock. It causes
-                segfaults from this code without the cs_main lock.
+                segfaults from this code without the cs_main lock. Check only
+                try-locks cs_main and skips the entry when it is taken, so the
+                lock held here is what makes the checks actually run.
             */
             m_nodeman.CheckAndRemove();
             m_nodeman.ProcessMasternodeConnections();
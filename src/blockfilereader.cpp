@@ -0,0 +1,127 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilereader.h"
+
+#include "blockfilewriter.h"
+#include "crypto/common.h"
+#include "main.h"
+#include "util.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CBlockFileReader blockFileReader;
+
+CMappedBlockFile::~CMappedBlockFile()
+{
+#ifndef WIN32
+    munmap((void*)pdata, nSize);
+#endif
+}
+
+CBlockFileReader::CBlockFileReader() : nMaxFiles(DEFAULT_MMAP_BLOCK_FILES), nUseCounter(0)
+{
+}
+
+void CBlockFileReader::SetMaxFiles(unsigned int nMaxFilesIn)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    nMaxFiles = nMaxFilesIn;
+    mapFiles.clear();
+}
+
+void CBlockFileReader::Forget(int nFile, const char* prefix)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    mapFiles.erase(std::make_pair(std::string(prefix), nFile));
+}
+
+boost::shared_ptr<const CMappedBlockFile> CBlockFileReader::MapFile(const CDiskBlockPos& pos, const char* prefix, size_t nMinSize)
+{
+    boost::shared_ptr<const CMappedBlockFile> file;
+#ifndef WIN32
+    std::pair<std::string, int> key = std::make_pair(std::string(prefix), pos.nFile);
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (nMaxFiles == 0)
+            return file;
+        std::map<std::pair<std::string, int>, std::pair<boost::shared_ptr<const CMappedBlockFile>, uint64_t> >::iterator it = mapFiles.find(key);
+        if (it != mapFiles.end() && it->second.first->nSize >= nMinSize) {
+            it->second.second = ++nUseCounter;
+            return it->second.first;
+        }
+    }
+
+    // map outside the lock, the file may have grown since it was mapped last
+    boost::filesystem::path path = GetBlockPosFilename(pos, prefix);
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd == -1)
+        return file;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0 && (uint64_t)st.st_size >= nMinSize) {
+        void* pdata = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (pdata != MAP_FAILED)
+            file.reset(new CMappedBlockFile((const char*)pdata, st.st_size));
+        else
+            LogPrintf("%s : Unable to map %s\n", __func__, path.string());
+    }
+    close(fd);
+    if (!file)
+        return file;
+
+    boost::unique_lock<boost::mutex> lock(mutex);
+    std::pair<boost::shared_ptr<const CMappedBlockFile>, uint64_t>& entry = mapFiles[key];
+    if (!entry.first || entry.first->nSize < file->nSize)
+        entry.first = file;
+    entry.second = ++nUseCounter;
+    file = entry.first;
+
+    // unmap the least recently used files, readers still using them keep them until they are done
+    while (mapFiles.size() > nMaxFiles) {
+        std::map<std::pair<std::string, int>, std::pair<boost::shared_ptr<const CMappedBlockFile>, uint64_t> >::iterator itOldest = mapFiles.begin();
+        for (std::map<std::pair<std::string, int>, std::pair<boost::shared_ptr<const CMappedBlockFile>, uint64_t> >::iterator it = mapFiles.begin(); it != mapFiles.end(); ++it) {
+            if (it->second.second < itOldest->second.second)
+                itOldest = it;
+        }
+        mapFiles.erase(itOldest);
+    }
+#endif
+    return file;
+}
+
+bool CBlockFileReader::MapRecord(const CDiskBlockPos& pos, const char* prefix, CMappedRecord& record)
+{
+    // every record is preceded by the network magic and its size
+    if (pos.IsNull() || pos.nPos < 8)
+        return false;
+
+    // data still queued for writing must reach the file first
+    blockFileWriter.WaitForPending(pos, prefix);
+
+    boost::shared_ptr<const CMappedBlockFile> file = MapFile(pos, prefix, pos.nPos);
+    if (!file)
+        return false;
+    uint64_t nRecordSize = ReadLE32((const unsigned char*)file->pdata + pos.nPos - 4);
+    if (nRecordSize > MAX_BLOCK_SIZE_CURRENT)
+        return false;
+
+    // The mapping covers the file as it was when it was mapped, and files are only truncated
+    // through Forget, so a record inside it is in the file. Only a record past the cached size
+    // looks at the file again; a file that doesn't hold it is left to the stdio reader.
+    if (pos.nPos + nRecordSize > file->nSize) {
+        file = MapFile(pos, prefix, pos.nPos + nRecordSize);
+        if (!file)
+            return false;
+    }
+
+    record.file = file;
+    record.pbegin = file->pdata + pos.nPos;
+    record.pend = record.pbegin + nRecordSize;
+    return true;
+}
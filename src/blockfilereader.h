@@ -0,0 +1,89 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKFILEREADER_H
+#define BITCOIN_BLOCKFILEREADER_H
+
+#include "chain.h"
+#include "streams.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+/** Default for -mmapblocks, the number of block files kept memory mapped */
+static const unsigned int DEFAULT_MMAP_BLOCK_FILES = sizeof(void*) >= 8 ? 64 : 0;
+
+/** A read-only memory mapping of a whole block or undo file, unmapped with the last reference */
+class CMappedBlockFile
+{
+private:
+    CMappedBlockFile(const CMappedBlockFile&);
+    CMappedBlockFile& operator=(const CMappedBlockFile&);
+
+public:
+    const char* pdata;
+    //! Size of the file when it was mapped, the mapping covers all of it
+    size_t nSize;
+
+    CMappedBlockFile(const char* pdataIn, size_t nSizeIn) : pdata(pdataIn), nSize(nSizeIn) {}
+    ~CMappedBlockFile();
+};
+
+/** A record in a mapped file. The mapping stays alive as long as the record. */
+class CMappedRecord
+{
+public:
+    boost::shared_ptr<const CMappedBlockFile> file;
+    const char* pbegin;
+    const char* pend;
+
+    CMappedRecord() : pbegin(NULL), pend(NULL) {}
+
+    CSpanReader GetReader(int nType, int nVersion) const { return CSpanReader(pbegin, pend, nType, nVersion); }
+};
+
+/**
+ * Serves reads of block records from memory mapped block files.
+ *
+ * Blocks are read for txindex lookups, rescans and for peers and RPC clients
+ * asking for old blocks. Instead of opening, seeking and reading the file
+ * through stdio every time, the reader maps each file once, keeps the most
+ * recently used mappings, and deserializes records straight from the mapping.
+ * A file that has grown past its mapping is mapped again; readers still
+ * holding the old mapping keep it until they are done.
+ *
+ * Mapping is not available on Windows, and callers fall back to reading the
+ * file when MapRecord returns false.
+ */
+class CBlockFileReader
+{
+private:
+    boost::mutex mutex;
+    unsigned int nMaxFiles;
+    uint64_t nUseCounter;
+    //! Mapped files with the value of nUseCounter when they were last used
+    std::map<std::pair<std::string, int>, std::pair<boost::shared_ptr<const CMappedBlockFile>, uint64_t> > mapFiles;
+
+    boost::shared_ptr<const CMappedBlockFile> MapFile(const CDiskBlockPos& pos, const char* prefix, size_t nMinSize);
+
+public:
+    CBlockFileReader();
+
+    //! Keep at most nMaxFilesIn files mapped, 0 disables mapping
+    void SetMaxFiles(unsigned int nMaxFilesIn);
+
+    //! Map the record whose data starts at pos, right after its index header. Returns false if it can't be mapped.
+    bool MapRecord(const CDiskBlockPos& pos, const char* prefix, CMappedRecord& record);
+
+    //! Drop the mapping of a file that is truncated or deleted. Must be called by whoever truncates a block file.
+    void Forget(int nFile, const char* prefix);
+};
+
+extern CBlockFileReader blockFileReader;
+
+#endif // BITCOIN_BLOCKFILEREADER_H
@@ -0,0 +1,308 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilewriter.h"
+
+#include "blockfilereader.h"
+#include "main.h"
+#include "util.h"
+#include "utiltime.h"
+
+CBlockFileWriter blockFileWriter;
+
+CBlockFileWriter::CBlockFileWriter() : nQueuedBytes(0), nQueued(0), nDone(0), fFailed(false), fRunning(false), fStop(false), keyAppend(std::string(), -1), nAppendPos(0)
+{
+}
+
+CBlockFileWriter::~CBlockFileWriter()
+{
+    for (std::map<std::pair<std::string, int>, FILE*>::iterator it = mapOpenFiles.begin(); it != mapOpenFiles.end(); ++it)
+        fclose(it->second);
+}
+
+void CBlockFileWriter::Start()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    if (fRunning)
+        return;
+    fStop = false;
+    fRunning = true;
+    threadWrite = boost::thread(boost::bind(&CBlockFileWriter::ThreadWrite, this));
+}
+
+void CBlockFileWriter::Stop()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (!fRunning)
+            return;
+        fStop = true;
+        condQueued.notify_all();
+    }
+    threadWrite.join();
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fRunning = false;
+    }
+
+    // sync and close whatever the thread left open
+    Flush();
+}
+
+uint64_t CBlockFileWriter::Enqueue(CBlockFileOp& op)
+{
+    uint64_t nSequence;
+    bool fRunningNow;
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fRunningNow = fRunning;
+        // only data counts against the limit, and a single record always fits
+        while (fRunning && op.type == CBlockFileOp::WRITE && !queue.empty() && nQueuedBytes + op.vch.size() > MAX_BLOCK_WRITE_QUEUE)
+            condDone.wait(lock);
+        queue.push_back(CBlockFileOp());
+        queue.back().type = op.type;
+        queue.back().strPrefix = op.strPrefix;
+        queue.back().nFile = op.nFile;
+        queue.back().nPos = op.nPos;
+        queue.back().nLength = op.nLength;
+        queue.back().vch.swap(op.vch);
+        nQueuedBytes += queue.back().vch.size();
+        nSequence = ++nQueued;
+        condQueued.notify_one();
+    }
+
+    if (!fRunningNow)
+        Process();
+    return nSequence;
+}
+
+bool CBlockFileWriter::WaitDone(uint64_t nSequence)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    while (nDone < nSequence)
+        condDone.wait(lock);
+    return !fFailed;
+}
+
+bool CBlockFileWriter::Write(const CDiskBlockPos& pos, const char* prefix, const CDataStream& ss)
+{
+    CBlockFileOp op;
+    op.type = CBlockFileOp::WRITE;
+    op.strPrefix = prefix;
+    op.nFile = pos.nFile;
+    op.nPos = pos.nPos;
+    op.nLength = ss.size();
+    op.vch.assign(ss.begin(), ss.end());
+    Enqueue(op);
+
+    boost::unique_lock<boost::mutex> lock(mutex);
+    return !fFailed;
+}
+
+void CBlockFileWriter::Allocate(const CDiskBlockPos& pos, const char* prefix, unsigned int nLength)
+{
+    CBlockFileOp op;
+    op.type = CBlockFileOp::ALLOCATE;
+    op.strPrefix = prefix;
+    op.nFile = pos.nFile;
+    op.nPos = pos.nPos;
+    op.nLength = nLength;
+    Enqueue(op);
+}
+
+void CBlockFileWriter::Truncate(int nFile, const char* prefix, unsigned int nLength)
+{
+    CBlockFileOp op;
+    op.type = CBlockFileOp::TRUNCATE;
+    op.strPrefix = prefix;
+    op.nFile = nFile;
+    op.nPos = 0;
+    op.nLength = nLength;
+    Enqueue(op);
+}
+
+bool CBlockFileWriter::Flush()
+{
+    CBlockFileOp op;
+    op.type = CBlockFileOp::SYNC;
+    op.nFile = -1;
+    op.nPos = 0;
+    op.nLength = 0;
+    return WaitDone(Enqueue(op));
+}
+
+bool CBlockFileWriter::ReadPending(const CDiskBlockPos& pos, const char* prefix, CDataStream& ss)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    for (std::deque<CBlockFileOp>::reverse_iterator it = queue.rbegin(); it != queue.rend(); ++it) {
+        if (it->type != CBlockFileOp::WRITE || it->nFile != pos.nFile || it->strPrefix != prefix)
+            continue;
+        if (pos.nPos < it->nPos || pos.nPos >= it->nPos + it->vch.size())
+            continue;
+        ss.clear();
+        ss.write(&it->vch[pos.nPos - it->nPos], it->vch.size() - (pos.nPos - it->nPos));
+        return true;
+    }
+    return false;
+}
+
+void CBlockFileWriter::WaitForPending(const CDiskBlockPos& pos, const char* prefix)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    uint64_t nSequence = 0;
+    for (unsigned int i = 0; i < queue.size(); i++) {
+        const CBlockFileOp& op = queue[i];
+        if (op.type == CBlockFileOp::WRITE && op.nFile == pos.nFile && op.strPrefix == prefix && op.nPos + op.vch.size() > pos.nPos)
+            nSequence = nDone + i + 1;
+    }
+    while (nDone < nSequence)
+        condDone.wait(lock);
+}
+
+FILE* CBlockFileWriter::GetFile(const std::string& strPrefix, int nFile)
+{
+    std::pair<std::string, int> key = std::make_pair(strPrefix, nFile);
+    std::map<std::pair<std::string, int>, FILE*>::iterator it = mapOpenFiles.find(key);
+    if (it != mapOpenFiles.end())
+        return it->second;
+
+    CDiskBlockPos pos(nFile, 0);
+    FILE* file = strPrefix == "blk" ? OpenBlockFile(pos) : OpenUndoFile(pos);
+    if (file)
+        mapOpenFiles[key] = file;
+    return file;
+}
+
+void CBlockFileWriter::CloseFile(const std::string& strPrefix, int nFile)
+{
+    std::pair<std::string, int> key = std::make_pair(strPrefix, nFile);
+    std::map<std::pair<std::string, int>, FILE*>::iterator it = mapOpenFiles.find(key);
+    if (it != mapOpenFiles.end()) {
+        fclose(it->second);
+        mapOpenFiles.erase(it);
+    }
+    setDirtyFiles.erase(key);
+}
+
+bool CBlockFileWriter::ProcessOp(const CBlockFileOp& op)
+{
+    bool fAppend = op.type == CBlockFileOp::WRITE && keyAppend == std::make_pair(op.strPrefix, op.nFile) && nAppendPos == op.nPos;
+    keyAppend = std::make_pair(std::string(), -1);
+
+    if (op.type == CBlockFileOp::SYNC) {
+        for (std::set<std::pair<std::string, int> >::iterator it = setDirtyFiles.begin(); it != setDirtyFiles.end(); ++it)
+            FileCommit(mapOpenFiles[*it]);
+        setDirtyFiles.clear();
+        // reopening is cheap, don't hold on to file handles between syncs
+        for (std::map<std::pair<std::string, int>, FILE*>::iterator it = mapOpenFiles.begin(); it != mapOpenFiles.end(); ++it)
+            fclose(it->second);
+        mapOpenFiles.clear();
+        return true;
+    }
+
+    FILE* file = GetFile(op.strPrefix, op.nFile);
+    if (!file)
+        return error("%s : Failed to open %s%05u.dat", __func__, op.strPrefix, op.nFile);
+
+    switch (op.type) {
+    case CBlockFileOp::WRITE:
+        // a record that continues the previous one is appended in the stdio buffer, seeking would flush it
+        if (!fAppend && fseek(file, op.nPos, SEEK_SET))
+            return error("%s : Failed to seek to position %u of %s%05u.dat", __func__, op.nPos, op.strPrefix, op.nFile);
+        if (fwrite(&op.vch[0], 1, op.vch.size(), file) != op.vch.size())
+            return error("%s : Failed to write %u bytes to %s%05u.dat", __func__, (unsigned int)op.vch.size(), op.strPrefix, op.nFile);
+        setDirtyFiles.insert(std::make_pair(op.strPrefix, op.nFile));
+        keyAppend = std::make_pair(op.strPrefix, op.nFile);
+        nAppendPos = op.nPos + op.vch.size();
+        return true;
+    case CBlockFileOp::ALLOCATE:
+        LogPrintf("Pre-allocating up to position 0x%x in %s%05u.dat\n", op.nPos + op.nLength, op.strPrefix, op.nFile);
+        AllocateFileRange(file, op.nPos, op.nLength);
+        break;
+    case CBlockFileOp::TRUNCATE:
+        // a mapping of the preallocated tail must not outlive it
+        blockFileReader.Forget(op.nFile, op.strPrefix.c_str());
+        fflush(file);
+        if (!TruncateFile(file, op.nLength))
+            return error("%s : Failed to truncate %s%05u.dat", __func__, op.strPrefix, op.nFile);
+        FileCommit(file);
+        CloseFile(op.strPrefix, op.nFile);
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+bool CBlockFileWriter::Process()
+{
+    boost::unique_lock<boost::mutex> lockProcess(mutexProcess);
+
+    // references into the deque stay valid while more is queued behind them
+    std::vector<const CBlockFileOp*> vOps;
+    bool fThread;
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fThread = fRunning;
+        for (unsigned int i = 0; i < queue.size(); i++)
+            vOps.push_back(&queue[i]);
+    }
+    if (vOps.empty())
+        return true;
+
+    int64_t nStart = GetTimeMicros();
+    size_t nBytes = 0;
+    bool fOk = true;
+    keyAppend = std::make_pair(std::string(), -1);
+    for (unsigned int i = 0; i < vOps.size(); i++) {
+        try {
+            fOk &= ProcessOp(*vOps[i]);
+        } catch (const std::exception& e) {
+            fOk = error("%s : %s", __func__, e.what());
+        }
+        nBytes += vOps[i]->vch.size();
+    }
+
+    // readers open the files themselves once the records leave the queue
+    for (std::set<std::pair<std::string, int> >::iterator it = setDirtyFiles.begin(); it != setDirtyFiles.end(); ++it)
+        if (fflush(mapOpenFiles[*it]) != 0)
+            fOk = error("%s : Failed to write %s%05u.dat", __func__, it->first, it->second);
+
+    // without a thread of its own the writer doesn't keep files open, the data directory may change under it
+    if (!fThread) {
+        for (std::set<std::pair<std::string, int> >::iterator it = setDirtyFiles.begin(); it != setDirtyFiles.end(); ++it)
+            FileCommit(mapOpenFiles[*it]);
+        setDirtyFiles.clear();
+        for (std::map<std::pair<std::string, int>, FILE*>::iterator it = mapOpenFiles.begin(); it != mapOpenFiles.end(); ++it)
+            fclose(it->second);
+        mapOpenFiles.clear();
+    }
+    LogPrint("blockwrite", "%s : wrote %u operations, %u bytes in %.2fms\n", __func__, (unsigned int)vOps.size(), (unsigned int)nBytes, (GetTimeMicros() - nStart) * 0.001);
+
+    boost::unique_lock<boost::mutex> lock(mutex);
+    for (unsigned int i = 0; i < vOps.size(); i++) {
+        nQueuedBytes -= queue.front().vch.size();
+        queue.pop_front();
+    }
+    nDone += vOps.size();
+    fFailed |= !fOk;
+    condDone.notify_all();
+    return fOk;
+}
+
+void CBlockFileWriter::ThreadWrite()
+{
+    RenameThread("vitae-blkwrite");
+
+    while (true) {
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (queue.empty() && !fStop)
+                condQueued.wait(lock);
+            if (queue.empty())
+                break;
+        }
+        Process();
+    }
+}
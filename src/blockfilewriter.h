@@ -0,0 +1,110 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKFILEWRITER_H
+#define BITCOIN_BLOCKFILEWRITER_H
+
+#include "chain.h"
+#include "streams.h"
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+/** Queued block and undo data above which writers wait for the disk to catch up (64MiB) */
+static const size_t MAX_BLOCK_WRITE_QUEUE = 64 * 1024 * 1024;
+
+/**
+ * Writes block (blk?????.dat) and undo (rev?????.dat) files from a background thread.
+ *
+ * Callers serialize a record and queue it at the position FindBlockPos or
+ * FindUndoPos handed out, and go on without waiting for the disk. The writer
+ * thread takes everything queued at once, writes consecutive records of the
+ * same file with a single seek, and keeps the files open between batches.
+ * Preallocation and truncation of finished files go through the same queue.
+ * fdatasync only happens in Flush, which FlushStateToDisk calls before the
+ * block index may refer to the queued data.
+ *
+ * Queued records stay readable: ReadPending serves them from memory, and
+ * opening a file for reading waits until the records in it are written.
+ * Without a running thread, every operation is done by the caller.
+ */
+class CBlockFileWriter
+{
+private:
+    struct CBlockFileOp {
+        enum Type {
+            WRITE,
+            ALLOCATE,
+            TRUNCATE,
+            SYNC
+        };
+        Type type;
+        std::string strPrefix;
+        int nFile;
+        unsigned int nPos;
+        unsigned int nLength;
+        std::vector<char> vch;
+    };
+
+    boost::mutex mutex;
+    boost::condition_variable condQueued;
+    boost::condition_variable condDone;
+    //! Operations not done yet, the front ones may be in progress
+    std::deque<CBlockFileOp> queue;
+    size_t nQueuedBytes;
+    uint64_t nQueued;
+    uint64_t nDone;
+    bool fFailed;
+    bool fRunning;
+    bool fStop;
+    boost::thread threadWrite;
+
+    //! Only used by whoever is processing the queue
+    boost::mutex mutexProcess;
+    std::map<std::pair<std::string, int>, FILE*> mapOpenFiles;
+    std::set<std::pair<std::string, int> > setDirtyFiles;
+    //! File and position the last write of the batch ended at
+    std::pair<std::string, int> keyAppend;
+    unsigned int nAppendPos;
+
+    uint64_t Enqueue(CBlockFileOp& op);
+    bool WaitDone(uint64_t nSequence);
+    bool Process();
+    bool ProcessOp(const CBlockFileOp& op);
+    FILE* GetFile(const std::string& strPrefix, int nFile);
+    void CloseFile(const std::string& strPrefix, int nFile);
+    void ThreadWrite();
+
+public:
+    CBlockFileWriter();
+    ~CBlockFileWriter();
+
+    void Start();
+    //! Write everything still queued and stop the thread
+    void Stop();
+
+    //! Queue a serialized record to be written at pos of the blk or rev file
+    bool Write(const CDiskBlockPos& pos, const char* prefix, const CDataStream& ss);
+    //! Queue preallocation of length bytes from pos
+    void Allocate(const CDiskBlockPos& pos, const char* prefix, unsigned int nLength);
+    //! Queue truncation of a finished file to its final length
+    void Truncate(int nFile, const char* prefix, unsigned int nLength);
+    //! Wait until everything queued is written and synced to disk. Returns false if any write failed.
+    bool Flush();
+
+    //! Copy the queued data from pos to the end of its record into ss, if it is not written yet
+    bool ReadPending(const CDiskBlockPos& pos, const char* prefix, CDataStream& ss);
+    //! Wait until the data queued at or after pos of a file is written
+    void WaitForPending(const CDiskBlockPos& pos, const char* prefix);
+};
+
+extern CBlockFileWriter blockFileWriter;
+
+#endif // BITCOIN_BLOCKFILEWRITER_H
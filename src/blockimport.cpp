@@ -0,0 +1,128 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockimport.h"
+
+#include "blocksignature.h"
+#include "clientversion.h"
+#include "main.h"
+#include "streams.h"
+#include "util.h"
+
+#include <boost/bind.hpp>
+
+CBlockImportQueue::CBlockImportQueue(int nThreads) : nTaken(0), nPopped(0), nQueuedBytes(0), fStop(false)
+{
+    for (int i = 0; i < nThreads; i++)
+        threadGroup.create_thread(boost::bind(&CBlockImportQueue::ThreadCheck, this));
+}
+
+CBlockImportQueue::~CBlockImportQueue()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fStop = true;
+    }
+    condWorker.notify_all();
+    // the loader may be unwinding from an interruption, don't let the join throw again
+    boost::this_thread::disable_interruption di;
+    threadGroup.join_all();
+}
+
+void CBlockImportQueue::Check(CImportBlock& entry)
+{
+    if (!entry.vchBlock.empty()) {
+        try {
+            CSpanReader reader(&entry.vchBlock[0], &entry.vchBlock[0] + entry.vchBlock.size(), SER_DISK, CLIENT_VERSION);
+            reader >> entry.block;
+        } catch (const std::exception& e) {
+            LogPrintf("%s : Deserialize or I/O error - %s\n", __func__, e.what());
+            entry.fValid = false;
+        }
+        std::vector<char>().swap(entry.vchBlock);
+        if (!entry.fValid)
+            return;
+    }
+    entry.hash = entry.block.GetHash();
+    // CheckBlock takes the height for the serial range of zerocoin spends from the parent, which
+    // a worker ahead of the loader may not know yet; such blocks with spends are checked again
+    bool fParentKnown = LookupBlockIndex(entry.block.hashPrevBlock) != NULL;
+    CValidationState state;
+    entry.fChecked = CheckBlock(entry.block, state) && CheckBlockSignature(entry.block);
+    for (unsigned int i = 0; i < entry.block.vtx.size() && entry.fChecked && !fParentKnown; i++) {
+        if (entry.block.vtx[i].IsZerocoinSpend())
+            entry.fChecked = false;
+    }
+}
+
+bool CBlockImportQueue::IsFull()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    return nQueuedBytes >= MAX_BLOCK_IMPORT_QUEUE || queue.size() >= MAX_BLOCK_IMPORT_QUEUE_BLOCKS;
+}
+
+bool CBlockImportQueue::IsEmpty()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    return queue.empty();
+}
+
+void CBlockImportQueue::Push(const boost::shared_ptr<CImportBlock>& entry)
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        queue.push_back(std::make_pair(entry, false));
+        nQueuedBytes += entry->nSize;
+    }
+    condWorker.notify_one();
+}
+
+boost::shared_ptr<CImportBlock> CBlockImportQueue::Pop()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    assert(!queue.empty());
+    boost::shared_ptr<CImportBlock> entry = queue.front().first;
+    if (nTaken == 0) {
+        // no worker got to it yet, rather check it here than wait
+        nTaken++;
+        lock.unlock();
+        Check(*entry);
+        lock.lock();
+        queue.front().second = true;
+    }
+    while (!queue.front().second)
+        condChecked.wait(lock);
+    queue.pop_front();
+    nTaken--;
+    nPopped++;
+    nQueuedBytes -= entry->nSize;
+    return entry;
+}
+
+void CBlockImportQueue::ThreadCheck()
+{
+    RenameThread("vitae-importch");
+    while (true) {
+        boost::shared_ptr<CImportBlock> entry;
+        uint64_t nIndex;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (!fStop && nTaken >= queue.size())
+                condWorker.wait(lock);
+            if (fStop)
+                return;
+            nIndex = nPopped + nTaken;
+            entry = queue[nTaken++].first;
+        }
+
+        Check(*entry);
+
+        {
+            // only checked blocks are taken out, so this one is still queued
+            boost::unique_lock<boost::mutex> lock(mutex);
+            queue[nIndex - nPopped].second = true;
+        }
+        condChecked.notify_all();
+    }
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKIMPORT_H
+#define BITCOIN_BLOCKIMPORT_H
+
+#include "chain.h"
+#include "primitives/block.h"
+#include "uint256.h"
+
+#include <deque>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+/** Size of the blocks read ahead of the one being processed during -reindex and -loadblock (32MiB) */
+static const size_t MAX_BLOCK_IMPORT_QUEUE = 32 * 1024 * 1024;
+/** Number of blocks read ahead of the one being processed during -reindex and -loadblock */
+static const unsigned int MAX_BLOCK_IMPORT_QUEUE_BLOCKS = 1024;
+
+/** A block read from a block file, with the results of the checks that didn't need the chain */
+class CImportBlock
+{
+public:
+    //! Serialized block as read from the file, deserialized into block and freed by Check
+    std::vector<char> vchBlock;
+    CBlock block;
+    //! Position of the block data in its block file, null for blocks not stored there yet
+    CDiskBlockPos pos;
+    unsigned int nSize;
+    uint256 hash;
+    //! The block deserialized, false for a corrupt record that is skipped
+    bool fValid;
+    //! CheckBlock and CheckBlockSignature passed, so ProcessNewBlock doesn't run them again
+    bool fChecked;
+
+    CImportBlock() : nSize(0), fValid(true), fChecked(false) {}
+};
+
+/**
+ * Checks blocks of -reindex and -loadblock ahead of processing them.
+ *
+ * LoadExternalBlockFile reads raw blocks from the files and queues them here.
+ * Worker threads deserialize and hash them and run CheckBlock and
+ * CheckBlockSignature, while the loader processes earlier blocks in file
+ * order. Blocks come out in the order they went in. A block no worker got to
+ * yet is checked by the thread taking it out, so without workers everything
+ * runs on the loader thread. One queue serves all files of an import, so the
+ * workers keep going across the file boundaries.
+ */
+class CBlockImportQueue
+{
+private:
+    boost::mutex mutex;
+    boost::condition_variable condWorker;
+    boost::condition_variable condChecked;
+    //! Queued blocks in file order with whether their checks are done
+    std::deque<std::pair<boost::shared_ptr<CImportBlock>, bool> > queue;
+    //! Number of blocks at the front of the queue taken by a worker or the loader
+    size_t nTaken;
+    //! Number of blocks taken out, to find a block again by the index it had when a worker took it
+    uint64_t nPopped;
+    size_t nQueuedBytes;
+    bool fStop;
+    boost::thread_group threadGroup;
+
+    void ThreadCheck();
+
+public:
+    explicit CBlockImportQueue(int nThreads);
+    ~CBlockImportQueue();
+
+    //! Deserialize and hash a block and run the checks that don't depend on the chain
+    static void Check(CImportBlock& entry);
+
+    //! Whether enough is queued to keep the workers busy
+    bool IsFull();
+    bool IsEmpty();
+    void Push(const boost::shared_ptr<CImportBlock>& entry);
+    //! Take out the oldest block once it is checked
+    boost::shared_ptr<CImportBlock> Pop();
+};
+
+#endif // BITCOIN_BLOCKIMPORT_H
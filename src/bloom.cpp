@@ -5,6 +5,7 @@
 
 #include "bloom.h"
 
+#include "crypto/common.h"
 #include "hash.h"
 #include "primitives/transaction.h"
 #include "script/script.h"
@@ -189,3 +190,42 @@ void CBloomFilter::UpdateEmptyFull()
     isFull = full;
     isEmpty = empty;
 }
+
+void CHashFilter::reset(unsigned int nMaxElementsIn, double nFPRate)
+{
+    nMaxElements = std::max(nMaxElementsIn, 1U);
+    nElements = 0;
+    uint64_t nBits = std::max((uint64_t)(-1 / LN2SQUARED * nMaxElements * log(nFPRate)), (uint64_t)64);
+    vData.assign((nBits + 63) / 64, 0);
+    nHashFuncs = std::max(std::min((unsigned int)(vData.size() * 64 / nMaxElements * LN2), MAX_HASH_FUNCS), 1U);
+}
+
+void CHashFilter::insert(const uint256& hash)
+{
+    if (vData.empty())
+        return;
+    // double hashing with two independent words of the key
+    uint64_t nBits = vData.size() * 64;
+    uint64_t h1 = ReadLE64(hash.begin());
+    uint64_t h2 = ReadLE64(hash.begin() + 8) | 1;
+    for (unsigned int i = 0; i < nHashFuncs; i++) {
+        uint64_t nIndex = (h1 + i * h2) % nBits;
+        vData[nIndex >> 6] |= (uint64_t)1 << (nIndex & 63);
+    }
+    nElements++;
+}
+
+bool CHashFilter::contains(const uint256& hash) const
+{
+    if (vData.empty())
+        return true;
+    uint64_t nBits = vData.size() * 64;
+    uint64_t h1 = ReadLE64(hash.begin());
+    uint64_t h2 = ReadLE64(hash.begin() + 8) | 1;
+    for (unsigned int i = 0; i < nHashFuncs; i++) {
+        uint64_t nIndex = (h1 + i * h2) % nBits;
+        if (!(vData[nIndex >> 6] & ((uint64_t)1 << (nIndex & 63))))
+            return false;
+    }
+    return true;
+}
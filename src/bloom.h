@@ -8,6 +8,7 @@
 
 #include "serialize.h"
 
+#include <stdint.h>
 #include <vector>
 
 class COutPoint;
@@ -98,4 +99,36 @@ public:
     void UpdateEmptyFull();
 };
 
+/**
+ * A bloom filter over keys that already are hashes, kept for local lookups.
+ *
+ * It never goes over the wire, so unlike CBloomFilter it is not bound by the
+ * protocol limits, and its bit positions are taken from the key itself instead
+ * of hashing it again. A key that is not contained was never inserted. Keys
+ * can't be removed; a key that is gone only costs a false positive.
+ *
+ * A filter that was never sized contains everything.
+ */
+class CHashFilter
+{
+private:
+    std::vector<uint64_t> vData;
+    unsigned int nHashFuncs;
+    unsigned int nElements;
+    unsigned int nMaxElements;
+
+public:
+    CHashFilter() : nHashFuncs(0), nElements(0), nMaxElements(0) {}
+
+    //! Empty the filter and size it for nMaxElementsIn keys at the given false positive rate
+    void reset(unsigned int nMaxElementsIn, double nFPRate);
+
+    void insert(const uint256& hash);
+    bool contains(const uint256& hash) const;
+
+    //! True once more keys were inserted than the filter was sized for. An unsized filter is never full.
+    bool IsFull() const { return nMaxElements > 0 && nElements >= nMaxElements; }
+    unsigned int size() const { return nElements; }
+};
+
 #endif // BITCOIN_BLOOM_H
@@ -0,0 +1,155 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "cachefile.h"
+
+#include "chainparams.h"
+#include "clientversion.h"
+#include "hash.h"
+#include "random.h"
+#include "util.h"
+
+#include <boost/filesystem.hpp>
+
+CCacheFile::CCacheFile(const std::string& strFileName, const std::string& strMagicMessageIn)
+{
+    pathFile = GetDataDir() / strFileName;
+    strMagicMessage = strMagicMessageIn;
+}
+
+CDataStream& CCacheFile::AddChunk(const std::string& strName)
+{
+    vChunks.push_back(std::make_pair(strName, CDataStream(SER_DISK, CLIENT_VERSION)));
+    return vChunks.back().second;
+}
+
+bool CCacheFile::Write()
+{
+    CDataStream ssFile(SER_DISK, CLIENT_VERSION);
+    ssFile << strMagicMessage;                   // cache file specific magic message
+    ssFile << FLATDATA(Params().MessageStart()); // network specific magic number
+    ssFile << CACHE_FILE_VERSION;
+    for (unsigned int i = 0; i < vChunks.size(); i++) {
+        const CDataStream& ssChunk = vChunks[i].second;
+        ssFile << vChunks[i].first;
+        WriteCompactSize(ssFile, ssChunk.size());
+        ssFile << ssChunk;
+        ssFile << Hash(ssChunk.begin(), ssChunk.end());
+    }
+    ssFile << std::string();
+
+    // write to a temporary file first, so that the old cache survives a failed write
+    unsigned short randv = 0;
+    GetRandBytes((unsigned char*)&randv, sizeof(randv));
+    boost::filesystem::path pathTmp = pathFile;
+    pathTmp += strprintf(".%04x", randv);
+
+    FILE* file = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull())
+        return error("%s : Failed to open file %s", __func__, pathTmp.string());
+
+    try {
+        fileout << ssFile;
+    } catch (const std::exception& e) {
+        return error("%s : Serialize or I/O error - %s", __func__, e.what());
+    }
+    FileCommit(fileout.Get());
+    fileout.fclose();
+
+    if (!RenameOver(pathTmp, pathFile))
+        return error("%s : Rename-into-place failed", __func__);
+
+    return true;
+}
+
+CCacheFile::ReadResult CCacheFile::Open()
+{
+    vchData.clear();
+    mapChunks.clear();
+
+    FILE* file = fopen(pathFile.string().c_str(), "rb");
+    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        error("%s : Failed to open file %s", __func__, pathFile.string());
+        return FileError;
+    }
+
+    try {
+        vchData.resize(boost::filesystem::file_size(pathFile));
+        if (!vchData.empty())
+            filein.read(&vchData[0], vchData.size());
+    } catch (const std::exception& e) {
+        error("%s : I/O error - %s", __func__, e.what());
+        return FileError;
+    }
+    filein.fclose();
+
+    CDataStream ssFile(vchData, SER_DISK, CLIENT_VERSION);
+    unsigned char pchMsgTmp[4];
+    std::string strMagicMessageTmp;
+    uint32_t nFileVersion;
+    try {
+        // de-serialize file header (cache file specific magic message) and ..
+        ssFile >> strMagicMessageTmp;
+
+        // ... verify the message matches predefined one
+        if (strMagicMessage != strMagicMessageTmp) {
+            error("%s : Invalid %s magic message", __func__, strMagicMessage);
+            return IncorrectMagicMessage;
+        }
+
+        // de-serialize file header (network specific magic number) and ..
+        ssFile >> FLATDATA(pchMsgTmp);
+
+        // ... verify the network matches ours
+        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
+            error("%s : Invalid network magic number", __func__);
+            return IncorrectMagicNumber;
+        }
+
+        // files written before the chunked layout have no version and are recreated
+        ssFile >> nFileVersion;
+        if (nFileVersion != CACHE_FILE_VERSION) {
+            error("%s : Unsupported %s version %u", __func__, pathFile.filename().string(), nFileVersion);
+            return IncorrectFormat;
+        }
+
+        // index the chunks, their payloads are only hashed once they are read
+        while (true) {
+            std::string strName;
+            ssFile >> strName;
+            if (strName.empty())
+                break;
+            unsigned int nSize = ReadCompactSize(ssFile);
+            unsigned int nOffset = vchData.size() - ssFile.size();
+            ssFile.ignore(nSize);
+            uint256 hash;
+            ssFile >> hash;
+            mapChunks[strName] = std::make_pair(std::make_pair(nOffset, nSize), hash);
+        }
+    } catch (const std::exception& e) {
+        mapChunks.clear();
+        error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        return IncorrectFormat;
+    }
+
+    return Ok;
+}
+
+bool CCacheFile::ReadChunk(const std::string& strName, CDataStream& ssChunk) const
+{
+    std::map<std::string, std::pair<std::pair<unsigned int, unsigned int>, uint256> >::const_iterator it = mapChunks.find(strName);
+    if (it == mapChunks.end())
+        return error("%s : Missing chunk %s in %s", __func__, strName, pathFile.filename().string());
+
+    const char* pbegin = &vchData[0] + it->second.first.first;
+    const char* pend = pbegin + it->second.first.second;
+    if (Hash(pbegin, pend) != it->second.second)
+        return error("%s : Checksum mismatch in chunk %s of %s, data corrupted", __func__, strName, pathFile.filename().string());
+
+    ssChunk.clear();
+    ssChunk.write(pbegin, pend - pbegin);
+    return true;
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CACHEFILE_H
+#define BITCOIN_CACHEFILE_H
+
+#include "streams.h"
+#include "uint256.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+/** Version of the chunked cache file layout, stored right after the file header */
+static const uint32_t CACHE_FILE_VERSION = 1;
+
+/**
+ * On-disk cache of a fundamentalnode, masternode, budget or payment manager.
+ *
+ * Layout: magic message, network magic and format version, followed by named
+ * chunks (name, payload, hash of the payload) and an empty name at the end.
+ * Every chunk carries its own checksum, so a manager can be written one chunk
+ * at a time while holding its lock only for that chunk, and opening a file
+ * only has to walk the chunk index instead of deserializing the whole manager.
+ * The file is replaced atomically, a partial write never clobbers the old one.
+ */
+class CCacheFile
+{
+private:
+    boost::filesystem::path pathFile;
+    std::string strMagicMessage;
+
+    /** Chunks added for writing, in order */
+    std::vector<std::pair<std::string, CDataStream> > vChunks;
+
+    /** Contents of the opened file, and the payload offset, size and hash of each chunk in it */
+    std::vector<char> vchData;
+    std::map<std::string, std::pair<std::pair<unsigned int, unsigned int>, uint256> > mapChunks;
+
+public:
+    enum ReadResult {
+        Ok,
+        FileError,
+        HashReadError,
+        IncorrectHash,
+        IncorrectMagicMessage,
+        IncorrectMagicNumber,
+        IncorrectFormat
+    };
+
+    CCacheFile(const std::string& strFileName, const std::string& strMagicMessageIn);
+
+    /** Start a new chunk to be written, the caller serializes its payload into the returned stream */
+    CDataStream& AddChunk(const std::string& strName);
+
+    /** Write the header and all added chunks to a temporary file and move it over the cache file */
+    bool Write();
+
+    /** Read the file and check its header and chunk index, without touching any payload */
+    ReadResult Open();
+
+    /** Load the payload of one chunk of the opened file into ssChunk, after checking its hash */
+    bool ReadChunk(const std::string& strName, CDataStream& ssChunk) const;
+
+    const boost::filesystem::path& GetPath() const { return pathFile; }
+};
+
+#endif // BITCOIN_CACHEFILE_H
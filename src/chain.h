@@ -584,4 +584,54 @@ public:
     const CBlockIndex* FindFork(const CBlockIndex* pindex) const;
 };
 
+/**
+ * Immutable view of the active chain as of one tip, published on every tip change.
+ * Block index entries are never freed while the node runs and their pprev/pskip links
+ * do not change, so the chain can be walked from the tip without holding cs_main.
+ * Lookups by height use the skip list and cost O(log n) instead of the O(1) of CChain.
+ */
+class CChainSnapshot
+{
+private:
+    CBlockIndex* pindexTip;
+
+public:
+    explicit CChainSnapshot(CBlockIndex* pindex) : pindexTip(pindex) {}
+
+    /** Returns the index entry for the tip of this chain, or NULL if none. */
+    CBlockIndex* Tip() const
+    {
+        return pindexTip;
+    }
+
+    /** Returns the index entry at a particular height in this chain, or NULL if no such height exists. */
+    CBlockIndex* operator[](int nHeight) const
+    {
+        if (pindexTip == NULL || nHeight < 0 || nHeight > pindexTip->nHeight)
+            return NULL;
+        return pindexTip->GetAncestor(nHeight);
+    }
+
+    /** Check whether a block is present in this chain. */
+    bool Contains(const CBlockIndex* pindex) const
+    {
+        return (*this)[pindex->nHeight] == pindex;
+    }
+
+    /** Find the successor of a block in this chain, or NULL if the given index is not found or is the tip. */
+    CBlockIndex* Next(const CBlockIndex* pindex) const
+    {
+        if (Contains(pindex))
+            return (*this)[pindex->nHeight + 1];
+        else
+            return NULL;
+    }
+
+    /** Return the maximal height in the chain, or -1 if it is empty. */
+    int Height() const
+    {
+        return pindexTip ? pindexTip->nHeight : -1;
+    }
+};
+
 #endif // BITCOIN_CHAIN_H
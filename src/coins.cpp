@@ -5,7 +5,9 @@
 
 #include "coins.h"
 
+#include "hash.h"
 #include "random.h"
+#include "version.h"
 
 #include <assert.h>
 
@@ -58,12 +60,78 @@ bool CCoins::Spend(int nPos)
     return Spend(out, undo);
 }
 
+/** The set element committed to for one unspent output */
+static uint256 GetCoinElementHash(const uint256& txid, unsigned int n, const CTxOut& out, int nHeight, bool fCoinBase)
+{
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << txid;
+    ss << VARINT(n);
+    ss << VARINT(nHeight * 2 + (fCoinBase ? 1 : 0));
+    ss << out;
+    return ss.GetHash();
+}
+
+/** Approximate chainstate footprint of one output: its compressed form as stored in CCoins */
+static int64_t GetCoinSerializedSize(const CTxOut& out)
+{
+    return ::GetSerializeSize(CTxOutCompressor(REF(out)), SER_DISK, PROTOCOL_VERSION);
+}
+
+void CCoinsRollingStats::AddTransaction()
+{
+    nTransactions++;
+    nSerializedSize += 32;
+}
+
+void CCoinsRollingStats::RemoveTransaction()
+{
+    nTransactions--;
+    nSerializedSize -= 32;
+}
+
+void CCoinsRollingStats::AddCoin(const uint256& txid, unsigned int n, const CTxOut& out, int nHeight, bool fCoinBase)
+{
+    nTransactionOutputs++;
+    nSerializedSize += GetCoinSerializedSize(out);
+    nTotalAmount += out.nValue;
+    muhash.Insert(GetCoinElementHash(txid, n, out, nHeight, fCoinBase));
+}
+
+void CCoinsRollingStats::RemoveCoin(const uint256& txid, unsigned int n, const CTxOut& out, int nHeight, bool fCoinBase)
+{
+    nTransactionOutputs--;
+    nSerializedSize -= GetCoinSerializedSize(out);
+    nTotalAmount -= out.nValue;
+    muhash.Remove(GetCoinElementHash(txid, n, out, nHeight, fCoinBase));
+}
+
+CCoinsRollingStats& CCoinsRollingStats::operator+=(const CCoinsRollingStats& delta)
+{
+    nTransactions += delta.nTransactions;
+    nTransactionOutputs += delta.nTransactionOutputs;
+    nSerializedSize += delta.nSerializedSize;
+    nTotalAmount += delta.nTotalAmount;
+    muhash *= delta.muhash;
+    return *this;
+}
+
+void CCoinsRollingStats::GetStats(CCoinsStats& stats) const
+{
+    stats.nTransactions = nTransactions;
+    stats.nTransactionOutputs = nTransactionOutputs;
+    stats.nSerializedSize = nSerializedSize;
+    stats.nTotalAmount = nTotalAmount;
+    stats.hashMuHash = muhash.Finalize();
+}
+
 
 bool CCoinsView::GetCoins(const uint256& txid, CCoins& coins) const { return false; }
 bool CCoinsView::HaveCoins(const uint256& txid) const { return false; }
 uint256 CCoinsView::GetBestBlock() const { return uint256(0); }
-bool CCoinsView::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) { return false; }
+bool CCoinsView::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDelta) { return false; }
 bool CCoinsView::GetStats(CCoinsStats& stats) const { return false; }
+bool CCoinsView::GetRollingStats(CCoinsRollingStats& stats) const { return false; }
+bool CCoinsView::GetHashSerialized(uint256& hash) const { return false; }
 
 
 CCoinsViewBacked::CCoinsViewBacked(CCoinsView* viewIn) : base(viewIn) {}
@@ -71,12 +139,14 @@ bool CCoinsViewBacked::GetCoins(const uint256& txid, CCoins& coins) const { retu
 bool CCoinsViewBacked::HaveCoins(const uint256& txid) const { return base->HaveCoins(txid); }
 uint256 CCoinsViewBacked::GetBestBlock() const { return base->GetBestBlock(); }
 void CCoinsViewBacked::SetBackend(CCoinsView& viewIn) { base = &viewIn; }
-bool CCoinsViewBacked::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) { return base->BatchWrite(mapCoins, hashBlock); }
+bool CCoinsViewBacked::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDelta) { return base->BatchWrite(mapCoins, hashBlock, statsDelta); }
 bool CCoinsViewBacked::GetStats(CCoinsStats& stats) const { return base->GetStats(stats); }
+bool CCoinsViewBacked::GetRollingStats(CCoinsRollingStats& stats) const { return base->GetRollingStats(stats); }
+bool CCoinsViewBacked::GetHashSerialized(uint256& hash) const { return base->GetHashSerialized(hash); }
 
 CCoinsKeyHasher::CCoinsKeyHasher() : salt(GetRandHash()) {}
 
-CCoinsViewCache::CCoinsViewCache(CCoinsView* baseIn) : CCoinsViewBacked(baseIn), hasModifier(false), hashBlock(0) {}
+CCoinsViewCache::CCoinsViewCache(CCoinsView* baseIn) : CCoinsViewBacked(baseIn), hasModifier(false), hashBlock(0), cachedCoinsUsage(0) {}
 
 CCoinsViewCache::~CCoinsViewCache()
 {
@@ -93,6 +163,7 @@ CCoinsMap::const_iterator CCoinsViewCache::FetchCoins(const uint256& txid) const
         return cacheCoins.end();
     CCoinsMap::iterator ret = cacheCoins.insert(std::make_pair(txid, CCoinsCacheEntry())).first;
     tmp.swap(ret->second.coins);
+    cachedCoinsUsage += ret->second.coins.DynamicMemoryUsage();
     if (ret->second.coins.IsPruned()) {
         // The parent only has an empty entry for this txid; we can consider our
         // version as fresh.
@@ -115,6 +186,7 @@ CCoinsModifier CCoinsViewCache::ModifyCoins(const uint256& txid)
 {
     assert(!hasModifier);
     std::pair<CCoinsMap::iterator, bool> ret = cacheCoins.insert(std::make_pair(txid, CCoinsCacheEntry()));
+    size_t cachedCoinUsage = 0;
     if (ret.second) {
         if (!base->GetCoins(txid, ret.first->second.coins)) {
             // The parent view does not have this entry; mark it as fresh.
@@ -124,10 +196,12 @@ CCoinsModifier CCoinsViewCache::ModifyCoins(const uint256& txid)
             // The parent view only has a pruned entry for this; mark it as fresh.
             ret.first->second.flags = CCoinsCacheEntry::FRESH;
         }
+    } else {
+        cachedCoinUsage = ret.first->second.coins.DynamicMemoryUsage();
     }
     // Assume that whenever ModifyCoins is called, the entry will be modified.
     ret.first->second.flags |= CCoinsCacheEntry::DIRTY;
-    return CCoinsModifier(*this, ret.first);
+    return CCoinsModifier(*this, ret.first, cachedCoinUsage);
 }
 
 const CCoins* CCoinsViewCache::AccessCoins(const uint256& txid) const
@@ -162,7 +236,7 @@ void CCoinsViewCache::SetBestBlock(const uint256& hashBlockIn)
     hashBlock = hashBlockIn;
 }
 
-bool CCoinsViewCache::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlockIn)
+bool CCoinsViewCache::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlockIn, const CCoinsRollingStats& statsDeltaIn)
 {
     assert(!hasModifier);
     for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
@@ -177,6 +251,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlockIn
                     assert(it->second.flags & CCoinsCacheEntry::FRESH);
                     CCoinsCacheEntry& entry = cacheCoins[it->first];
                     entry.coins.swap(it->second.coins);
+                    cachedCoinsUsage += entry.coins.DynamicMemoryUsage();
                     entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
                 }
             } else {
@@ -184,10 +259,13 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlockIn
                     // The grandparent does not have an entry, and the child is
                     // modified and being pruned. This means we can just delete
                     // it from the parent.
+                    cachedCoinsUsage -= itUs->second.coins.DynamicMemoryUsage();
                     cacheCoins.erase(itUs);
                 } else {
                     // A normal modification.
+                    cachedCoinsUsage -= itUs->second.coins.DynamicMemoryUsage();
                     itUs->second.coins.swap(it->second.coins);
+                    cachedCoinsUsage += itUs->second.coins.DynamicMemoryUsage();
                     itUs->second.flags |= CCoinsCacheEntry::DIRTY;
                 }
             }
@@ -196,21 +274,96 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlockIn
         mapCoins.erase(itOld);
     }
     hashBlock = hashBlockIn;
+    statsDelta += statsDeltaIn;
     return true;
 }
 
 bool CCoinsViewCache::Flush()
 {
-    bool fOk = base->BatchWrite(cacheCoins, hashBlock);
+    bool fOk = base->BatchWrite(cacheCoins, hashBlock, statsDelta);
     cacheCoins.clear();
+    cachedCoinsUsage = 0;
+    statsDelta.SetNull();
     return fOk;
 }
 
+bool CCoinsViewCache::Sync(size_t nTargetUsage)
+{
+    assert(!hasModifier);
+
+    // Modified entries go to the base: copied if they still fit in the cache, moved otherwise
+    CCoinsMap mapWrite;
+    size_t nKeptUsage = memusage::DynamicUsage(cacheCoins);
+    for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end();) {
+        if (!(it->second.flags & CCoinsCacheEntry::DIRTY)) {
+            it++;
+            continue;
+        }
+        size_t nUsage = it->second.coins.DynamicMemoryUsage();
+        CCoinsCacheEntry& entry = mapWrite[it->first];
+        entry.flags = it->second.flags;
+        if (it->second.coins.IsPruned() || nKeptUsage + nUsage > nTargetUsage) {
+            entry.coins.swap(it->second.coins);
+            cachedCoinsUsage -= nUsage;
+            cacheCoins.erase(it++);
+        } else {
+            entry.coins = it->second.coins;
+            nKeptUsage += nUsage;
+            it++;
+        }
+    }
+
+    // Unmodified entries only get the room the kept modified ones left over
+    for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end();) {
+        if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+            // once written, the base has exactly this version of the entry
+            it->second.flags = 0;
+            it++;
+            continue;
+        }
+        size_t nUsage = it->second.coins.DynamicMemoryUsage();
+        if (nKeptUsage + nUsage > nTargetUsage) {
+            cachedCoinsUsage -= nUsage;
+            cacheCoins.erase(it++);
+        } else {
+            nKeptUsage += nUsage;
+            it++;
+        }
+    }
+
+    bool fOk = base->BatchWrite(mapWrite, hashBlock, statsDelta);
+    statsDelta.SetNull();
+    return fOk;
+}
+
+bool CCoinsViewCache::GetRollingStats(CCoinsRollingStats& stats) const
+{
+    if (!base->GetRollingStats(stats))
+        return false;
+    stats += statsDelta;
+    return true;
+}
+
+bool CCoinsViewCache::GetStats(CCoinsStats& stats) const
+{
+    CCoinsRollingStats rolling;
+    if (!GetRollingStats(rolling))
+        return false;
+    stats.hashBlock = GetBestBlock();
+    rolling.GetStats(stats);
+    return true;
+}
+
 unsigned int CCoinsViewCache::GetCacheSize() const
 {
     return cacheCoins.size();
 }
 
+size_t CCoinsViewCache::DynamicMemoryUsage() const
+{
+    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
+}
+
 const CTxOut& CCoinsViewCache::GetOutputFor(const CTxIn& input) const
 {
     const CCoins* coins = AccessCoins(input.prevout.hash);
@@ -264,7 +417,7 @@ double CCoinsViewCache::GetPriority(const CTransaction& tx, int nHeight) const
     return tx.ComputePriority(dResult);
 }
 
-CCoinsModifier::CCoinsModifier(CCoinsViewCache& cache_, CCoinsMap::iterator it_) : cache(cache_), it(it_)
+CCoinsModifier::CCoinsModifier(CCoinsViewCache& cache_, CCoinsMap::iterator it_, size_t usage) : cache(cache_), it(it_), cachedCoinUsage(usage)
 {
     assert(!cache.hasModifier);
     cache.hasModifier = true;
@@ -275,7 +428,11 @@ CCoinsModifier::~CCoinsModifier()
     assert(cache.hasModifier);
     cache.hasModifier = false;
     it->second.coins.Cleanup();
+    cache.cachedCoinsUsage -= cachedCoinUsage; // Subtract the old usage
     if ((it->second.flags & CCoinsCacheEntry::FRESH) && it->second.coins.IsPruned()) {
         cache.cacheCoins.erase(it);
+    } else {
+        // If the coin still exists after the modification, add the new usage
+        cache.cachedCoinsUsage += it->second.coins.DynamicMemoryUsage();
     }
 }
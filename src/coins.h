@@ -7,6 +7,8 @@
 #define BITCOIN_COINS_H
 
 #include "compressor.h"
+#include "memusage.h"
+#include "muhash.h"
 #include "script/standard.h"
 #include "serialize.h"
 #include "uint256.h"
@@ -283,6 +285,15 @@ public:
                 return false;
         return true;
     }
+
+    size_t DynamicMemoryUsage() const
+    {
+        size_t ret = memusage::DynamicUsage(vout);
+        BOOST_FOREACH (const CTxOut& out, vout) {
+            ret += memusage::DynamicUsage(static_cast<const std::vector<unsigned char>&>(out.scriptPubKey));
+        }
+        return ret;
+    }
 };
 
 class CCoinsKeyHasher
@@ -325,9 +336,65 @@ struct CCoinsStats {
     uint64_t nTransactionOutputs;
     uint64_t nSerializedSize;
     uint256 hashSerialized;
+    uint256 hashMuHash;
     CAmount nTotalAmount;
 
-    CCoinsStats() : nHeight(0), hashBlock(0), nTransactions(0), nTransactionOutputs(0), nSerializedSize(0), hashSerialized(0), nTotalAmount(0) {}
+    CCoinsStats() : nHeight(0), hashBlock(0), nTransactions(0), nTransactionOutputs(0), nSerializedSize(0), hashSerialized(0), hashMuHash(0), nTotalAmount(0) {}
+};
+
+/**
+ * Running totals and rolling set hash of the unspent output set. Kept up to
+ * date while blocks are connected and disconnected, so that the statistics
+ * never require a scan of the coins database. Each CCoinsViewCache records
+ * the changes made through it as a delta which is pushed to its base on
+ * Flush(); CCoinsViewDB persists the result atomically with the coins.
+ */
+class CCoinsRollingStats
+{
+public:
+    int64_t nTransactions;
+    int64_t nTransactionOutputs;
+    int64_t nSerializedSize;
+    CAmount nTotalAmount;
+    CMuHash3072 muhash;
+
+    CCoinsRollingStats() { SetNull(); }
+
+    void SetNull()
+    {
+        nTransactions = 0;
+        nTransactionOutputs = 0;
+        nSerializedSize = 0;
+        nTotalAmount = 0;
+        muhash = CMuHash3072();
+    }
+
+    //! a transaction gained its first unspent output
+    void AddTransaction();
+
+    //! the last unspent output of a transaction was removed
+    void RemoveTransaction();
+
+    void AddCoin(const uint256& txid, unsigned int n, const CTxOut& out, int nHeight, bool fCoinBase);
+    void RemoveCoin(const uint256& txid, unsigned int n, const CTxOut& out, int nHeight, bool fCoinBase);
+
+    //! apply the changes recorded in another delta
+    CCoinsRollingStats& operator+=(const CCoinsRollingStats& delta);
+
+    //! fill the externally visible statistics
+    void GetStats(CCoinsStats& stats) const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(nTransactions);
+        READWRITE(nTransactionOutputs);
+        READWRITE(nSerializedSize);
+        READWRITE(nTotalAmount);
+        READWRITE(muhash);
+    }
 };
 
 
@@ -345,13 +412,19 @@ public:
     //! Retrieve the block hash whose state this CCoinsView currently represents
     virtual uint256 GetBestBlock() const;
 
-    //! Do a bulk modification (multiple CCoins changes + BestBlock change).
+    //! Do a bulk modification (multiple CCoins changes + BestBlock change + rolling statistics change).
     //! The passed mapCoins can be modified.
-    virtual bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock);
+    virtual bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDelta);
 
     //! Calculate statistics about the unspent transaction output set
     virtual bool GetStats(CCoinsStats& stats) const;
 
+    //! Retrieve the rolling statistics of the unspent transaction output set
+    virtual bool GetRollingStats(CCoinsRollingStats& stats) const;
+
+    //! Hash the serialized unspent transaction output set of the database by scanning it, flushed changes only
+    virtual bool GetHashSerialized(uint256& hash) const;
+
     //! As we use CCoinsViews polymorphically, have a virtual destructor
     virtual ~CCoinsView() {}
 };
@@ -369,8 +442,10 @@ public:
     bool HaveCoins(const uint256& txid) const;
     uint256 GetBestBlock() const;
     void SetBackend(CCoinsView& viewIn);
-    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock);
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDelta);
     bool GetStats(CCoinsStats& stats) const;
+    bool GetRollingStats(CCoinsRollingStats& stats) const;
+    bool GetHashSerialized(uint256& hash) const;
 };
 
 class CCoinsViewCache;
@@ -398,7 +473,8 @@ class CCoinsModifier
 private:
     CCoinsViewCache& cache;
     CCoinsMap::iterator it;
-    CCoinsModifier(CCoinsViewCache& cache_, CCoinsMap::iterator it_);
+    size_t cachedCoinUsage; // Cached memory usage of the CCoins object before modification
+    CCoinsModifier(CCoinsViewCache& cache_, CCoinsMap::iterator it_, size_t usage);
 
 public:
     CCoins* operator->() { return &it->second.coins; }
@@ -421,6 +497,12 @@ protected:
     mutable uint256 hashBlock;
     mutable CCoinsMap cacheCoins;
 
+    /* Changes to the rolling statistics not yet pushed to the base. */
+    CCoinsRollingStats statsDelta;
+
+    /* Cached dynamic memory usage for the inner CCoins objects. */
+    mutable size_t cachedCoinsUsage;
+
 public:
     CCoinsViewCache(CCoinsView* baseIn);
     ~CCoinsViewCache();
@@ -430,7 +512,16 @@ public:
     bool HaveCoins(const uint256& txid) const;
     uint256 GetBestBlock() const;
     void SetBestBlock(const uint256& hashBlock);
-    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock);
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDeltaIn);
+    bool GetStats(CCoinsStats& stats) const;
+    bool GetRollingStats(CCoinsRollingStats& stats) const;
+
+    /**
+     * Return the changes to the rolling statistics recorded in this cache.
+     * Callers that modify coins on behalf of the active chain (ConnectBlock,
+     * DisconnectBlock) must record every output they add or remove here.
+     */
+    CCoinsRollingStats& GetStatsDelta() { return statsDelta; }
 
     /**
      * Return a pointer to CCoins in the cache, or NULL if not found. This is
@@ -453,9 +544,21 @@ public:
      */
     bool Flush();
 
+    /**
+     * Push the modifications applied to this cache to its base like Flush(),
+     * but keep entries cached as unmodified ones, up to nTargetUsage bytes.
+     * Entries over that budget are handed to the base instead of copied, and
+     * unmodified ones are dropped, so the cache stays warm after a flush
+     * without growing past its limit.
+     */
+    bool Sync(size_t nTargetUsage);
+
     //! Calculate the size of the cache (in number of transactions)
     unsigned int GetCacheSize() const;
 
+    //! Calculate the size of the cache (in bytes)
+    size_t DynamicMemoryUsage() const;
+
     /** 
      * Amount of vitae coming in to a transaction
      * Note that lightweight clients may not know anything besides the hash of previous transactions,
@@ -0,0 +1,191 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Groestl-512 using AES-NI. Every row of the 8x16 byte state lives in its own
+// register, so SubBytes and ShiftBytes of a row are one pshufb (undoing the AES
+// ShiftRows and rotating the row at the same time) plus one aesenclast with a
+// zero key, and MixBytes is a handful of xors and byte-wise doublings.
+
+#ifdef ENABLE_AESNI
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+namespace
+{
+/** pshufb masks that make aesenclast rotate each row of P left by 0, 1, 2, 3, 4, 5, 6 and 11 bytes */
+alignas(16) const uint8_t SHIFT_P[8][16] = {
+    {0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3},
+    {1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3, 0, 13, 10, 7, 4},
+    {2, 15, 12, 9, 6, 3, 0, 13, 10, 7, 4, 1, 14, 11, 8, 5},
+    {3, 0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6},
+    {4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3, 0, 13, 10, 7},
+    {5, 2, 15, 12, 9, 6, 3, 0, 13, 10, 7, 4, 1, 14, 11, 8},
+    {6, 3, 0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9},
+    {11, 8, 5, 2, 15, 12, 9, 6, 3, 0, 13, 10, 7, 4, 1, 14},
+};
+
+/** pshufb masks that make aesenclast rotate each row of Q left by 1, 3, 5, 11, 0, 2, 4 and 6 bytes */
+alignas(16) const uint8_t SHIFT_Q[8][16] = {
+    {1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3, 0, 13, 10, 7, 4},
+    {3, 0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6},
+    {5, 2, 15, 12, 9, 6, 3, 0, 13, 10, 7, 4, 1, 14, 11, 8},
+    {11, 8, 5, 2, 15, 12, 9, 6, 3, 0, 13, 10, 7, 4, 1, 14},
+    {0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3},
+    {2, 15, 12, 9, 6, 3, 0, 13, 10, 7, 4, 1, 14, 11, 8, 5},
+    {4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3, 0, 13, 10, 7},
+    {6, 3, 0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9},
+};
+
+/** Column numbers shifted into the high nibble, the per-column part of the round constants */
+alignas(16) const uint8_t COLUMNS[16] = {
+    0x00, 0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x80, 0x90, 0xa0, 0xb0, 0xc0, 0xd0, 0xe0, 0xf0};
+
+const int ROUNDS = 14;
+
+inline __m128i Load(const uint8_t* p) { return _mm_load_si128((const __m128i*)p); }
+
+/** Multiply every byte by 2 in GF(2^8) */
+inline __attribute__((always_inline)) __m128i Double(__m128i x)
+{
+    __m128i carry = _mm_cmpgt_epi8(_mm_setzero_si128(), x);
+    return _mm_xor_si128(_mm_add_epi8(x, x), _mm_and_si128(carry, _mm_set1_epi8(0x1b)));
+}
+
+/** One row of MixBytes from the pairwise sums t[i] = a[i] ^ a[i+1] and three of the rows */
+inline __attribute__((always_inline)) __m128i MixRow(__m128i ti, __m128i ti3, __m128i ti4, __m128i ti6, __m128i ai2, __m128i ai5, __m128i ai7)
+{
+    const __m128i s4 = _mm_xor_si128(ti3, ti6);
+    const __m128i s2 = _mm_xor_si128(_mm_xor_si128(ti, ai2), _mm_xor_si128(ai5, ai7));
+    const __m128i s1 = _mm_xor_si128(ai2, _mm_xor_si128(ti4, ti6));
+    return _mm_xor_si128(s1, Double(_mm_xor_si128(s2, Double(s4))));
+}
+
+/**
+ * MixBytes: row i becomes 02*a[i] + 02*a[i+1] + 03*a[i+2] + 04*a[i+3] + 05*a[i+4]
+ * + 03*a[i+5] + 05*a[i+6] + 07*a[i+7], split by the 1, 2 and 4 terms of each
+ * coefficient so that only two doublings per row remain.
+ */
+inline __attribute__((always_inline)) void MixBytes(__m128i& a0, __m128i& a1, __m128i& a2, __m128i& a3, __m128i& a4, __m128i& a5, __m128i& a6, __m128i& a7)
+{
+    const __m128i t0 = _mm_xor_si128(a0, a1);
+    const __m128i t1 = _mm_xor_si128(a1, a2);
+    const __m128i t2 = _mm_xor_si128(a2, a3);
+    const __m128i t3 = _mm_xor_si128(a3, a4);
+    const __m128i t4 = _mm_xor_si128(a4, a5);
+    const __m128i t5 = _mm_xor_si128(a5, a6);
+    const __m128i t6 = _mm_xor_si128(a6, a7);
+    const __m128i t7 = _mm_xor_si128(a7, a0);
+    const __m128i b0 = MixRow(t0, t3, t4, t6, a2, a5, a7);
+    const __m128i b1 = MixRow(t1, t4, t5, t7, a3, a6, a0);
+    const __m128i b2 = MixRow(t2, t5, t6, t0, a4, a7, a1);
+    const __m128i b3 = MixRow(t3, t6, t7, t1, a5, a0, a2);
+    const __m128i b4 = MixRow(t4, t7, t0, t2, a6, a1, a3);
+    const __m128i b5 = MixRow(t5, t0, t1, t3, a7, a2, a4);
+    const __m128i b6 = MixRow(t6, t1, t2, t4, a0, a3, a5);
+    a7 = MixRow(t7, t2, t3, t5, a1, a4, a6);
+    a0 = b0;
+    a1 = b1;
+    a2 = b2;
+    a3 = b3;
+    a4 = b4;
+    a5 = b5;
+    a6 = b6;
+}
+
+/** SubBytes and ShiftBytes of one row */
+inline __attribute__((always_inline)) __m128i SubShift(__m128i x, const uint8_t* shift)
+{
+    return _mm_aesenclast_si128(_mm_shuffle_epi8(x, Load(shift)), _mm_setzero_si128());
+}
+
+void PermutationP(__m128i* a)
+{
+    const __m128i columns = Load(COLUMNS);
+    __m128i a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3], a4 = a[4], a5 = a[5], a6 = a[6], a7 = a[7];
+    for (int r = 0; r < ROUNDS; r++) {
+        a0 = SubShift(_mm_xor_si128(a0, _mm_xor_si128(columns, _mm_set1_epi8(r))), SHIFT_P[0]);
+        a1 = SubShift(a1, SHIFT_P[1]);
+        a2 = SubShift(a2, SHIFT_P[2]);
+        a3 = SubShift(a3, SHIFT_P[3]);
+        a4 = SubShift(a4, SHIFT_P[4]);
+        a5 = SubShift(a5, SHIFT_P[5]);
+        a6 = SubShift(a6, SHIFT_P[6]);
+        a7 = SubShift(a7, SHIFT_P[7]);
+        MixBytes(a0, a1, a2, a3, a4, a5, a6, a7);
+    }
+    a[0] = a0, a[1] = a1, a[2] = a2, a[3] = a3, a[4] = a4, a[5] = a5, a[6] = a6, a[7] = a7;
+}
+
+void PermutationQ(__m128i* a)
+{
+    const __m128i columns = Load(COLUMNS);
+    const __m128i ones = _mm_set1_epi8(-1);
+    __m128i a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3], a4 = a[4], a5 = a[5], a6 = a[6], a7 = a[7];
+    for (int r = 0; r < ROUNDS; r++) {
+        a0 = SubShift(_mm_xor_si128(a0, ones), SHIFT_Q[0]);
+        a1 = SubShift(_mm_xor_si128(a1, ones), SHIFT_Q[1]);
+        a2 = SubShift(_mm_xor_si128(a2, ones), SHIFT_Q[2]);
+        a3 = SubShift(_mm_xor_si128(a3, ones), SHIFT_Q[3]);
+        a4 = SubShift(_mm_xor_si128(a4, ones), SHIFT_Q[4]);
+        a5 = SubShift(_mm_xor_si128(a5, ones), SHIFT_Q[5]);
+        a6 = SubShift(_mm_xor_si128(a6, ones), SHIFT_Q[6]);
+        a7 = SubShift(_mm_xor_si128(a7, _mm_xor_si128(columns, _mm_set1_epi8(0xff ^ r))), SHIFT_Q[7]);
+        MixBytes(a0, a1, a2, a3, a4, a5, a6, a7);
+    }
+    a[0] = a0, a[1] = a1, a[2] = a2, a[3] = a3, a[4] = a4, a[5] = a5, a[6] = a6, a[7] = a7;
+}
+
+/** Load a column-major 128 byte block into one register per row */
+void ToRows(__m128i* a, const uint8_t* block)
+{
+    alignas(16) uint8_t rows[8][16];
+    for (int i = 0; i < 8; i++)
+        for (int j = 0; j < 16; j++)
+            rows[i][j] = block[8 * j + i];
+    for (int i = 0; i < 8; i++)
+        a[i] = Load(rows[i]);
+}
+} // namespace
+
+namespace groestl512_aesni
+{
+void Hash64(unsigned char* out, const unsigned char* in)
+{
+    // The message plus its padding (0x80, then a block count of one) fills exactly one block
+    uint8_t block[128] = {0};
+    memcpy(block, in, 64);
+    block[64] = 0x80;
+    block[127] = 0x01;
+
+    __m128i m[8], p[8], h[8];
+    ToRows(m, block);
+    for (int i = 0; i < 8; i++)
+        h[i] = _mm_setzero_si128();
+    // The initial value encodes the 512 bit output size in its last bytes
+    h[6] = _mm_insert_epi16(h[6], 0x02 << 8, 7);
+
+    // Compression: h = P(h ^ m) ^ Q(m) ^ h
+    for (int i = 0; i < 8; i++)
+        p[i] = _mm_xor_si128(h[i], m[i]);
+    PermutationP(p);
+    PermutationQ(m);
+    for (int i = 0; i < 8; i++)
+        h[i] = _mm_xor_si128(h[i], _mm_xor_si128(p[i], m[i]));
+
+    // Output transformation: the last 64 bytes of P(h) ^ h
+    for (int i = 0; i < 8; i++)
+        p[i] = h[i];
+    PermutationP(p);
+    alignas(16) uint8_t rows[8][16];
+    for (int i = 0; i < 8; i++)
+        _mm_store_si128((__m128i*)rows[i], _mm_xor_si128(p[i], h[i]));
+    for (int j = 8; j < 16; j++)
+        for (int i = 0; i < 8; i++)
+            out[8 * (j - 8) + i] = rows[i][j];
+}
+} // namespace groestl512_aesni
+
+#endif
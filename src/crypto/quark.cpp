@@ -0,0 +1,184 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include "config/vitae-config.h"
+#endif
+
+#include "crypto/quark.h"
+
+#include "crypto/sph_blake.h"
+#include "crypto/sph_bmw.h"
+#include "crypto/sph_groestl.h"
+#include "crypto/sph_jh.h"
+#include "crypto/sph_keccak.h"
+#include "crypto/sph_skein.h"
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#if defined(ENABLE_AESNI)
+namespace groestl512_aesni
+{
+void Hash64(unsigned char* out, const unsigned char* in);
+}
+#endif
+
+#if defined(__SSE2__)
+namespace jh512_sse2
+{
+void Hash64(unsigned char* out, const unsigned char* in);
+}
+#endif
+
+namespace
+{
+/** A 512-bit hash of a 64 byte message, the shape of every Quark stage after the first */
+typedef void (*Hash64Type)(unsigned char* out, const unsigned char* in);
+
+void Blake512(unsigned char* out, const unsigned char* in)
+{
+    sph_blake512_context ctx;
+    sph_blake512_init(&ctx);
+    sph_blake512(&ctx, in, 64);
+    sph_blake512_close(&ctx, out);
+}
+
+void Bmw512(unsigned char* out, const unsigned char* in)
+{
+    sph_bmw512_context ctx;
+    sph_bmw512_init(&ctx);
+    sph_bmw512(&ctx, in, 64);
+    sph_bmw512_close(&ctx, out);
+}
+
+void Groestl512(unsigned char* out, const unsigned char* in)
+{
+    sph_groestl512_context ctx;
+    sph_groestl512_init(&ctx);
+    sph_groestl512(&ctx, in, 64);
+    sph_groestl512_close(&ctx, out);
+}
+
+void JH512(unsigned char* out, const unsigned char* in)
+{
+    sph_jh512_context ctx;
+    sph_jh512_init(&ctx);
+    sph_jh512(&ctx, in, 64);
+    sph_jh512_close(&ctx, out);
+}
+
+void Keccak512(unsigned char* out, const unsigned char* in)
+{
+    sph_keccak512_context ctx;
+    sph_keccak512_init(&ctx);
+    sph_keccak512(&ctx, in, 64);
+    sph_keccak512_close(&ctx, out);
+}
+
+void Skein512(unsigned char* out, const unsigned char* in)
+{
+    sph_skein512_context ctx;
+    sph_skein512_init(&ctx);
+    sph_skein512(&ctx, in, 64);
+    sph_skein512_close(&ctx, out);
+}
+
+//! The implementations in use, selected by QuarkAutoDetect()
+Hash64Type Groestl512_64 = Groestl512;
+Hash64Type JH512_64 = JH512;
+
+/** Whether the branch after a stage takes its first option: bit 3 of the 512-bit little-endian result */
+inline bool Branch(const unsigned char* hash) { return hash[0] & 8; }
+
+/**
+ * Check the selected implementations against the sphlib code on a few messages,
+ * and the whole chain against a known answer.
+ */
+bool SelfTest()
+{
+    static const unsigned char knownQuark[32] = {
+        0xa2, 0x61, 0xc6, 0x4c, 0xb4, 0x2a, 0xef, 0xce, 0xd9, 0x9e, 0x43, 0x82, 0x65, 0xca, 0x82, 0xb1,
+        0x48, 0x6b, 0x34, 0xda, 0xa4, 0xbf, 0x0d, 0x9b, 0xc3, 0xcf, 0xc1, 0x19, 0xeb, 0x82, 0x69, 0xc6};
+    unsigned char in[80];
+    for (int i = 0; i < 80; i++)
+        in[i] = i * 7 + 1;
+
+    for (int i = 0; i < 8; i++) {
+        unsigned char expected[64], out[64];
+        Groestl512(expected, in + 2 * i);
+        Groestl512_64(out, in + 2 * i);
+        if (memcmp(out, expected, 64))
+            return false;
+        JH512(expected, in + 2 * i);
+        JH512_64(out, in + 2 * i);
+        if (memcmp(out, expected, 64))
+            return false;
+    }
+
+    unsigned char out[32];
+    QuarkHash(out, in, 80);
+    return memcmp(out, knownQuark, 32) == 0;
+}
+} // namespace
+
+std::string QuarkAutoDetect()
+{
+    std::string ret = "standard";
+#if defined(ENABLE_AESNI) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+    uint32_t eax, ebx, ecx, edx;
+    // The Groestl code shuffles bytes with SSSE3 pshufb as well
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && ((ecx >> 25) & 1) && ((ecx >> 9) & 1)) {
+        Groestl512_64 = groestl512_aesni::Hash64;
+        ret = "groestl(aesni)";
+    }
+#endif
+
+#if defined(__SSE2__)
+    JH512_64 = jh512_sse2::Hash64;
+    ret = (ret == "standard" ? "" : ret + ",") + "jh(sse2)";
+#endif
+
+    if (!SelfTest()) {
+        Groestl512_64 = Groestl512;
+        JH512_64 = JH512;
+        ret = "standard";
+        assert(SelfTest());
+    }
+    return ret;
+}
+
+void QuarkHash(unsigned char* out, const unsigned char* data, size_t len)
+{
+    unsigned char hash[9][64];
+
+    sph_blake512_context ctx_blake;
+    sph_blake512_init(&ctx_blake);
+    sph_blake512(&ctx_blake, data, len);
+    sph_blake512_close(&ctx_blake, hash[0]);
+
+    Bmw512(hash[1], hash[0]);
+    if (Branch(hash[1]))
+        Groestl512_64(hash[2], hash[1]);
+    else
+        Skein512(hash[2], hash[1]);
+    Groestl512_64(hash[3], hash[2]);
+    JH512_64(hash[4], hash[3]);
+    if (Branch(hash[4]))
+        Blake512(hash[5], hash[4]);
+    else
+        Bmw512(hash[5], hash[4]);
+    Keccak512(hash[6], hash[5]);
+    Skein512(hash[7], hash[6]);
+    if (Branch(hash[7]))
+        Keccak512(hash[8], hash[7]);
+    else
+        JH512_64(hash[8], hash[7]);
+
+    memcpy(out, hash[8], 32);
+}
@@ -0,0 +1,22 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_QUARK_H
+#define BITCOIN_CRYPTO_QUARK_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+/**
+ * Select the fastest implementations of the Quark building blocks the CPU
+ * supports (AES-NI Groestl, SSE2 JH) and self-test them. Call once at startup,
+ * before other threads hash anything. Returns a description of the choice.
+ */
+std::string QuarkAutoDetect();
+
+/** Compute the 256-bit Quark hash of len bytes at data into out. */
+void QuarkHash(unsigned char* out, const unsigned char* data, size_t len);
+
+#endif // BITCOIN_CRYPTO_QUARK_H
@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string>
 
 /** A hasher class for SHA-256. */
 class CSHA256
@@ -25,4 +26,18 @@ public:
     CSHA256& Reset();
 };
 
+/**
+ * Select the fastest SHA-256 implementation the CPU supports (SHA extensions,
+ * AVX2, SSE4.1) and self-test it. Call once at startup, before other threads
+ * hash anything. Returns a description of the implementation in use.
+ */
+std::string SHA256AutoDetect();
+
+/**
+ * Compute double SHA-256 of many 64-byte messages at once, e.g. the sibling
+ * pairs of a merkle tree level. The input holds 64 * blocks bytes, the output
+ * 32 * blocks bytes.
+ */
+void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
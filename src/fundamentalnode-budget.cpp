@@ -277,112 +277,39 @@ void CBudgetManager::SubmitFinalBudget()
 // CBudgetDB
 //
 
-CBudgetDB::CBudgetDB()
+CBudgetDB::CBudgetDB() : CCacheFile("budget.dat", "FundamentalnodeBudget")
 {
-    pathDB = GetDataDir() / "budget.dat";
-    strMagicMessage = "FundamentalnodeBudget";
 }
 
 bool CBudgetDB::Write(const CBudgetManager& objToSave)
 {
-    LOCK(objToSave.cs);
-
     int64_t nStart = GetTimeMillis();
 
-    // serialize, checksum data up to that point, then append checksum
-    CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-    ssObj << strMagicMessage;                   // fundamentalnode cache file specific magic message
-    ssObj << FLATDATA(Params().MessageStart()); // network specific magic number
-    ssObj << objToSave;
-    uint256 hash = Hash(ssObj.begin(), ssObj.end());
-    ssObj << hash;
-
-    // open output file, and associate with CAutoFile
-    FILE* file = fopen(pathDB.string().c_str(), "wb");
-    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("%s : Failed to open file %s", __func__, pathDB.string());
-
-    // Write and commit header, data
-    try {
-        fileout << ssObj;
-    } catch (const std::exception& e) {
-        return error("%s : Serialize or I/O error - %s", __func__, e.what());
-    }
-    fileout.fclose();
+    objToSave.WriteCache(*this);
+    if (!CCacheFile::Write())
+        return false;
 
     LogPrint("fnbudget","Written info to budget.dat  %dms\n", GetTimeMillis() - nStart);
 
     return true;
 }
 
-CBudgetDB::ReadResult CBudgetDB::Read(CBudgetManager& objToLoad, bool fDryRun)
+CBudgetDB::ReadResult CBudgetDB::Read(CBudgetManager& objToLoad)
 {
     LOCK(objToLoad.cs);
 
     int64_t nStart = GetTimeMillis();
-    // open input file, and associate with CAutoFile
-    FILE* file = fopen(pathDB.string().c_str(), "rb");
-    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        error("%s : Failed to open file %s", __func__, pathDB.string());
-        return FileError;
-    }
-
-    // use file size to size memory buffer
-    int fileSize = boost::filesystem::file_size(pathDB);
-    int dataSize = fileSize - sizeof(uint256);
-    // Don't try to resize to a negative number if file is small
-    if (dataSize < 0)
-        dataSize = 0;
-    vector<unsigned char> vchData;
-    vchData.resize(dataSize);
-    uint256 hashIn;
-
-    // read data and checksum from file
-    try {
-        filein.read((char*)&vchData[0], dataSize);
-        filein >> hashIn;
-    } catch (const std::exception& e) {
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return HashReadError;
-    }
-    filein.fclose();
-
-    CDataStream ssObj(vchData, SER_DISK, CLIENT_VERSION);
-
-    // verify stored checksum matches input data
-    uint256 hashTmp = Hash(ssObj.begin(), ssObj.end());
-    if (hashIn != hashTmp) {
-        error("%s : Checksum mismatch, data corrupted", __func__);
-        return IncorrectHash;
-    }
 
+    ReadResult result = Open();
+    if (result != Ok)
+        return result;
 
-    unsigned char pchMsgTmp[4];
-    std::string strMagicMessageTmp;
     try {
-        // de-serialize file header (fundamentalnode cache file specific magic message) and ..
-        ssObj >> strMagicMessageTmp;
-
-        // ... verify the message matches predefined one
-        if (strMagicMessage != strMagicMessageTmp) {
-            error("%s : Invalid fundamentalnode cache magic message", __func__);
-            return IncorrectMagicMessage;
-        }
-
-
-        // de-serialize file header (network specific magic number) and ..
-        ssObj >> FLATDATA(pchMsgTmp);
-
-        // ... verify the network matches ours
-        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
-            error("%s : Invalid network magic number", __func__);
-            return IncorrectMagicNumber;
-        }
-
         // de-serialize data into CBudgetManager object
-        ssObj >> objToLoad;
+        if (!objToLoad.ReadCache(*this)) {
+            objToLoad.Clear();
+            return IncorrectFormat;
+        }
     } catch (const std::exception& e) {
         objToLoad.Clear();
         error("%s : Deserialize or I/O error - %s", __func__, e.what());
@@ -391,12 +318,10 @@ CBudgetDB::ReadResult CBudgetDB::Read(CBudgetManager& objToLoad, bool fDryRun)
 
     LogPrint("fnbudget","Loaded info from budget.dat  %dms\n", GetTimeMillis() - nStart);
     LogPrint("fnbudget","  %s\n", objToLoad.ToString());
-    if (!fDryRun) {
-        LogPrint("fnbudget","Budget manager - cleaning....\n");
-        objToLoad.CheckAndRemove();
-        LogPrint("fnbudget","Budget manager - result:\n");
-        LogPrint("fnbudget","  %s\n", objToLoad.ToString());
-    }
+    LogPrint("fnbudget","Budget manager - cleaning....\n");
+    objToLoad.CheckAndRemove();
+    LogPrint("fnbudget","Budget manager - result:\n");
+    LogPrint("fnbudget","  %s\n", objToLoad.ToString());
 
     return Ok;
 }
@@ -406,10 +331,9 @@ void DumpBudgets()
     int64_t nStart = GetTimeMillis();
 
     CBudgetDB budgetdb;
-    CBudgetManager tempBudget;
 
     LogPrint("fnbudget","Verifying budget.dat format...\n");
-    CBudgetDB::ReadResult readResult = budgetdb.Read(tempBudget, true);
+    CBudgetDB::ReadResult readResult = budgetdb.Open();
     // there was an error and it was not an error on file opening => do not proceed
     if (readResult == CBudgetDB::FileError)
         LogPrint("fnbudget","Missing budgets file - budget.dat, will try to recreate\n");
@@ -428,6 +352,49 @@ void DumpBudgets()
     LogPrint("fnbudget","Budget dump finished  %dms\n", GetTimeMillis() - nStart);
 }
 
+void CBudgetManager::WriteCache(CCacheFile& file) const
+{
+    {
+        LOCK(cs);
+        file.AddChunk("seenproposals") << mapSeenFundamentalnodeBudgetProposals << mapSeenFundamentalnodeBudgetVotes;
+    }
+    {
+        LOCK(cs);
+        file.AddChunk("seenfinalized") << mapSeenFinalizedBudgets << mapSeenFinalizedBudgetVotes;
+    }
+    {
+        LOCK(cs);
+        file.AddChunk("orphanvotes") << mapOrphanFundamentalnodeBudgetVotes << mapOrphanFinalizedBudgetVotes;
+    }
+    {
+        LOCK(cs);
+        file.AddChunk("proposals") << mapProposals;
+    }
+    {
+        LOCK(cs);
+        file.AddChunk("finalized") << mapFinalizedBudgets;
+    }
+}
+
+bool CBudgetManager::ReadCache(const CCacheFile& file)
+{
+    CDataStream ssSeenProposals(SER_DISK, CLIENT_VERSION), ssSeenFinalized(SER_DISK, CLIENT_VERSION), ssOrphanVotes(SER_DISK, CLIENT_VERSION);
+    CDataStream ssProposals(SER_DISK, CLIENT_VERSION), ssFinalized(SER_DISK, CLIENT_VERSION);
+    if (!file.ReadChunk("seenproposals", ssSeenProposals) || !file.ReadChunk("seenfinalized", ssSeenFinalized) ||
+        !file.ReadChunk("orphanvotes", ssOrphanVotes) || !file.ReadChunk("proposals", ssProposals) ||
+        !file.ReadChunk("finalized", ssFinalized))
+        return false;
+
+    LOCK(cs);
+    ssSeenProposals >> mapSeenFundamentalnodeBudgetProposals >> mapSeenFundamentalnodeBudgetVotes;
+    ssSeenFinalized >> mapSeenFinalizedBudgets >> mapSeenFinalizedBudgetVotes;
+    ssOrphanVotes >> mapOrphanFundamentalnodeBudgetVotes >> mapOrphanFinalizedBudgetVotes;
+    ssProposals >> mapProposals;
+    ssFinalized >> mapFinalizedBudgets;
+    nProposalUpdates++;
+    return true;
+}
+
 bool CBudgetManager::AddFinalizedBudget(CFinalizedBudget& finalizedBudget)
 {
     std::string strError = "";
@@ -455,6 +422,7 @@ bool CBudgetManager::AddProposal(CBudgetProposal& budgetProposal)
     }
 
     mapProposals.insert(make_pair(budgetProposal.GetHash(), budgetProposal));
+    nProposalUpdates++;
     LogPrint("fnbudget","CBudgetManager::AddProposal - proposal %s added\n", budgetProposal.GetName ().c_str ());
     return true;
 }
@@ -525,6 +493,7 @@ void CBudgetManager::CheckAndRemove()
     // Remove invalid entries by overwriting complete map
     mapFinalizedBudgets.swap(tmpMapFinalizedBudgets);
     mapProposals.swap(tmpMapProposals);
+    nProposalUpdates++;
 
     // clang doesn't accept copy assignemnts :-/
     // mapFinalizedBudgets = tmpMapFinalizedBudgets;
@@ -742,16 +711,26 @@ TrxValidationStatus CBudgetManager::IsTransactionValid(const CTransaction& txNew
     return transactionStatus;
 }
 
+void CBudgetManager::CleanProposals()
+{
+    std::map<uint256, CBudgetProposal>::iterator it = mapProposals.begin();
+    while (it != mapProposals.end()) {
+        if ((*it).second.CleanAndRemove(false))
+            nProposalUpdates++;
+        ++it;
+    }
+}
+
 std::vector<CBudgetProposal*> CBudgetManager::GetAllProposals()
 {
     LOCK(cs);
 
     std::vector<CBudgetProposal*> vBudgetProposalRet;
 
+    CleanProposals();
+
     std::map<uint256, CBudgetProposal>::iterator it = mapProposals.begin();
     while (it != mapProposals.end()) {
-        (*it).second.CleanAndRemove(false);
-
         CBudgetProposal* pbudgetProposal = &((*it).second);
         vBudgetProposalRet.push_back(pbudgetProposal);
 
@@ -778,13 +757,32 @@ std::vector<CBudgetProposal*> CBudgetManager::GetBudget()
 {
     LOCK(cs);
 
+    CleanProposals();
+
+    CBlockIndex* pindexPrev = chainActive.Tip();
+    if (pindexPrev == NULL) return std::vector<CBudgetProposal*>();
+
+    // ------- Reuse the last result if nothing it depends on has changed
+
+    int nEnabled = mnodeman.CountEnabled(ActiveProtocol());
+    int nEstablished = 0;
+    std::map<uint256, CBudgetProposal>::iterator it = mapProposals.begin();
+    while (it != mapProposals.end()) {
+        if ((*it).second.IsEstablished()) nEstablished++;
+        ++it;
+    }
+
+    if (fBudgetCacheValid && nBudgetCacheUpdates == nProposalUpdates && nBudgetCacheHeight == pindexPrev->nHeight &&
+        nBudgetCacheEnabled == nEnabled && nBudgetCacheEstablished == nEstablished) {
+        return vBudgetCache;
+    }
+
     // ------- Sort budgets by Yes Count
 
     std::vector<std::pair<CBudgetProposal*, int> > vBudgetPorposalsSort;
 
-    std::map<uint256, CBudgetProposal>::iterator it = mapProposals.begin();
+    it = mapProposals.begin();
     while (it != mapProposals.end()) {
-        (*it).second.CleanAndRemove(false);
         vBudgetPorposalsSort.push_back(make_pair(&((*it).second), (*it).second.GetYeas() - (*it).second.GetNays()));
         ++it;
     }
@@ -796,8 +794,6 @@ std::vector<CBudgetProposal*> CBudgetManager::GetBudget()
     std::vector<CBudgetProposal*> vBudgetProposalsRet;
 
     CAmount nBudgetAllocated = 0;
-    CBlockIndex* pindexPrev = chainActive.Tip();
-    if (pindexPrev == NULL) return vBudgetProposalsRet;
 
     int nBlockStart = pindexPrev->nHeight - pindexPrev->nHeight % GetBudgetPaymentCycleBlocks() + GetBudgetPaymentCycleBlocks();
     int nBlockEnd = nBlockStart + GetBudgetPaymentCycleBlocks() - 1;
@@ -812,12 +808,12 @@ std::vector<CBudgetProposal*> CBudgetManager::GetBudget()
         //prop start/end should be inside this period
         if (pbudgetProposal->fValid && pbudgetProposal->nBlockStart <= nBlockStart &&
             pbudgetProposal->nBlockEnd >= nBlockEnd &&
-            pbudgetProposal->GetYeas() - pbudgetProposal->GetNays() > mnodeman.CountEnabled(ActiveProtocol()) / 10 &&
+            pbudgetProposal->GetYeas() - pbudgetProposal->GetNays() > nEnabled / 10 &&
             pbudgetProposal->IsEstablished()) {
 
             LogPrint("fnbudget","CBudgetManager::GetBudget() -   Check 1 passed: valid=%d | %ld <= %ld | %ld >= %ld | Yeas=%d Nays=%d Count=%d | established=%d\n",
                       pbudgetProposal->fValid, pbudgetProposal->nBlockStart, nBlockStart, pbudgetProposal->nBlockEnd,
-                      nBlockEnd, pbudgetProposal->GetYeas(), pbudgetProposal->GetNays(), mnodeman.CountEnabled(ActiveProtocol()) / 10,
+                      nBlockEnd, pbudgetProposal->GetYeas(), pbudgetProposal->GetNays(), nEnabled / 10,
                       pbudgetProposal->IsEstablished());
 
             if (pbudgetProposal->GetAmount() + nBudgetAllocated <= nTotalBudget) {
@@ -833,13 +829,20 @@ std::vector<CBudgetProposal*> CBudgetManager::GetBudget()
         else {
             LogPrint("fnbudget","CBudgetManager::GetBudget() -   Check 1 failed: valid=%d | %ld <= %ld | %ld >= %ld | Yeas=%d Nays=%d Count=%d | established=%d\n",
                       pbudgetProposal->fValid, pbudgetProposal->nBlockStart, nBlockStart, pbudgetProposal->nBlockEnd,
-                      nBlockEnd, pbudgetProposal->GetYeas(), pbudgetProposal->GetNays(), mnodeman.CountEnabled(ActiveProtocol()) / 10,
+                      nBlockEnd, pbudgetProposal->GetYeas(), pbudgetProposal->GetNays(), nEnabled / 10,
                       pbudgetProposal->IsEstablished());
         }
 
         ++it2;
     }
 
+    vBudgetCache = vBudgetProposalsRet;
+    fBudgetCacheValid = true;
+    nBudgetCacheUpdates = nProposalUpdates;
+    nBudgetCacheHeight = pindexPrev->nHeight;
+    nBudgetCacheEnabled = nEnabled;
+    nBudgetCacheEstablished = nEstablished;
+
     return vBudgetProposalsRet;
 }
 
@@ -970,11 +973,7 @@ void CBudgetManager::NewBlock()
     }
 
     LogPrint("fnbudget","CBudgetManager::NewBlock - mapProposals cleanup - size: %d\n", mapProposals.size());
-    std::map<uint256, CBudgetProposal>::iterator it2 = mapProposals.begin();
-    while (it2 != mapProposals.end()) {
-        (*it2).second.CleanAndRemove(false);
-        ++it2;
-    }
+    CleanProposals();
 
     LogPrint("fnbudget","CBudgetManager::NewBlock - mapFinalizedBudgets cleanup - size: %d\n", mapFinalizedBudgets.size());
     std::map<uint256, CFinalizedBudget>::iterator it3 = mapFinalizedBudgets.begin();
@@ -1384,8 +1383,11 @@ bool CBudgetManager::UpdateProposal(CBudgetVote& vote, CNode* pfrom, std::string
         return false;
     }
 
+    if (!mapProposals[vote.nProposalHash].AddOrUpdateVote(vote, strError))
+        return false;
 
-    return mapProposals[vote.nProposalHash].AddOrUpdateVote(vote, strError);
+    nProposalUpdates++;
+    return true;
 }
 
 bool CBudgetManager::UpdateFinalizedBudget(CFinalizedBudgetVote& vote, CNode* pfrom, std::string& strError)
@@ -1422,6 +1424,7 @@ CBudgetProposal::CBudgetProposal()
     nAmount = 0;
     nTime = 0;
     fValid = true;
+    CountVotes();
 }
 
 CBudgetProposal::CBudgetProposal(std::string strProposalNameIn, std::string strURLIn, int nBlockStartIn, int nBlockEndIn, CScript addressIn, CAmount nAmountIn, uint256 nFeeTXHashIn)
@@ -1434,6 +1437,7 @@ CBudgetProposal::CBudgetProposal(std::string strProposalNameIn, std::string strU
     nAmount = nAmountIn;
     nFeeTXHash = nFeeTXHashIn;
     fValid = true;
+    CountVotes();
 }
 
 CBudgetProposal::CBudgetProposal(const CBudgetProposal& other)
@@ -1448,6 +1452,7 @@ CBudgetProposal::CBudgetProposal(const CBudgetProposal& other)
     nFeeTXHash = other.nFeeTXHash;
     mapVotes = other.mapVotes;
     fValid = true;
+    CountVotes();
 }
 
 bool CBudgetProposal::IsValid(std::string& strError, bool fCheckCollateral)
@@ -1554,78 +1559,73 @@ bool CBudgetProposal::AddOrUpdateVote(CBudgetVote& vote, std::string& strError)
         return false;
     }
 
+    if (mapVotes.count(hash))
+        CountVote(mapVotes[hash], -1);
     mapVotes[hash] = vote;
+    // keep a fully checked proposal that way, CleanAndRemove would otherwise skip the new vote
+    if (nCheckedListVersion != -1)
+        mapVotes[hash].fValid = mapVotes[hash].SignatureValid(false);
+    CountVote(mapVotes[hash], 1);
     LogPrint("mnbudget", "CBudgetProposal::AddOrUpdateVote - %s %s\n", strAction.c_str(), vote.GetHash().ToString().c_str());
 
     return true;
 }
 
 // If fundamentalnode voted for a proposal, but is now invalid -- remove the vote
-void CBudgetProposal::CleanAndRemove(bool fSignatureCheck)
+bool CBudgetProposal::CleanAndRemove(bool fSignatureCheck)
 {
-    std::map<uint256, CBudgetVote>::iterator it = mapVotes.begin();
-
-    while (it != mapVotes.end()) {
-        (*it).second.fValid = (*it).second.SignatureValid(fSignatureCheck);
-        ++it;
-    }
-}
-
-double CBudgetProposal::GetRatio()
-{
-    int yeas = 0;
-    int nays = 0;
+    // without the signature check a vote only turns invalid or valid again when
+    // its fundamentalnode leaves or joins the list, so an unchanged list needs no recheck
+    int64_t nListVersion = mnodeman.GetListVersion();
+    if (!fSignatureCheck && nListVersion == nCheckedListVersion) return false;
 
+    bool fChanged = false;
     std::map<uint256, CBudgetVote>::iterator it = mapVotes.begin();
 
     while (it != mapVotes.end()) {
-        if ((*it).second.nVote == VOTE_YES) yeas++;
-        if ((*it).second.nVote == VOTE_NO) nays++;
+        bool fVoteValid = (*it).second.SignatureValid(fSignatureCheck);
+        if (fVoteValid != (*it).second.fValid) {
+            CountVote((*it).second, -1);
+            (*it).second.fValid = fVoteValid;
+            CountVote((*it).second, 1);
+            fChanged = true;
+        }
         ++it;
     }
 
-    if (yeas + nays == 0) return 0.0f;
-
-    return ((double)(yeas) / (double)(yeas + nays));
+    nCheckedListVersion = fSignatureCheck ? -1 : nListVersion;
+    return fChanged;
 }
 
-int CBudgetProposal::GetYeas()
+void CBudgetProposal::CountVote(const CBudgetVote& vote, int nDelta)
 {
-    int ret = 0;
+    if (vote.nVote == VOTE_YES) nAllYeas += nDelta;
+    if (vote.nVote == VOTE_NO) nAllNays += nDelta;
 
-    std::map<uint256, CBudgetVote>::iterator it = mapVotes.begin();
-    while (it != mapVotes.end()) {
-        if ((*it).second.nVote == VOTE_YES && (*it).second.fValid) ret++;
-        ++it;
-    }
+    if (!vote.fValid) return;
 
-    return ret;
+    if (vote.nVote == VOTE_YES) nYeas += nDelta;
+    if (vote.nVote == VOTE_NO) nNays += nDelta;
+    if (vote.nVote == VOTE_ABSTAIN) nAbstains += nDelta;
 }
 
-int CBudgetProposal::GetNays()
+void CBudgetProposal::CountVotes()
 {
-    int ret = 0;
+    nYeas = nNays = nAbstains = nAllYeas = nAllNays = 0;
+    nCheckedListVersion = -1;
 
     std::map<uint256, CBudgetVote>::iterator it = mapVotes.begin();
     while (it != mapVotes.end()) {
-        if ((*it).second.nVote == VOTE_NO && (*it).second.fValid) ret++;
+        CountVote((*it).second, 1);
         ++it;
     }
-
-    return ret;
 }
 
-int CBudgetProposal::GetAbstains()
+double CBudgetProposal::GetRatio()
 {
-    int ret = 0;
+    if (nAllYeas + nAllNays == 0) return 0.0f;
 
-    std::map<uint256, CBudgetVote>::iterator it = mapVotes.begin();
-    while (it != mapVotes.end()) {
-        if ((*it).second.nVote == VOTE_ABSTAIN && (*it).second.fValid) ret++;
-        ++it;
-    }
-
-    return ret;
+    return ((double)(nAllYeas) / (double)(nAllYeas + nAllNays));
 }
 
 int CBudgetProposal::GetBlockStartCycle()
@@ -1749,9 +1749,6 @@ bool CBudgetVote::Sign(CKey& keyFundamentalnode, CPubKey& pubKeyFundamentalnode)
 
 bool CBudgetVote::SignatureValid(bool fSignatureCheck)
 {
-    std::string errorMessage;
-    std::string strMessage = vin.prevout.ToStringShort() + nProposalHash.ToString() + boost::lexical_cast<std::string>(nVote) + boost::lexical_cast<std::string>(nTime);
-
     CFundamentalnode* pmn = mnodeman.Find(vin);
 
     if (pmn == NULL) {
@@ -1763,7 +1760,7 @@ bool CBudgetVote::SignatureValid(bool fSignatureCheck)
 
     if (!fSignatureCheck) return true;
 
-    if (!obfuScationSigner.VerifyMessage(pmn->pubKeyFundamentalnode, vchSig, strMessage, errorMessage)) {
+    if (!VerifySignature(pmn->pubKeyFundamentalnode)) {
         LogPrint("fnbudget","CBudgetVote::SignatureValid() - Verify message failed\n");
         return false;
     }
@@ -1771,6 +1768,14 @@ bool CBudgetVote::SignatureValid(bool fSignatureCheck)
     return true;
 }
 
+bool CBudgetVote::VerifySignature(const CPubKey& pubKeyFundamentalnode)
+{
+    std::string errorMessage;
+    std::string strMessage = vin.prevout.ToStringShort() + nProposalHash.ToString() + boost::lexical_cast<std::string>(nVote) + boost::lexical_cast<std::string>(nTime);
+
+    return obfuScationSigner.VerifyMessage(pubKeyFundamentalnode, vchSig, strMessage, errorMessage);
+}
+
 CFinalizedBudget::CFinalizedBudget()
 {
     strBudgetName = "";
@@ -2251,27 +2256,31 @@ bool CFinalizedBudgetVote::Sign(CKey& keyFundamentalnode, CPubKey& pubKeyFundame
 
 bool CFinalizedBudgetVote::SignatureValid(bool fSignatureCheck)
 {
-    std::string errorMessage;
-
-    std::string strMessage = vin.prevout.ToStringShort() + nBudgetHash.ToString() + boost::lexical_cast<std::string>(nTime);
-
     CFundamentalnode* pmn = mnodeman.Find(vin);
 
     if (pmn == NULL) {
-        LogPrint("fnbudget","CFinalizedBudgetVote::SignatureValid() - Unknown Fundamentalnode %s\n", strMessage);
+        LogPrint("fnbudget","CFinalizedBudgetVote::SignatureValid() - Unknown Fundamentalnode %s %s\n", vin.prevout.ToStringShort(), nBudgetHash.ToString());
         return false;
     }
 
     if (!fSignatureCheck) return true;
 
-    if (!obfuScationSigner.VerifyMessage(pmn->pubKeyFundamentalnode, vchSig, strMessage, errorMessage)) {
-        LogPrint("fnbudget","CFinalizedBudgetVote::SignatureValid() - Verify message failed %s %s\n", strMessage, errorMessage);
+    if (!VerifySignature(pmn->pubKeyFundamentalnode)) {
+        LogPrint("fnbudget","CFinalizedBudgetVote::SignatureValid() - Verify message failed %s %s\n", vin.prevout.ToStringShort(), nBudgetHash.ToString());
         return false;
     }
 
     return true;
 }
 
+bool CFinalizedBudgetVote::VerifySignature(const CPubKey& pubKeyFundamentalnode)
+{
+    std::string errorMessage;
+    std::string strMessage = vin.prevout.ToStringShort() + nBudgetHash.ToString() + boost::lexical_cast<std::string>(nTime);
+
+    return obfuScationSigner.VerifyMessage(pubKeyFundamentalnode, vchSig, strMessage, errorMessage);
+}
+
 std::string CBudgetManager::ToString() const
 {
     std::ostringstream info;
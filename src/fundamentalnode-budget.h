@@ -7,6 +7,7 @@
 #define FUNDAMENTALNODE_BUDGET_H
 
 #include "base58.h"
+#include "cachefile.h"
 #include "init.h"
 #include "key.h"
 #include "main.h"
@@ -76,6 +77,7 @@ public:
 
     bool Sign(CKey& keyFundamentalnode, CPubKey& pubKeyFundamentalnode);
     bool SignatureValid(bool fSignatureCheck);
+    bool VerifySignature(const CPubKey& pubKeyFundamentalnode);
     void Relay();
 
     std::string GetVoteString()
@@ -128,6 +130,7 @@ public:
 
     bool Sign(CKey& keyFundamentalnode, CPubKey& pubKeyFundamentalnode);
     bool SignatureValid(bool fSignatureCheck);
+    bool VerifySignature(const CPubKey& pubKeyFundamentalnode);
     void Relay();
 
     uint256 GetHash()
@@ -153,26 +156,12 @@ public:
 
 /** Save Budget Manager (budget.dat)
  */
-class CBudgetDB
+class CBudgetDB : public CCacheFile
 {
-private:
-    boost::filesystem::path pathDB;
-    std::string strMagicMessage;
-
 public:
-    enum ReadResult {
-        Ok,
-        FileError,
-        HashReadError,
-        IncorrectHash,
-        IncorrectMagicMessage,
-        IncorrectMagicNumber,
-        IncorrectFormat
-    };
-
     CBudgetDB();
     bool Write(const CBudgetManager& objToSave);
-    ReadResult Read(CBudgetManager& objToLoad, bool fDryRun = false);
+    ReadResult Read(CBudgetManager& objToLoad);
 };
 
 
@@ -186,6 +175,19 @@ private:
     // XX42    map<uint256, CTransaction> mapCollateral;
     map<uint256, uint256> mapCollateralTxids;
 
+    // bumped by every change to the proposals or their vote tallies
+    int64_t nProposalUpdates;
+
+    // last GetBudget() result and what it was computed from
+    std::vector<CBudgetProposal*> vBudgetCache;
+    bool fBudgetCacheValid;
+    int64_t nBudgetCacheUpdates;
+    int nBudgetCacheHeight;
+    int nBudgetCacheEnabled;
+    int nBudgetCacheEstablished;
+
+    void CleanProposals();
+
 public:
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -205,6 +207,8 @@ public:
     {
         mapProposals.clear();
         mapFinalizedBudgets.clear();
+        nProposalUpdates = 0;
+        fBudgetCacheValid = false;
     }
 
     void ClearSeen()
@@ -253,6 +257,7 @@ public:
 
         LogPrintf("Budget object cleared\n");
         mapProposals.clear();
+        nProposalUpdates++;
         mapFinalizedBudgets.clear();
         mapSeenFundamentalnodeBudgetProposals.clear();
         mapSeenFundamentalnodeBudgetVotes.clear();
@@ -264,6 +269,10 @@ public:
     void CheckAndRemove();
     std::string ToString() const;
 
+    // add the cache file chunks, locking for one chunk at a time
+    void WriteCache(CCacheFile& file) const;
+    // load the cache file chunks, false if one is missing or corrupted
+    bool ReadCache(const CCacheFile& file);
 
     ADD_SERIALIZE_METHODS;
 
@@ -279,6 +288,8 @@ public:
 
         READWRITE(mapProposals);
         READWRITE(mapFinalizedBudgets);
+        if (ser_action.ForRead())
+            nProposalUpdates++;
     }
 };
 
@@ -466,6 +477,19 @@ private:
     mutable CCriticalSection cs;
     CAmount nAlloted;
 
+protected:
+    // running tallies of mapVotes: valid votes by type, and yes/no votes regardless of validity for GetRatio()
+    int nYeas;
+    int nNays;
+    int nAbstains;
+    int nAllYeas;
+    int nAllNays;
+    // fundamentalnode list version the votes were last checked against, -1 if they need checking
+    int64_t nCheckedListVersion;
+
+    void CountVote(const CBudgetVote& vote, int nDelta);
+    void CountVotes();
+
 public:
     bool fValid;
     std::string strProposalName;
@@ -516,14 +540,15 @@ public:
     int GetBlockCurrentCycle();
     int GetBlockEndCycle();
     double GetRatio();
-    int GetYeas();
-    int GetNays();
-    int GetAbstains();
+    int GetYeas() { return nYeas; }
+    int GetNays() { return nNays; }
+    int GetAbstains() { return nAbstains; }
     CAmount GetAmount() { return nAmount; }
     void SetAllotted(CAmount nAllotedIn) { nAlloted = nAllotedIn; }
     CAmount GetAllotted() { return nAlloted; }
 
-    void CleanAndRemove(bool fSignatureCheck);
+    /// Recheck which votes count, returns whether any tally changed
+    bool CleanAndRemove(bool fSignatureCheck);
 
     uint256 GetHash()
     {
@@ -557,6 +582,8 @@ public:
 
         //for saving to the serialized db
         READWRITE(mapVotes);
+        if (ser_action.ForRead())
+            CountVotes();
     }
 };
 
@@ -585,6 +612,13 @@ public:
         swap(first.nTime, second.nTime);
         swap(first.nFeeTXHash, second.nFeeTXHash);
         first.mapVotes.swap(second.mapVotes);
+        // the tallies belong to mapVotes and go with it
+        swap(first.nYeas, second.nYeas);
+        swap(first.nNays, second.nNays);
+        swap(first.nAbstains, second.nAbstains);
+        swap(first.nAllYeas, second.nAllYeas);
+        swap(first.nAllNays, second.nAllNays);
+        swap(first.nCheckedListVersion, second.nCheckedListVersion);
     }
 
     CBudgetProposalBroadcast& operator=(CBudgetProposalBroadcast from)
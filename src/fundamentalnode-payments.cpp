@@ -32,121 +32,49 @@ CCriticalSection cs_mapFundamentalnodePayeeVotes;
 // CFundamentalnodePaymentDB
 //
 
-CFundamentalnodePaymentDB::CFundamentalnodePaymentDB()
+CFundamentalnodePaymentDB::CFundamentalnodePaymentDB() : CCacheFile("fnpayments.dat", "FundamentalnodePayments")
 {
-    pathDB = GetDataDir() / "fnpayments.dat";
-    strMagicMessage = "FundamentalnodePayments";
 }
 
 bool CFundamentalnodePaymentDB::Write(const CFundamentalnodePayments& objToSave)
 {
     int64_t nStart = GetTimeMillis();
 
-    // serialize, checksum data up to that point, then append checksum
-    CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-    ssObj << strMagicMessage;                   // fundamentalnode cache file specific magic message
-    ssObj << FLATDATA(Params().MessageStart()); // network specific magic number
-    ssObj << objToSave;
-    uint256 hash = Hash(ssObj.begin(), ssObj.end());
-    ssObj << hash;
-
-    // open output file, and associate with CAutoFile
-    FILE* file = fopen(pathDB.string().c_str(), "wb");
-    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("%s : Failed to open file %s", __func__, pathDB.string());
-
-    // Write and commit header, data
-    try {
-        fileout << ssObj;
-    } catch (const std::exception& e) {
-        return error("%s : Serialize or I/O error - %s", __func__, e.what());
-    }
-    fileout.fclose();
+    objToSave.WriteCache(*this);
+    if (!CCacheFile::Write())
+        return false;
 
-    LogPrint("fundamentalnode","Written info to mnpayments.dat  %dms\n", GetTimeMillis() - nStart);
+    LogPrint("fundamentalnode","Written info to fnpayments.dat  %dms\n", GetTimeMillis() - nStart);
 
     return true;
 }
 
-CFundamentalnodePaymentDB::ReadResult CFundamentalnodePaymentDB::Read(CFundamentalnodePayments& objToLoad, bool fDryRun)
+CFundamentalnodePaymentDB::ReadResult CFundamentalnodePaymentDB::Read(CFundamentalnodePayments& objToLoad)
 {
     int64_t nStart = GetTimeMillis();
-    // open input file, and associate with CAutoFile
-    FILE* file = fopen(pathDB.string().c_str(), "rb");
-    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        error("%s : Failed to open file %s", __func__, pathDB.string());
-        return FileError;
-    }
-
-    // use file size to size memory buffer
-    int fileSize = boost::filesystem::file_size(pathDB);
-    int dataSize = fileSize - sizeof(uint256);
-    // Don't try to resize to a negative number if file is small
-    if (dataSize < 0)
-        dataSize = 0;
-    vector<unsigned char> vchData;
-    vchData.resize(dataSize);
-    uint256 hashIn;
-
-    // read data and checksum from file
-    try {
-        filein.read((char*)&vchData[0], dataSize);
-        filein >> hashIn;
-    } catch (const std::exception& e) {
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return HashReadError;
-    }
-    filein.fclose();
-
-    CDataStream ssObj(vchData, SER_DISK, CLIENT_VERSION);
 
-    // verify stored checksum matches input data
-    uint256 hashTmp = Hash(ssObj.begin(), ssObj.end());
-    if (hashIn != hashTmp) {
-        error("%s : Checksum mismatch, data corrupted", __func__);
-        return IncorrectHash;
-    }
+    ReadResult result = Open();
+    if (result != Ok)
+        return result;
 
-    unsigned char pchMsgTmp[4];
-    std::string strMagicMessageTmp;
     try {
-        // de-serialize file header (fundamentalnode cache file specific magic message) and ..
-        ssObj >> strMagicMessageTmp;
-
-        // ... verify the message matches predefined one
-        if (strMagicMessage != strMagicMessageTmp) {
-            error("%s : Invalid fundamentalnode payement cache magic message", __func__);
-            return IncorrectMagicMessage;
-        }
-
-
-        // de-serialize file header (network specific magic number) and ..
-        ssObj >> FLATDATA(pchMsgTmp);
-
-        // ... verify the network matches ours
-        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
-            error("%s : Invalid network magic number", __func__);
-            return IncorrectMagicNumber;
-        }
-
         // de-serialize data into CFundamentalnodePayments object
-        ssObj >> objToLoad;
+        if (!objToLoad.ReadCache(*this)) {
+            objToLoad.Clear();
+            return IncorrectFormat;
+        }
     } catch (const std::exception& e) {
         objToLoad.Clear();
         error("%s : Deserialize or I/O error - %s", __func__, e.what());
         return IncorrectFormat;
     }
 
-    LogPrint("fundamentalnode","Loaded info from mnpayments.dat  %dms\n", GetTimeMillis() - nStart);
+    LogPrint("fundamentalnode","Loaded info from fnpayments.dat  %dms\n", GetTimeMillis() - nStart);
+    LogPrint("fundamentalnode","  %s\n", objToLoad.ToString());
+    LogPrint("fundamentalnode","Fundamentalnode payments manager - cleaning....\n");
+    objToLoad.CleanPaymentList();
+    LogPrint("fundamentalnode","Fundamentalnode payments manager - result:\n");
     LogPrint("fundamentalnode","  %s\n", objToLoad.ToString());
-    if (!fDryRun) {
-        LogPrint("fundamentalnode","Fundamentalnode payments manager - cleaning....\n");
-        objToLoad.CleanPaymentList();
-        LogPrint("fundamentalnode","Fundamentalnode payments manager - result:\n");
-        LogPrint("fundamentalnode","  %s\n", objToLoad.ToString());
-    }
 
     return Ok;
 }
@@ -156,15 +84,14 @@ void DumpFundamentalnodePayments()
     int64_t nStart = GetTimeMillis();
 
     CFundamentalnodePaymentDB paymentdb;
-    CFundamentalnodePayments tempPayments;
 
-    LogPrint("fundamentalnode","Verifying mnpayments.dat format...\n");
-    CFundamentalnodePaymentDB::ReadResult readResult = paymentdb.Read(tempPayments, true);
+    LogPrint("fundamentalnode","Verifying fnpayments.dat format...\n");
+    CFundamentalnodePaymentDB::ReadResult readResult = paymentdb.Open();
     // there was an error and it was not an error on file opening => do not proceed
     if (readResult == CFundamentalnodePaymentDB::FileError)
-        LogPrint("fundamentalnode","Missing budgets file - mnpayments.dat, will try to recreate\n");
+        LogPrint("fundamentalnode","Missing budgets file - fnpayments.dat, will try to recreate\n");
     else if (readResult != CFundamentalnodePaymentDB::Ok) {
-        LogPrint("fundamentalnode","Error reading mnpayments.dat: ");
+        LogPrint("fundamentalnode","Error reading fnpayments.dat: ");
         if (readResult == CFundamentalnodePaymentDB::IncorrectFormat)
             LogPrint("fundamentalnode","magic is ok but data has invalid format, will try to recreate\n");
         else {
@@ -172,12 +99,36 @@ void DumpFundamentalnodePayments()
             return;
         }
     }
-    LogPrint("fundamentalnode","Writting info to mnpayments.dat...\n");
+    LogPrint("fundamentalnode","Writting info to fnpayments.dat...\n");
     paymentdb.Write(fundamentalnodePayments);
 
     LogPrint("fundamentalnode","Budget dump finished  %dms\n", GetTimeMillis() - nStart);
 }
 
+void CFundamentalnodePayments::WriteCache(CCacheFile& file) const
+{
+    {
+        LOCK(cs_mapFundamentalnodePayeeVotes);
+        file.AddChunk("payeevotes") << mapFundamentalnodePayeeVotes;
+    }
+    {
+        LOCK(cs_mapFundamentalnodeBlocks);
+        file.AddChunk("blocks") << mapFundamentalnodeBlocks;
+    }
+}
+
+bool CFundamentalnodePayments::ReadCache(const CCacheFile& file)
+{
+    CDataStream ssPayeeVotes(SER_DISK, CLIENT_VERSION), ssBlocks(SER_DISK, CLIENT_VERSION);
+    if (!file.ReadChunk("payeevotes", ssPayeeVotes) || !file.ReadChunk("blocks", ssBlocks))
+        return false;
+
+    LOCK2(cs_mapFundamentalnodeBlocks, cs_mapFundamentalnodePayeeVotes);
+    ssPayeeVotes >> mapFundamentalnodePayeeVotes;
+    ssBlocks >> mapFundamentalnodeBlocks;
+    return true;
+}
+
 bool IsBlockValueValid(const CBlock& block, CAmount nExpectedValue, CAmount nMinted)
 {
     CBlockIndex* pindexPrev = chainActive.Tip();
@@ -973,12 +924,7 @@ bool CFundamentalnodePaymentWinner::SignatureValid()
     CFundamentalnode* pmn = mnodeman.Find(vinFundamentalnode);
 
     if (pmn != NULL) {
-        std::string strMessage = vinFundamentalnode.prevout.ToStringShort() +
-                                 boost::lexical_cast<std::string>(nBlockHeight) +
-                                 payee.ToString();
-
-        std::string errorMessage = "";
-        if (!obfuScationSigner.VerifyMessage(pmn->pubKeyFundamentalnode, vchSig, strMessage, errorMessage)) {
+        if (!VerifySignature(pmn->pubKeyFundamentalnode)) {
             return error("CFundamentalnodePaymentWinner::SignatureValid() - Got bad Fundamentalnode address signature %s\n", vinFundamentalnode.prevout.hash.ToString());
         }
 
@@ -988,6 +934,16 @@ bool CFundamentalnodePaymentWinner::SignatureValid()
     return false;
 }
 
+bool CFundamentalnodePaymentWinner::VerifySignature(const CPubKey& pubKeyFundamentalnode)
+{
+    std::string strMessage = vinFundamentalnode.prevout.ToStringShort() +
+                             boost::lexical_cast<std::string>(nBlockHeight) +
+                             payee.ToString();
+
+    std::string errorMessage = "";
+    return obfuScationSigner.VerifyMessage(pubKeyFundamentalnode, vchSig, strMessage, errorMessage);
+}
+
 void CFundamentalnodePayments::Sync(CNode* node, int nCountNeeded)
 {
     LOCK(cs_mapFundamentalnodePayeeVotes);
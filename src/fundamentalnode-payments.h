@@ -6,6 +6,7 @@
 #ifndef FUNDAMENTALNODE_PAYMENTS_H
 #define FUNDAMENTALNODE_PAYMENTS_H
 
+#include "cachefile.h"
 #include "key.h"
 #include "main.h"
 #include "fundamentalnode.h"
@@ -36,26 +37,12 @@ void DumpFundamentalnodePayments();
 
 /** Save Fundamentalnode Payment Data (fnpayments.dat)
  */
-class CFundamentalnodePaymentDB
+class CFundamentalnodePaymentDB : public CCacheFile
 {
-private:
-    boost::filesystem::path pathDB;
-    std::string strMagicMessage;
-
 public:
-    enum ReadResult {
-        Ok,
-        FileError,
-        HashReadError,
-        IncorrectHash,
-        IncorrectMagicMessage,
-        IncorrectMagicNumber,
-        IncorrectFormat
-    };
-
     CFundamentalnodePaymentDB();
     bool Write(const CFundamentalnodePayments& objToSave);
-    ReadResult Read(CFundamentalnodePayments& objToLoad, bool fDryRun = false);
+    ReadResult Read(CFundamentalnodePayments& objToLoad);
 };
 
 class CFundamentalnodePayee
@@ -195,6 +182,7 @@ public:
     bool Sign(CKey& keyFundamentalnode, CPubKey& pubKeyFundamentalnode);
     bool IsValid(CNode* pnode, std::string& strError);
     bool SignatureValid();
+    bool VerifySignature(const CPubKey& pubKeyFundamentalnode);
     void Relay();
 
     void AddPayee(CScript payeeIn)
@@ -288,6 +276,11 @@ public:
     int GetOldestBlock();
     int GetNewestBlock();
 
+    // add the cache file chunks, locking for one chunk at a time
+    void WriteCache(CCacheFile& file) const;
+    // load the cache file chunks, false if one is missing or corrupted
+    bool ReadCache(const CCacheFile& file);
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
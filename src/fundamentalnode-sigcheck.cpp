@@ -0,0 +1,104 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "fundamentalnode-sigcheck.h"
+
+#include "checkqueue.h"
+#include "fundamentalnode-budget.h"
+#include "fundamentalnode-payments.h"
+#include "fundamentalnode-sync.h"
+#include "fundamentalnode.h"
+#include "fundamentalnodeman.h"
+#include "main.h"
+#include "masternode.h"
+#include "masternodeman.h"
+#include "obfuscation.h"
+#include "util.h"
+
+#include <boost/lexical_cast.hpp>
+
+static CCheckQueue<CFundamentalnodeSigCheck> sigcheckqueue(16);
+
+bool CFundamentalnodeSigCheck::operator()()
+{
+    // nothing is logged here, a peer could otherwise flood the log from every worker
+    bool fValid = true;
+    try {
+        CPubKey pubKeyFundamentalnode;
+        std::string errorMessage;
+        if (strCommand == "fnb") {
+            CFundamentalnodeBroadcast fnb;
+            vRecv >> fnb;
+            fValid = fnb.CheckSignature(errorMessage);
+        } else if (strCommand == "fnp") {
+            CFundamentalnodePing fnp;
+            vRecv >> fnp;
+            if (mnodeman.GetPubKey(fnp.vin, pubKeyFundamentalnode))
+                fValid = fnp.CheckSignature(pubKeyFundamentalnode, errorMessage);
+        } else if (strCommand == "fnw") {
+            CFundamentalnodePaymentWinner winner;
+            vRecv >> winner;
+            if (mnodeman.GetPubKey(winner.vinFundamentalnode, pubKeyFundamentalnode))
+                fValid = winner.VerifySignature(pubKeyFundamentalnode);
+        } else if (strCommand == "fvote") {
+            CBudgetVote vote;
+            vRecv >> vote;
+            if (mnodeman.GetPubKey(vote.vin, pubKeyFundamentalnode))
+                fValid = vote.VerifySignature(pubKeyFundamentalnode);
+        } else if (strCommand == "fbvote") {
+            CFinalizedBudgetVote vote;
+            vRecv >> vote;
+            if (mnodeman.GetPubKey(vote.vin, pubKeyFundamentalnode))
+                fValid = vote.VerifySignature(pubKeyFundamentalnode);
+        } else if (strCommand == "mnw") {
+            CMasternodePaymentWinner winner;
+            vRecv >> winner;
+            fValid = masternodePayments.CheckSignature(winner);
+        } else if (strCommand == "mvote") {
+            CTxIn vin;
+            std::vector<unsigned char> vchSig;
+            int nVote;
+            vRecv >> vin >> vchSig >> nVote;
+            CPubKey pubKeyMasternode;
+            if (m_nodeman.GetPubKey(vin, pubKeyMasternode))
+                fValid = obfuScationSigner.VerifyMessage(pubKeyMasternode, vchSig, vin.ToString() + boost::lexical_cast<std::string>(nVote), errorMessage);
+        }
+    } catch (const std::exception& e) {
+        // malformed messages are rejected by ProcessMessage itself
+    }
+
+    if (pfValid)
+        *pfValid = fValid;
+
+    // a bad signature must not stop the rest of the batch from being checked
+    return true;
+}
+
+bool IsFundamentalnodeSigMessage(const std::string& strCommand)
+{
+    // the legacy masternode handlers ignore these during the initial block download instead
+    if (strCommand == "mnw")
+        return !IsInitialBlockDownload();
+    if (strCommand == "mvote")
+        return !fMNLiteMode && !IsInitialBlockDownload();
+
+    if (strCommand != "fnb" && strCommand != "fnp" && strCommand != "fnw" && strCommand != "fvote" && strCommand != "fbvote")
+        return false;
+
+    // ProcessMessage ignores these until the chain is synced, so don't spend time on them either
+    return !fLiteMode && fundamentalnodeSync.IsBlockchainSynced();
+}
+
+void CheckFundamentalnodeSignatures(std::vector<CFundamentalnodeSigCheck>& vChecks)
+{
+    CCheckQueueControl<CFundamentalnodeSigCheck> control(&sigcheckqueue);
+    control.Add(vChecks);
+    control.Wait();
+}
+
+void ThreadFundamentalnodeSigCheck()
+{
+    RenameThread("vitae-fnsigch");
+    sigcheckqueue.Thread();
+}
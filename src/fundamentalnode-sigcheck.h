@@ -0,0 +1,56 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef FUNDAMENTALNODE_SIGCHECK_H
+#define FUNDAMENTALNODE_SIGCHECK_H
+
+#include "streams.h"
+#include "version.h"
+
+#include <string>
+#include <vector>
+
+/** Maximum number of received messages whose signatures are checked in one batch */
+static const unsigned int MAX_FUNDAMENTALNODE_SIGCHECK_BATCH = 256;
+
+/**
+ * Signature check of one received fundamentalnode broadcast, ping, payment
+ * winner or budget vote, or of a legacy masternode payment winner or vote.
+ * It works on its own copy of the message and only
+ * fills the message signature cache, so that ProcessMessage later finds the
+ * result there instead of recovering the key on the message handler thread.
+ * Whether the message is accepted is still decided by ProcessMessage alone.
+ */
+class CFundamentalnodeSigCheck
+{
+private:
+    std::string strCommand;
+    CDataStream vRecv;
+    //! Set to false for a bad signature; unknown senders and malformed messages count as valid
+    bool* pfValid;
+
+public:
+    CFundamentalnodeSigCheck() : vRecv(SER_NETWORK, PROTOCOL_VERSION), pfValid(NULL) {}
+    CFundamentalnodeSigCheck(const std::string& strCommandIn, const CDataStream& vRecvIn, bool* pfValidIn = NULL) : strCommand(strCommandIn), vRecv(vRecvIn), pfValid(pfValidIn) {}
+
+    bool operator()();
+
+    void swap(CFundamentalnodeSigCheck& check)
+    {
+        strCommand.swap(check.strCommand);
+        std::swap(vRecv, check.vRecv);
+        std::swap(pfValid, check.pfValid);
+    }
+};
+
+/** Whether a message is one whose signature CFundamentalnodeSigCheck can check ahead of processing */
+bool IsFundamentalnodeSigMessage(const std::string& strCommand);
+
+/** Run a batch of checks on the signature check threads and wait until all are done */
+void CheckFundamentalnodeSignatures(std::vector<CFundamentalnodeSigCheck>& vChecks);
+
+/** Worker thread of the signature check queue */
+void ThreadFundamentalnodeSigCheck();
+
+#endif
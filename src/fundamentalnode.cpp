@@ -702,14 +702,19 @@ bool CFundamentalnodeBroadcast::VerifySignature()
 {
     std::string errorMessage;
 
-    if(!obfuScationSigner.VerifyMessage(pubKeyCollateralAddress, sig, GetNewStrMessage(), errorMessage)
-    		&& !obfuScationSigner.VerifyMessage(pubKeyCollateralAddress, sig, GetOldStrMessage(), errorMessage)) {
+    if (!CheckSignature(errorMessage)) {
         return error("CFundamentalnodeBroadcast::VerifySignature() - Error: %s\n", errorMessage);
     }
 
     return true;
 }
 
+bool CFundamentalnodeBroadcast::CheckSignature(std::string& errorMessage)
+{
+    return obfuScationSigner.VerifyMessage(pubKeyCollateralAddress, sig, GetNewStrMessage(), errorMessage) ||
+           obfuScationSigner.VerifyMessage(pubKeyCollateralAddress, sig, GetOldStrMessage(), errorMessage);
+}
+
 std::string CFundamentalnodeBroadcast::GetOldStrMessage()
 {
     std::string strMessage;
@@ -769,16 +774,21 @@ bool CFundamentalnodePing::Sign(CKey& keyFundamentalnode, CPubKey& pubKeyFundame
 }
 
 bool CFundamentalnodePing::VerifySignature(CPubKey& pubKeyFundamentalnode, int &nDos) {
-	std::string strMessage = vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
 	std::string errorMessage = "";
 
-	if(!obfuScationSigner.VerifyMessage(pubKeyFundamentalnode, vchSig, strMessage, errorMessage)){
+	if(!CheckSignature(pubKeyFundamentalnode, errorMessage)){
 		nDos = 33;
 		return error("CFundamentalnodePing::VerifySignature - Got bad Fundamentalnode ping signature %s Error: %s\n", vin.ToString(), errorMessage);
 	}
 	return true;
 }
 
+bool CFundamentalnodePing::CheckSignature(CPubKey& pubKeyFundamentalnode, std::string& errorMessage)
+{
+    std::string strMessage = vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+    return obfuScationSigner.VerifyMessage(pubKeyFundamentalnode, vchSig, strMessage, errorMessage);
+}
+
 bool CFundamentalnodePing::CheckAndUpdate(int& nDos, bool fRequireEnabled, bool fCheckSigTimeOnly)
 {
     if (sigTime > GetAdjustedTime() + 60 * 60) {
@@ -65,6 +65,8 @@ public:
     bool CheckAndUpdate(int& nDos, bool fRequireEnabled = true, bool fCheckSigTimeOnly = false);
     bool Sign(CKey& keyFundamentalnode, CPubKey& pubKeyFundamentalnode);
     bool VerifySignature(CPubKey& pubKeyFundamentalnode, int &nDos);
+    /// Signature check without logging, for the signature check threads
+    bool CheckSignature(CPubKey& pubKeyFundamentalnode, std::string& errorMessage);
     void Relay();
 
     uint256 GetHash()
@@ -297,6 +299,8 @@ public:
     bool CheckInputsAndAdd(int& nDos);
     bool Sign(CKey& keyCollateralAddress);
     bool VerifySignature();
+    /// Signature check without logging, for the signature check threads
+    bool CheckSignature(std::string& errorMessage);
     void Relay();
     std::string GetOldStrMessage();
     std::string GetNewStrMessage();
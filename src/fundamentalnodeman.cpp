@@ -46,122 +46,50 @@ struct CompareScoreMN {
 // CFundamentalnodeDB
 //
 
-CFundamentalnodeDB::CFundamentalnodeDB()
+CFundamentalnodeDB::CFundamentalnodeDB() : CCacheFile("fncache.dat", "FundamentalnodeCache")
 {
-    pathMN = GetDataDir() / "fncache.dat";
-    strMagicMessage = "FundamentalnodeCache";
 }
 
 bool CFundamentalnodeDB::Write(const CFundamentalnodeMan& mnodemanToSave)
 {
     int64_t nStart = GetTimeMillis();
 
-    // serialize, checksum data up to that point, then append checksum
-    CDataStream ssFundamentalnodes(SER_DISK, CLIENT_VERSION);
-    ssFundamentalnodes << strMagicMessage;                   // fundamentalnode cache file specific magic message
-    ssFundamentalnodes << FLATDATA(Params().MessageStart()); // network specific magic number
-    ssFundamentalnodes << mnodemanToSave;
-    uint256 hash = Hash(ssFundamentalnodes.begin(), ssFundamentalnodes.end());
-    ssFundamentalnodes << hash;
-
-    // open output file, and associate with CAutoFile
-    FILE* file = fopen(pathMN.string().c_str(), "wb");
-    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("%s : Failed to open file %s", __func__, pathMN.string());
-
-    // Write and commit header, data
-    try {
-        fileout << ssFundamentalnodes;
-    } catch (const std::exception& e) {
-        return error("%s : Serialize or I/O error - %s", __func__, e.what());
-    }
-    //    FileCommit(fileout);
-    fileout.fclose();
+    mnodemanToSave.WriteCache(*this);
+    if (!CCacheFile::Write())
+        return false;
 
-    LogPrint("fundamentalnode","Written info to mncache.dat  %dms\n", GetTimeMillis() - nStart);
+    LogPrint("fundamentalnode","Written info to fncache.dat  %dms\n", GetTimeMillis() - nStart);
     LogPrint("fundamentalnode","  %s\n", mnodemanToSave.ToString());
 
     return true;
 }
 
-CFundamentalnodeDB::ReadResult CFundamentalnodeDB::Read(CFundamentalnodeMan& mnodemanToLoad, bool fDryRun)
+CFundamentalnodeDB::ReadResult CFundamentalnodeDB::Read(CFundamentalnodeMan& mnodemanToLoad)
 {
     int64_t nStart = GetTimeMillis();
-    // open input file, and associate with CAutoFile
-    FILE* file = fopen(pathMN.string().c_str(), "rb");
-    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        error("%s : Failed to open file %s", __func__, pathMN.string());
-        return FileError;
-    }
-
-    // use file size to size memory buffer
-    int fileSize = boost::filesystem::file_size(pathMN);
-    int dataSize = fileSize - sizeof(uint256);
-    // Don't try to resize to a negative number if file is small
-    if (dataSize < 0)
-        dataSize = 0;
-    vector<unsigned char> vchData;
-    vchData.resize(dataSize);
-    uint256 hashIn;
-
-    // read data and checksum from file
-    try {
-        filein.read((char*)&vchData[0], dataSize);
-        filein >> hashIn;
-    } catch (const std::exception& e) {
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return HashReadError;
-    }
-    filein.fclose();
 
-    CDataStream ssFundamentalnodes(vchData, SER_DISK, CLIENT_VERSION);
+    ReadResult result = Open();
+    if (result != Ok)
+        return result;
 
-    // verify stored checksum matches input data
-    uint256 hashTmp = Hash(ssFundamentalnodes.begin(), ssFundamentalnodes.end());
-    if (hashIn != hashTmp) {
-        error("%s : Checksum mismatch, data corrupted", __func__);
-        return IncorrectHash;
-    }
-
-    unsigned char pchMsgTmp[4];
-    std::string strMagicMessageTmp;
     try {
-        // de-serialize file header (fundamentalnode cache file specific magic message) and ..
-
-        ssFundamentalnodes >> strMagicMessageTmp;
-
-        // ... verify the message matches predefined one
-        if (strMagicMessage != strMagicMessageTmp) {
-            error("%s : Invalid fundamentalnode cache magic message", __func__);
-            return IncorrectMagicMessage;
-        }
-
-        // de-serialize file header (network specific magic number) and ..
-        ssFundamentalnodes >> FLATDATA(pchMsgTmp);
-
-        // ... verify the network matches ours
-        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
-            error("%s : Invalid network magic number", __func__);
-            return IncorrectMagicNumber;
-        }
         // de-serialize data into CFundamentalnodeMan object
-        ssFundamentalnodes >> mnodemanToLoad;
+        if (!mnodemanToLoad.ReadCache(*this)) {
+            mnodemanToLoad.Clear();
+            return IncorrectFormat;
+        }
     } catch (const std::exception& e) {
         mnodemanToLoad.Clear();
         error("%s : Deserialize or I/O error - %s", __func__, e.what());
         return IncorrectFormat;
     }
 
-    LogPrint("fundamentalnode","Loaded info from mncache.dat  %dms\n", GetTimeMillis() - nStart);
+    LogPrint("fundamentalnode","Loaded info from fncache.dat  %dms\n", GetTimeMillis() - nStart);
+    LogPrint("fundamentalnode","  %s\n", mnodemanToLoad.ToString());
+    LogPrint("fundamentalnode","Fundamentalnode manager - cleaning....\n");
+    mnodemanToLoad.CheckAndRemove(true);
+    LogPrint("fundamentalnode","Fundamentalnode manager - result:\n");
     LogPrint("fundamentalnode","  %s\n", mnodemanToLoad.ToString());
-    if (!fDryRun) {
-        LogPrint("fundamentalnode","Fundamentalnode manager - cleaning....\n");
-        mnodemanToLoad.CheckAndRemove(true);
-        LogPrint("fundamentalnode","Fundamentalnode manager - result:\n");
-        LogPrint("fundamentalnode","  %s\n", mnodemanToLoad.ToString());
-    }
 
     return Ok;
 }
@@ -171,15 +99,14 @@ void DumpFundamentalnodes()
     int64_t nStart = GetTimeMillis();
 
     CFundamentalnodeDB mndb;
-    CFundamentalnodeMan tempMnodeman;
 
-    LogPrint("fundamentalnode","Verifying mncache.dat format...\n");
-    CFundamentalnodeDB::ReadResult readResult = mndb.Read(tempMnodeman, true);
+    LogPrint("fundamentalnode","Verifying fncache.dat format...\n");
+    CFundamentalnodeDB::ReadResult readResult = mndb.Open();
     // there was an error and it was not an error on file opening => do not proceed
     if (readResult == CFundamentalnodeDB::FileError)
-        LogPrint("fundamentalnode","Missing fundamentalnode cache file - mncache.dat, will try to recreate\n");
+        LogPrint("fundamentalnode","Missing fundamentalnode cache file - fncache.dat, will try to recreate\n");
     else if (readResult != CFundamentalnodeDB::Ok) {
-        LogPrint("fundamentalnode","Error reading mncache.dat: ");
+        LogPrint("fundamentalnode","Error reading fncache.dat: ");
         if (readResult == CFundamentalnodeDB::IncorrectFormat)
             LogPrint("fundamentalnode","magic is ok but data has invalid format, will try to recreate\n");
         else {
@@ -187,7 +114,7 @@ void DumpFundamentalnodes()
             return;
         }
     }
-    LogPrint("fundamentalnode","Writting info to mncache.dat...\n");
+    LogPrint("fundamentalnode","Writting info to fncache.dat...\n");
     mndb.Write(mnodeman);
 
     LogPrint("fundamentalnode","Fundamentalnode dump finished  %dms\n", GetTimeMillis() - nStart);
@@ -196,23 +123,91 @@ void DumpFundamentalnodes()
 CFundamentalnodeMan::CFundamentalnodeMan()
 {
     nDsqCount = 0;
+    nListVersion = 0;
 }
 
-bool CFundamentalnodeMan::Add(CFundamentalnode& mn)
+void CFundamentalnodeMan::WriteCache(CCacheFile& file) const
 {
+    std::vector<CFundamentalnode> vFundamentalnodes = CopyFundamentalnodes();
+    {
+        LOCK(cs);
+        file.AddChunk("list") << vFundamentalnodes << mAskedUsForFundamentalnodeList << mWeAskedForFundamentalnodeList << mWeAskedForFundamentalnodeListEntry << nDsqCount;
+    }
+    {
+        LOCK(cs);
+        file.AddChunk("seenbroadcasts") << mapSeenFundamentalnodeBroadcast;
+    }
+    {
+        LOCK(cs);
+        file.AddChunk("seenpings") << mapSeenFundamentalnodePing;
+    }
+}
+
+bool CFundamentalnodeMan::ReadCache(const CCacheFile& file)
+{
+    CDataStream ssList(SER_DISK, CLIENT_VERSION), ssBroadcasts(SER_DISK, CLIENT_VERSION), ssPings(SER_DISK, CLIENT_VERSION);
+    if (!file.ReadChunk("list", ssList) || !file.ReadChunk("seenbroadcasts", ssBroadcasts) || !file.ReadChunk("seenpings", ssPings))
+        return false;
+
+    std::vector<CFundamentalnode> vFundamentalnodes;
+    ssList >> vFundamentalnodes;
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        shards[i].vFundamentalnodes.clear();
+    }
+    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
+        CFundamentalnodeShard& shard = GetShard(mn.vin.prevout);
+        LOCK(shard.cs);
+        shard.vFundamentalnodes.push_back(mn);
+    }
+
     LOCK(cs);
+    ssList >> mAskedUsForFundamentalnodeList >> mWeAskedForFundamentalnodeList >> mWeAskedForFundamentalnodeListEntry >> nDsqCount;
+    nListVersion++;
+    ssBroadcasts >> mapSeenFundamentalnodeBroadcast;
+    ssPings >> mapSeenFundamentalnodePing;
+    return true;
+}
+
+std::vector<CFundamentalnode> CFundamentalnodeMan::CopyFundamentalnodes() const
+{
+    std::vector<CFundamentalnode> vFundamentalnodes;
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        vFundamentalnodes.insert(vFundamentalnodes.end(), shards[i].vFundamentalnodes.begin(), shards[i].vFundamentalnodes.end());
+    }
+    return vFundamentalnodes;
+}
 
+int CFundamentalnodeMan::size() const
+{
+    int nSize = 0;
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        nSize += shards[i].vFundamentalnodes.size();
+    }
+    return nSize;
+}
+
+bool CFundamentalnodeMan::Add(CFundamentalnode& mn)
+{
     if (!mn.IsEnabled())
         return false;
 
-    CFundamentalnode* pmn = Find(mn.vin);
-    if (pmn == NULL) {
-        LogPrint("fundamentalnode", "CFundamentalnodeMan: Adding new Fundamentalnode %s - %i now\n", mn.vin.prevout.hash.ToString(), size() + 1);
-        vFundamentalnodes.push_back(mn);
-        return true;
+    {
+        CFundamentalnodeShard& shard = GetShard(mn.vin.prevout);
+        LOCK(shard.cs);
+        if (Find(mn.vin) != NULL)
+            return false;
+        shard.vFundamentalnodes.push_back(mn);
+    }
+    {
+        LOCK(cs);
+        nListVersion++;
     }
 
-    return false;
+    LogPrint("fundamentalnode", "CFundamentalnodeMan: Adding new Fundamentalnode %s - %i now\n", mn.vin.prevout.hash.ToString(), size());
+    return true;
 }
 
 void CFundamentalnodeMan::AskForMN(CNode* pnode, CTxIn& vin)
@@ -233,55 +228,59 @@ void CFundamentalnodeMan::AskForMN(CNode* pnode, CTxIn& vin)
 
 void CFundamentalnodeMan::Check()
 {
-    LOCK(cs);
-
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        mn.Check();
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[i].vFundamentalnodes) {
+            mn.Check();
+        }
     }
 }
 
 void CFundamentalnodeMan::CheckAndRemove(bool forceExpiredRemoval)
 {
-    Check();
-
-    LOCK(cs);
+    int nMinProtocol = fundamentalnodePayments.GetMinFundamentalnodePaymentsProto();
+    std::vector<CTxIn> vRemoved;
 
     //remove inactive and outdated
-    vector<CFundamentalnode>::iterator it = vFundamentalnodes.begin();
-    while (it != vFundamentalnodes.end()) {
-        if ((*it).activeState == CFundamentalnode::FUNDAMENTALNODE_REMOVE ||
-            (*it).activeState == CFundamentalnode::FUNDAMENTALNODE_VIN_SPENT ||
-            (forceExpiredRemoval && (*it).activeState == CFundamentalnode::FUNDAMENTALNODE_EXPIRED) ||
-            (*it).protocolVersion < fundamentalnodePayments.GetMinFundamentalnodePaymentsProto()) {
-            LogPrint("fundamentalnode", "CFundamentalnodeMan: Removing inactive Fundamentalnode %s - %i now\n", (*it).vin.prevout.hash.ToString(), size() - 1);
-
-            //erase all of the broadcasts we've seen from this vin
-            // -- if we missed a few pings and the node was removed, this will allow is to get it back without them
-            //    sending a brand new fnb
-            map<uint256, CFundamentalnodeBroadcast>::iterator it3 = mapSeenFundamentalnodeBroadcast.begin();
-            while (it3 != mapSeenFundamentalnodeBroadcast.end()) {
-                if ((*it3).second.vin == (*it).vin) {
-                    fundamentalnodeSync.mapSeenSyncMNB.erase((*it3).first);
-                    mapSeenFundamentalnodeBroadcast.erase(it3++);
-                } else {
-                    ++it3;
-                }
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        vector<CFundamentalnode>::iterator it = shards[i].vFundamentalnodes.begin();
+        while (it != shards[i].vFundamentalnodes.end()) {
+            (*it).Check();
+            if ((*it).activeState == CFundamentalnode::FUNDAMENTALNODE_REMOVE ||
+                (*it).activeState == CFundamentalnode::FUNDAMENTALNODE_VIN_SPENT ||
+                (forceExpiredRemoval && (*it).activeState == CFundamentalnode::FUNDAMENTALNODE_EXPIRED) ||
+                (*it).protocolVersion < nMinProtocol) {
+                LogPrint("fundamentalnode", "CFundamentalnodeMan: Removing inactive Fundamentalnode %s\n", (*it).vin.prevout.hash.ToString());
+                vRemoved.push_back((*it).vin);
+                it = shards[i].vFundamentalnodes.erase(it);
+            } else {
+                ++it;
             }
+        }
+    }
 
-            // allow us to ask for this fundamentalnode again if we see another ping
-            map<COutPoint, int64_t>::iterator it2 = mWeAskedForFundamentalnodeListEntry.begin();
-            while (it2 != mWeAskedForFundamentalnodeListEntry.end()) {
-                if ((*it2).first == (*it).vin.prevout) {
-                    mWeAskedForFundamentalnodeListEntry.erase(it2++);
-                } else {
-                    ++it2;
-                }
-            }
+    LOCK(cs);
 
-            it = vFundamentalnodes.erase(it);
-        } else {
-            ++it;
+    if (!vRemoved.empty())
+        nListVersion++;
+
+    BOOST_FOREACH (const CTxIn& vin, vRemoved) {
+        //erase all of the broadcasts we've seen from this vin
+        // -- if we missed a few pings and the node was removed, this will allow is to get it back without them
+        //    sending a brand new fnb
+        map<uint256, CFundamentalnodeBroadcast>::iterator it3 = mapSeenFundamentalnodeBroadcast.begin();
+        while (it3 != mapSeenFundamentalnodeBroadcast.end()) {
+            if ((*it3).second.vin == vin) {
+                fundamentalnodeSync.mapSeenSyncMNB.erase((*it3).first);
+                mapSeenFundamentalnodeBroadcast.erase(it3++);
+            } else {
+                ++it3;
+            }
         }
+
+        // allow us to ask for this fundamentalnode again if we see another ping
+        mWeAskedForFundamentalnodeListEntry.erase(vin.prevout);
     }
 
     // check who's asked for the Fundamentalnode list
@@ -338,8 +337,13 @@ void CFundamentalnodeMan::CheckAndRemove(bool forceExpiredRemoval)
 
 void CFundamentalnodeMan::Clear()
 {
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        shards[i].vFundamentalnodes.clear();
+    }
+
     LOCK(cs);
-    vFundamentalnodes.clear();
+    nListVersion++;
     mAskedUsForFundamentalnodeList.clear();
     mWeAskedForFundamentalnodeList.clear();
     mWeAskedForFundamentalnodeListEntry.clear();
@@ -355,21 +359,24 @@ int CFundamentalnodeMan::stable_size ()
     int64_t nFundamentalnode_Min_Age = MN_WINNER_MINIMUM_AGE;
     int64_t nFundamentalnode_Age = 0;
 
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        if (mn.protocolVersion < nMinProtocol) {
-            continue; // Skip obsolete versions
-        }
-        if (IsSporkActive (SPORK_8_FUNDAMENTALNODE_PAYMENT_ENFORCEMENT)) {
-            nFundamentalnode_Age = GetAdjustedTime() - mn.sigTime;
-            if ((nFundamentalnode_Age) < nFundamentalnode_Min_Age) {
-                continue; // Skip fundamentalnodes younger than (default) 8000 sec (MUST be > FUNDAMENTALNODE_REMOVAL_SECONDS)
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[i].vFundamentalnodes) {
+            if (mn.protocolVersion < nMinProtocol) {
+                continue; // Skip obsolete versions
             }
-        }
-        mn.Check ();
-        if (!mn.IsEnabled ())
-            continue; // Skip not-enabled fundamentalnodes
+            if (IsSporkActive (SPORK_8_FUNDAMENTALNODE_PAYMENT_ENFORCEMENT)) {
+                nFundamentalnode_Age = GetAdjustedTime() - mn.sigTime;
+                if ((nFundamentalnode_Age) < nFundamentalnode_Min_Age) {
+                    continue; // Skip fundamentalnodes younger than (default) 8000 sec (MUST be > FUNDAMENTALNODE_REMOVAL_SECONDS)
+                }
+            }
+            mn.Check ();
+            if (!mn.IsEnabled ())
+                continue; // Skip not-enabled fundamentalnodes
 
-        nStable_size++;
+            nStable_size++;
+        }
     }
 
     return nStable_size;
@@ -380,10 +387,13 @@ int CFundamentalnodeMan::CountEnabled(int protocolVersion)
     int i = 0;
     protocolVersion = protocolVersion == -1 ? fundamentalnodePayments.GetMinFundamentalnodePaymentsProto() : protocolVersion;
 
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        mn.Check();
-        if (mn.protocolVersion < protocolVersion || !mn.IsEnabled()) continue;
-        i++;
+    for (int j = 0; j < FUNDAMENTALNODE_SHARDS; j++) {
+        LOCK(shards[j].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[j].vFundamentalnodes) {
+            mn.Check();
+            if (mn.protocolVersion < protocolVersion || !mn.IsEnabled()) continue;
+            i++;
+        }
     }
 
     return i;
@@ -393,8 +403,8 @@ void CFundamentalnodeMan::CountNetworks(int protocolVersion, int& ipv4, int& ipv
 {
     protocolVersion = protocolVersion == -1 ? fundamentalnodePayments.GetMinFundamentalnodePaymentsProto() : protocolVersion;
 
+    std::vector<CFundamentalnode> vFundamentalnodes = GetFullFundamentalnodeVector();
     BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        mn.Check();
         std::string strHost;
         int port;
         SplitHostPort(mn.addr.ToString(), port, strHost);
@@ -437,22 +447,25 @@ void CFundamentalnodeMan::DsegUpdate(CNode* pnode)
 
 CFundamentalnode* CFundamentalnodeMan::Find(const CScript& payee)
 {
-    LOCK(cs);
     CScript payee2;
 
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        payee2 = GetScriptForDestination(mn.pubKeyCollateralAddress.GetID());
-        if (payee2 == payee)
-            return &mn;
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[i].vFundamentalnodes) {
+            payee2 = GetScriptForDestination(mn.pubKeyCollateralAddress.GetID());
+            if (payee2 == payee)
+                return &mn;
+        }
     }
     return NULL;
 }
 
 CFundamentalnode* CFundamentalnodeMan::Find(const CTxIn& vin)
 {
-    LOCK(cs);
+    CFundamentalnodeShard& shard = GetShard(vin.prevout);
+    LOCK(shard.cs);
 
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
+    BOOST_FOREACH (CFundamentalnode& mn, shard.vFundamentalnodes) {
         if (mn.vin.prevout == vin.prevout)
             return &mn;
     }
@@ -460,13 +473,25 @@ CFundamentalnode* CFundamentalnodeMan::Find(const CTxIn& vin)
 }
 
 
-CFundamentalnode* CFundamentalnodeMan::Find(const CPubKey& pubKeyFundamentalnode)
+bool CFundamentalnodeMan::GetPubKey(const CTxIn& vin, CPubKey& pubKeyFundamentalnode)
 {
-    LOCK(cs);
+    LOCK(GetShard(vin.prevout).cs);
 
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        if (mn.pubKeyFundamentalnode == pubKeyFundamentalnode)
-            return &mn;
+    CFundamentalnode* pmn = Find(vin);
+    if (pmn == NULL)
+        return false;
+    pubKeyFundamentalnode = pmn->pubKeyFundamentalnode;
+    return true;
+}
+
+CFundamentalnode* CFundamentalnodeMan::Find(const CPubKey& pubKeyFundamentalnode)
+{
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[i].vFundamentalnodes) {
+            if (mn.pubKeyFundamentalnode == pubKeyFundamentalnode)
+                return &mn;
+        }
     }
     return NULL;
 }
@@ -476,8 +501,6 @@ CFundamentalnode* CFundamentalnodeMan::Find(const CPubKey& pubKeyFundamentalnode
 //
 CFundamentalnode* CFundamentalnodeMan::GetNextFundamentalnodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCount)
 {
-    LOCK(cs);
-
     CFundamentalnode* pBestFundamentalnode = NULL;
     std::vector<pair<int64_t, CTxIn> > vecFundamentalnodeLastPaid;
 
@@ -486,21 +509,31 @@ CFundamentalnode* CFundamentalnodeMan::GetNextFundamentalnodeInQueueForPayment(i
     */
 
     int nMnCount = CountEnabled();
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        mn.Check();
-        if (!mn.IsEnabled()) continue;
+    int nMinProtocol = fundamentalnodePayments.GetMinFundamentalnodePaymentsProto();
+    std::vector<CFundamentalnode> vecCandidates;
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[i].vFundamentalnodes) {
+            mn.Check();
+            if (!mn.IsEnabled()) continue;
 
-        // //check protocol version
-        if (mn.protocolVersion < fundamentalnodePayments.GetMinFundamentalnodePaymentsProto()) continue;
+            // //check protocol version
+            if (mn.protocolVersion < nMinProtocol) continue;
 
-        //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
-        if (fundamentalnodePayments.IsScheduled(mn, nBlockHeight)) continue;
+            //it's too new, wait for a cycle
+            if (fFilterSigTime && mn.sigTime + (nMnCount * 2.6 * 60) > GetAdjustedTime()) continue;
 
-        //it's too new, wait for a cycle
-        if (fFilterSigTime && mn.sigTime + (nMnCount * 2.6 * 60) > GetAdjustedTime()) continue;
+            //make sure it has as many confirmations as there are fundamentalnodes
+            if (mn.GetFundamentalnodeInputAge() < nMnCount) continue;
 
-        //make sure it has as many confirmations as there are fundamentalnodes
-        if (mn.GetFundamentalnodeInputAge() < nMnCount) continue;
+            vecCandidates.push_back(mn);
+        }
+    }
+
+    // the payment schedule and history lock the payments manager and count the list again, so no shard is held here
+    BOOST_FOREACH (CFundamentalnode& mn, vecCandidates) {
+        //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
+        if (fundamentalnodePayments.IsScheduled(mn, nBlockHeight)) continue;
 
         vecFundamentalnodeLastPaid.push_back(make_pair(mn.SecondsSincePayment(), mn.vin));
     }
@@ -537,8 +570,6 @@ CFundamentalnode* CFundamentalnodeMan::GetNextFundamentalnodeInQueueForPayment(i
 
 CFundamentalnode* CFundamentalnodeMan::FindRandomNotInVec(std::vector<CTxIn>& vecToExclude, int protocolVersion)
 {
-    LOCK(cs);
-
     protocolVersion = protocolVersion == -1 ? fundamentalnodePayments.GetMinFundamentalnodePaymentsProto() : protocolVersion;
 
     int nCountEnabled = CountEnabled(protocolVersion);
@@ -549,18 +580,21 @@ CFundamentalnode* CFundamentalnodeMan::FindRandomNotInVec(std::vector<CTxIn>& ve
     LogPrint("fundamentalnode", "CFundamentalnodeMan::FindRandomNotInVec - rand %d\n", rand);
     bool found;
 
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        if (mn.protocolVersion < protocolVersion || !mn.IsEnabled()) continue;
-        found = false;
-        BOOST_FOREACH (CTxIn& usedVin, vecToExclude) {
-            if (mn.vin.prevout == usedVin.prevout) {
-                found = true;
-                break;
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[i].vFundamentalnodes) {
+            if (mn.protocolVersion < protocolVersion || !mn.IsEnabled()) continue;
+            found = false;
+            BOOST_FOREACH (CTxIn& usedVin, vecToExclude) {
+                if (mn.vin.prevout == usedVin.prevout) {
+                    found = true;
+                    break;
+                }
+            }
+            if (found) continue;
+            if (--rand < 1) {
+                return &mn;
             }
-        }
-        if (found) continue;
-        if (--rand < 1) {
-            return &mn;
         }
     }
 
@@ -570,25 +604,28 @@ CFundamentalnode* CFundamentalnodeMan::FindRandomNotInVec(std::vector<CTxIn>& ve
 CFundamentalnode* CFundamentalnodeMan::GetCurrentFundamentalNode(int mod, int64_t nBlockHeight, int minProtocol)
 {
     int64_t score = 0;
-    CFundamentalnode* winner = NULL;
+    CTxIn vinWinner;
 
     // scan for winner
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        mn.Check();
-        if (mn.protocolVersion < minProtocol || !mn.IsEnabled()) continue;
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[i].vFundamentalnodes) {
+            mn.Check();
+            if (mn.protocolVersion < minProtocol || !mn.IsEnabled()) continue;
 
-        // calculate the score for each Fundamentalnode
-        uint256 n = mn.CalculateScore(mod, nBlockHeight);
-        int64_t n2 = n.GetCompact(false);
+            // calculate the score for each Fundamentalnode
+            uint256 n = mn.CalculateScore(mod, nBlockHeight);
+            int64_t n2 = n.GetCompact(false);
 
-        // determine the winner
-        if (n2 > score) {
-            score = n2;
-            winner = &mn;
+            // determine the winner
+            if (n2 > score) {
+                score = n2;
+                vinWinner = mn.vin;
+            }
         }
     }
 
-    return winner;
+    return score > 0 ? Find(vinWinner) : NULL;
 }
 
 int CFundamentalnodeMan::GetFundamentalnodeRank(const CTxIn& vin, int64_t nBlockHeight, int minProtocol, bool fOnlyActive)
@@ -602,27 +639,30 @@ int CFundamentalnodeMan::GetFundamentalnodeRank(const CTxIn& vin, int64_t nBlock
     if (!GetBlockHash(hash, nBlockHeight)) return -1;
 
     // scan for winner
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        if (mn.protocolVersion < minProtocol) {
-            LogPrint("fundamentalnode","Skipping Fundamentalnode with obsolete version %d\n", mn.protocolVersion);
-            continue;                                                       // Skip obsolete versions
-        }
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[i].vFundamentalnodes) {
+            if (mn.protocolVersion < minProtocol) {
+                LogPrint("fundamentalnode","Skipping Fundamentalnode with obsolete version %d\n", mn.protocolVersion);
+                continue;                                                       // Skip obsolete versions
+            }
 
-        if (IsSporkActive(SPORK_8_FUNDAMENTALNODE_PAYMENT_ENFORCEMENT)) {
-            nFundamentalnode_Age = GetAdjustedTime() - mn.sigTime;
-            if ((nFundamentalnode_Age) < nFundamentalnode_Min_Age) {
-                if (fDebug) LogPrint("fundamentalnode","Skipping just activated Fundamentalnode. Age: %ld\n", nFundamentalnode_Age);
-                continue;                                                   // Skip fundamentalnodes younger than (default) 1 hour
+            if (IsSporkActive(SPORK_8_FUNDAMENTALNODE_PAYMENT_ENFORCEMENT)) {
+                nFundamentalnode_Age = GetAdjustedTime() - mn.sigTime;
+                if ((nFundamentalnode_Age) < nFundamentalnode_Min_Age) {
+                    if (fDebug) LogPrint("fundamentalnode","Skipping just activated Fundamentalnode. Age: %ld\n", nFundamentalnode_Age);
+                    continue;                                                   // Skip fundamentalnodes younger than (default) 1 hour
+                }
             }
-        }
-        if (fOnlyActive) {
-            mn.Check();
-            if (!mn.IsEnabled()) continue;
-        }
-        uint256 n = mn.CalculateScore(1, nBlockHeight);
-        int64_t n2 = n.GetCompact(false);
+            if (fOnlyActive) {
+                mn.Check();
+                if (!mn.IsEnabled()) continue;
+            }
+            uint256 n = mn.CalculateScore(1, nBlockHeight);
+            int64_t n2 = n.GetCompact(false);
 
-        vecFundamentalnodeScores.push_back(make_pair(n2, mn.vin));
+            vecFundamentalnodeScores.push_back(make_pair(n2, mn.vin));
+        }
     }
 
     sort(vecFundamentalnodeScores.rbegin(), vecFundamentalnodeScores.rend(), CompareScoreTxIn());
@@ -648,20 +688,23 @@ std::vector<pair<int, CFundamentalnode> > CFundamentalnodeMan::GetFundamentalnod
     if (!GetBlockHash(hash, nBlockHeight)) return vecFundamentalnodeRanks;
 
     // scan for winner
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        mn.Check();
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[i].vFundamentalnodes) {
+            mn.Check();
 
-        if (mn.protocolVersion < minProtocol) continue;
+            if (mn.protocolVersion < minProtocol) continue;
 
-        if (!mn.IsEnabled()) {
-            vecFundamentalnodeScores.push_back(make_pair(9999, mn));
-            continue;
-        }
+            if (!mn.IsEnabled()) {
+                vecFundamentalnodeScores.push_back(make_pair(9999, mn));
+                continue;
+            }
 
-        uint256 n = mn.CalculateScore(1, nBlockHeight);
-        int64_t n2 = n.GetCompact(false);
+            uint256 n = mn.CalculateScore(1, nBlockHeight);
+            int64_t n2 = n.GetCompact(false);
 
-        vecFundamentalnodeScores.push_back(make_pair(n2, mn));
+            vecFundamentalnodeScores.push_back(make_pair(n2, mn));
+        }
     }
 
     sort(vecFundamentalnodeScores.rbegin(), vecFundamentalnodeScores.rend(), CompareScoreMN());
@@ -680,17 +723,20 @@ CFundamentalnode* CFundamentalnodeMan::GetFundamentalnodeByRank(int nRank, int64
     std::vector<pair<int64_t, CTxIn> > vecFundamentalnodeScores;
 
     // scan for winner
-    BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
-        if (mn.protocolVersion < minProtocol) continue;
-        if (fOnlyActive) {
-            mn.Check();
-            if (!mn.IsEnabled()) continue;
-        }
+    for (int i = 0; i < FUNDAMENTALNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CFundamentalnode& mn, shards[i].vFundamentalnodes) {
+            if (mn.protocolVersion < minProtocol) continue;
+            if (fOnlyActive) {
+                mn.Check();
+                if (!mn.IsEnabled()) continue;
+            }
 
-        uint256 n = mn.CalculateScore(1, nBlockHeight);
-        int64_t n2 = n.GetCompact(false);
+            uint256 n = mn.CalculateScore(1, nBlockHeight);
+            int64_t n2 = n.GetCompact(false);
 
-        vecFundamentalnodeScores.push_back(make_pair(n2, mn.vin));
+            vecFundamentalnodeScores.push_back(make_pair(n2, mn.vin));
+        }
     }
 
     sort(vecFundamentalnodeScores.rbegin(), vecFundamentalnodeScores.rend(), CompareScoreTxIn());
@@ -825,6 +871,7 @@ void CFundamentalnodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand,
 
         int nInvCount = 0;
 
+        std::vector<CFundamentalnode> vFundamentalnodes = CopyFundamentalnodes();
         BOOST_FOREACH (CFundamentalnode& mn, vFundamentalnodes) {
             if (mn.addr.IsRFC1918()) continue; //local network
 
@@ -1140,16 +1187,26 @@ void CFundamentalnodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand,
 
 void CFundamentalnodeMan::Remove(CTxIn vin)
 {
-    LOCK(cs);
-
-    vector<CFundamentalnode>::iterator it = vFundamentalnodes.begin();
-    while (it != vFundamentalnodes.end()) {
-        if ((*it).vin == vin) {
-            LogPrint("fundamentalnode", "CFundamentalnodeMan: Removing Fundamentalnode %s - %i now\n", (*it).vin.prevout.hash.ToString(), size() - 1);
-            vFundamentalnodes.erase(it);
-            break;
+    bool fRemoved = false;
+    {
+        CFundamentalnodeShard& shard = GetShard(vin.prevout);
+        LOCK(shard.cs);
+
+        vector<CFundamentalnode>::iterator it = shard.vFundamentalnodes.begin();
+        while (it != shard.vFundamentalnodes.end()) {
+            if ((*it).vin == vin) {
+                LogPrint("fundamentalnode", "CFundamentalnodeMan: Removing Fundamentalnode %s\n", (*it).vin.prevout.hash.ToString());
+                shard.vFundamentalnodes.erase(it);
+                fRemoved = true;
+                break;
+            }
+            ++it;
         }
-        ++it;
+    }
+
+    if (fRemoved) {
+        LOCK(cs);
+        nListVersion++;
     }
 }
 
@@ -1174,7 +1231,7 @@ std::string CFundamentalnodeMan::ToString() const
 {
     std::ostringstream info;
 
-    info << "Fundamentalnodes: " << (int)vFundamentalnodes.size() << ", peers who asked us for Fundamentalnode list: " << (int)mAskedUsForFundamentalnodeList.size() << ", peers we asked for Fundamentalnode list: " << (int)mWeAskedForFundamentalnodeList.size() << ", entries in Fundamentalnode list we asked for: " << (int)mWeAskedForFundamentalnodeListEntry.size() << ", nDsqCount: " << (int)nDsqCount;
+    info << "Fundamentalnodes: " << size() << ", peers who asked us for Fundamentalnode list: " << (int)mAskedUsForFundamentalnodeList.size() << ", peers we asked for Fundamentalnode list: " << (int)mWeAskedForFundamentalnodeList.size() << ", entries in Fundamentalnode list we asked for: " << (int)mWeAskedForFundamentalnodeListEntry.size() << ", nDsqCount: " << (int)nDsqCount;
 
     return info.str();
 }
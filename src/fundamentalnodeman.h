@@ -7,6 +7,7 @@
 #define FUNDAMENTALNODEMAN_H
 
 #include "base58.h"
+#include "cachefile.h"
 #include "key.h"
 #include "main.h"
 #include "fundamentalnode.h"
@@ -16,6 +17,7 @@
 
 #define FUNDAMENTALNODES_DUMP_SECONDS (15 * 60)
 #define FUNDAMENTALNODES_DSEG_SECONDS (3 * 60 * 60)
+#define FUNDAMENTALNODE_SHARDS 16
 
 using namespace std;
 
@@ -24,28 +26,14 @@ class CFundamentalnodeMan;
 extern CFundamentalnodeMan mnodeman;
 void DumpFundamentalnodes();
 
-/** Access to the MN database (mncache.dat)
+/** Access to the MN database (fncache.dat)
  */
-class CFundamentalnodeDB
+class CFundamentalnodeDB : public CCacheFile
 {
-private:
-    boost::filesystem::path pathMN;
-    std::string strMagicMessage;
-
 public:
-    enum ReadResult {
-        Ok,
-        FileError,
-        HashReadError,
-        IncorrectHash,
-        IncorrectMagicMessage,
-        IncorrectMagicNumber,
-        IncorrectFormat
-    };
-
     CFundamentalnodeDB();
     bool Write(const CFundamentalnodeMan& mnodemanToSave);
-    ReadResult Read(CFundamentalnodeMan& mnodemanToLoad, bool fDryRun = false);
+    ReadResult Read(CFundamentalnodeMan& mnodemanToLoad);
 };
 
 class CFundamentalnodeMan
@@ -57,8 +45,18 @@ private:
     // critical section to protect the inner data structures specifically on messaging
     mutable CCriticalSection cs_process_message;
 
-    // map to hold all MNs
-    std::vector<CFundamentalnode> vFundamentalnodes;
+    // One part of the list, guarded by its own lock. Shard locks are always taken
+    // last: while one is held nothing may lock cs or another shard, so that
+    // lookups, ranking and cleanup of different entries don't wait on each other.
+    struct CFundamentalnodeShard {
+        mutable CCriticalSection cs;
+        std::vector<CFundamentalnode> vFundamentalnodes;
+    };
+
+    // all MNs, split by collateral outpoint
+    CFundamentalnodeShard shards[FUNDAMENTALNODE_SHARDS];
+    // bumped whenever an entry is added to or removed from the list
+    int64_t nListVersion;
     // who's asked for the Fundamentalnode list and the last time
     std::map<CNetAddr, int64_t> mAskedUsForFundamentalnodeList;
     // who we asked for the Fundamentalnode list and the last time
@@ -66,6 +64,14 @@ private:
     // which Fundamentalnodes we've asked for
     std::map<COutPoint, int64_t> mWeAskedForFundamentalnodeListEntry;
 
+    CFundamentalnodeShard& GetShard(const COutPoint& outpoint)
+    {
+        return shards[(outpoint.hash.Get64() + outpoint.n) % FUNDAMENTALNODE_SHARDS];
+    }
+
+    /// Copy the entries of all shards, locking one shard at a time
+    std::vector<CFundamentalnode> CopyFundamentalnodes() const;
+
 public:
     // Keep track of all broadcasts I've seen
     map<uint256, CFundamentalnodeBroadcast> mapSeenFundamentalnodeBroadcast;
@@ -75,25 +81,15 @@ public:
     // keep track of dsq count to prevent fundamentalnodes from gaming obfuscation queue
     int64_t nDsqCount;
 
-    ADD_SERIALIZE_METHODS;
-
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
-    {
-        LOCK(cs);
-        READWRITE(vFundamentalnodes);
-        READWRITE(mAskedUsForFundamentalnodeList);
-        READWRITE(mWeAskedForFundamentalnodeList);
-        READWRITE(mWeAskedForFundamentalnodeListEntry);
-        READWRITE(nDsqCount);
-
-        READWRITE(mapSeenFundamentalnodeBroadcast);
-        READWRITE(mapSeenFundamentalnodePing);
-    }
-
     CFundamentalnodeMan();
     CFundamentalnodeMan(CFundamentalnodeMan& other);
 
+    /// Add the cache file chunks, locking for one chunk at a time
+    void WriteCache(CCacheFile& file) const;
+
+    /// Load the cache file chunks, false if one is missing or corrupted
+    bool ReadCache(const CCacheFile& file);
+
     /// Add an entry
     bool Add(CFundamentalnode& mn);
 
@@ -120,6 +116,16 @@ public:
     CFundamentalnode* Find(const CTxIn& vin);
     CFundamentalnode* Find(const CPubKey& pubKeyFundamentalnode);
 
+    /// Copy the key an entry signs its messages with, safe to call from any thread
+    bool GetPubKey(const CTxIn& vin, CPubKey& pubKeyFundamentalnode);
+
+    /// Changes whenever entries are added or removed, so callers can skip rechecking votes against an unchanged list
+    int64_t GetListVersion()
+    {
+        LOCK(cs);
+        return nListVersion;
+    }
+
     /// Find an entry in the fundamentalnode list that is next to be paid
     CFundamentalnode* GetNextFundamentalnodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCount);
 
@@ -132,7 +138,7 @@ public:
     std::vector<CFundamentalnode> GetFullFundamentalnodeVector()
     {
         Check();
-        return vFundamentalnodes;
+        return CopyFundamentalnodes();
     }
 
     std::vector<pair<int, CFundamentalnode> > GetFundamentalnodeRanks(int64_t nBlockHeight, int minProtocol = 0);
@@ -144,7 +150,7 @@ public:
     void ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
 
     /// Return the number of (unique) Fundamentalnodes
-    int size() { return vFundamentalnodes.size(); }
+    int size() const;
 
     /// Return the number of Fundamentalnodes older than (default) 8000 seconds
     int stable_size ();
@@ -3,6 +3,7 @@
 #include "base58.h"
 #include "chainparams.h"
 #include "httpserver.h"
+#include "jsonstream.h"
 #include "rpcprotocol.h"
 #include "rpcserver.h"
 #include "random.h"
@@ -12,6 +13,7 @@
 #include "ui_interface.h"
 
 #include <boost/algorithm/string.hpp> // boost::trim
+#include <boost/bind.hpp>
 
 /** Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wellet.
@@ -84,6 +86,47 @@ static bool RPCAuthorized(const std::string& strAuth)
     return TimingResistantEqual(strUserPass, strRPCUserColonPass);
 }
 
+/** Sends the output of a streamed reply, adding the headers before the first part */
+static void JSONRPCStreamSink(HTTPRequest* req, bool& fStarted, const std::string& strPart, bool fFinal)
+{
+    if (!fStarted) {
+        req->WriteHeader("Content-Type", "application/json");
+        fStarted = true;
+    }
+    req->WriteReplyPart(HTTP_OK, strPart, fFinal);
+}
+
+/**
+ * Reply to a request for a command that streams its result, writing the reply
+ * while it is produced. Returns false, with nothing sent, if the command cannot
+ * stream. Errors raised before any output was sent are thrown as usual; once the
+ * reply has started the only option left is to cut it short.
+ */
+static bool JSONRPCStreamReply(HTTPRequest* req, const JSONRequest& jreq)
+{
+    if (!tableRPC[jreq.strMethod] || !tableRPC[jreq.strMethod]->streamActor)
+        return false;
+
+    bool fStarted = false;
+    CJSONStreamWriter writer(boost::bind(&JSONRPCStreamSink, req, boost::ref(fStarted), _1, _2));
+    try {
+        writer.BeginObject();
+        writer.Key("result");
+        tableRPC.executeStream(jreq.strMethod, jreq.params, writer);
+        writer.KeyValue("error", NullUniValue);
+        writer.KeyValue("id", jreq.id);
+        writer.EndObject();
+        writer.Raw("\n");
+        writer.Finish();
+    } catch (...) {
+        if (!fStarted)
+            throw;
+        LogPrintf("%s: %s failed after part of the reply was sent\n", __func__, jreq.strMethod);
+        req->EndReply();
+    }
+    return true;
+}
+
 static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 {
     // JSONRPC handles only POST
@@ -122,6 +165,9 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
 
+            if (JSONRPCStreamReply(req, jreq))
+                return true;
+
             UniValue result = tableRPC.execute(jreq.strMethod, jreq.params);
 
             // Send reply
@@ -19,6 +19,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <set>
 
 #include <event2/event.h>
 #include <event2/http.h>
@@ -41,6 +42,29 @@
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
 
+/** Amount of a chunked reply that may wait for the client before the writer blocks */
+static const size_t MAX_REPLY_STREAM_PENDING = 4 * 1024 * 1024;
+
+/** Chunked reply state shared between the worker producing it and the main http thread */
+struct HTTPReplyStream
+{
+    struct evhttp_request* req;
+    boost::mutex cs;
+    boost::condition_variable cond;
+    //! Bytes queued by the worker that have not reached the client yet
+    size_t nPending;
+    //! Bytes handed to evhttp since its output buffer last drained (main thread only)
+    size_t nSubmitted;
+    //! The connection went away and req was freed along with it
+    bool fClosed;
+    //! The worker gave up on a client that stopped reading, the main thread drops the connection
+    bool fDropped;
+    //! The server is shutting down, the worker must not wait for the client anymore
+    bool fInterrupted;
+
+    HTTPReplyStream(struct evhttp_request* req) : req(req), nPending(0), nSubmitted(0), fClosed(false), fDropped(false), fInterrupted(false) {}
+};
+
 /** HTTP request work item */
 class HTTPWorkItem : public HTTPClosure
 {
@@ -189,6 +213,12 @@ static WorkQueue<HTTPClosure>* workQueue = 0;
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
 std::vector<evhttp_bound_socket *> boundSockets;
+//! Chunked replies in progress, to wake their writers on shutdown
+static boost::mutex csReplyStreams;
+static std::set<HTTPReplyStream*> setReplyStreams;
+static bool fReplyStreamsInterrupted = false;
+//! Seconds a chunked reply waits for the client to read before the connection is dropped
+static int nReplyStreamTimeout = DEFAULT_HTTP_SERVER_TIMEOUT;
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr& netaddr)
@@ -418,7 +448,8 @@ bool InitHTTPServer()
         return false;
     }
 
-    evhttp_set_timeout(http, GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
+    nReplyStreamTimeout = GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT);
+    evhttp_set_timeout(http, nReplyStreamTimeout);
     evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
     evhttp_set_max_body_size(http, MAX_SIZE);
     evhttp_set_gencb(http, http_request_cb, NULL);
@@ -454,9 +485,22 @@ bool StartHTTPServer()
     return true;
 }
 
+/** Stop the workers writing chunked replies from waiting for their clients */
+static void InterruptReplyStreams()
+{
+    boost::unique_lock<boost::mutex> lock(csReplyStreams);
+    fReplyStreamsInterrupted = true;
+    BOOST_FOREACH (HTTPReplyStream* stream, setReplyStreams) {
+        boost::unique_lock<boost::mutex> lockStream(stream->cs);
+        stream->fInterrupted = true;
+        stream->cond.notify_all();
+    }
+}
+
 void InterruptHTTPServer()
 {
     LogPrint("http", "Interrupting HTTP server\n");
+    InterruptReplyStreams();
     if (eventHTTP) {
         BOOST_FOREACH (evhttp_bound_socket *socket, boundSockets) {
             evhttp_del_accept_socket(eventHTTP, socket);
@@ -470,6 +514,7 @@ void InterruptHTTPServer()
 void StopHTTPServer()
 {
     LogPrint("http", "Stopping HTTP server\n");
+    InterruptReplyStreams();
     if (workQueue) {
         LogPrint("http", "Waiting for HTTP worker threads to exit\n");
         workQueue->WaitExit();
@@ -537,11 +582,17 @@ void HTTPEvent::trigger(struct timeval* tv)
         evtimer_add(ev, tv); // trigger after timeval passed
 }
 HTTPRequest::HTTPRequest(struct evhttp_request* req) : req(req),
-                                                       replySent(false)
+                                                       replySent(false),
+                                                       stream(NULL)
 {
 }
 HTTPRequest::~HTTPRequest()
 {
+    if (stream) {
+        // A chunked reply that was not finished, e.g. because producing it threw
+        LogPrintf("%s: Unfinished chunked reply\n", __func__);
+        EndReply();
+    }
     if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
@@ -607,6 +658,127 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = 0; // transferred back to main thread
 }
 
+/** Called by evhttp once everything sent so far has been written to the client */
+static void http_reply_stream_written_cb(struct evhttp_connection* con, void* arg)
+{
+    HTTPReplyStream* stream = (HTTPReplyStream*)arg;
+    boost::unique_lock<boost::mutex> lock(stream->cs);
+    stream->nPending -= std::min(stream->nPending, stream->nSubmitted);
+    stream->nSubmitted = 0;
+    stream->cond.notify_all();
+}
+
+static void http_reply_stream_close_cb(struct evhttp_connection* con, void* arg)
+{
+    HTTPReplyStream* stream = (HTTPReplyStream*)arg;
+    boost::unique_lock<boost::mutex> lock(stream->cs);
+    stream->fClosed = true;
+    stream->cond.notify_all();
+}
+
+/** The following run in the main http thread, in the order the worker queued them */
+static void http_reply_stream_start(HTTPReplyStream* stream, int nStatus)
+{
+    evhttp_connection_set_closecb(evhttp_request_get_connection(stream->req), http_reply_stream_close_cb, stream);
+    evhttp_send_reply_start(stream->req, nStatus, NULL);
+}
+
+static void http_reply_stream_chunk(HTTPReplyStream* stream, struct evbuffer* evb)
+{
+    if (!stream->fClosed) {
+        stream->nSubmitted += evbuffer_get_length(evb);
+        evhttp_send_reply_chunk_with_cb(stream->req, evb, http_reply_stream_written_cb, stream);
+    }
+    evbuffer_free(evb);
+}
+
+static void http_reply_stream_drop(HTTPReplyStream* stream)
+{
+    if (!stream->fClosed) {
+        struct evhttp_connection* con = evhttp_request_get_connection(stream->req);
+        evhttp_connection_set_closecb(con, NULL, NULL);
+        evhttp_connection_free(con);
+        boost::unique_lock<boost::mutex> lock(stream->cs);
+        stream->fClosed = true;
+    }
+}
+
+static void http_reply_stream_end(HTTPReplyStream* stream)
+{
+    if (!stream->fClosed) {
+        evhttp_connection_set_closecb(evhttp_request_get_connection(stream->req), NULL, NULL);
+        evhttp_send_reply_end(stream->req);
+    }
+    {
+        boost::unique_lock<boost::mutex> lock(csReplyStreams);
+        setReplyStreams.erase(stream);
+    }
+    delete stream;
+}
+
+void HTTPRequest::StartReply(int nStatus)
+{
+    assert(!replySent && req);
+    stream = new HTTPReplyStream(req);
+    {
+        boost::unique_lock<boost::mutex> lock(csReplyStreams);
+        stream->fInterrupted = fReplyStreamsInterrupted;
+        setReplyStreams.insert(stream);
+    }
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, boost::bind(http_reply_stream_start, stream, nStatus));
+    ev->trigger(0);
+    replySent = true;
+}
+
+void HTTPRequest::WriteReplyChunk(const std::string& strChunk)
+{
+    assert(stream);
+    {
+        boost::unique_lock<boost::mutex> lock(stream->cs);
+        boost::system_time deadline = boost::get_system_time() + boost::posix_time::seconds(nReplyStreamTimeout);
+        while (stream->nPending > MAX_REPLY_STREAM_PENDING && !stream->fClosed && !stream->fDropped) {
+            if (stream->fInterrupted || !stream->cond.timed_wait(lock, deadline)) {
+                // the client stopped reading or we are shutting down, give up on it
+                LogPrint("http", "Dropping chunked reply to a client that is not reading\n");
+                stream->fDropped = true;
+                HTTPEvent* ev = new HTTPEvent(eventBase, true, boost::bind(http_reply_stream_drop, stream));
+                ev->trigger(0);
+            }
+        }
+        if (stream->fClosed || stream->fDropped)
+            return;
+        stream->nPending += strChunk.size();
+    }
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, strChunk.data(), strChunk.size());
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, boost::bind(http_reply_stream_chunk, stream, evb));
+    ev->trigger(0);
+}
+
+void HTTPRequest::EndReply()
+{
+    assert(stream);
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, boost::bind(http_reply_stream_end, stream));
+    ev->trigger(0);
+    stream = NULL;
+    req = 0; // transferred back to main thread
+}
+
+void HTTPRequest::WriteReplyPart(int nStatus, const std::string& strPart, bool fFinal)
+{
+    if (!stream) {
+        if (fFinal) {
+            WriteReply(nStatus, strPart);
+            return;
+        }
+        StartReply(nStatus);
+    }
+    WriteReplyChunk(strPart);
+    if (fFinal)
+        EndReply();
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
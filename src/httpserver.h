@@ -19,6 +19,7 @@ struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPReplyStream;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -57,6 +58,7 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    HTTPReplyStream* stream;
 
 public:
     HTTPRequest(struct evhttp_request* req);
@@ -112,6 +114,37 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a reply whose body is sent in pieces with WriteReplyChunk (chunked
+     * transfer encoding), for bodies that are produced incrementally.
+     *
+     * @note Can be called instead of WriteReply only. After this, only
+     * WriteReplyChunk and EndReply may be called.
+     */
+    void StartReply(int nStatus);
+
+    /**
+     * Send the next piece of a reply started with StartReply. Blocks while too much
+     * earlier output is still waiting for the client, so that a slow reader cannot
+     * make the reply pile up in memory. A client that reads nothing for -rpcservertimeout
+     * seconds, or any client once the server is shutting down, gets its connection
+     * dropped and the rest of the reply is discarded.
+     */
+    void WriteReplyChunk(const std::string& strChunk);
+
+    /**
+     * Finish a reply started with StartReply. As this will give the request back to
+     * the main thread, do not call any other HTTPRequest methods after calling this.
+     */
+    void EndReply();
+
+    /**
+     * Send the next part of a reply that is produced incrementally. A reply that
+     * consists of a single final part is sent with WriteReply, anything longer as a
+     * chunked reply.
+     */
+    void WriteReplyPart(int nStatus, const std::string& strPart, bool fFinal);
 };
 
 /** Event handler closure.
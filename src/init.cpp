@@ -16,8 +16,13 @@
 #include "activefundamentalnode.h"
 #include "addrman.h"
 #include "amount.h"
+#include "blockfilereader.h"
+#include "blockfilewriter.h"
+#include "blockimport.h"
 #include "checkpoints.h"
 #include "compat/sanity.h"
+#include "crypto/quark.h"
+#include "crypto/sha256.h"
 #include "httpserver.h"
 #include "httprpc.h"
 #include "invalid.h"
@@ -25,6 +30,7 @@
 #include "main.h"
 #include "fundamentalnode-budget.h"
 #include "fundamentalnode-payments.h"
+#include "fundamentalnode-sigcheck.h"
 #include "fundamentalnodeconfig.h"
 #include "fundamentalnodeman.h"
 
@@ -32,6 +38,7 @@
 #include "masternode-pos.h"
 #include "masternodeconfig.h"
 #include "masternodeman.h"
+#include "messagesigcache.h"
 
 #include "miner.h"
 #include "net.h"
@@ -87,10 +94,6 @@ volatile bool fFeeEstimatesInitialized = false;
 volatile bool fRestartRequested = false; // true: restart false: shutdown
 extern std::list<uint256> listAccCheckpointsNoDB;
 
-#if ENABLE_ZMQ
-static CZMQNotificationInterface* pzmqNotificationInterface = NULL;
-#endif
-
 #ifdef WIN32
 // Win32 LevelDB doesn't use filedescriptors, and the ones used for
 // accessing block files, don't count towards to fd_set size limit
@@ -175,6 +178,7 @@ public:
 
 static CCoinsViewDB* pcoinsdbview = NULL;
 static CCoinsViewErrorCatcher* pcoinscatcher = NULL;
+static CCoinsViewDBWriter* pcoinswriter = NULL;
 static boost::scoped_ptr<ECCVerifyHandle> globalVerifyHandle;
 
 void Interrupt(boost::thread_group& threadGroup)
@@ -236,10 +240,13 @@ void PrepareShutdown()
             FlushStateToDisk();
 
             //record that client took the proper shutdown procedure
-            pblocktree->WriteFlag("shutdown", true);
+            if (pcoinswriter->Wait())
+                pblocktree->WriteFlag("shutdown", true);
         }
         delete pcoinsTip;
         pcoinsTip = NULL;
+        delete pcoinswriter;
+        pcoinswriter = NULL;
         delete pcoinscatcher;
         pcoinscatcher = NULL;
         delete pcoinsdbview;
@@ -251,6 +258,7 @@ void PrepareShutdown()
         delete pSporkDB;
         pSporkDB = NULL;
     }
+    blockFileWriter.Stop();
 #ifdef ENABLE_WALLET
     if (pwalletMain)
         bitdb.Flush(true);
@@ -300,6 +308,7 @@ void Shutdown()
     globalVerifyHandle.reset();
     ECC_Stop();
     LogPrintf("%s: done\n", __func__);
+    StopDebugLog();
 }
 
 /**
@@ -380,9 +389,13 @@ std::string HelpMessage(HelpMessageMode mode)
     }
     strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory"));
     strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
+    strUsage += HelpMessageOpt("-dboption=<name>.<setting>=<value>", _("Tune a LevelDB database (chainstate, index, zerocoin or sporks), can be specified multiple times. Settings: "
+                                                                         "cache (megabytes, taken out of -dbcache), cachesplit (percent of the cache used for reads, default: 50), "
+                                                                         "bloombits (0 to disable, default: 10), compression (0 or 1, default: 0), blocksize (kilobytes, default: 4), maxopenfiles (default: 64)"));
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file") + " " + _("on startup"));
     strUsage += HelpMessageOpt("-maxreorg=<n>", strprintf(_("Set the Maximum reorg depth (default: %u)"), Params(CBaseChainParams::MAIN).MaxReorganizationDepth()));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
+    strUsage += HelpMessageOpt("-mmapblocks=<n>", strprintf(_("Keep up to <n> block files memory mapped for reading old blocks (0 to disable, default: %u)"), DEFAULT_MMAP_BLOCK_FILES));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"), -(int)boost::thread::hardware_concurrency(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
 #ifndef WIN32
     strUsage += HelpMessageOpt("-pid=<file>", strprintf(_("Specify pid file (default: %s)"), "vitaed.pid"));
@@ -395,6 +408,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-sysperms", _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)"));
 #endif
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), 0));
+    strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used by the getaddressbalance, getaddressutxos and getaddressdeltas rpc calls (default: %u)"), 0));
+    strUsage += HelpMessageOpt("-spentindex", strprintf(_("Maintain a full spent output index, used by the getspentinfo rpc call (default: %u)"), 0));
     strUsage += HelpMessageOpt("-forcestart", _("Attempt to force blockchain corruption recovery") + " " + _("on startup"));
 
     strUsage += HelpMessageGroup(_("Connection options:"));
@@ -472,6 +487,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-zmqpubrawblock=<address>", _("Enable publish raw block in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtx=<address>", _("Enable publish raw transaction in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtxlock=<address>", _("Enable publish raw transaction (locked via SwiftX) in <address>"));
+    strUsage += HelpMessageOpt("-zmqreplaysize=<n>", strprintf(_("Keep the last <n> MiB of messages of each notifier for zmqreplay (default: %u)"), DEFAULT_ZMQ_REPLAY_SIZE));
 #endif
 
     strUsage += HelpMessageGroup(_("Debugging/Testing options:"));
@@ -489,7 +505,7 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-stopafterblockimport", strprintf(_("Stop running after importing blocks from disk (default: %u)"), 0));
         strUsage += HelpMessageOpt("-sporkkey=<privkey>", _("Enable spork administration functionality with the appropriate private key."));
     }
-    string debugCategories = "addrman, alert, bench, coindb, db, lock, rand, rpc, selectcoins, tor, mempool, net, proxy, vitae, (obfuscation, swiftx, fundamentalnode, mnpayments, mnbudget, zero)"; // Don't translate these and qt below
+    string debugCategories = "addrman, alert, bench, blockwrite, coindb, db, lock, rand, rpc, selectcoins, tor, mempool, net, proxy, vitae, (obfuscation, swiftx, fundamentalnode, mnpayments, mnbudget, zero)"; // Don't translate these and qt below
     if (mode == HMM_BITCOIN_QT)
         debugCategories += ", qt";
     strUsage += HelpMessageOpt("-debug=<category>", strprintf(_("Output debugging information (default: %u, supplying <category> is optional)"), 0) + ". " +
@@ -503,10 +519,14 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-help-debug", _("Show all debugging options (usage: --help -help-debug)"));
     strUsage += HelpMessageOpt("-logips", strprintf(_("Include IP addresses in debug output (default: %u)"), 0));
     strUsage += HelpMessageOpt("-logtimestamps", strprintf(_("Prepend debug output with timestamp (default: %u)"), 1));
+    strUsage += HelpMessageOpt("-asynclog", strprintf(_("Write debug.log on a separate logger thread (default: %u)"), 1));
+    strUsage += HelpMessageOpt("-logbuffer=<n>", strprintf(_("Buffer up to <n> lines for the logger thread, further lines are dropped until it catches up (default: %u)"), DEFAULT_LOG_BUFFER));
+    strUsage += HelpMessageOpt("-lograte=<n>", strprintf(_("Log at most <n> lines per second for each debug category, 0 = unlimited (default: %u)"), DEFAULT_LOG_RATE));
     if (GetBoolArg("-help-debug", false)) {
         strUsage += HelpMessageOpt("-limitfreerelay=<n>", strprintf(_("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default:%u)"), 15));
         strUsage += HelpMessageOpt("-relaypriority", strprintf(_("Require high priority for relaying free or low-fee transactions (default:%u)"), 1));
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf(_("Limit size of signature cache to <n> entries (default: %u)"), 50000));
+        strUsage += HelpMessageOpt("-maxmsgsigcachesize=<n>", strprintf(_("Limit size of the masternode, budget and spork message signature cache to <n> entries (default: %u)"), DEFAULT_MAX_MSGSIGCACHE_SIZE));
     }
     strUsage += HelpMessageOpt("-minrelaytxfee=<amt>", strprintf(_("Fees (in VITAE/Kb) smaller than this are considered zero fee for relaying (default: %s)"), FormatMoney(::minRelayTxFee.GetFeePerK())));
     strUsage += HelpMessageOpt("-printtoconsole", strprintf(_("Send trace/debug info to console instead of debug.log file (default: %u)"), 0));
@@ -648,6 +668,9 @@ void ThreadImport(std::vector<boost::filesystem::path> vImportFiles)
 {
     RenameThread("vitae-loadblk");
 
+    // One queue for all files, so its check workers don't drain and restart at every file
+    CBlockImportQueue importQueue(nScriptCheckThreads ? nScriptCheckThreads - 1 : 0);
+
     // -reindex
     if (fReindex) {
         CImportingNow imp;
@@ -660,9 +683,10 @@ void ThreadImport(std::vector<boost::filesystem::path> vImportFiles)
             if (!file)
                 break; // This error is logged in OpenBlockFile
             LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
-            LoadExternalBlockFile(file, &pos);
+            LoadExternalBlockFile(file, &pos, &importQueue);
             nFile++;
         }
+        FlushBlockImportQueue(importQueue);
         pblocktree->WriteReindexing(false);
         fReindex = false;
         LogPrintf("Reindexing finished\n");
@@ -678,7 +702,8 @@ void ThreadImport(std::vector<boost::filesystem::path> vImportFiles)
             CImportingNow imp;
             filesystem::path pathBootstrapOld = GetDataDir() / "bootstrap.dat.old";
             LogPrintf("Importing bootstrap.dat...\n");
-            LoadExternalBlockFile(file);
+            LoadExternalBlockFile(file, NULL, &importQueue);
+            FlushBlockImportQueue(importQueue);
             RenameOver(pathBootstrap, pathBootstrapOld);
         } else {
             LogPrintf("Warning: Could not open bootstrap file %s\n", pathBootstrap.string());
@@ -686,15 +711,18 @@ void ThreadImport(std::vector<boost::filesystem::path> vImportFiles)
     }
 
     // -loadblock=
-    BOOST_FOREACH (boost::filesystem::path& path, vImportFiles) {
-        FILE* file = fopen(path.string().c_str(), "rb");
-        if (file) {
-            CImportingNow imp;
-            LogPrintf("Importing blocks file %s...\n", path.string());
-            LoadExternalBlockFile(file);
-        } else {
-            LogPrintf("Warning: Could not open blocks file %s\n", path.string());
+    if (!vImportFiles.empty()) {
+        CImportingNow imp;
+        BOOST_FOREACH (boost::filesystem::path& path, vImportFiles) {
+            FILE* file = fopen(path.string().c_str(), "rb");
+            if (file) {
+                LogPrintf("Importing blocks file %s...\n", path.string());
+                LoadExternalBlockFile(file, NULL, &importQueue);
+            } else {
+                LogPrintf("Warning: Could not open blocks file %s\n", path.string());
+            }
         }
+        FlushBlockImportQueue(importQueue);
     }
 
     if (GetBoolArg("-stopafterblockimport", false)) {
@@ -872,15 +900,21 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
         }
     }
 
-    // Make sure enough file descriptors are available
+    std::string strDBOptionError;
+    int nDBExtraFiles = 0;
+    if (!CheckLevelDBOptions(strDBOptionError, nDBExtraFiles))
+        return InitError(strDBOptionError);
+
+    // Make sure enough file descriptors are available, including the files databases may keep open beyond the default
+    int nCoreFD = MIN_CORE_FILEDESCRIPTORS + nDBExtraFiles;
     int nBind = std::max((int)mapArgs.count("-bind") + (int)mapArgs.count("-whitebind"), 1);
     nMaxConnections = GetArg("-maxconnections", 125);
-    nMaxConnections = std::max(std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS)), 0);
-    int nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS);
-    if (nFD < MIN_CORE_FILEDESCRIPTORS)
+    nMaxConnections = std::max(std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - nCoreFD)), 0);
+    int nFD = RaiseFileDescriptorLimit(nMaxConnections + nCoreFD);
+    if (nFD < nCoreFD)
         return InitError(_("Not enough file descriptors available."));
-    if (nFD - MIN_CORE_FILEDESCRIPTORS < nMaxConnections)
-        nMaxConnections = nFD - MIN_CORE_FILEDESCRIPTORS;
+    if (nFD - nCoreFD < nMaxConnections)
+        nMaxConnections = nFD - nCoreFD;
 
     // ********************************************************* Step 3: parameter-to-internal-flags
 
@@ -1003,6 +1037,10 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     // ********************************************************* Step 4: application initialization: dir lock, daemonize, pidfile, debug log
 
+    // Select the fastest SHA256 and Quark implementations the CPU supports
+    std::string sha256_algo = SHA256AutoDetect();
+    std::string quark_algo = QuarkAutoDetect();
+
     // Initialize elliptic curve code
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1032,9 +1070,14 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
 #endif
     if (GetBoolArg("-shrinkdebugfile", !fDebug))
         ShrinkDebugFile();
+    SetLogRateLimit(GetArg("-lograte", DEFAULT_LOG_RATE));
+    if (GetBoolArg("-asynclog", true))
+        StartDebugLog(std::max((int64_t)1, GetArg("-logbuffer", DEFAULT_LOG_BUFFER)));
     LogPrintf("\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n");
     LogPrintf("VITAE version %s (%s)\n", FormatFullVersion(), CLIENT_DATE);
     LogPrintf("Using OpenSSL version %s\n", SSLeay_version(SSLEAY_VERSION));
+    LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    LogPrintf("Using the '%s' Quark implementation\n", quark_algo);
 #ifdef ENABLE_WALLET
     LogPrintf("Using BerkeleyDB version %s\n", DbEnv::version(0, 0, 0));
 #endif
@@ -1046,10 +1089,13 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     LogPrintf("Using at most %i connections (%i file descriptors available)\n", nMaxConnections, nFD);
     std::ostringstream strErrors;
 
-    LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
+    LogPrintf("Using %u threads for script, block and fundamentalnode signature verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i = 0; i < nScriptCheckThreads - 1; i++)
+        for (int i = 0; i < nScriptCheckThreads - 1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadVerifyBlockCheck);
+            threadGroup.create_thread(&ThreadFundamentalnodeSigCheck);
+        }
     }
 
     if (mapArgs.count("-sporkkey")) // spork priv key
@@ -1396,10 +1442,17 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     size_t nBlockTreeDBCache = nTotalCache / 8;
     if (nBlockTreeDBCache > (1 << 21) && !GetBoolArg("-txindex", true))
         nBlockTreeDBCache = (1 << 21); // block tree db cache shouldn't be larger than 2 MiB
-    nTotalCache -= nBlockTreeDBCache;
-    size_t nCoinDBCache = nTotalCache / 2; // use half of the remaining cache for coindb cache
-    nTotalCache -= nCoinDBCache;
-    nCoinCacheSize = nTotalCache / 300; // coins in memory require around 300 bytes
+    size_t nCoinDBCache = (nTotalCache - nBlockTreeDBCache) / 2; // use half of the remaining cache for coindb cache
+    // -dboption cache settings replace these shares and come out of -dbcache as well, the coins cache gets the rest
+    size_t nLevelDBCache = GetLevelDBCacheSize("index", nBlockTreeDBCache) + GetLevelDBCacheSize("chainstate", nCoinDBCache) +
+                           GetLevelDBCacheSize("zerocoin", 0) + GetLevelDBCacheSize("sporks", 0);
+    if (nLevelDBCache + (nMinDbCache << 20) / 2 > nTotalCache)
+        return InitError(strprintf(_("The -dboption cache settings leave less than %d MiB of -dbcache for the coins cache."), nMinDbCache / 2));
+    nCoinCacheUsage = nTotalCache - nLevelDBCache;
+
+    // Block and undo files are written in the background from here on
+    blockFileWriter.Start();
+    blockFileReader.SetMaxFiles(std::max((int64_t)0, GetArg("-mmapblocks", DEFAULT_MMAP_BLOCK_FILES)));
 
     bool fLoaded = false;
     while (!fLoaded) {
@@ -1413,6 +1466,7 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
             try {
                 UnloadBlockIndex();
                 delete pcoinsTip;
+                delete pcoinswriter;
                 delete pcoinsdbview;
                 delete pcoinscatcher;
                 delete pblocktree;
@@ -1426,11 +1480,18 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
                 pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReindex);
                 pcoinsdbview = new CCoinsViewDB(nCoinDBCache, false, fReindex);
                 pcoinscatcher = new CCoinsViewErrorCatcher(pcoinsdbview);
-                pcoinsTip = new CCoinsViewCache(pcoinscatcher);
+                pcoinswriter = new CCoinsViewDBWriter(pcoinscatcher);
+                pcoinsTip = new CCoinsViewCache(pcoinswriter);
 
                 if (fReindex)
                     pblocktree->WriteReindexing(true);
 
+                uiInterface.InitMessage(_("Loading UTXO set statistics..."));
+                if (!pcoinsdbview->InitRollingStats()) {
+                    strLoadError = _("Error computing UTXO set statistics");
+                    break;
+                }
+
                 // VITAE: load previous sessions sporks if we have them.
                 uiInterface.InitMessage(_("Loading sporks..."));
                 LoadSporksFromDB();
@@ -1460,6 +1521,16 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
                     break;
                 }
 
+                // Check for changed -addressindex and -spentindex state
+                if (fAddressIndex != GetBoolArg("-addressindex", false)) {
+                    strLoadError = _("You need to rebuild the database using -reindex to change -addressindex");
+                    break;
+                }
+                if (fSpentIndex != GetBoolArg("-spentindex", false)) {
+                    strLoadError = _("You need to rebuild the database using -reindex to change -spentindex");
+                    break;
+                }
+
                 // Populate list of invalid/fraudulent outpoints that are banned from the chain
                 invalid_out::LoadOutpoints();
                 invalid_out::LoadSerials();
@@ -1513,7 +1584,7 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
                 fVerifyingBlocks = true;
 
                 // Zerocoin must check at level 4
-                if (!CVerifyDB().VerifyDB(pcoinsdbview, 4, GetArg("-checkblocks", 100))) {
+                if (!CVerifyDB().VerifyDB(pcoinswriter, 4, GetArg("-checkblocks", 100))) {
                     strLoadError = _("Corrupted block database detected");
                     fVerifyingBlocks = false;
                     break;
@@ -0,0 +1,97 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "jsonstream.h"
+
+#include <assert.h>
+
+CJSONStreamWriter::CJSONStreamWriter(const SinkFn& sink, size_t nChunkSize) : sink(sink),
+                                                                              nChunkSize(nChunkSize),
+                                                                              fAfterKey(false),
+                                                                              fStarted(false)
+{
+    strBuffer.reserve(nChunkSize + 1024);
+}
+
+void CJSONStreamWriter::BeginValue()
+{
+    if (fAfterKey) {
+        fAfterKey = false;
+        return;
+    }
+    if (!vEmpty.empty()) {
+        if (!vEmpty.back())
+            strBuffer += ',';
+        vEmpty.back() = false;
+    }
+}
+
+void CJSONStreamWriter::FlushIfFull()
+{
+    if (strBuffer.size() < nChunkSize)
+        return;
+    sink(strBuffer, false);
+    strBuffer.clear();
+    fStarted = true;
+}
+
+void CJSONStreamWriter::BeginObject()
+{
+    BeginValue();
+    strBuffer += '{';
+    vEmpty.push_back(true);
+}
+
+void CJSONStreamWriter::EndObject()
+{
+    assert(!vEmpty.empty() && !fAfterKey);
+    vEmpty.pop_back();
+    strBuffer += '}';
+    FlushIfFull();
+}
+
+void CJSONStreamWriter::BeginArray()
+{
+    BeginValue();
+    strBuffer += '[';
+    vEmpty.push_back(true);
+}
+
+void CJSONStreamWriter::EndArray()
+{
+    assert(!vEmpty.empty() && !fAfterKey);
+    vEmpty.pop_back();
+    strBuffer += ']';
+    FlushIfFull();
+}
+
+void CJSONStreamWriter::Key(const std::string& strKey)
+{
+    assert(!vEmpty.empty() && !fAfterKey);
+    BeginValue();
+    strBuffer += UniValue(strKey).write();
+    strBuffer += ':';
+    fAfterKey = true;
+}
+
+void CJSONStreamWriter::Value(const UniValue& value)
+{
+    BeginValue();
+    strBuffer += value.write();
+    FlushIfFull();
+}
+
+void CJSONStreamWriter::Raw(const std::string& str)
+{
+    strBuffer += str;
+    FlushIfFull();
+}
+
+void CJSONStreamWriter::Finish()
+{
+    assert(vEmpty.empty());
+    sink(strBuffer, true);
+    strBuffer.clear();
+    fStarted = true;
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_JSONSTREAM_H
+#define BITCOIN_JSONSTREAM_H
+
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+
+#include <univalue.h>
+
+/** Default amount of output collected before it is handed to the sink */
+static const size_t DEFAULT_JSON_STREAM_CHUNK = 64 * 1024;
+
+/**
+ * Writes a JSON document piece by piece, so large results never need to be
+ * built as a single UniValue tree or string. Containers are opened and closed
+ * explicitly; small members are written as UniValue subtrees. The output is
+ * compact and byte-for-byte identical to UniValue::write() of the same tree.
+ *
+ * Output is collected in a buffer and handed to the sink whenever it grows
+ * past the chunk size. The final part is delivered by Finish().
+ */
+class CJSONStreamWriter
+{
+public:
+    //! Receives the output in order; fFinal is set on the last call only
+    typedef boost::function<void(const std::string& strChunk, bool fFinal)> SinkFn;
+
+    CJSONStreamWriter(const SinkFn& sink, size_t nChunkSize = DEFAULT_JSON_STREAM_CHUNK);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    //! Start an object member; must be followed by a value or container
+    void Key(const std::string& strKey);
+
+    //! Write a complete value: an array element, or the value of the last Key()
+    void Value(const UniValue& value);
+
+    void KeyValue(const std::string& strKey, const UniValue& value)
+    {
+        Key(strKey);
+        Value(value);
+    }
+
+    //! Append text outside of the JSON document, e.g. a trailing newline
+    void Raw(const std::string& str);
+
+    //! Deliver the remaining output to the sink as the final chunk
+    void Finish();
+
+    //! Whether any output has been handed to the sink yet
+    bool Started() const { return fStarted; }
+
+private:
+    SinkFn sink;
+    size_t nChunkSize;
+    std::string strBuffer;
+    //! For every open container: whether it is still empty
+    std::vector<bool> vEmpty;
+    bool fAfterKey;
+    bool fStarted;
+
+    void BeginValue();
+    void FlushIfFull();
+};
+
+#endif // BITCOIN_JSONSTREAM_H
@@ -4,9 +4,16 @@
 
 #include "leveldbwrapper.h"
 
+#include "sync.h"
 #include "util.h"
+#include "utilstrencodings.h"
+
+#include <atomic>
+#include <set>
+#include <sstream>
 
 #include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <leveldb/cache.h>
 #include <leveldb/env.h>
@@ -27,14 +34,157 @@ void HandleError(const leveldb::Status& status) throw(leveldb_error)
     throw leveldb_error("Unknown database error");
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+/** Block cache that counts its hits and misses for GetLevelDBStats */
+class CCountingCache : public leveldb::Cache
+{
+private:
+    leveldb::Cache* base;
+
+public:
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+
+    CCountingCache(size_t nCapacity) : base(leveldb::NewLRUCache(nCapacity)), nHits(0), nMisses(0) {}
+    ~CCountingCache() { delete base; }
+
+    Handle* Insert(const leveldb::Slice& key, void* value, size_t charge, void (*deleter)(const leveldb::Slice& key, void* value))
+    {
+        return base->Insert(key, value, charge, deleter);
+    }
+
+    Handle* Lookup(const leveldb::Slice& key)
+    {
+        Handle* handle = base->Lookup(key);
+        if (handle)
+            nHits.fetch_add(1, std::memory_order_relaxed);
+        else
+            nMisses.fetch_add(1, std::memory_order_relaxed);
+        return handle;
+    }
+
+    void Release(Handle* handle) { base->Release(handle); }
+    void* Value(Handle* handle) { return base->Value(handle); }
+    void Erase(const leveldb::Slice& key) { base->Erase(key); }
+    uint64_t NewId() { return base->NewId(); }
+};
+
+static const int DEFAULT_LEVELDB_MAX_OPEN_FILES = 64;
+
+CLevelDBProfile::CLevelDBProfile(size_t nCacheSizeIn) : nCacheSize(nCacheSizeIn), nBlockCachePercent(50), nBloomBits(10), fCompression(false), nBlockSize(4096), nMaxOpenFiles(DEFAULT_LEVELDB_MAX_OPEN_FILES)
+{
+}
+
+/** Split -dboption=<name>.<setting>=<value> into its parts, and check the value is in range for the setting */
+static bool ParseLevelDBOption(const std::string& strOption, std::string& strName, std::string& strSetting, int64_t& nValue, std::string& strError)
+{
+    size_t nDot = strOption.find('.');
+    size_t nEquals = strOption.find('=');
+    if (nDot == std::string::npos || nEquals == std::string::npos || nEquals < nDot) {
+        strError = strprintf("Invalid -dboption '%s', expected <name>.<setting>=<value>", strOption);
+        return false;
+    }
+    strName = strOption.substr(0, nDot);
+    strSetting = strOption.substr(nDot + 1, nEquals - nDot - 1);
+    std::string strValue = strOption.substr(nEquals + 1);
+
+    bool fKnownName = false;
+    for (unsigned int i = 0; i < sizeof(LEVELDB_NAMES) / sizeof(LEVELDB_NAMES[0]); i++)
+        fKnownName |= strName == LEVELDB_NAMES[i];
+    if (!fKnownName) {
+        strError = strprintf("Unknown database '%s' in -dboption", strName);
+        return false;
+    }
+
+    int64_t nMin, nMax;
+    if (strSetting == "cache") {
+        nMin = 0;
+        nMax = 16384;
+    } else if (strSetting == "cachesplit") {
+        nMin = 0;
+        nMax = 100;
+    } else if (strSetting == "bloombits") {
+        nMin = 0;
+        nMax = 32;
+    } else if (strSetting == "compression") {
+        nMin = 0;
+        nMax = 1;
+    } else if (strSetting == "blocksize") {
+        nMin = 1;
+        nMax = 1024;
+    } else if (strSetting == "maxopenfiles") {
+        nMin = DEFAULT_LEVELDB_MAX_OPEN_FILES;
+        nMax = 50000;
+    } else {
+        strError = strprintf("Unknown setting '%s' in -dboption", strSetting);
+        return false;
+    }
+
+    if (!ParseInt64(strValue, &nValue) || nValue < nMin || nValue > nMax) {
+        strError = strprintf("Invalid value for -dboption %s.%s, must be between %d and %d", strName, strSetting, nMin, nMax);
+        return false;
+    }
+    return true;
+}
+
+void CLevelDBProfile::Apply(const std::string& strName)
+{
+    const std::vector<std::string>& vOptions = mapMultiArgs["-dboption"];
+    for (unsigned int i = 0; i < vOptions.size(); i++) {
+        std::string strOptionName, strSetting, strError;
+        int64_t nValue;
+        if (!ParseLevelDBOption(vOptions[i], strOptionName, strSetting, nValue, strError) || strOptionName != strName)
+            continue;
+        if (strSetting == "cache")
+            nCacheSize = nValue << 20;
+        else if (strSetting == "cachesplit")
+            nBlockCachePercent = nValue;
+        else if (strSetting == "bloombits")
+            nBloomBits = nValue;
+        else if (strSetting == "compression")
+            fCompression = nValue != 0;
+        else if (strSetting == "blocksize")
+            nBlockSize = nValue << 10;
+        else if (strSetting == "maxopenfiles")
+            nMaxOpenFiles = nValue;
+    }
+}
+
+size_t GetLevelDBCacheSize(const std::string& strName, size_t nDefaultCacheSize)
+{
+    CLevelDBProfile profile(nDefaultCacheSize);
+    profile.Apply(strName);
+    return profile.nCacheSize;
+}
+
+bool CheckLevelDBOptions(std::string& strError, int& nExtraFiles)
+{
+    std::map<std::string, int> mapMaxOpenFiles;
+    const std::vector<std::string>& vOptions = mapMultiArgs["-dboption"];
+    for (unsigned int i = 0; i < vOptions.size(); i++) {
+        std::string strName, strSetting;
+        int64_t nValue;
+        if (!ParseLevelDBOption(vOptions[i], strName, strSetting, nValue, strError))
+            return false;
+        if (strSetting == "maxopenfiles")
+            mapMaxOpenFiles[strName] = nValue;
+    }
+
+    nExtraFiles = 0;
+    for (std::map<std::string, int>::iterator it = mapMaxOpenFiles.begin(); it != mapMaxOpenFiles.end(); ++it)
+        nExtraFiles += it->second - DEFAULT_LEVELDB_MAX_OPEN_FILES;
+    return true;
+}
+
+static leveldb::Options GetOptions(const CLevelDBProfile& profile)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
-    options.max_open_files = 64;
+    options.block_cache = new CCountingCache(profile.nCacheSize * profile.nBlockCachePercent / 100);
+    options.write_buffer_size = profile.nCacheSize * (100 - profile.nBlockCachePercent) / 200; // up to two write buffers may be held in memory simultaneously
+    if (profile.nBloomBits > 0)
+        options.filter_policy = leveldb::NewBloomFilterPolicy(profile.nBloomBits);
+    options.compression = profile.fCompression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+    options.block_size = profile.nBlockSize;
+    options.max_open_files = profile.nMaxOpenFiles;
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
         // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
         // on corruption in later versions.
@@ -43,19 +193,128 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory, bool fWipe)
+int CNamedBytewiseComparator::Compare(const leveldb::Slice& a, const leveldb::Slice& b) const
+{
+    return leveldb::BytewiseComparator()->Compare(a, b);
+}
+
+const char* CNamedBytewiseComparator::Name() const
+{
+    return strName.c_str();
+}
+
+void CNamedBytewiseComparator::FindShortestSeparator(std::string* start, const leveldb::Slice& limit) const
+{
+    leveldb::BytewiseComparator()->FindShortestSeparator(start, limit);
+}
+
+void CNamedBytewiseComparator::FindShortSuccessor(std::string* key) const
+{
+    leveldb::BytewiseComparator()->FindShortSuccessor(key);
+}
+
+/** Whether LevelDB refused to open a database because it was created with the default comparator */
+static bool IsDefaultComparatorMismatch(const leveldb::Status& status)
+{
+    std::string strMismatch = std::string(leveldb::BytewiseComparator()->Name()) + " does not match existing comparator";
+    return !status.ok() && status.ToString().find(strMismatch) != std::string::npos;
+}
+
+static boost::filesystem::path GetConversionPath(const boost::filesystem::path& path, const std::string& strSuffix)
+{
+    return path.parent_path() / (path.filename().string() + strSuffix);
+}
+
+/**
+ * Clean up after an interrupted comparator conversion. The copy in .new is
+ * only moved in place once it is complete, and the original in .old is only
+ * removed after that, so whichever of the two is missing decides.
+ */
+static void RecoverConversion(const boost::filesystem::path& path)
+{
+    boost::filesystem::path pathOld = GetConversionPath(path, ".old");
+    if (boost::filesystem::exists(pathOld)) {
+        if (boost::filesystem::exists(path))
+            boost::filesystem::remove_all(pathOld);
+        else
+            boost::filesystem::rename(pathOld, path);
+    }
+    boost::filesystem::remove_all(GetConversionPath(path, ".new"));
+}
+
+/** Copy the database at path, created with the default comparator, to one created with options.comparator, and put the copy in its place */
+static void ConvertComparator(const boost::filesystem::path& path, const leveldb::Options& options)
+{
+    LogPrintf("Converting LevelDB in %s for this version, this is only done once...\n", path.string());
+    boost::filesystem::path pathNew = GetConversionPath(path, ".new");
+    boost::filesystem::path pathOld = GetConversionPath(path, ".old");
+
+    leveldb::Options optionsFrom = options;
+    optionsFrom.comparator = leveldb::BytewiseComparator();
+    optionsFrom.create_if_missing = false;
+    leveldb::DB* pdbFrom = NULL;
+    HandleError(leveldb::DB::Open(optionsFrom, path.string(), &pdbFrom));
+    boost::scoped_ptr<leveldb::DB> dbFrom(pdbFrom);
+    TryCreateDirectory(pathNew);
+    leveldb::DB* pdbTo = NULL;
+    HandleError(leveldb::DB::Open(options, pathNew.string(), &pdbTo));
+    boost::scoped_ptr<leveldb::DB> dbTo(pdbTo);
+
+    // Both comparators order the keys the same, so the copy is written in key order
+    leveldb::ReadOptions readoptions;
+    readoptions.verify_checksums = true;
+    readoptions.fill_cache = false;
+    leveldb::WriteOptions syncoptions;
+    syncoptions.sync = true;
+    uint64_t nRecords = 0;
+    {
+        boost::scoped_ptr<leveldb::Iterator> pcursor(dbFrom->NewIterator(readoptions));
+        leveldb::WriteBatch batch;
+        size_t nBatchSize = 0;
+        for (pcursor->SeekToFirst(); pcursor->Valid(); pcursor->Next()) {
+            batch.Put(pcursor->key(), pcursor->value());
+            nBatchSize += pcursor->key().size() + pcursor->value().size();
+            nRecords++;
+            if (nBatchSize >= (16 << 20)) {
+                HandleError(dbTo->Write(leveldb::WriteOptions(), &batch));
+                batch.Clear();
+                nBatchSize = 0;
+            }
+        }
+        HandleError(pcursor->status());
+        HandleError(dbTo->Write(syncoptions, &batch));
+    }
+    dbTo.reset();
+    dbFrom.reset();
+
+    boost::filesystem::rename(path, pathOld);
+    boost::filesystem::rename(pathNew, path);
+    boost::filesystem::remove_all(pathOld);
+    LogPrintf("Converted %u records\n", nRecords);
+}
+
+/** Open databases, for GetLevelDBStats */
+static CCriticalSection cs_setWrappers;
+static std::set<CLevelDBWrapper*> setWrappers;
+
+CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path& pathIn, size_t nCacheSize, bool fMemory, bool fWipe, const CNamedBytewiseComparator* pcomparator) : strName(pathIn.filename().string()), path(pathIn), profile(nCacheSize)
 {
     penv = NULL;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    profile.Apply(strName);
+    options = GetOptions(profile);
     options.create_if_missing = true;
+    if (pcomparator)
+        options.comparator = pcomparator;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
         options.env = penv;
     } else {
+        if (pcomparator)
+            RecoverConversion(path);
         if (fWipe) {
             LogPrintf("Wiping LevelDB in %s\n", path.string());
             leveldb::DestroyDB(path.string(), options);
@@ -64,12 +323,23 @@ CLevelDBWrapper::CLevelDBWrapper(const boost::filesystem::path& path, size_t nCa
         LogPrintf("Opening LevelDB in %s\n", path.string());
     }
     leveldb::Status status = leveldb::DB::Open(options, path.string(), &pdb);
+    if (pcomparator && !fMemory && IsDefaultComparatorMismatch(status)) {
+        ConvertComparator(path, options);
+        status = leveldb::DB::Open(options, path.string(), &pdb);
+    }
     HandleError(status);
     LogPrintf("Opened LevelDB successfully\n");
+
+    LOCK(cs_setWrappers);
+    setWrappers.insert(this);
 }
 
 CLevelDBWrapper::~CLevelDBWrapper()
 {
+    {
+        LOCK(cs_setWrappers);
+        setWrappers.erase(this);
+    }
     delete pdb;
     pdb = NULL;
     delete options.filter_policy;
@@ -80,6 +350,37 @@ CLevelDBWrapper::~CLevelDBWrapper()
     options.env = NULL;
 }
 
+std::vector<CLevelDBStats> GetLevelDBStats()
+{
+    std::vector<CLevelDBStats> vStats;
+
+    LOCK(cs_setWrappers);
+    for (std::set<CLevelDBWrapper*>::iterator it = setWrappers.begin(); it != setWrappers.end(); ++it) {
+        CLevelDBWrapper* pwrapper = *it;
+        CLevelDBStats stats;
+        stats.strName = pwrapper->strName;
+        stats.strPath = pwrapper->path.string();
+        stats.profile = pwrapper->profile;
+        CCountingCache* pcache = static_cast<CCountingCache*>(pwrapper->options.block_cache);
+        stats.nCacheHits = pcache->nHits.load(std::memory_order_relaxed);
+        stats.nCacheMisses = pcache->nMisses.load(std::memory_order_relaxed);
+
+        // leveldb.stats has a three line header followed by one line per non-empty level
+        std::string strStats;
+        if (pwrapper->pdb->GetProperty("leveldb.stats", &strStats)) {
+            std::istringstream ss(strStats);
+            std::string strLine;
+            for (int nLine = 0; std::getline(ss, strLine); nLine++) {
+                CLevelDBLevelStats level;
+                if (nLine >= 3 && sscanf(strLine.c_str(), "%d %d %lf %lf %lf %lf", &level.nLevel, &level.nFiles, &level.dSizeMB, &level.dCompactionSeconds, &level.dReadMB, &level.dWriteMB) == 6)
+                    stats.vLevels.push_back(level);
+            }
+        }
+        vStats.push_back(stats);
+    }
+    return vStats;
+}
+
 bool CLevelDBWrapper::WriteBatch(CLevelDBBatch& batch, bool fSync) throw(leveldb_error)
 {
     leveldb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
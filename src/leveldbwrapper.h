@@ -11,8 +11,12 @@
 #include "util.h"
 #include "version.h"
 
+#include <string>
+#include <vector>
+
 #include <boost/filesystem/path.hpp>
 
+#include <leveldb/comparator.h>
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 
@@ -24,6 +28,84 @@ public:
 
 void HandleError(const leveldb::Status& status) throw(leveldb_error);
 
+/** Databases that can be tuned with -dboption, named after their directory */
+static const char* const LEVELDB_NAMES[] = {"chainstate", "index", "zerocoin", "sporks"};
+
+/**
+ * LevelDB settings of one database. The defaults can be overridden per
+ * database with -dboption=<name>.<setting>=<value>.
+ */
+struct CLevelDBProfile {
+    //! memory for the block cache and the write buffers, in bytes
+    size_t nCacheSize;
+    //! share of nCacheSize used for the block cache, the rest goes to the two write buffers
+    int nBlockCachePercent;
+    //! bloom filter bits per key, 0 disables the filter
+    int nBloomBits;
+    //! snappy compression of table blocks, if LevelDB was built with snappy
+    bool fCompression;
+    //! uncompressed size of a table block, in bytes
+    size_t nBlockSize;
+    //! table files LevelDB keeps open
+    int nMaxOpenFiles;
+
+    CLevelDBProfile(size_t nCacheSizeIn);
+
+    //! Override the defaults with the -dboption settings given for strName
+    void Apply(const std::string& strName);
+};
+
+/** Cache size of the database strName after its -dboption settings, in bytes */
+size_t GetLevelDBCacheSize(const std::string& strName, size_t nDefaultCacheSize);
+
+/** Check the -dboption settings. nExtraFiles is set to the file descriptors they need beyond the defaults. */
+bool CheckLevelDBOptions(std::string& strError, int& nExtraFiles);
+
+/** Compaction statistics of one level of a database */
+struct CLevelDBLevelStats {
+    int nLevel;
+    int nFiles;
+    double dSizeMB;
+    double dCompactionSeconds;
+    double dReadMB;
+    double dWriteMB;
+};
+
+/** Settings and statistics of an open database */
+struct CLevelDBStats {
+    std::string strName;
+    std::string strPath;
+    CLevelDBProfile profile;
+    uint64_t nCacheHits;
+    uint64_t nCacheMisses;
+    std::vector<CLevelDBLevelStats> vLevels;
+
+    CLevelDBStats() : profile(0), nCacheHits(0), nCacheMisses(0) {}
+};
+
+/** Statistics of every open database */
+std::vector<CLevelDBStats> GetLevelDBStats();
+
+/**
+ * Orders keys like LevelDB's default bytewise comparator, under another name.
+ * LevelDB stores the name of the comparator in the database and refuses to
+ * open it with any other, so clients that don't know the name can't open a
+ * database created with it.
+ */
+class CNamedBytewiseComparator : public leveldb::Comparator
+{
+private:
+    std::string strName;
+
+public:
+    CNamedBytewiseComparator(const std::string& strNameIn) : strName(strNameIn) {}
+
+    int Compare(const leveldb::Slice& a, const leveldb::Slice& b) const;
+    const char* Name() const;
+    void FindShortestSeparator(std::string* start, const leveldb::Slice& limit) const;
+    void FindShortSuccessor(std::string* key) const;
+};
+
 /** Batch of changes queued to be written to a CLevelDBWrapper */
 class CLevelDBBatch
 {
@@ -85,8 +167,20 @@ private:
     //! the database itself
     leveldb::DB* pdb;
 
+    //! name and path of the database, and the settings it was opened with
+    std::string strName;
+    boost::filesystem::path path;
+    CLevelDBProfile profile;
+
+    friend std::vector<CLevelDBStats> GetLevelDBStats();
+
 public:
-    CLevelDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    /**
+     * Open the database at path. A database opened with pcomparator is
+     * created with it, and one created with the default comparator is
+     * copied over to it once.
+     */
+    CLevelDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, const CNamedBytewiseComparator* pcomparator = NULL);
     ~CLevelDBWrapper();
 
     template <typename K, typename V>
@@ -12,6 +12,9 @@
 #include "accumulatormap.h"
 #include "addrman.h"
 #include "alert.h"
+#include "blockfilereader.h"
+#include "blockfilewriter.h"
+#include "blockimport.h"
 #include "blocksignature.h"
 #include "chainparams.h"
 #include "checkpoints.h"
@@ -20,6 +23,7 @@
 #include "kernel.h"
 #include "fundamentalnode-budget.h"
 #include "fundamentalnode-payments.h"
+#include "fundamentalnode-sigcheck.h"
 #include "fundamentalnodeman.h"
 #include "merkleblock.h"
 #include "net.h"
@@ -68,6 +72,8 @@ using namespace libzerocoin;
 CCriticalSection cs_main;
 
 BlockMap mapBlockIndex;
+/** Held while mapBlockIndex changes, so LookupBlockIndex() works without cs_main */
+static CCriticalSection cs_mapBlockIndex;
 map<uint256, uint256> mapProofOfStake;
 set<pair<COutPoint, unsigned int> > setStakeSeen;
 
@@ -82,6 +88,9 @@ map<COutPoint, int> mapStakeSpent;
 
 map<unsigned int, unsigned int> mapHashedBlocks;
 CChain chainActive;
+/** The active chain as last published by UpdateTip(), for readers that do not hold cs_main */
+static CCriticalSection cs_chainSnapshot;
+static boost::shared_ptr<const CChainSnapshot> pchainSnapshot(new CChainSnapshot(NULL));
 CBlockIndex* pindexBestHeader = NULL;
 int64_t nTimeBestReceived = 0;
 CWaitableCriticalSection csBestBlock;
@@ -90,10 +99,12 @@ int nScriptCheckThreads = 0;
 bool fImporting = false;
 bool fReindex = false;
 bool fTxIndex = true;
+bool fAddressIndex = false;
+bool fSpentIndex = false;
 bool fIsBareMultisigStd = true;
 bool fCheckBlockIndex = false;
 bool fVerifyingBlocks = false;
-unsigned int nCoinCacheSize = 5000;
+size_t nCoinCacheUsage = 5000 * 300;
 bool fAlerts = DEFAULT_ALERTS;
 
 unsigned int nStakeMinAge = 1 * 60 * 60;
@@ -113,6 +124,7 @@ struct COrphanTx {
 };
 map<uint256, COrphanTx> mapOrphanTransactions;
 map<uint256, set<uint256> > mapOrphanTransactionsByPrev;
+CCriticalSection cs_mapRejectedBlocks;
 map<uint256, int64_t> mapRejectedBlocks;
 map<uint256, int64_t> mapZerocoinspends; //txid, time received
 
@@ -1265,8 +1277,9 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState& state, const CTransa
     // ----------- swiftTX transaction scanning -----------
 
     BOOST_FOREACH (const CTxIn& in, tx.vin) {
-        if (mapLockedInputs.count(in.prevout)) {
-            if (mapLockedInputs[in.prevout] != tx.GetHash()) {
+        uint256 txHashLocked;
+        if (GetLockedInputTx(in.prevout, txHashLocked)) {
+            if (txHashLocked != tx.GetHash()) {
                 return state.DoS(0,
                     error("AcceptToMemoryPool : conflicts with existing transaction lock: %s", reason),
                     REJECT_INVALID, "tx-lock-conflict");
@@ -1528,8 +1541,9 @@ bool AcceptableInputs(CTxMemPool& pool, CValidationState& state, const CTransact
     // ----------- swiftTX transaction scanning -----------
 
     BOOST_FOREACH (const CTxIn& in, tx.vin) {
-        if (mapLockedInputs.count(in.prevout)) {
-            if (mapLockedInputs[in.prevout] != tx.GetHash()) {
+        uint256 txHashLocked;
+        if (GetLockedInputTx(in.prevout, txHashLocked)) {
+            if (txHashLocked != tx.GetHash()) {
                 return state.DoS(0,
                     error("AcceptableInputs : conflicts with existing transaction lock: %s", reason),
                     REJECT_INVALID, "tx-lock-conflict");
@@ -1737,8 +1751,9 @@ bool AcceptableFundamentalTxn(CTxMemPool& pool, CValidationState& state, const C
     // ----------- swiftTX transaction scanning -----------
 
     BOOST_FOREACH (const CTxIn& in, tx.vin) {
-        if (mapLockedInputs.count(in.prevout)) {
-            if (mapLockedInputs[in.prevout] != tx.GetHash()) {
+        uint256 txHashLocked;
+        if (GetLockedInputTx(in.prevout, txHashLocked)) {
+            if (txHashLocked != tx.GetHash()) {
                 return state.DoS(0,
                     error("AcceptableInputs : conflicts with existing transaction lock: %s", reason),
                     REJECT_INVALID, "tx-lock-conflict");
@@ -1835,25 +1850,78 @@ bool AcceptableFundamentalTxn(CTxMemPool& pool, CValidationState& state, const C
     return true;
 }
 
+bool ExtractAddressIndexKey(const CScript& scriptPubKey, int& addressType, uint160& addressHash)
+{
+    CTxDestination dest;
+    if (!ExtractDestination(scriptPubKey, dest))
+        return false;
+    if (const CKeyID* keyID = boost::get<CKeyID>(&dest)) {
+        addressType = ADDRESS_INDEX_PUBKEYHASH;
+        addressHash = *keyID;
+        return true;
+    }
+    if (const CScriptID* scriptID = boost::get<CScriptID>(&dest)) {
+        addressType = ADDRESS_INDEX_SCRIPTHASH;
+        addressHash = *scriptID;
+        return true;
+    }
+    return false;
+}
+
+bool GetSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value)
+{
+    if (!fSpentIndex)
+        return false;
+    return pblocktree->ReadSpentIndex(key, value);
+}
+
+bool GetAddressIndex(const uint160& addressHash, int type, std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex, int nStart, int nEnd)
+{
+    if (!fAddressIndex)
+        return error("%s : address index not enabled", __func__);
+    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, nStart, nEnd))
+        return error("%s : unable to get txids for address", __func__);
+    return true;
+}
+
+bool GetAddressUnspent(const uint160& addressHash, int type, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& unspentOutputs)
+{
+    if (!fAddressIndex)
+        return error("%s : address index not enabled", __func__);
+    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
+        return error("%s : unable to get txids for address", __func__);
+    return true;
+}
+
 /** Return transaction in tx, and if it was found inside a block, its hash is placed in hashBlock */
 bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock, bool fAllowSlow)
 {
     CBlockIndex* pindexSlow = NULL;
-    {
-        LOCK(cs_main);
-        {
-            if (mempool.lookup(hash, txOut)) {
-                return true;
-            }
-        }
 
-        if (fTxIndex) {
-            CDiskTxPos postx;
-            if (pblocktree->ReadTxIndex(hash, postx)) {
+    // The mempool and the transaction index have their own locking, so
+    // neither of them needs cs_main
+    if (mempool.lookup(hash, txOut)) {
+        return true;
+    }
+
+    if (fTxIndex) {
+        CDiskTxPos postx;
+        if (pblocktree->ReadTxIndex(hash, postx)) {
+            CBlockHeader header;
+            CMappedRecord record;
+            if (blockFileReader.MapRecord(postx, "blk", record)) {
+                try {
+                    CSpanReader span = record.GetReader(SER_DISK, CLIENT_VERSION);
+                    span >> header;
+                    span.ignore(postx.nTxOffset);
+                    span >> txOut;
+                } catch (const std::exception& e) {
+                    return error("%s : Deserialize error - %s", __func__, e.what());
+                }
+            } else {
                 CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
                 if (file.IsNull())
                     return error("%s: OpenBlockFile failed", __func__);
-                CBlockHeader header;
                 try {
                     file >> header;
                     fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
@@ -1861,16 +1929,19 @@ bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock
                 } catch (const std::exception& e) {
                     return error("%s : Deserialize or I/O error - %s", __func__, e.what());
                 }
-                hashBlock = header.GetHash();
-                if (txOut.GetHash() != hash)
-                    return error("%s : txid mismatch", __func__);
-                return true;
             }
-
-            // transaction not found in the index, nothing more can be done
-            return false;
+            hashBlock = header.GetHash();
+            if (txOut.GetHash() != hash)
+                return error("%s : txid mismatch", __func__);
+            return true;
         }
 
+        // transaction not found in the index, nothing more can be done
+        return false;
+    }
+
+    {
+        LOCK(cs_main);
         if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
             int nHeight = -1;
             {
@@ -1908,21 +1979,16 @@ bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock
 
 bool WriteBlockToDisk(CBlock& block, CDiskBlockPos& pos)
 {
-    // Open history file to append
-    CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("WriteBlockToDisk : OpenBlockFile failed");
+    // Serialize index header and block, the block file writer puts them at pos
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    unsigned int nSize = ss.GetSerializeSize(block);
+    ss << FLATDATA(Params().MessageStart()) << nSize;
+    unsigned int nHeaderSize = ss.size();
+    ss << block;
 
-    // Write index header
-    unsigned int nSize = fileout.GetSerializeSize(block);
-    fileout << FLATDATA(Params().MessageStart()) << nSize;
-
-    // Write block
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0)
-        return error("WriteBlockToDisk : ftell failed");
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << block;
+    if (!blockFileWriter.Write(pos, "blk", ss))
+        return error("WriteBlockToDisk : Failed to write block file");
+    pos.nPos += nHeaderSize;
 
     return true;
 }
@@ -1931,16 +1997,34 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos)
 {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("ReadBlockFromDisk : OpenBlockFile failed");
+    // A block that is still queued for writing is read from memory, others from the mapped file if possible
+    CDataStream ssPending(SER_DISK, CLIENT_VERSION);
+    CMappedRecord record;
+    if (blockFileWriter.ReadPending(pos, "blk", ssPending)) {
+        try {
+            ssPending >> block;
+        } catch (const std::exception& e) {
+            return error("%s : Deserialize error - %s", __func__, e.what());
+        }
+    } else if (blockFileReader.MapRecord(pos, "blk", record)) {
+        try {
+            CSpanReader span = record.GetReader(SER_DISK, CLIENT_VERSION);
+            span >> block;
+        } catch (const std::exception& e) {
+            return error("%s : Deserialize error - %s", __func__, e.what());
+        }
+    } else {
+        // Open history file to read
+        CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return error("ReadBlockFromDisk : OpenBlockFile failed");
 
-    // Read block
-    try {
-        filein >> block;
-    } catch (const std::exception& e) {
-        return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        // Read block
+        try {
+            filein >> block;
+        } catch (const std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
     }
 
     // Check the header
@@ -1963,6 +2047,20 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex)
     return true;
 }
 
+bool ReadBlockFromDiskUnlocked(CBlock& block, const CBlockIndex* pindex)
+{
+    CDiskBlockPos pos;
+    {
+        LOCK(cs_main);
+        pos = pindex->GetBlockPos();
+    }
+    if (!ReadBlockFromDisk(block, pos))
+        return false;
+    if (block.GetHash() != pindex->GetBlockHash())
+        return error("%s : GetHash() doesn't match index for %s", __func__, pindex->GetBlockHash().ToString());
+    return true;
+}
+
 
 double ConvertBitsToDouble(unsigned int nBits)
 {
@@ -2292,8 +2390,12 @@ CAmount GetMasternodePayment(int nHeight, int64_t blockValue, int nMasternodeCou
 
 bool IsInitialBlockDownload()
 {
+    // the import flags don't need cs_main, so blocks checked on other threads while importing don't wait for it
+    if (fImporting || fReindex)
+        return true;
+    // verifychain sets the verifying flag while it holds cs_main, blocks checked meanwhile must not see it
     LOCK(cs_main);
-    if (fImporting || fReindex || fVerifyingBlocks || chainActive.Height() < Checkpoints::GetTotalBlocksEstimate())
+    if (fVerifyingBlocks || chainActive.Height() < Checkpoints::GetTotalBlocksEstimate())
         return true;
     static bool lockIBDState = false;
     if (lockIBDState)
@@ -2448,6 +2550,37 @@ void UpdateCoins(const CTransaction& tx, CValidationState& state, CCoinsViewCach
     inputs.ModifyCoins(tx.GetHash())->FromTx(tx, nHeight);
 }
 
+/** UpdateCoins, additionally recording the spent and created outputs in the view's rolling statistics */
+static void UpdateCoinsWithStats(const CTransaction& tx, CValidationState& state, CCoinsViewCache& inputs, CTxUndo& txundo, int nHeight)
+{
+    CCoinsRollingStats& stats = inputs.GetStatsDelta();
+    if (!tx.IsCoinBase() && !tx.IsZerocoinSpend()) {
+        BOOST_FOREACH (const CTxIn& txin, tx.vin) {
+            const CCoins* coins = inputs.AccessCoins(txin.prevout.hash);
+            assert(coins && coins->IsAvailable(txin.prevout.n));
+            stats.RemoveCoin(txin.prevout.hash, txin.prevout.n, coins->vout[txin.prevout.n], coins->nHeight, coins->fCoinBase);
+        }
+    }
+
+    UpdateCoins(tx, state, inputs, txundo, nHeight);
+
+    // undo data carries the height only when the last output of the previous transaction was spent
+    BOOST_FOREACH (const CTxInUndo& undo, txundo.vprevout) {
+        if (undo.nHeight != 0)
+            stats.RemoveTransaction();
+    }
+
+    const uint256& hash = tx.GetHash();
+    const CCoins* coins = inputs.AccessCoins(hash);
+    if (coins && !coins->IsPruned()) {
+        stats.AddTransaction();
+        for (unsigned int i = 0; i < coins->vout.size(); i++) {
+            if (!coins->vout[i].IsNull())
+                stats.AddCoin(hash, i, coins->vout[i], coins->nHeight, coins->fCoinBase);
+        }
+    }
+}
+
 bool CScriptCheck::operator()()
 {
     const CScript& scriptSig = ptxTo->vin[nIn].scriptSig;
@@ -2654,6 +2787,10 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
     if (blockUndo.vtxundo.size() + 1 != block.vtx.size())
         return error("DisconnectBlock() : block and undo data inconsistent");
 
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+
     // undo transactions in reverse order
     for (int i = block.vtx.size() - 1; i >= 0; i--) {
         const CTransaction& tx = block.vtx[i];
@@ -2701,6 +2838,18 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
 
         uint256 hash = tx.GetHash();
 
+        if (fAddressIndex) {
+            for (unsigned int k = tx.vout.size(); k-- > 0;) {
+                const CTxOut& out = tx.vout[k];
+                int addressType;
+                uint160 addressHash;
+                if (!ExtractAddressIndexKey(out.scriptPubKey, addressType, addressHash))
+                    continue;
+                addressIndex.push_back(make_pair(CAddressIndexKey(addressType, addressHash, pindex->nHeight, i, hash, k, false), out.nValue));
+                addressUnspentIndex.push_back(make_pair(CAddressUnspentKey(addressType, addressHash, hash, k), CAddressUnspentValue()));
+            }
+        }
+
         // Check that all outputs are available and match the outputs in the block itself
         // exactly. Note that transactions with only provably unspendable outputs won't
         // have outputs available even in the block itself, so we handle that case
@@ -2720,6 +2869,13 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
                 fClean = fClean && error("DisconnectBlock() : added transaction mismatch? database corrupted");
 
             // remove outputs
+            if (!outs->IsPruned()) {
+                view.GetStatsDelta().RemoveTransaction();
+                for (unsigned int j = 0; j < outs->vout.size(); j++) {
+                    if (!outs->vout[j].IsNull())
+                        view.GetStatsDelta().RemoveCoin(hash, j, outs->vout[j], outs->nHeight, outs->fCoinBase);
+                }
+            }
             outs->Clear();
         }
 
@@ -2750,6 +2906,19 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
                     coins->vout.resize(out.n + 1);
                 coins->vout[out.n] = undo.txout;
 
+                if (undo.nHeight != 0)
+                    view.GetStatsDelta().AddTransaction();
+                view.GetStatsDelta().AddCoin(out.hash, out.n, undo.txout, coins->nHeight, coins->fCoinBase);
+
+                int addressType = ADDRESS_INDEX_NONE;
+                uint160 addressHash = 0;
+                if (ExtractAddressIndexKey(undo.txout.scriptPubKey, addressType, addressHash) && fAddressIndex) {
+                    addressIndex.push_back(make_pair(CAddressIndexKey(addressType, addressHash, pindex->nHeight, i, hash, j, true), undo.txout.nValue * -1));
+                    addressUnspentIndex.push_back(make_pair(CAddressUnspentKey(addressType, addressHash, out.hash, out.n), CAddressUnspentValue(undo.txout.nValue, undo.txout.scriptPubKey, coins->nHeight)));
+                }
+                if (fSpentIndex)
+                    spentIndex.push_back(make_pair(CSpentIndexKey(out.hash, out.n), CSpentIndexValue()));
+
                 // erase the spent input
                 mapStakeSpent.erase(out);
             }
@@ -2760,6 +2929,17 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
     if (!fVerifyingBlocks) {
+        // the temporary views used while verifying blocks at startup must not touch the indexes
+        if (fAddressIndex) {
+            if (!pblocktree->EraseAddressIndex(addressIndex))
+                return state.Abort("Failed to delete address index");
+            if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex))
+                return state.Abort("Failed to write address unspent index");
+        }
+        if (fSpentIndex)
+            if (!pblocktree->UpdateSpentIndex(spentIndex))
+                return state.Abort("Failed to write spent index");
+
         //if block is an accumulator checkpoint block, remove checkpoint and checksums from db
         uint256 nCheckpoint = pindex->nAccumulatorCheckpoint;
         if(nCheckpoint != pindex->pprev->nAccumulatorCheckpoint) {
@@ -2776,27 +2956,18 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
     }
 }
 
-void static FlushBlockFile(bool fFinalize = false)
+bool static FlushBlockFile(bool fFinalize = false)
 {
     LOCK(cs_LastBlockFile);
 
-    CDiskBlockPos posOld(nLastBlockFile, 0);
-
-    FILE* fileOld = OpenBlockFile(posOld);
-    if (fileOld) {
-        if (fFinalize)
-            TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nSize);
-        FileCommit(fileOld);
-        fclose(fileOld);
+    // Finishing a file doesn't need to wait, only a flush of the block index does
+    if (fFinalize) {
+        blockFileWriter.Truncate(nLastBlockFile, "blk", vinfoBlockFile[nLastBlockFile].nSize);
+        blockFileWriter.Truncate(nLastBlockFile, "rev", vinfoBlockFile[nLastBlockFile].nUndoSize);
+        return true;
     }
 
-    fileOld = OpenUndoFile(posOld);
-    if (fileOld) {
-        if (fFinalize)
-            TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nUndoSize);
-        FileCommit(fileOld);
-        fclose(fileOld);
-    }
+    return blockFileWriter.Flush();
 }
 
 bool FindUndoPos(CValidationState& state, int nFile, CDiskBlockPos& pos, unsigned int nAddSize);
@@ -3130,6 +3301,9 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     std::vector<std::pair<uint256, CDiskTxPos> > vPos;
     std::vector<std::pair<CoinSpend, uint256> > vSpends;
     std::vector<std::pair<PublicCoin, uint256> > vMints;
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
     vPos.reserve(block.vtx.size());
     CBlockUndo blockundo;
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
@@ -3252,11 +3426,46 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         }
         nValueOut += tx.GetValueOut();
 
+        // zerocoin spends have no prevouts to index; their outputs are indexed below like any other
+        if ((fAddressIndex || fSpentIndex) && !tx.IsCoinBase() && !tx.IsZerocoinSpend()) {
+            const uint256& txhash = tx.GetHash();
+            for (unsigned int j = 0; j < tx.vin.size(); j++) {
+                const CTxIn& input = tx.vin[j];
+                const CTxOut& prevout = view.GetOutputFor(input);
+                int addressType = ADDRESS_INDEX_NONE;
+                uint160 addressHash = 0;
+                if (ExtractAddressIndexKey(prevout.scriptPubKey, addressType, addressHash) && fAddressIndex) {
+                    addressIndex.push_back(make_pair(CAddressIndexKey(addressType, addressHash, pindex->nHeight, i, txhash, j, true), prevout.nValue * -1));
+                    addressUnspentIndex.push_back(make_pair(CAddressUnspentKey(addressType, addressHash, input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
+                }
+                if (fSpentIndex)
+                    spentIndex.push_back(make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(txhash, j, pindex->nHeight, prevout.nValue, addressType, addressHash)));
+            }
+        }
+
+        // zerocoin mints and the empty first output of a coinstake do not pay to an address and are skipped
+        if (fAddressIndex) {
+            const uint256& txhash = tx.GetHash();
+            for (unsigned int k = 0; k < tx.vout.size(); k++) {
+                const CTxOut& out = tx.vout[k];
+                int addressType;
+                uint160 addressHash;
+                if (!ExtractAddressIndexKey(out.scriptPubKey, addressType, addressHash))
+                    continue;
+                addressIndex.push_back(make_pair(CAddressIndexKey(addressType, addressHash, pindex->nHeight, i, txhash, k, false), out.nValue));
+                addressUnspentIndex.push_back(make_pair(CAddressUnspentKey(addressType, addressHash, txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
+            }
+        }
+
         CTxUndo undoDummy;
         if (i > 0) {
             blockundo.vtxundo.push_back(CTxUndo());
         }
-        UpdateCoins(tx, state, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight);
+        // the rolling statistics are only needed for views that will be flushed to the chainstate
+        if (fJustCheck)
+            UpdateCoins(tx, state, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight);
+        else
+            UpdateCoinsWithStats(tx, state, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight);
 
         vPos.push_back(std::make_pair(tx.GetHash(), pos));
         pos.nTxOffset += ::GetSerializeSize(tx, SER_DISK, CLIENT_VERSION);
@@ -3371,6 +3580,17 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         if (!pblocktree->WriteTxIndex(vPos))
             return state.Abort("Failed to write transaction index");
 
+    if (fAddressIndex) {
+        if (!pblocktree->WriteAddressIndex(addressIndex))
+            return state.Abort("Failed to write address index");
+        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex))
+            return state.Abort("Failed to write address unspent index");
+    }
+
+    if (fSpentIndex)
+        if (!pblocktree->UpdateSpentIndex(spentIndex))
+            return state.Abort("Failed to write spent index");
+
     // add new entries
     for (const CTransaction tx: block.vtx) {
         if (tx.IsCoinBase() || tx.IsZerocoinSpend())
@@ -3437,9 +3657,12 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode)
 {
     LOCK(cs_main);
     static int64_t nLastWrite = 0;
+    // The tip gets half of the coins cache. The other half is for the snapshot the background
+    // writer still holds, which is at most what the tip had when it was flushed.
+    size_t nTipCacheUsage = nCoinCacheUsage / 2;
     try {
         if ((mode == FLUSH_STATE_ALWAYS) ||
-            ((mode == FLUSH_STATE_PERIODIC || mode == FLUSH_STATE_IF_NEEDED) && pcoinsTip->GetCacheSize() > nCoinCacheSize) ||
+            ((mode == FLUSH_STATE_PERIODIC || mode == FLUSH_STATE_IF_NEEDED) && pcoinsTip->DynamicMemoryUsage() + zerocoinDB->CacheUsage() > nTipCacheUsage) ||
             (mode == FLUSH_STATE_PERIODIC && GetTimeMicros() > nLastWrite + DATABASE_WRITE_INTERVAL * 1000000)) {
             // Typical CCoins structures on disk are around 100 bytes in size.
             // Pushing a new one to the database can cause it to be written
@@ -3449,7 +3672,8 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode)
             if (!CheckDiskSpace(100 * 2 * 2 * pcoinsTip->GetCacheSize()))
                 return state.Error("out of disk space");
             // First make sure all block and undo data is flushed to disk.
-            FlushBlockFile();
+            if (!FlushBlockFile())
+                return state.Abort("Failed to write block files");
             // Then update all block file information (which may refer to block and undo files).
             bool fileschanged = false;
             for (set<int>::iterator it = setDirtyFileInfo.begin(); it != setDirtyFileInfo.end();) {
@@ -3469,8 +3693,12 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode)
                 setDirtyBlockIndex.erase(it++);
             }
             pblocktree->Sync();
-            // Finally flush the chainstate (which may refer to block index entries).
-            if (!pcoinsTip->Flush())
+            // The zerocoin records of the connected blocks go first, so they are never behind the chainstate
+            if (!zerocoinDB->FlushCache())
+                return state.Abort("Failed to write to zerocoin database");
+            // Finally flush the chainstate (which may refer to block index entries). It is written
+            // in the background, and half of the tip stays warm for the blocks that follow.
+            if (!pcoinsTip->Sync(nTipCacheUsage / 2))
                 return state.Abort("Failed to write to coin database");
             // Update best block in wallet (so we can detect restored wallets).
             if (mode != FLUSH_STATE_IF_NEEDED) {
@@ -3490,19 +3718,41 @@ void FlushStateToDisk()
     FlushStateToDisk(state, FLUSH_STATE_ALWAYS);
 }
 
+/** Make the current chainActive tip visible to GetChainSnapshot() callers. */
+static void PublishChainSnapshot()
+{
+    boost::shared_ptr<const CChainSnapshot> pnew(new CChainSnapshot(chainActive.Tip()));
+    LOCK(cs_chainSnapshot);
+    pchainSnapshot = pnew;
+}
+
+boost::shared_ptr<const CChainSnapshot> GetChainSnapshot()
+{
+    LOCK(cs_chainSnapshot);
+    return pchainSnapshot;
+}
+
+CBlockIndex* LookupBlockIndex(const uint256& hash)
+{
+    LOCK(cs_mapBlockIndex);
+    BlockMap::const_iterator it = mapBlockIndex.find(hash);
+    return it == mapBlockIndex.end() ? NULL : it->second;
+}
+
 /** Update chainActive and related internal data structures. */
 void static UpdateTip(CBlockIndex* pindexNew)
 {
     chainActive.SetTip(pindexNew);
+    PublishChainSnapshot();
 
     // New best block
     nTimeBestReceived = GetTime();
     mempool.AddTransactionsUpdated(1);
 
-    LogPrintf("UpdateTip: new best=%s  height=%d  log2_work=%.8g  tx=%lu  date=%s progress=%f  cache=%u\n",
+    LogPrintf("UpdateTip: new best=%s  height=%d  log2_work=%.8g  tx=%lu  date=%s progress=%f  cache=%.1fMiB(%utx)\n",
         chainActive.Tip()->GetBlockHash().ToString(), chainActive.Height(), log(chainActive.Tip()->nChainWork.getdouble()) / log(2.0), (unsigned long)chainActive.Tip()->nChainTx,
         DateTimeStrFormat("%Y-%m-%d %H:%M:%S", chainActive.Tip()->GetBlockTime()),
-        Checkpoints::GuessVerificationProgress(chainActive.Tip()), (unsigned int)pcoinsTip->GetCacheSize());
+        Checkpoints::GuessVerificationProgress(chainActive.Tip()), pcoinsTip->DynamicMemoryUsage() * (1.0 / (1 << 20)), (unsigned int)pcoinsTip->GetCacheSize());
 
     cvBlockChange.notify_all();
 
@@ -4035,7 +4285,11 @@ CBlockIndex* AddToBlockIndex(const CBlock& block)
     // to avoid miners withholding blocks but broadcasting headers, to get a
     // competitive advantage.
     pindexNew->nSequenceId = 0;
-    BlockMap::iterator mi = mapBlockIndex.insert(make_pair(hash, pindexNew)).first;
+    BlockMap::iterator mi;
+    {
+        LOCK(cs_mapBlockIndex);
+        mi = mapBlockIndex.insert(make_pair(hash, pindexNew)).first;
+    }
 
     //mark as PoS seen
     if (pindexNew->IsProofOfStake())
@@ -4170,14 +4424,9 @@ bool FindBlockPos(CValidationState& state, CDiskBlockPos& pos, unsigned int nAdd
         unsigned int nOldChunks = (pos.nPos + BLOCKFILE_CHUNK_SIZE - 1) / BLOCKFILE_CHUNK_SIZE;
         unsigned int nNewChunks = (vinfoBlockFile[nFile].nSize + BLOCKFILE_CHUNK_SIZE - 1) / BLOCKFILE_CHUNK_SIZE;
         if (nNewChunks > nOldChunks) {
-            if (CheckDiskSpace(nNewChunks * BLOCKFILE_CHUNK_SIZE - pos.nPos)) {
-                FILE* file = OpenBlockFile(pos);
-                if (file) {
-                    LogPrintf("Pre-allocating up to position 0x%x in blk%05u.dat\n", nNewChunks * BLOCKFILE_CHUNK_SIZE, pos.nFile);
-                    AllocateFileRange(file, pos.nPos, nNewChunks * BLOCKFILE_CHUNK_SIZE - pos.nPos);
-                    fclose(file);
-                }
-            } else
+            if (CheckDiskSpace(nNewChunks * BLOCKFILE_CHUNK_SIZE - pos.nPos))
+                blockFileWriter.Allocate(pos, "blk", nNewChunks * BLOCKFILE_CHUNK_SIZE - pos.nPos);
+            else
                 return state.Error("out of disk space");
         }
     }
@@ -4200,14 +4449,9 @@ bool FindUndoPos(CValidationState& state, int nFile, CDiskBlockPos& pos, unsigne
     unsigned int nOldChunks = (pos.nPos + UNDOFILE_CHUNK_SIZE - 1) / UNDOFILE_CHUNK_SIZE;
     unsigned int nNewChunks = (nNewSize + UNDOFILE_CHUNK_SIZE - 1) / UNDOFILE_CHUNK_SIZE;
     if (nNewChunks > nOldChunks) {
-        if (CheckDiskSpace(nNewChunks * UNDOFILE_CHUNK_SIZE - pos.nPos)) {
-            FILE* file = OpenUndoFile(pos);
-            if (file) {
-                LogPrintf("Pre-allocating up to position 0x%x in rev%05u.dat\n", nNewChunks * UNDOFILE_CHUNK_SIZE, pos.nFile);
-                AllocateFileRange(file, pos.nPos, nNewChunks * UNDOFILE_CHUNK_SIZE - pos.nPos);
-                fclose(file);
-            }
-        } else
+        if (CheckDiskSpace(nNewChunks * UNDOFILE_CHUNK_SIZE - pos.nPos))
+            blockFileWriter.Allocate(pos, "rev", nNewChunks * UNDOFILE_CHUNK_SIZE - pos.nPos);
+        else
             return state.Error("out of disk space");
     }
 
@@ -4235,6 +4479,13 @@ bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, bool f
     return true;
 }
 
+/** Remember a block CheckBlock rejected, so ReprocessBlocks can consider it again */
+static void RejectBlock(const uint256& hash)
+{
+    LOCK(cs_mapRejectedBlocks);
+    mapRejectedBlocks.insert(make_pair(hash, GetTime()));
+}
+
 bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bool fCheckMerkleRoot, bool fCheckSig)
 {
     // These are checks that are independent of context.
@@ -4311,10 +4562,11 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bo
             if (!tx.IsCoinBase()) {
                 //only reject blocks when it's based on complete consensus
                 BOOST_FOREACH (const CTxIn& in, tx.vin) {
-                    if (mapLockedInputs.count(in.prevout)) {
-                        if (mapLockedInputs[in.prevout] != tx.GetHash()) {
-                            mapRejectedBlocks.insert(make_pair(block.GetHash(), GetTime()));
-                            LogPrintf("CheckBlock() : found conflicting transaction with transaction lock %s %s\n", mapLockedInputs[in.prevout].ToString(), tx.GetHash().ToString());
+                    uint256 txHashLocked;
+                    if (GetLockedInputTx(in.prevout, txHashLocked)) {
+                        if (txHashLocked != tx.GetHash()) {
+                            RejectBlock(block.GetHash());
+                            LogPrintf("CheckBlock() : found conflicting transaction with transaction lock %s %s\n", txHashLocked.ToString(), tx.GetHash().ToString());
                             return state.DoS(0, error("CheckBlock() : found conflicting transaction with transaction lock"),
                                 REJECT_INVALID, "conflicting-tx-ix");
                         }
@@ -4327,17 +4579,10 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bo
     }
 
     // fundamentalnode payments / budgets
-    CBlockIndex* pindexPrev = chainActive.Tip();
-    int nHeight = 0;
+    // CheckBlock also runs on worker threads, where the tip may have moved on, so take the height from the block's own parent
+    CBlockIndex* pindexPrev = LookupBlockIndex(block.hashPrevBlock);
+    int nHeight = pindexPrev ? pindexPrev->nHeight + 1 : 0;
     if (pindexPrev != NULL) {
-        if (pindexPrev->GetBlockHash() == block.hashPrevBlock) {
-            nHeight = pindexPrev->nHeight + 1;
-        } else { //out of order
-            BlockMap::iterator mi = mapBlockIndex.find(block.hashPrevBlock);
-            if (mi != mapBlockIndex.end() && (*mi).second)
-                nHeight = (*mi).second->nHeight + 1;
-        }
-
         // VITAE
         // It is entierly possible that we don't have enough data and this could fail
         // (i.e. the block could indeed be valid). Store the block for later consideration
@@ -4346,7 +4591,7 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bo
         // that this block is invalid, so don't issue an outright ban.
         if (nHeight != 0 && !IsInitialBlockDownload()) {
             if (!IsBlockPayeeValid(block, nHeight)) {
-                mapRejectedBlocks.insert(make_pair(block.GetHash(), GetTime()));
+                RejectBlock(block.GetHash());
                 return state.DoS(0, error("CheckBlock() : Couldn't find fundamentalnode/budget payment"),
                         REJECT_INVALID, "bad-cb-payee");
             }
@@ -4360,9 +4605,15 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bo
 
     // Check transactions
     bool fZerocoinActive = block.GetBlockTime() > Params().Zerocoin_StartTime();
+    // a block whose parent isn't known yet is taken to extend the tip
+    int nHeightSerialRange = nHeight;
+    if (pindexPrev == NULL) {
+        boost::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
+        nHeightSerialRange = chain && chain->Tip() ? chain->Tip()->nHeight + 1 : 0;
+    }
     vector<CBigNum> vBlockSerials;
     for (const CTransaction& tx : block.vtx) {
-        if (!CheckTransaction(tx, fZerocoinActive, chainActive.Height() + 1 >= Params().Zerocoin_Block_EnforceSerialRange(), state))
+        if (!CheckTransaction(tx, fZerocoinActive, nHeightSerialRange >= Params().Zerocoin_Block_EnforceSerialRange(), state))
             return error("CheckBlock() : CheckTransaction failed");
 
         // double check that there are no double spent zVITAE spends in this block
@@ -4471,10 +4722,11 @@ bool ContextualCheckBlockHeader(const CBlockHeader& block, CValidationState& sta
 
 bool IsBlockHashInChain(const uint256& hashBlock)
 {
-    if (hashBlock == 0 || !mapBlockIndex.count(hashBlock))
+    if (hashBlock == 0)
         return false;
 
-    return chainActive.Contains(mapBlockIndex[hashBlock]);
+    CBlockIndex* pindex = LookupBlockIndex(hashBlock);
+    return pindex && chainActive.Contains(pindex);
 }
 
 bool IsTransactionInChain(const uint256& txId, int& nHeightTx, CTransaction& tx)
@@ -4806,11 +5058,11 @@ void CBlockIndex::BuildSkip()
         pskip = pprev->GetAncestor(GetSkipHeight(nHeight));
 }
 
-bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDiskBlockPos* dbp)
+bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDiskBlockPos* dbp, bool fAlreadyChecked)
 {
     // Preliminary checks
     int64_t nStartTime = GetTimeMillis();
-    bool checked = CheckBlock(*pblock, state);
+    bool checked = fAlreadyChecked || CheckBlock(*pblock, state);
 
     int nMints = 0;
     int nSpends = 0;
@@ -4829,7 +5081,7 @@ bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDis
     if (nMints || nSpends)
         LogPrintf("%s : block contains %d zVITAE mints and %d zVITAE spends\n", __func__, nMints, nSpends);
 
-    if (!CheckBlockSignature(*pblock))
+    if (!fAlreadyChecked && !CheckBlockSignature(*pblock))
         return error("ProcessNewBlock() : bad proof-of-stake block signature");
 
     if (pblock->GetHash() != Params().HashGenesisBlock() && pfrom != NULL) {
@@ -4924,6 +5176,8 @@ bool AbortNode(const std::string& strMessage, const std::string& userMessage)
 {
     strMiscWarning = strMessage;
     LogPrintf("*** %s\n", strMessage);
+    // the node may not get to a clean shutdown, don't leave the cause in the log buffer
+    FlushDebugLog();
     uiInterface.ThreadSafeMessageBox(
         userMessage.empty() ? _("Error: A fatal internal error occured, see debug.log for details") : userMessage,
         "", CClientUIInterface::MSG_ERROR);
@@ -4948,6 +5202,9 @@ FILE* OpenDiskFile(const CDiskBlockPos& pos, const char* prefix, bool fReadOnly)
         return NULL;
     boost::filesystem::path path = GetBlockPosFilename(pos, prefix);
     boost::filesystem::create_directories(path.parent_path());
+    // Readers must not see the file before the writer thread caught up with it
+    if (fReadOnly)
+        blockFileWriter.WaitForPending(pos, prefix);
     FILE* file = fopen(path.string().c_str(), "rb+");
     if (!file && !fReadOnly)
         file = fopen(path.string().c_str(), "wb+");
@@ -4994,7 +5251,10 @@ CBlockIndex* InsertBlockIndex(uint256 hash)
     CBlockIndex* pindexNew = new CBlockIndex();
     if (!pindexNew)
         throw runtime_error("LoadBlockIndex() : new CBlockIndex failed");
-    mi = mapBlockIndex.insert(make_pair(hash, pindexNew)).first;
+    {
+        LOCK(cs_mapBlockIndex);
+        mi = mapBlockIndex.insert(make_pair(hash, pindexNew)).first;
+    }
 
     //mark as PoS seen
     if (pindexNew->IsProofOfStake())
@@ -5092,6 +5352,12 @@ bool static LoadBlockIndexDB(string& strError)
     pblocktree->ReadFlag("txindex", fTxIndex);
     LogPrintf("LoadBlockIndexDB(): transaction index %s\n", fTxIndex ? "enabled" : "disabled");
 
+    // Check whether we have the address and spent indexes
+    pblocktree->ReadFlag("addressindex", fAddressIndex);
+    LogPrintf("LoadBlockIndexDB(): address index %s\n", fAddressIndex ? "enabled" : "disabled");
+    pblocktree->ReadFlag("spentindex", fSpentIndex);
+    LogPrintf("LoadBlockIndexDB(): spent index %s\n", fSpentIndex ? "enabled" : "disabled");
+
     // If this is written true before the next client init, then we know the shutdown process failed
     pblocktree->WriteFlag("shutdown", false);
 
@@ -5100,6 +5366,7 @@ bool static LoadBlockIndexDB(string& strError)
     if (it == mapBlockIndex.end())
         return true;
     chainActive.SetTip(it->second);
+    PublishChainSnapshot();
 
     PruneBlockIndexCandidates();
 
@@ -5111,6 +5378,83 @@ bool static LoadBlockIndexDB(string& strError)
     return true;
 }
 
+/**
+ * Closure representing the level 0-2 checks of one block in VerifyDB. They
+ * don't depend on the blocks around it and run on the worker threads; the
+ * block read is kept for the checks that have to run in chain order.
+ */
+class CVerifyBlockCheck
+{
+private:
+    CVerifyBlockResult* presult;
+    int nCheckLevel;
+
+public:
+    CVerifyBlockCheck() : presult(NULL), nCheckLevel(0) {}
+    CVerifyBlockCheck(CVerifyBlockResult& resultIn, int nCheckLevelIn) : presult(&resultIn), nCheckLevel(nCheckLevelIn) {}
+
+    bool operator()();
+
+    void swap(CVerifyBlockCheck& check)
+    {
+        std::swap(presult, check.presult);
+        std::swap(nCheckLevel, check.nCheckLevel);
+    }
+};
+
+bool CVerifyBlockCheck::operator()()
+{
+    CBlockIndex* pindex = presult->pindex;
+    CBlock& block = presult->block;
+    CValidationState state;
+    presult->fChecked = true;
+    // check level 0: read from disk
+    if (!ReadBlockFromDisk(block, pindex))
+        presult->nFailedLevel = 0;
+    // check level 1: verify block validity
+    else if (nCheckLevel >= 1 && !CheckBlock(block, state))
+        presult->nFailedLevel = 1;
+    // check level 2: verify undo validity
+    else if (nCheckLevel >= 2) {
+        CBlockUndo undo;
+        CDiskBlockPos pos = pindex->GetUndoPos();
+        if (!pos.IsNull() && !undo.ReadFromDisk(pos, pindex->pprev->GetBlockHash()))
+            presult->nFailedLevel = 2;
+    }
+    return presult->nFailedLevel == -1;
+}
+
+static CCheckQueue<CVerifyBlockCheck> verifyblockqueue(1);
+
+void ThreadVerifyBlockCheck()
+{
+    RenameThread("vitae-verifych");
+    verifyblockqueue.Thread();
+}
+
+int CheckVerifyDBBatch(std::vector<CVerifyBlockResult>& vResults, int nCheckLevel, bool fParallel)
+{
+    if (fParallel && nScriptCheckThreads) {
+        std::vector<CVerifyBlockCheck> vChecks;
+        vChecks.reserve(vResults.size());
+        for (unsigned int i = 0; i < vResults.size(); i++)
+            vChecks.push_back(CVerifyBlockCheck(vResults[i], nCheckLevel));
+        CCheckQueueControl<CVerifyBlockCheck> control(&verifyblockqueue);
+        control.Add(vChecks);
+        control.Wait();
+    }
+
+    // the queue skips what is left once a check failed, so a block ahead of the failure may not have
+    // been checked; checking those here reports the same block as checking one after another does
+    for (unsigned int i = 0; i < vResults.size(); i++) {
+        if (!vResults[i].fChecked)
+            CVerifyBlockCheck(vResults[i], nCheckLevel)();
+        if (vResults[i].nFailedLevel != -1)
+            return i;
+    }
+    return -1;
+}
+
 CVerifyDB::CVerifyDB()
 {
     uiInterface.ShowProgress(_("Verifying blocks..."), 0);
@@ -5121,64 +5465,101 @@ CVerifyDB::~CVerifyDB()
     uiInterface.ShowProgress("", 100);
 }
 
-bool CVerifyDB::VerifyDB(CCoinsView* coinsview, int nCheckLevel, int nCheckDepth)
+bool CVerifyDB::VerifyDB(CCoinsView* coinsview, int nCheckLevel, int nCheckDepth, bool fParallel)
 {
-    LOCK(cs_main);
-    if (chainActive.Tip() == NULL || chainActive.Tip()->pprev == NULL)
-        return true;
+    // the check queue serves one VerifyDB at a time
+    static CCriticalSection cs_verifydb;
+    LOCK(cs_verifydb);
+
+    CBlockIndex* pindexTip;
+    int nTipHeight;
+    {
+        LOCK(cs_main);
+        if (chainActive.Tip() == NULL || chainActive.Tip()->pprev == NULL)
+            return true;
+        pindexTip = chainActive.Tip();
+        nTipHeight = chainActive.Height();
+    }
 
     // Verify blocks in the best chain
     if (nCheckDepth <= 0)
         nCheckDepth = 1000000000; // suffices until the year 19000
-    if (nCheckDepth > chainActive.Height())
-        nCheckDepth = chainActive.Height();
+    if (nCheckDepth > nTipHeight)
+        nCheckDepth = nTipHeight;
     nCheckLevel = std::max(0, std::min(4, nCheckLevel));
     LogPrintf("Verifying last %i blocks at level %i\n", nCheckDepth, nCheckLevel);
     CCoinsViewCache coins(coinsview);
-    CBlockIndex* pindexState = chainActive.Tip();
+    CBlockIndex* pindexState = pindexTip;
     CBlockIndex* pindexFailure = NULL;
     int nGoodTransactions = 0;
     CValidationState state;
-    for (CBlockIndex* pindex = chainActive.Tip(); pindex && pindex->pprev; pindex = pindex->pprev) {
+    CBlockIndex* pindexNext = pindexTip;
+    bool fDone = false;
+    while (!fDone && pindexNext && pindexNext->pprev) {
         boost::this_thread::interruption_point();
-        uiInterface.ShowProgress(_("Verifying blocks..."), std::max(1, std::min(99, (int)(((double)(chainActive.Height() - pindex->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100)))));
-        if (pindex->nHeight < chainActive.Height() - nCheckDepth)
-            break;
-        CBlock block;
-        // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex))
-            return error("VerifyDB() : *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
-        // check level 1: verify block validity
-        if (nCheckLevel >= 1 && !CheckBlock(block, state))
-            return error("VerifyDB() : *** found bad block at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
-        // check level 2: verify undo validity
-        if (nCheckLevel >= 2 && pindex) {
-            CBlockUndo undo;
-            CDiskBlockPos pos = pindex->GetUndoPos();
-            if (!pos.IsNull()) {
-                if (!undo.ReadFromDisk(pos, pindex->pprev->GetBlockHash()))
-                    return error("VerifyDB() : *** found bad undo data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
+
+        // take the next blocks down from the tip
+        std::vector<CVerifyBlockResult> vResults;
+        {
+            LOCK(cs_main);
+            if (chainActive.Tip() != pindexTip)
+                return error("VerifyDB() : chain tip changed during verification");
+            vResults.reserve(VERIFYDB_BATCH_SIZE);
+            for (; pindexNext && pindexNext->pprev && vResults.size() < VERIFYDB_BATCH_SIZE; pindexNext = pindexNext->pprev) {
+                if (pindexNext->nHeight < nTipHeight - nCheckDepth) {
+                    fDone = true;
+                    break;
+                }
+                vResults.push_back(CVerifyBlockResult());
+                vResults.back().pindex = pindexNext;
             }
         }
-        // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
-        if (nCheckLevel >= 3 && pindex == pindexState && (coins.GetCacheSize() + pcoinsTip->GetCacheSize()) <= nCoinCacheSize) {
-            bool fClean = true;
-            if (!DisconnectBlock(block, state, pindex, coins, &fClean))
-                return error("VerifyDB() : *** irrecoverable inconsistency in block data at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
-            pindexState = pindex->pprev;
-            if (!fClean) {
-                nGoodTransactions = 0;
-                pindexFailure = pindex;
-            } else
-                nGoodTransactions += block.vtx.size();
+        if (vResults.empty())
+            break;
+
+        // check level 0-2 of the whole batch, on the worker threads without cs_main as CheckBlock takes it when it needs it
+        int nFailed = CheckVerifyDBBatch(vResults, nCheckLevel, fParallel);
+
+        LOCK(cs_main);
+        if (chainActive.Tip() != pindexTip)
+            return error("VerifyDB() : chain tip changed during verification");
+        for (unsigned int i = 0; i < vResults.size(); i++) {
+            CBlockIndex* pindex = vResults[i].pindex;
+            uiInterface.ShowProgress(_("Verifying blocks..."), std::max(1, std::min(99, (int)(((double)(nTipHeight - pindex->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100)))));
+            if ((int)i != nFailed)
+                continue;
+            if (vResults[i].nFailedLevel == 0)
+                return error("VerifyDB() : *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+            if (vResults[i].nFailedLevel == 1)
+                return error("VerifyDB() : *** found bad block at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
+            return error("VerifyDB() : *** found bad undo data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
+        }
+
+        // check level 3: check for inconsistencies during memory-only disconnect of tip blocks, in chain order
+        for (unsigned int i = 0; i < vResults.size(); i++) {
+            CBlockIndex* pindex = vResults[i].pindex;
+            if (nCheckLevel >= 3 && pindex == pindexState && (coins.DynamicMemoryUsage() + pcoinsTip->DynamicMemoryUsage()) <= nCoinCacheUsage) {
+                bool fClean = true;
+                if (!DisconnectBlock(vResults[i].block, state, pindex, coins, &fClean))
+                    return error("VerifyDB() : *** irrecoverable inconsistency in block data at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+                pindexState = pindex->pprev;
+                if (!fClean) {
+                    nGoodTransactions = 0;
+                    pindexFailure = pindex;
+                } else
+                    nGoodTransactions += vResults[i].block.vtx.size();
+            }
         }
         if (ShutdownRequested())
             return true;
     }
     if (pindexFailure)
-        return error("VerifyDB() : *** coin database inconsistencies found (last %i blocks, %i good transactions before that)\n", chainActive.Height() - pindexFailure->nHeight + 1, nGoodTransactions);
+        return error("VerifyDB() : *** coin database inconsistencies found (last %i blocks, %i good transactions before that)\n", nTipHeight - pindexFailure->nHeight + 1, nGoodTransactions);
 
     // check level 4: try reconnecting blocks
+    LOCK(cs_main);
+    if (chainActive.Tip() != pindexTip)
+        return error("VerifyDB() : chain tip changed during verification");
     if (nCheckLevel >= 4) {
         CBlockIndex* pindex = pindexState;
         while (pindex != chainActive.Tip()) {
@@ -5200,9 +5581,13 @@ bool CVerifyDB::VerifyDB(CCoinsView* coinsview, int nCheckLevel, int nCheckDepth
 
 void UnloadBlockIndex()
 {
-    mapBlockIndex.clear();
+    {
+        LOCK(cs_mapBlockIndex);
+        mapBlockIndex.clear();
+    }
     setBlockIndexCandidates.clear();
     chainActive.SetTip(NULL);
+    PublishChainSnapshot();
     pindexBestInvalid = NULL;
 }
 
@@ -5225,6 +5610,12 @@ bool InitBlockIndex()
     // Use the provided setting for -txindex in the new database
     fTxIndex = GetBoolArg("-txindex", true);
     pblocktree->WriteFlag("txindex", fTxIndex);
+
+    // Use the provided setting for -addressindex and -spentindex in the new database
+    fAddressIndex = GetBoolArg("-addressindex", false);
+    pblocktree->WriteFlag("addressindex", fAddressIndex);
+    fSpentIndex = GetBoolArg("-spentindex", false);
+    pblocktree->WriteFlag("spentindex", fSpentIndex);
     LogPrintf("Initializing databases...\n");
 
     // Only add the genesis block if not reindexing (in which case we reuse the one already on disk)
@@ -5255,98 +5646,136 @@ bool InitBlockIndex()
 }
 
 
-bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos* dbp)
+// Map of disk positions for blocks with unknown parent (only used for reindex)
+static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
+
+/** Process a block taken out of the import queue, false on a system error that ends the import */
+static bool ProcessImportBlock(CImportBlock& entry, int& nLoaded)
+{
+    if (!entry.fValid)
+        return true;
+    CBlock& block = entry.block;
+    CDiskBlockPos* dbp = entry.pos.IsNull() ? NULL : &entry.pos;
+    try {
+        // detect out of order blocks, and store them for later
+        uint256 hash = entry.hash;
+        if (hash != Params().HashGenesisBlock() && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
+            LogPrint("reindex", "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                block.hashPrevBlock.ToString());
+            if (dbp)
+                mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+            return true;
+        }
+
+        // process in case the block isn't known yet
+        if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
+            CValidationState state;
+            if (ProcessNewBlock(state, NULL, &block, dbp, entry.fChecked))
+                nLoaded++;
+            if (state.IsError())
+                return false;
+        } else if (hash != Params().HashGenesisBlock() && mapBlockIndex[hash]->nHeight % 1000 == 0) {
+            LogPrintf("Block Import: already had block %s at height %d\n", hash.ToString(), mapBlockIndex[hash]->nHeight);
+        }
+
+        // Recursively process earlier encountered successors of this block
+        deque<uint256> queue;
+        queue.push_back(hash);
+        while (!queue.empty()) {
+            uint256 head = queue.front();
+            queue.pop_front();
+            std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
+            while (range.first != range.second) {
+                std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
+                if (ReadBlockFromDisk(block, it->second)) {
+                    LogPrintf("%s: Processing out of order child %s of %s\n", __func__, block.GetHash().ToString(),
+                        head.ToString());
+                    CValidationState dummy;
+                    if (ProcessNewBlock(dummy, NULL, &block, &it->second)) {
+                        nLoaded++;
+                        queue.push_back(block.GetHash());
+                    }
+                }
+                range.first++;
+                mapBlocksUnknownParent.erase(it);
+            }
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    return true;
+}
+
+bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos* dbp, CBlockImportQueue* pimportQueue)
 {
-    // Map of disk positions for blocks with unknown parent (only used for reindex)
-    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
     int64_t nStart = GetTimeMillis();
 
     int nLoaded = 0;
+    // Blocks are deserialized and checked on the worker threads while earlier ones are processed here
+    boost::scoped_ptr<CBlockImportQueue> importQueueLocal;
+    if (!pimportQueue) {
+        importQueueLocal.reset(new CBlockImportQueue(nScriptCheckThreads ? nScriptCheckThreads - 1 : 0));
+        pimportQueue = importQueueLocal.get();
+    }
+    CBlockImportQueue& importQueue = *pimportQueue;
     try {
         // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
         CBufferedFile blkdat(fileIn, 2 * MAX_BLOCK_SIZE_CURRENT, MAX_BLOCK_SIZE_CURRENT + 8, SER_DISK, CLIENT_VERSION);
         uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
+        while (true) {
             boost::this_thread::interruption_point();
 
-            blkdat.SetPos(nRewind);
-            nRewind++;         // start one byte further next time, in case of failure
-            blkdat.SetLimit(); // remove former limit
-            unsigned int nSize = 0;
-            try {
-                // locate a header
-                unsigned char buf[MESSAGE_START_SIZE];
-                blkdat.FindByte(Params().MessageStart()[0]);
-                nRewind = blkdat.GetPos() + 1;
-                blkdat >> FLATDATA(buf);
-                if (memcmp(buf, Params().MessageStart(), MESSAGE_START_SIZE))
-                    continue;
-                // read size
-                blkdat >> nSize;
-                if (nSize < 80 || nSize > MAX_BLOCK_SIZE_CURRENT)
-                    continue;
-            } catch (const std::exception&) {
-                // no valid block header found; don't complain
-                break;
-            }
-            try {
-                // read block
-                uint64_t nBlockPos = blkdat.GetPos();
-                if (dbp)
-                    dbp->nPos = nBlockPos;
-                blkdat.SetLimit(nBlockPos + nSize);
-                blkdat.SetPos(nBlockPos);
-                CBlock block;
-                blkdat >> block;
-                nRewind = blkdat.GetPos();
-
-                // detect out of order blocks, and store them for later
-                uint256 hash = block.GetHash();
-                if (hash != Params().HashGenesisBlock() && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
-                    LogPrint("reindex", "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                        block.hashPrevBlock.ToString());
-                    if (dbp)
-                        mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
-                    continue;
-                }
-
-                // process in case the block isn't known yet
-                if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
-                    CValidationState state;
-                    if (ProcessNewBlock(state, NULL, &block, dbp))
-                        nLoaded++;
-                    if (state.IsError())
-                        break;
-                } else if (hash != Params().HashGenesisBlock() && mapBlockIndex[hash]->nHeight % 1000 == 0) {
-                    LogPrintf("Block Import: already had block %s at height %d\n", hash.ToString(), mapBlockIndex[hash]->nHeight);
+            // read ahead until the workers have enough to do
+            if (!importQueue.IsFull()) {
+                if (blkdat.eof())
+                    break;
+                blkdat.SetPos(nRewind);
+                nRewind++;         // start one byte further next time, in case of failure
+                blkdat.SetLimit(); // remove former limit
+                unsigned int nSize = 0;
+                try {
+                    // locate a header
+                    unsigned char buf[MESSAGE_START_SIZE];
+                    blkdat.FindByte(Params().MessageStart()[0]);
+                    nRewind = blkdat.GetPos() + 1;
+                    blkdat >> FLATDATA(buf);
+                    if (memcmp(buf, Params().MessageStart(), MESSAGE_START_SIZE))
+                        continue;
+                    // read size
+                    blkdat >> nSize;
+                    if (nSize < 80 || nSize > MAX_BLOCK_SIZE_CURRENT)
+                        continue;
+                } catch (const std::exception&) {
+                    // no valid block header found; don't complain
+                    break;
                 }
-
-                // Recursively process earlier encountered successors of this block
-                deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
-                        if (ReadBlockFromDisk(block, it->second)) {
-                            LogPrintf("%s: Processing out of order child %s of %s\n", __func__, block.GetHash().ToString(),
-                                head.ToString());
-                            CValidationState dummy;
-                            if (ProcessNewBlock(dummy, NULL, &block, &it->second)) {
-                                nLoaded++;
-                                queue.push_back(block.GetHash());
-                            }
-                        }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                    }
+                try {
+                    // read the raw block, the workers deserialize it
+                    uint64_t nBlockPos = blkdat.GetPos();
+                    blkdat.SetLimit(nBlockPos + nSize);
+                    blkdat.SetPos(nBlockPos);
+                    boost::shared_ptr<CImportBlock> entry(new CImportBlock());
+                    entry->vchBlock.resize(nSize);
+                    blkdat.read(&entry->vchBlock[0], nSize);
+                    nRewind = blkdat.GetPos();
+                    entry->nSize = nSize;
+                    if (dbp)
+                        entry->pos = CDiskBlockPos(dbp->nFile, nBlockPos);
+                    importQueue.Push(entry);
+                } catch (const std::exception& e) {
+                    LogPrintf("%s : Deserialize or I/O error - %s", __func__, e.what());
                 }
-            } catch (const std::exception& e) {
-                LogPrintf("%s : Deserialize or I/O error - %s", __func__, e.what());
+                continue;
             }
+
+            // process the oldest block, in file order
+            boost::shared_ptr<CImportBlock> entry = importQueue.Pop();
+            if (!ProcessImportBlock(*entry, nLoaded))
+                break;
         }
+        // without a queue shared with the next file, process what is left of this one
+        if (importQueueLocal)
+            FlushBlockImportQueue(importQueue);
     } catch (const std::runtime_error& e) {
         AbortNode(std::string("System error: ") + e.what());
     }
@@ -5355,6 +5784,18 @@ bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos* dbp)
     return nLoaded > 0;
 }
 
+bool FlushBlockImportQueue(CBlockImportQueue& importQueue)
+{
+    int nLoaded = 0;
+    while (!importQueue.IsEmpty()) {
+        boost::this_thread::interruption_point();
+        boost::shared_ptr<CImportBlock> entry = importQueue.Pop();
+        if (!ProcessImportBlock(*entry, nLoaded))
+            break;
+    }
+    return nLoaded > 0;
+}
+
 void static CheckBlockIndex()
 {
     if (!fCheckBlockIndex) {
@@ -5574,8 +6015,10 @@ bool static AlreadyHave(const CInv& inv)
                mapTxLockReqRejected.count(inv.hash);
     case MSG_TXLOCK_VOTE:
         return mapTxLockVote.count(inv.hash);
-    case MSG_SPORK:
+    case MSG_SPORK: {
+        LOCK(cs_mapSporks);
         return mapSporks.count(inv.hash);
+    }
     case MSG_FUNDAMENTALNODE_WINNER:
         if (fundamentalnodePayments.mapFundamentalnodePayeeVotes.count(inv.hash)) {
             fundamentalnodeSync.AddedFundamentalnodeWinner(inv.hash);
@@ -5743,6 +6186,7 @@ void static ProcessGetData(CNode* pfrom)
                     }
                 }
                 if (!pushed && inv.type == MSG_SPORK) {
+                    LOCK(cs_mapSporks);
                     if (mapSporks.count(inv.hash)) {
                         CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
                         ss.reserve(1000);
@@ -5832,6 +6276,7 @@ void static ProcessGetData(CNode* pfrom)
                 }
 
                 if (!pushed && inv.type == MSG_MN_SPORK) {
+                    LOCK(cs_mapSporks);
                     if(mapSporks.count(inv.hash)){
                         CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
                         ss.reserve(1000);
@@ -6766,6 +7211,37 @@ int ActiveProtocol()
     return MIN_PEER_PROTO_VERSION_BEFORE_ENFORCEMENT;
 }
 
+/**
+ * Check the signatures of the fundamentalnode and masternode messages waiting from a peer,
+ * starting at itBegin, in parallel. ProcessMessage then finds the results in
+ * the message signature cache, while the messages are still processed one by
+ * one and in order. Requires LOCK(cs_vRecvMsg).
+ */
+static void BatchCheckFundamentalnodeSignatures(CNode* pfrom, std::deque<CNetMessage>::iterator itBegin)
+{
+    std::vector<CFundamentalnodeSigCheck> vChecks;
+    // not a vector<bool>, every check writes its own result from a worker thread
+    bool vValid[MAX_FUNDAMENTALNODE_SIGCHECK_BATCH] = {};
+    for (std::deque<CNetMessage>::iterator it = itBegin; it != pfrom->vRecvMsg.end() && it->complete(); it++) {
+        if (vChecks.size() >= MAX_FUNDAMENTALNODE_SIGCHECK_BATCH)
+            break;
+        if (it->fSigChecked)
+            continue;
+        it->fSigChecked = true;
+        std::string strCommand = it->hdr.GetCommand();
+        if (IsFundamentalnodeSigMessage(strCommand))
+            vChecks.push_back(CFundamentalnodeSigCheck(strCommand, it->vRecv, &vValid[vChecks.size()]));
+    }
+    if (vChecks.size() <= 1)
+        return;
+
+    size_t nChecks = vChecks.size();
+    CheckFundamentalnodeSignatures(vChecks);
+    size_t nInvalid = std::count(vValid, vValid + nChecks, false);
+    if (nInvalid)
+        LogPrint("fundamentalnode", "%s : %u of %u signatures from peer=%d are invalid\n", __func__, nInvalid, nChecks, pfrom->id);
+}
+
 // requires LOCK(cs_vRecvMsg)
 bool ProcessMessages(CNode* pfrom)
 {
@@ -6806,6 +7282,9 @@ bool ProcessMessages(CNode* pfrom)
         if (!msg.complete())
             break;
 
+        if (nScriptCheckThreads && !msg.fSigChecked && IsFundamentalnodeSigMessage(msg.hdr.GetCommand()))
+            BatchCheckFundamentalnodeSignatures(pfrom, it);
+
         // at this point, any failure means we can delete the current message
         it++;
 
@@ -7105,45 +7584,52 @@ bool SendMessages(CNode* pto, bool fSendTrickle)
 
 bool CBlockUndo::WriteToDisk(CDiskBlockPos& pos, const uint256& hashBlock)
 {
-    // Open history file to append
-    CAutoFile fileout(OpenUndoFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("CBlockUndo::WriteToDisk : OpenUndoFile failed");
-
-    // Write index header
-    unsigned int nSize = fileout.GetSerializeSize(*this);
-    fileout << FLATDATA(Params().MessageStart()) << nSize;
-
-    // Write undo data
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0)
-        return error("CBlockUndo::WriteToDisk : ftell failed");
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << *this;
+    // Serialize index header and undo data, the block file writer puts them at pos
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    unsigned int nSize = ss.GetSerializeSize(*this);
+    ss << FLATDATA(Params().MessageStart()) << nSize;
+    unsigned int nHeaderSize = ss.size();
+    ss << *this;
 
     // calculate & write checksum
     CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
     hasher << hashBlock;
     hasher << *this;
-    fileout << hasher.GetHash();
+    ss << hasher.GetHash();
+
+    if (!blockFileWriter.Write(pos, "rev", ss))
+        return error("CBlockUndo::WriteToDisk : Failed to write undo file");
+    pos.nPos += nHeaderSize;
 
     return true;
 }
 
 bool CBlockUndo::ReadFromDisk(const CDiskBlockPos& pos, const uint256& hashBlock)
 {
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("CBlockUndo::ReadFromDisk : OpenBlockFile failed");
-
-    // Read block
     uint256 hashChecksum;
-    try {
-        filein >> *this;
-        filein >> hashChecksum;
-    } catch (const std::exception& e) {
-        return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+
+    // Undo data that is still queued for writing is read from memory
+    CDataStream ssPending(SER_DISK, CLIENT_VERSION);
+    if (blockFileWriter.ReadPending(pos, "rev", ssPending)) {
+        try {
+            ssPending >> *this;
+            ssPending >> hashChecksum;
+        } catch (const std::exception& e) {
+            return error("%s : Deserialize error - %s", __func__, e.what());
+        }
+    } else {
+        // Open history file to read
+        CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return error("CBlockUndo::ReadFromDisk : OpenBlockFile failed");
+
+        // Read block
+        try {
+            filein >> *this;
+            filein >> hashChecksum;
+        } catch (const std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
     }
 
     // Verify checksum
@@ -13,6 +13,7 @@
 #include "config/vitae-config.h"
 #endif
 
+#include "addressindex.h"
 #include "amount.h"
 #include "chain.h"
 #include "chainparams.h"
@@ -25,6 +26,7 @@
 #include "script/script.h"
 #include "script/sigcache.h"
 #include "script/standard.h"
+#include "spentindex.h"
 #include "sync.h"
 #include "tinyformat.h"
 #include "txmempool.h"
@@ -42,8 +44,10 @@
 
 #include "libzerocoin/CoinSpend.h"
 
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 
+class CBlockImportQueue;
 class CBlockIndex;
 class CBlockTreeDB;
 class CZerocoinDB;
@@ -89,6 +93,8 @@ static const int COINBASE_MATURITY = 100;
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Number of blocks VerifyDB checks on the script-checking threads before it disconnects them in chain order */
+static const unsigned int VERIFYDB_BATCH_SIZE = 64;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -138,9 +144,11 @@ extern bool fImporting;
 extern bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
+extern bool fAddressIndex;
+extern bool fSpentIndex;
 extern bool fIsBareMultisigStd;
 extern bool fCheckBlockIndex;
-extern unsigned int nCoinCacheSize;
+extern size_t nCoinCacheUsage;
 extern CFeeRate minRelayTxFee;
 extern bool fAlerts;
 extern bool fVerifyingBlocks;
@@ -153,6 +161,8 @@ extern int64_t nLastCoinStakeSearchInterval;
 extern int64_t nLastCoinStakeSearchTime;
 extern int64_t nReserveBalance;
 
+/** Blocks rejected for a missing payment or a transaction lock conflict, CheckBlock adds to it from worker threads */
+extern CCriticalSection cs_mapRejectedBlocks;
 extern std::map<uint256, int64_t> mapRejectedBlocks;
 extern std::map<unsigned int, unsigned int> mapHashedBlocks;
 extern std::set<std::pair<COutPoint, unsigned int> > setStakeSeen;
@@ -189,7 +199,7 @@ void UnregisterNodeSignals(CNodeSignals& nodeSignals);
  * @param[out]  dbp     If pblock is stored to disk (or already there), this will be set to its location.
  * @return True if state.IsValid()
  */
-bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDiskBlockPos* dbp = NULL);
+bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDiskBlockPos* dbp = NULL, bool fAlreadyChecked = false);
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
 /** Open a block file (blk?????.dat) */
@@ -198,8 +208,10 @@ FILE* OpenBlockFile(const CDiskBlockPos& pos, bool fReadOnly = false);
 FILE* OpenUndoFile(const CDiskBlockPos& pos, bool fReadOnly = false);
 /** Translation to a filesystem path */
 boost::filesystem::path GetBlockPosFilename(const CDiskBlockPos& pos, const char* prefix);
-/** Import blocks from an external file */
-bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos* dbp = NULL);
+/** Import blocks from an external file, blocks still in a shared queue are left for the next file */
+bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos* dbp = NULL, CBlockImportQueue* pimportQueue = NULL);
+/** Process the blocks left in an import queue */
+bool FlushBlockImportQueue(CBlockImportQueue& importQueue);
 /** Initialize a new block tree database + block data on disk */
 bool InitBlockIndex();
 /** Load the block tree and coins database from disk */
@@ -219,6 +231,8 @@ bool ProcessMessages(CNode* pfrom);
 bool SendMessages(CNode* pto, bool fSendTrickle);
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the thread checking blocks for VerifyDB */
+void ThreadVerifyBlockCheck();
 
 // ***TODO*** probably not the right place for these 2
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
@@ -230,6 +244,14 @@ bool IsInitialBlockDownload();
 std::string GetWarnings(std::string strFor);
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
 bool GetTransaction(const uint256& hash, CTransaction& tx, uint256& hashBlock, bool fAllowSlow = false);
+/** Map an output script to its address index entry; false if it does not pay to an address */
+bool ExtractAddressIndexKey(const CScript& scriptPubKey, int& addressType, uint160& addressHash);
+/** Look up the input that spent an output (requires -spentindex) */
+bool GetSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value);
+/** Retrieve the credits and debits of an address, optionally limited to a height range (requires -addressindex) */
+bool GetAddressIndex(const uint160& addressHash, int type, std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex, int nStart = 0, int nEnd = 0);
+/** Retrieve the unspent outputs of an address (requires -addressindex) */
+bool GetAddressUnspent(const uint160& addressHash, int type, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& unspentOutputs);
 /** Find the best known block, and make it the tip of the block chain */
 
 bool DisconnectBlocksAndReprocess(int blocks);
@@ -442,6 +464,8 @@ public:
 bool WriteBlockToDisk(CBlock& block, CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex);
+/** Read a block without holding cs_main, only its position is copied under the lock */
+bool ReadBlockFromDiskUnlocked(CBlock& block, const CBlockIndex* pindex);
 
 
 /** Functions for validating blocks and updating the block tree */
@@ -612,9 +636,29 @@ class CVerifyDB
 public:
     CVerifyDB();
     ~CVerifyDB();
-    bool VerifyDB(CCoinsView* coinsview, int nCheckLevel, int nCheckDepth);
+    /** Callers holding cs_main must not check in parallel, the checks on the worker threads take it */
+    bool VerifyDB(CCoinsView* coinsview, int nCheckLevel, int nCheckDepth, bool fParallel = true);
 };
 
+/** Outcome of the level 0-2 checks of one block in VerifyDB */
+struct CVerifyBlockResult {
+    CBlockIndex* pindex;
+    CBlock block;
+    //! Level of the check that failed, -1 while none did
+    int nFailedLevel;
+    //! Whether the checks ran, a batch stops early once one of its blocks failed
+    bool fChecked;
+
+    CVerifyBlockResult() : pindex(NULL), nFailedLevel(-1), fChecked(false) {}
+};
+
+/**
+ * Run the level 0-2 checks of a batch of blocks, on the worker threads if
+ * fParallel and -par allow it. Returns the index of the first block in the
+ * batch that failed, the blocks after it may not have been checked, or -1.
+ */
+int CheckVerifyDBBatch(std::vector<CVerifyBlockResult>& vResults, int nCheckLevel, bool fParallel);
+
 /** Find the last common block between the parameter chain and a locator. */
 CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& locator);
 
@@ -627,6 +671,12 @@ bool ReconsiderBlock(CValidationState& state, CBlockIndex* pindex);
 /** The currently-connected chain of blocks. */
 extern CChain chainActive;
 
+/** The active chain as of the last tip change; safe to use without cs_main */
+boost::shared_ptr<const CChainSnapshot> GetChainSnapshot();
+
+/** Find a block index entry by hash without holding cs_main; NULL if unknown */
+CBlockIndex* LookupBlockIndex(const uint256& hash);
+
 /** Global variable that points to the active CCoinsView (protected by cs_main) */
 extern CCoinsViewCache* pcoinsTip;
 
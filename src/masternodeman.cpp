@@ -45,39 +45,17 @@ struct CompareValueOnlyMN
 // CMasternodeDB
 //
 
-CMasternodeDB::CMasternodeDB()
+CMasternodeDB::CMasternodeDB() : CCacheFile("mncache.dat", "MasternodeCache")
 {
-    pathMN = GetDataDir() / "mncache.dat";
-    strMagicMessage = "MasternodeCache";
 }
 
 bool CMasternodeDB::Write(const CMasternodeMan& mnodemanToSave)
 {
     int64_t nStart = GetTimeMillis();
 
-    // serialize, checksum data up to that point, then append checksum
-    CDataStream ssMasternodes(SER_DISK, CLIENT_VERSION);
-    ssMasternodes << strMagicMessage; // masternode cache file specific magic message
-    ssMasternodes << FLATDATA(Params().MessageStart()); // network specific magic number
-    ssMasternodes << mnodemanToSave;
-    uint256 hash = Hash(ssMasternodes.begin(), ssMasternodes.end());
-    ssMasternodes << hash;
-
-    // open output file, and associate with CAutoFile
-    FILE *file = fopen(pathMN.string().c_str(), "wb");
-    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("%s : Failed to open file %s", __func__, pathMN.string());
-
-    // Write and commit header, data
-    try {
-        fileout << ssMasternodes;
-    }
-    catch (const std::exception &e) {
-        return error("%s : Serialize or I/O error - %s", __func__, e.what());
-    }
-    //FileCommit(fileout);
-    fileout.fclose();
+    mnodemanToSave.WriteCache(*this);
+    if (!CCacheFile::Write())
+        return false;
 
     LogPrintf("Written info to mncache.dat  %dms\n", GetTimeMillis() - nStart);
     LogPrintf("  %s\n", mnodemanToSave.ToString());
@@ -88,71 +66,17 @@ bool CMasternodeDB::Write(const CMasternodeMan& mnodemanToSave)
 CMasternodeDB::ReadResult CMasternodeDB::Read(CMasternodeMan& mnodemanToLoad)
 {
     int64_t nStart = GetTimeMillis();
-    // open input file, and associate with CAutoFile
-    FILE *file = fopen(pathMN.string().c_str(), "rb");
-    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-    {
-        error("%s : Failed to open file %s", __func__, pathMN.string());
-        return FileError;
-    }
 
-    // use file size to size memory buffer
-    int fileSize = boost::filesystem::file_size(pathMN);
-    int dataSize = fileSize - sizeof(uint256);
-    // Don't try to resize to a negative number if file is small
-    if (dataSize < 0)
-        dataSize = 0;
-    vector<unsigned char> vchData;
-    vchData.resize(dataSize);
-    uint256 hashIn;
-
-    // read data and checksum from file
-    try {
-        filein.read((char *)&vchData[0], dataSize);
-        filein >> hashIn;
-    }
-    catch (const std::exception &e) {
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return HashReadError;
-    }
-    filein.fclose();
-
-    CDataStream ssMasternodes(vchData, SER_DISK, CLIENT_VERSION);
-
-    // verify stored checksum matches input data
-    uint256 hashTmp = Hash(ssMasternodes.begin(), ssMasternodes.end());
-    if (hashIn != hashTmp)
-    {
-        error("%s : Checksum mismatch, data corrupted", __func__);
-        return IncorrectHash;
-    }
+    ReadResult result = Open();
+    if (result != Ok)
+        return result;
 
-    unsigned char pchMsgTmp[4];
-    std::string strMagicMessageTmp;
     try {
-        // de-serialize file header (masternode cache file specific magic message) and ..
-
-        ssMasternodes >> strMagicMessageTmp;
-
-        // ... verify the message matches predefined one
-        if (strMagicMessage != strMagicMessageTmp)
-        {
-            error("%s : Invalid masternode cache magic message", __func__);
-            return IncorrectMagicMessage;
-        }
-
-        // de-serialize file header (network specific magic number) and ..
-        ssMasternodes >> FLATDATA(pchMsgTmp);
-
-        // ... verify the network matches ours
-        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
-        {
-            error("%s : Invalid network magic number", __func__);
-            return IncorrectMagicNumber;
-        }
         // de-serialize data into CMasternodeMan object
-        ssMasternodes >> mnodemanToLoad;
+        if (!mnodemanToLoad.ReadCache(*this)) {
+            mnodemanToLoad.Clear();
+            return IncorrectFormat;
+        }
     }
     catch (const std::exception &e) {
         mnodemanToLoad.Clear();
@@ -172,10 +96,9 @@ void DumpMasternodes()
     int64_t nStart = GetTimeMillis();
 
     CMasternodeDB mndb;
-    CMasternodeMan tempMnodeman;
 
     LogPrintf("Verifying mncache.dat format...\n");
-    CMasternodeDB::ReadResult readResult = mndb.Read(tempMnodeman);
+    CMasternodeDB::ReadResult readResult = mndb.Open();
     // there was an error and it was not an error on file openning => do not proceed
     if (readResult == CMasternodeDB::FileError)
         LogPrintf("Missing masternode cache file - mncache.dat, will try to recreate\n");
@@ -200,50 +123,101 @@ CMasternodeMan::CMasternodeMan() {
     nDsqCount = 0;
 }
 
-bool CMasternodeMan::Add(CMasternode &mn)
+void CMasternodeMan::WriteCache(CCacheFile& file) const
 {
+    std::vector<CMasternode> vMasternodes = CopyMasternodes();
     LOCK(cs);
+    file.AddChunk("list") << vMasternodes << mAskedUsForMasternodeList << mWeAskedForMasternodeList << mWeAskedForMasternodeListEntry << nDsqCount;
+}
 
-    if (!mn.IsEnabled())
+bool CMasternodeMan::ReadCache(const CCacheFile& file)
+{
+    CDataStream ssList(SER_DISK, CLIENT_VERSION);
+    if (!file.ReadChunk("list", ssList))
         return false;
 
-    CMasternode *pmn = Find(mn.vin);
+    std::vector<CMasternode> vMasternodes;
+    ssList >> vMasternodes;
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        shards[i].vMasternodes.clear();
+    }
+    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
+        CMasternodeShard& shard = GetShard(mn.vin.prevout);
+        LOCK(shard.cs);
+        shard.vMasternodes.push_back(mn);
+    }
+
+    LOCK(cs);
+    ssList >> mAskedUsForMasternodeList >> mWeAskedForMasternodeList >> mWeAskedForMasternodeListEntry >> nDsqCount;
+    return true;
+}
+
+std::vector<CMasternode> CMasternodeMan::CopyMasternodes() const
+{
+    std::vector<CMasternode> vMasternodes;
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        vMasternodes.insert(vMasternodes.end(), shards[i].vMasternodes.begin(), shards[i].vMasternodes.end());
+    }
+    return vMasternodes;
+}
+
+int CMasternodeMan::size() const
+{
+    int nSize = 0;
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        nSize += shards[i].vMasternodes.size();
+    }
+    return nSize;
+}
+
+bool CMasternodeMan::Add(CMasternode &mn)
+{
+    if (!mn.IsEnabled())
+        return false;
 
-    if (pmn == NULL)
     {
-        if(fDebug) LogPrintf("CMasternodeMan: Adding new Masternode %s - %i now\n", mn.addr.ToString().c_str(), size() + 1);
-        vMasternodes.push_back(mn);
-        return true;
+        CMasternodeShard& shard = GetShard(mn.vin.prevout);
+        LOCK(shard.cs);
+        if (Find(mn.vin) != NULL)
+            return false;
+        shard.vMasternodes.push_back(mn);
     }
 
-    return false;
+    if(fDebug) LogPrintf("CMasternodeMan: Adding new Masternode %s - %i now\n", mn.addr.ToString().c_str(), size());
+    return true;
 }
 
 void CMasternodeMan::Check()
 {
-    LOCK(cs);
-
-    BOOST_FOREACH(CMasternode& mn, vMasternodes)
-        mn.Check();
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH(CMasternode& mn, shards[i].vMasternodes)
+            mn.Check();
+    }
 }
 
 void CMasternodeMan::CheckAndRemove()
 {
-    LOCK(cs);
-
-    Check();
-
     //remove inactive
-    vector<CMasternode>::iterator it = vMasternodes.begin();
-    while(it != vMasternodes.end()){
-        if((*it).activeState == CMasternode::MASTERNODE_REMOVE || (*it).activeState == CMasternode::MASTERNODE_VIN_SPENT){
-            if(fDebug) LogPrintf("CMasternodeMan: Removing inactive Masternode %s - %i now\n", (*it).addr.ToString().c_str(), size() - 1);
-            it = vMasternodes.erase(it);
-        } else {
-            ++it;
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        vector<CMasternode>::iterator it = shards[i].vMasternodes.begin();
+        while(it != shards[i].vMasternodes.end()){
+            (*it).Check();
+            if((*it).activeState == CMasternode::MASTERNODE_REMOVE || (*it).activeState == CMasternode::MASTERNODE_VIN_SPENT){
+                if(fDebug) LogPrintf("CMasternodeMan: Removing inactive Masternode %s\n", (*it).addr.ToString().c_str());
+                it = shards[i].vMasternodes.erase(it);
+            } else {
+                ++it;
+            }
         }
     }
 
+    LOCK(cs);
+
     // check who's asked for the Masternode list
     map<CNetAddr, int64_t>::iterator it1 = mAskedUsForMasternodeList.begin();
     while(it1 != mAskedUsForMasternodeList.end()){
@@ -278,8 +252,12 @@ void CMasternodeMan::CheckAndRemove()
 
 void CMasternodeMan::Clear()
 {
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        shards[i].vMasternodes.clear();
+    }
+
     LOCK(cs);
-    vMasternodes.clear();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -290,9 +268,12 @@ int CMasternodeMan::CountEnabled()
 {
     int i = 0;
 
-    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
-        mn.Check();
-        if(mn.IsEnabled()) i++;
+    for (int j = 0; j < MASTERNODE_SHARDS; j++) {
+        LOCK(shards[j].cs);
+        BOOST_FOREACH(CMasternode& mn, shards[j].vMasternodes) {
+            mn.Check();
+            if(mn.IsEnabled()) i++;
+        }
     }
 
     return i;
@@ -302,8 +283,8 @@ void CMasternodeMan::CountNetworks(int protocolVersion, int& ipv4, int& ipv6, in
 {
     protocolVersion = protocolVersion == -1 ? GetMinMasternodePaymentsProto() : protocolVersion;
 
+    std::vector<CMasternode> vMasternodes = GetFullMasternodeVector();
     BOOST_FOREACH (CMasternode& mn, vMasternodes) {
-        mn.Check();
         std::string strHost;
         int port;
         SplitHostPort(mn.addr.ToString(), port, strHost);
@@ -327,10 +308,13 @@ int CMasternodeMan::CountMasternodesAboveProtocol(int protocolVersion)
 {
     int i = 0;
 
-    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
-        mn.Check();
-        if(mn.protocolVersion < protocolVersion || !mn.IsEnabled()) continue;
-        i++;
+    for (int j = 0; j < MASTERNODE_SHARDS; j++) {
+        LOCK(shards[j].cs);
+        BOOST_FOREACH(CMasternode& mn, shards[j].vMasternodes) {
+            mn.Check();
+            if(mn.protocolVersion < protocolVersion || !mn.IsEnabled()) continue;
+            i++;
+        }
     }
 
     return i;
@@ -343,20 +327,23 @@ int CMasternodeMan::stable_size ()
     int64_t nMasternode_Min_Age = MN_WINNER_MINIMUM_AGE;
     int64_t nMasternode_Age = 0;
 
-    BOOST_FOREACH (CMasternode& mn, vMasternodes) {
-        if (mn.protocolVersion < nMinProtocol) {
-            continue; // Skip obsolete versions
-        }
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH (CMasternode& mn, shards[i].vMasternodes) {
+            if (mn.protocolVersion < nMinProtocol) {
+                continue; // Skip obsolete versions
+            }
 
-        nMasternode_Age = GetAdjustedTime() - mn.sigTime;
-        if ((nMasternode_Age) < nMasternode_Min_Age) {
-            continue; // Skip masternodes younger than (default) 8000 sec (MUST be > MASTERNODE_REMOVAL_SECONDS)
-        }
-        mn.Check ();
-        if (!mn.IsEnabled ())
-            continue; // Skip not-enabled masternodes
+            nMasternode_Age = GetAdjustedTime() - mn.sigTime;
+            if ((nMasternode_Age) < nMasternode_Min_Age) {
+                continue; // Skip masternodes younger than (default) 8000 sec (MUST be > MASTERNODE_REMOVAL_SECONDS)
+            }
+            mn.Check ();
+            if (!mn.IsEnabled ())
+                continue; // Skip not-enabled masternodes
 
-        nStable_size++;
+            nStable_size++;
+        }
     }
 
     return nStable_size;
@@ -381,9 +368,10 @@ void CMasternodeMan::DsegUpdate(CNode* pnode)
 
 CMasternode *CMasternodeMan::Find(const CTxIn &vin)
 {
-    LOCK(cs);
+    CMasternodeShard& shard = GetShard(vin.prevout);
+    LOCK(shard.cs);
 
-    BOOST_FOREACH(CMasternode& mn, vMasternodes)
+    BOOST_FOREACH(CMasternode& mn, shard.vMasternodes)
     {
         if(mn.vin.prevout == vin.prevout)
             return &mn;
@@ -391,45 +379,61 @@ CMasternode *CMasternodeMan::Find(const CTxIn &vin)
     return NULL;
 }
 
-CMasternode *CMasternodeMan::Find(const CPubKey &pubKeyMasternode)
+bool CMasternodeMan::GetPubKey(const CTxIn& vin, CPubKey& pubKeyMasternode)
 {
-LOCK(cs);
+    LOCK(GetShard(vin.prevout).cs);
 
-BOOST_FOREACH(CMasternode& mn, vMasternodes)
-{
-if(mn.pubkey2 == pubKeyMasternode)
-return &mn;
+    CMasternode* pmn = Find(vin);
+    if (pmn == NULL)
+        return false;
+    pubKeyMasternode = pmn->pubkey2;
+    return true;
 }
-return NULL;
+
+CMasternode *CMasternodeMan::Find(const CPubKey &pubKeyMasternode)
+{
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH(CMasternode& mn, shards[i].vMasternodes)
+        {
+            if(mn.pubkey2 == pubKeyMasternode)
+                return &mn;
+        }
+    }
+    return NULL;
 }
 
 CMasternode* CMasternodeMan::FindOldestNotInVec(const std::vector<CTxIn> &vVins, int nMinimumAge, int nMinimumActiveSeconds)
 {
-    LOCK(cs);
-
     CMasternode *pOldestMasternode = NULL;
+    int nOldestAge = 0;
 
-    BOOST_FOREACH(CMasternode &mn, vMasternodes)
-    {
-        mn.Check();
-        if(!mn.IsEnabled()) continue;
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH(CMasternode &mn, shards[i].vMasternodes)
+        {
+            mn.Check();
+            if(!mn.IsEnabled()) continue;
 
-        //if(!RegTest()){
-            if(mn.GetMasternodeInputAge() < nMinimumAge || mn.lastTimeSeen - mn.sigTime < nMinimumActiveSeconds) continue;
-        //}
+            int nAge = mn.GetMasternodeInputAge();
+            //if(!RegTest()){
+                if(nAge < nMinimumAge || mn.lastTimeSeen - mn.sigTime < nMinimumActiveSeconds) continue;
+            //}
 
-        bool found = false;
-        BOOST_FOREACH(const CTxIn& vin, vVins)
-            if(mn.vin.prevout == vin.prevout)
-            {
-                found = true;
-                break;
-            }
+            bool found = false;
+            BOOST_FOREACH(const CTxIn& vin, vVins)
+                if(mn.vin.prevout == vin.prevout)
+                {
+                    found = true;
+                    break;
+                }
 
-        if(found) continue;
+            if(found) continue;
 
-        if(pOldestMasternode == NULL || pOldestMasternode->GetMasternodeInputAge() < mn.GetMasternodeInputAge()){
-            pOldestMasternode = &mn;
+            if(pOldestMasternode == NULL || nOldestAge < nAge){
+                pOldestMasternode = &mn;
+                nOldestAge = nAge;
+            }
         }
     }
 
@@ -438,36 +442,46 @@ CMasternode* CMasternodeMan::FindOldestNotInVec(const std::vector<CTxIn> &vVins,
 
 CMasternode *CMasternodeMan::FindRandom()
 {
-    LOCK(cs);
-
-    if(size() == 0) return NULL;
+    int nSize = size();
+    if(nSize == 0) return NULL;
+
+    int n = GetRandInt(nSize);
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        if (n < (int)shards[i].vMasternodes.size())
+            return &shards[i].vMasternodes[n];
+        n -= shards[i].vMasternodes.size();
+    }
 
-    return &vMasternodes[GetRandInt(vMasternodes.size())];
+    return NULL;
 }
 
 CMasternode* CMasternodeMan::GetCurrentMasterNode(int mod, int64_t nBlockHeight, int minProtocol)
 {
     unsigned int score = 0;
-    CMasternode* winner = NULL;
+    CTxIn vinWinner;
 
     // scan for winner
-    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
-        mn.Check();
-        if(mn.protocolVersion < minProtocol || !mn.IsEnabled()) continue;
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH(CMasternode& mn, shards[i].vMasternodes) {
+            mn.Check();
+            if(mn.protocolVersion < minProtocol || !mn.IsEnabled()) continue;
 
-        // calculate the score for each Masternode
-        uint256 n = mn.CalculateScore(mod, nBlockHeight);
-        unsigned int n2 = 0;
-        memcpy(&n2, &n, sizeof(n2));
+            // calculate the score for each Masternode
+            uint256 n = mn.CalculateScore(mod, nBlockHeight);
+            unsigned int n2 = 0;
+            memcpy(&n2, &n, sizeof(n2));
 
-        // determine the winner
-        if(n2 > score){
-            score = n2;
-            winner = &mn;
+            // determine the winner
+            if(n2 > score){
+                score = n2;
+                vinWinner = mn.vin;
+            }
         }
     }
 
-    return winner;
+    return score > 0 ? Find(vinWinner) : NULL;
 }
 
 int CMasternodeMan::GetMasternodeRank(const CTxIn& vin, int64_t nBlockHeight, int minProtocol, bool fOnlyActive)
@@ -479,19 +493,22 @@ int CMasternodeMan::GetMasternodeRank(const CTxIn& vin, int64_t nBlockHeight, in
     if(!GetBlockHashMN(hash, nBlockHeight)) return -1;
 
     // scan for winner
-    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
-
-        if(mn.protocolVersion < minProtocol) continue;
-        if(fOnlyActive) {
-            mn.Check();
-            if(!mn.IsEnabled()) continue;
-        }
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH(CMasternode& mn, shards[i].vMasternodes) {
+
+            if(mn.protocolVersion < minProtocol) continue;
+            if(fOnlyActive) {
+                mn.Check();
+                if(!mn.IsEnabled()) continue;
+            }
 
-        uint256 n = mn.CalculateScore(1, nBlockHeight);
-        unsigned int n2 = 0;
-        memcpy(&n2, &n, sizeof(n2));
+            uint256 n = mn.CalculateScore(1, nBlockHeight);
+            unsigned int n2 = 0;
+            memcpy(&n2, &n, sizeof(n2));
 
-        vecMasternodeScores.push_back(make_pair(n2, mn.vin));
+            vecMasternodeScores.push_back(make_pair(n2, mn.vin));
+        }
     }
 
     sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareValueOnly());
@@ -517,20 +534,23 @@ std::vector<pair<int, CMasternode> > CMasternodeMan::GetMasternodeRanks(int64_t
     if(!GetBlockHashMN(hash, nBlockHeight)) return vecMasternodeRanks;
 
     // scan for winner
-    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH(CMasternode& mn, shards[i].vMasternodes) {
 
-        mn.Check();
+            mn.Check();
 
-        if(mn.protocolVersion < minProtocol) continue;
-        if(!mn.IsEnabled()) {
-            continue;
-        }
+            if(mn.protocolVersion < minProtocol) continue;
+            if(!mn.IsEnabled()) {
+                continue;
+            }
 
-        uint256 n = mn.CalculateScore(1, nBlockHeight);
-        unsigned int n2 = 0;
-        memcpy(&n2, &n, sizeof(n2));
+            uint256 n = mn.CalculateScore(1, nBlockHeight);
+            unsigned int n2 = 0;
+            memcpy(&n2, &n, sizeof(n2));
 
-        vecMasternodeScores.push_back(make_pair(n2, mn));
+            vecMasternodeScores.push_back(make_pair(n2, mn));
+        }
     }
 
     sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareValueOnlyMN());
@@ -549,19 +569,22 @@ CMasternode* CMasternodeMan::GetMasternodeByRank(int nRank, int64_t nBlockHeight
     std::vector<pair<unsigned int, CTxIn> > vecMasternodeScores;
 
     // scan for winner
-    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
-
-        if(mn.protocolVersion < minProtocol) continue;
-        if(fOnlyActive) {
-            mn.Check();
-            if(!mn.IsEnabled()) continue;
-        }
+    for (int i = 0; i < MASTERNODE_SHARDS; i++) {
+        LOCK(shards[i].cs);
+        BOOST_FOREACH(CMasternode& mn, shards[i].vMasternodes) {
+
+            if(mn.protocolVersion < minProtocol) continue;
+            if(fOnlyActive) {
+                mn.Check();
+                if(!mn.IsEnabled()) continue;
+            }
 
-        uint256 n = mn.CalculateScore(1, nBlockHeight);
-        unsigned int n2 = 0;
-        memcpy(&n2, &n, sizeof(n2));
+            uint256 n = mn.CalculateScore(1, nBlockHeight);
+            unsigned int n2 = 0;
+            memcpy(&n2, &n, sizeof(n2));
 
-        vecMasternodeScores.push_back(make_pair(n2, mn.vin));
+            vecMasternodeScores.push_back(make_pair(n2, mn.vin));
+        }
     }
 
     sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareValueOnly());
@@ -924,7 +947,8 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CData
             }
         } //else, asking for a specific node which is ok
 
-        int count = this->size();
+        std::vector<CMasternode> vMasternodes = CopyMasternodes();
+        int count = vMasternodes.size();
         int i = 0;
 
         BOOST_FOREACH(CMasternode& mn, vMasternodes) {
@@ -965,15 +989,17 @@ void CMasternodeMan::RelayMasternodeEntryPing(const CTxIn vin, const std::vector
 
 void CMasternodeMan::Remove(CTxIn vin)
 {
-    LOCK(cs);
+    CMasternodeShard& shard = GetShard(vin.prevout);
+    LOCK(shard.cs);
 
-    vector<CMasternode>::iterator it = vMasternodes.begin();
-    while(it != vMasternodes.end()){
+    vector<CMasternode>::iterator it = shard.vMasternodes.begin();
+    while(it != shard.vMasternodes.end()){
         if((*it).vin == vin){
-            if(fDebug) LogPrintf("CMasternodeMan: Removing Masternode %s - %i now\n", (*it).addr.ToString().c_str(), size() - 1);
-            vMasternodes.erase(it);
+            if(fDebug) LogPrintf("CMasternodeMan: Removing Masternode %s\n", (*it).addr.ToString().c_str());
+            shard.vMasternodes.erase(it);
             break;
         }
+        ++it;
     }
 }
 
@@ -981,7 +1007,7 @@ std::string CMasternodeMan::ToString() const
 {
     std::ostringstream info;
 
-    info << "Masternodes: " << (int)vMasternodes.size() <<
+    info << "Masternodes: " << size() <<
             ", peers who asked us for Masternode list: " << (int)mAskedUsForMasternodeList.size() <<
             ", peers we asked for Masternode list: " << (int)mWeAskedForMasternodeList.size() <<
             ", entries in Masternode list we asked for: " << (int)mWeAskedForMasternodeListEntry.size() <<
@@ -16,11 +16,13 @@
 #include "util.h"
 #include "script/script.h"
 #include "base58.h"
+#include "cachefile.h"
 #include "main.h"
 #include "masternode.h"
 
 #define MASTERNODES_DUMP_SECONDS               (15*60)
 #define MASTERNODES_DSEG_SECONDS               (3*60*60)
+#define MASTERNODE_SHARDS                      16
 
 using namespace std;
 
@@ -31,22 +33,9 @@ void DumpMasternodes();
 
 /** Access to the MN database (mncache.dat)
  */
-class CMasternodeDB
+class CMasternodeDB : public CCacheFile
 {
-private:
-    boost::filesystem::path pathMN;
-    std::string strMagicMessage;
 public:
-    enum ReadResult {
-        Ok,
-        FileError,
-        HashReadError,
-        IncorrectHash,
-        IncorrectMagicMessage,
-        IncorrectMagicNumber,
-        IncorrectFormat
-    };
-
     CMasternodeDB();
     bool Write(const CMasternodeMan &m_nodemanToSave);
     ReadResult Read(CMasternodeMan& m_nodemanToLoad);
@@ -58,8 +47,16 @@ private:
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
 
-    // map to hold all MNs
-    std::vector<CMasternode> vMasternodes;
+    // One part of the list, guarded by its own lock. Shard locks are always taken
+    // last: while one is held nothing may lock cs or another shard, so that
+    // lookups, ranking and cleanup of different entries don't wait on each other.
+    struct CMasternodeShard {
+        mutable CCriticalSection cs;
+        std::vector<CMasternode> vMasternodes;
+    };
+
+    // all MNs, split by collateral outpoint
+    CMasternodeShard shards[MASTERNODE_SHARDS];
     // who's asked for the Masternode list and the last time
     std::map<CNetAddr, int64_t> mAskedUsForMasternodeList;
     // who we asked for the Masternode list and the last time
@@ -67,33 +64,27 @@ private:
     // which Masternodes we've asked for
     std::map<COutPoint, int64_t> mWeAskedForMasternodeListEntry;
 
+    CMasternodeShard& GetShard(const COutPoint& outpoint)
+    {
+        return shards[(outpoint.hash.Get64() + outpoint.n) % MASTERNODE_SHARDS];
+    }
+
+    /// Copy the entries of all shards, locking one shard at a time
+    std::vector<CMasternode> CopyMasternodes() const;
+
 public:
     // keep track of dsq count to prevent masternodes from gaming darksend queue
     int64_t nDsqCount;
 
-    ADD_SERIALIZE_METHODS;
-
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
-    {
-        // serialized format:
-        // * version byte (currently 0)
-        // * masternodes vector
-        {
-                LOCK(cs);
-                unsigned char nVersion = 0;
-                READWRITE(nVersion);
-                READWRITE(vMasternodes);
-                READWRITE(mAskedUsForMasternodeList);
-                READWRITE(mWeAskedForMasternodeList);
-                READWRITE(mWeAskedForMasternodeListEntry);
-                READWRITE(nDsqCount);
-        }
-    }
-
     CMasternodeMan();
     CMasternodeMan(CMasternodeMan& other);
 
+    /// Add the cache file chunks, locking for one chunk at a time
+    void WriteCache(CCacheFile& file) const;
+
+    /// Load the cache file chunks, false if one is missing or corrupted
+    bool ReadCache(const CCacheFile& file);
+
     /// Add an entry
     bool Add(CMasternode &mn);
 
@@ -118,6 +109,9 @@ public:
     CMasternode* Find(const CTxIn& vin);
     CMasternode* Find(const CPubKey& pubKeyMasternode);
 
+    /// Copy the key an entry signs its votes with, safe to call from any thread
+    bool GetPubKey(const CTxIn& vin, CPubKey& pubKeyMasternode);
+
     /// Find an entry thta do not match every entry provided vector
     CMasternode* FindOldestNotInVec(const std::vector<CTxIn> &vVins, int nMinimumAge, int nMinimumActiveSeconds);
 
@@ -127,7 +121,7 @@ public:
     /// Get the current winner for this block
     CMasternode* GetCurrentMasterNode(int mod=1, int64_t nBlockHeight=0, int minProtocol=0);
 
-    std::vector<CMasternode> GetFullMasternodeVector() { Check(); return vMasternodes; }
+    std::vector<CMasternode> GetFullMasternodeVector() { Check(); return CopyMasternodes(); }
 
     std::vector<pair<int, CMasternode> > GetMasternodeRanks(int64_t nBlockHeight, int minProtocol=0);
     int GetMasternodeRank(const CTxIn &vin, int64_t nBlockHeight, int minProtocol=0, bool fOnlyActive=true);
@@ -138,7 +132,7 @@ public:
     void ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
 
     /// Return the number of (unique) Masternodes
-    int size() { return vMasternodes.size(); }
+    int size() const;
 
     /// Return the number of masternodes older than (default) 8000 seconds
     int stable_size ();
@@ -0,0 +1,51 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "messagesigcache.h"
+
+#include "hash.h"
+#include "random.h"
+
+CMessageSigCache::CMessageSigCache()
+{
+    GetRandBytes(salt.begin(), 32);
+}
+
+uint256 CMessageSigCache::GetEntry(const uint256& hash, const std::vector<unsigned char>& vchSig, const CKeyID& keyID) const
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << salt << hash << vchSig << keyID;
+    return ss.GetHash();
+}
+
+bool CMessageSigCache::Get(const uint256& hash, const std::vector<unsigned char>& vchSig, const CKeyID& keyID) const
+{
+    uint256 entry = GetEntry(hash, vchSig, keyID);
+
+    boost::shared_lock<boost::shared_mutex> lock(cs_msgsigcache);
+    return setValid.count(entry) > 0;
+}
+
+void CMessageSigCache::Set(const uint256& hash, const std::vector<unsigned char>& vchSig, const CKeyID& keyID, int64_t nMaxSize)
+{
+    if (nMaxSize <= 0)
+        return;
+    uint256 entry = GetEntry(hash, vchSig, keyID);
+
+    boost::unique_lock<boost::shared_mutex> lock(cs_msgsigcache);
+    while (static_cast<int64_t>(setValid.size()) >= nMaxSize) {
+        // Evict a random entry, so that peers cannot flush chosen votes out of the cache
+        std::set<uint256>::iterator it = setValid.lower_bound(GetRandHash());
+        if (it == setValid.end())
+            it = setValid.begin();
+        setValid.erase(it);
+    }
+    setValid.insert(entry);
+}
+
+size_t CMessageSigCache::Size() const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_msgsigcache);
+    return setValid.size();
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MESSAGESIGCACHE_H
+#define BITCOIN_MESSAGESIGCACHE_H
+
+#include "pubkey.h"
+#include "uint256.h"
+
+#include <set>
+#include <stdint.h>
+#include <vector>
+
+#include <boost/thread/shared_mutex.hpp>
+
+//! Default for -maxmsgsigcachesize
+static const unsigned int DEFAULT_MAX_MSGSIGCACHE_SIZE = 100000;
+
+/**
+ * Cache of signed messages (masternode and fundamentalnode announcements, pings
+ * and winner votes, budget and finalized budget votes, sporks, SwiftX votes)
+ * whose signature is known to belong to a given key. The same vote reaches a
+ * node many times and is re-checked on every budget clean-up pass; with the
+ * cache only the first sighting pays for the public key recovery.
+ *
+ * Entries are salted hashes of (message hash, signature, key id), so the
+ * layout of the set cannot be predicted by peers, and only successful
+ * verifications are stored.
+ */
+class CMessageSigCache
+{
+private:
+    uint256 salt;
+    std::set<uint256> setValid;
+    mutable boost::shared_mutex cs_msgsigcache;
+
+    uint256 GetEntry(const uint256& hash, const std::vector<unsigned char>& vchSig, const CKeyID& keyID) const;
+
+public:
+    CMessageSigCache();
+
+    //! Whether vchSig is a known good signature of hash by keyID
+    bool Get(const uint256& hash, const std::vector<unsigned char>& vchSig, const CKeyID& keyID) const;
+    //! Remember a good signature, evicting random entries beyond nMaxSize
+    void Set(const uint256& hash, const std::vector<unsigned char>& vchSig, const CKeyID& keyID, int64_t nMaxSize);
+
+    size_t Size() const;
+};
+
+#endif // BITCOIN_MESSAGESIGCACHE_H
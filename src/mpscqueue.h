@@ -0,0 +1,88 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MPSCQUEUE_H
+#define BITCOIN_MPSCQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <utility>
+
+/**
+ * Bounded lock-free queue with any number of producers and a single consumer.
+ * Every cell carries a sequence number telling whose turn it is: producers
+ * claim a position with one compare-and-swap and publish the cell by bumping
+ * its sequence, the consumer frees it the same way. A push into a full queue
+ * fails instead of waiting, so producers never block on the consumer.
+ */
+template <typename T>
+class CMPSCQueue
+{
+private:
+    struct Cell {
+        std::atomic<size_t> nSequence;
+        T value;
+    };
+
+    Cell* pCells;
+    size_t nMask;
+    std::atomic<size_t> nPushPos;
+    char padding[64];  // keep the consumer position off the cache line producers fight over
+    size_t nPopPos;
+
+    CMPSCQueue(const CMPSCQueue&);
+    CMPSCQueue& operator=(const CMPSCQueue&);
+
+public:
+    /** Create a queue holding nCapacity elements, rounded up to a power of two */
+    explicit CMPSCQueue(size_t nCapacity) : nPushPos(0), nPopPos(0)
+    {
+        size_t nSize = 2;
+        while (nSize < nCapacity)
+            nSize *= 2;
+        pCells = new Cell[nSize];
+        nMask = nSize - 1;
+        for (size_t i = 0; i < nSize; i++)
+            pCells[i].nSequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~CMPSCQueue() { delete[] pCells; }
+
+    size_t Capacity() const { return nMask + 1; }
+
+    /** Move value into the queue, may be called from any thread. Returns false if the queue is full. */
+    bool Push(T&& value)
+    {
+        size_t nPos = nPushPos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = pCells[nPos & nMask];
+            size_t nSequence = cell.nSequence.load(std::memory_order_acquire);
+            if (nSequence == nPos) {
+                if (nPushPos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.nSequence.store(nPos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if ((ptrdiff_t)(nSequence - nPos) < 0) {
+                return false;
+            } else {
+                nPos = nPushPos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Move the oldest element into value, only from the consumer thread. Returns false if the queue is empty. */
+    bool Pop(T& value)
+    {
+        Cell& cell = pCells[nPopPos & nMask];
+        if (cell.nSequence.load(std::memory_order_acquire) != nPopPos + 1)
+            return false;
+        value = std::move(cell.value);
+        cell.nSequence.store(nPopPos + nMask + 1, std::memory_order_release);
+        nPopPos++;
+        return true;
+    }
+};
+
+#endif // BITCOIN_MPSCQUEUE_H
@@ -0,0 +1,74 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "muhash.h"
+
+#include "crypto/sha512.h"
+#include "hash.h"
+
+namespace
+{
+const unsigned int MUHASH_BITS = 3072;
+const unsigned int MUHASH_BYTES = MUHASH_BITS / 8;
+
+const CBigNum& Modulus()
+{
+    static const CBigNum bnModulus = (CBigNum(1) << MUHASH_BITS) - CBigNum(1103717);
+    return bnModulus;
+}
+
+/** Expand a 256-bit element hash into a group element using SHA512 in counter mode */
+CBigNum ToGroupElement(const uint256& hashElement)
+{
+    // setvch() takes little-endian magnitude with a sign bit, so keep a trailing zero byte
+    std::vector<unsigned char> vch(MUHASH_BYTES + 1, 0);
+    for (unsigned int i = 0; i < MUHASH_BYTES / CSHA512::OUTPUT_SIZE; i++) {
+        unsigned char nCounter = i;
+        CSHA512().Write(hashElement.begin(), hashElement.size()).Write(&nCounter, 1).Finalize(&vch[i * CSHA512::OUTPUT_SIZE]);
+    }
+    CBigNum bn;
+    bn.setvch(vch);
+    bn %= Modulus();
+    // Zero has no inverse; a hash landing on it is practically impossible but must stay well-defined
+    if (bn == 0)
+        bn = 1;
+    return bn;
+}
+}
+
+CMuHash3072& CMuHash3072::Insert(const uint256& hashElement)
+{
+    bnNumerator = bnNumerator.mul_mod(ToGroupElement(hashElement), Modulus());
+    return *this;
+}
+
+CMuHash3072& CMuHash3072::Remove(const uint256& hashElement)
+{
+    bnDenominator = bnDenominator.mul_mod(ToGroupElement(hashElement), Modulus());
+    return *this;
+}
+
+CMuHash3072& CMuHash3072::operator*=(const CMuHash3072& other)
+{
+    bnNumerator = bnNumerator.mul_mod(other.bnNumerator, Modulus());
+    bnDenominator = bnDenominator.mul_mod(other.bnDenominator, Modulus());
+    return *this;
+}
+
+void CMuHash3072::Normalize()
+{
+    if (bnDenominator == 1)
+        return;
+    bnNumerator = bnNumerator.mul_mod(bnDenominator.inverse(Modulus()), Modulus());
+    bnDenominator = 1;
+}
+
+uint256 CMuHash3072::Finalize() const
+{
+    CMuHash3072 normalized(*this);
+    normalized.Normalize();
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << normalized.bnNumerator;
+    return ss.GetHash();
+}
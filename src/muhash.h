@@ -0,0 +1,53 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MUHASH_H
+#define BITCOIN_MUHASH_H
+
+#include "libzerocoin/bignum.h"
+#include "serialize.h"
+#include "uint256.h"
+
+/**
+ * Rolling multiset hash over the multiplicative group modulo the prime
+ * 2^3072 - 1103717. Every element is a 256-bit hash that is expanded into a
+ * group element. Insertions multiply the numerator and removals multiply the
+ * denominator, so updates commute, can be combined across caches and never
+ * need a modular inverse until the set hash is finalized.
+ */
+class CMuHash3072
+{
+private:
+    CBigNum bnNumerator;
+    CBigNum bnDenominator;
+
+public:
+    CMuHash3072() : bnNumerator(1), bnDenominator(1) {}
+
+    //! Add an element to the set
+    CMuHash3072& Insert(const uint256& hashElement);
+
+    //! Remove an element from the set
+    CMuHash3072& Remove(const uint256& hashElement);
+
+    //! Combine with the changes recorded in another instance
+    CMuHash3072& operator*=(const CMuHash3072& other);
+
+    //! Fold the denominator into the numerator (one modular inverse)
+    void Normalize();
+
+    //! Hash of the current set; equal sets give equal results regardless of update order
+    uint256 Finalize() const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(bnNumerator);
+        READWRITE(bnDenominator);
+    }
+};
+
+#endif // BITCOIN_MUHASH_H
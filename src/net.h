@@ -189,6 +189,8 @@ public:
 
     int64_t nTime; // time (in microseconds) of message receipt.
 
+    bool fSigChecked; // signature already checked ahead of processing
+
     CNetMessage(int nTypeIn, int nVersionIn) : hdrbuf(nTypeIn, nVersionIn), vRecv(nTypeIn, nVersionIn)
     {
         hdrbuf.resize(24);
@@ -196,6 +198,7 @@ public:
         nHdrPos = 0;
         nDataPos = 0;
         nTime = 0;
+        fSigChecked = false;
     }
 
     bool complete() const
@@ -9,6 +9,7 @@
 #include "coincontrol.h"
 #include "init.h"
 #include "main.h"
+#include "messagesigcache.h"
 #include "fundamentalnodeman.h"
 #include "script/sign.h"
 #include "swifttx.h"
@@ -2163,20 +2164,32 @@ bool CObfuScationSigner::SignMessage(std::string strMessage, std::string& errorM
 
 bool CObfuScationSigner::VerifyMessage(CPubKey pubkey, vector<unsigned char>& vchSig, std::string strMessage, std::string& errorMessage)
 {
+    static CMessageSigCache messageSigCache;
+
     CHashWriter ss(SER_GETHASH, 0);
     ss << strMessageMagic;
     ss << strMessage;
+    uint256 hash = ss.GetHash();
+
+    // Relayed and re-checked votes carry the same signature again and again
+    CKeyID keyID = pubkey.GetID();
+    if (messageSigCache.Get(hash, vchSig, keyID))
+        return true;
 
     CPubKey pubkey2;
-    if (!pubkey2.RecoverCompact(ss.GetHash(), vchSig)) {
+    if (!pubkey2.RecoverCompact(hash, vchSig)) {
         errorMessage = _("Error recovering public key.");
         return false;
     }
 
-    if (fDebug && pubkey2.GetID() != pubkey.GetID())
-        LogPrintf("CObfuScationSigner::VerifyMessage -- keys don't match: %s %s\n", pubkey2.GetID().ToString(), pubkey.GetID().ToString());
+    if (pubkey2.GetID() != keyID) {
+        if (fDebug)
+            LogPrintf("CObfuScationSigner::VerifyMessage -- keys don't match: %s %s\n", pubkey2.GetID().ToString(), keyID.ToString());
+        return false;
+    }
 
-    return (pubkey2.GetID() == pubkey.GetID());
+    messageSigCache.Set(hash, vchSig, keyID, GetArg("-maxmsgsigcachesize", DEFAULT_MAX_MSGSIGCACHE_SIZE));
+    return true;
 }
 
 bool CObfuscationQueue::Sign()
@@ -11,6 +11,7 @@
 #include "primitives/transaction.h"
 #include "main.h"
 #include "httpserver.h"
+#include "jsonstream.h"
 #include "rpcserver.h"
 #include "streams.h"
 #include "sync.h"
@@ -19,6 +20,7 @@
 #include "version.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 #include <boost/dynamic_bitset.hpp>
 
 #include <univalue.h>
@@ -64,6 +66,8 @@ extern void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue&
 extern UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
 extern UniValue mempoolInfoToJSON();
 extern UniValue mempoolToJSON(bool fVerbose = false);
+extern void blockToJSONStream(CJSONStreamWriter& writer, const CBlock& block, const CBlockIndex* blockindex, bool txDetails);
+extern void mempoolToJSONStream(CJSONStreamWriter& writer);
 extern void ScriptPubKeyToJSON(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex);
 extern UniValue blockheaderToJSON(const CBlockIndex* blockindex);
 
@@ -241,10 +245,11 @@ static bool rest_block(HTTPRequest* req,
     }
 
     case RF_JSON: {
-        UniValue objBlock = blockToJSON(block, pblockindex, showTxDetails);
-        string strJSON = objBlock.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        CJSONStreamWriter writer(boost::bind(&HTTPRequest::WriteReplyPart, req, HTTP_OK, _1, _2));
+        blockToJSONStream(writer, block, pblockindex, showTxDetails);
+        writer.Raw("\n");
+        writer.Finish();
         return true;
     }
 
@@ -326,11 +331,11 @@ static bool rest_mempool_contents(HTTPRequest* req, const std::string& strURIPar
 
     switch (rf) {
     case RF_JSON: {
-        UniValue mempoolObject = mempoolToJSON(true);
-
-        string strJSON = mempoolObject.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        CJSONStreamWriter writer(boost::bind(&HTTPRequest::WriteReplyPart, req, HTTP_OK, _1, _2));
+        mempoolToJSONStream(writer);
+        writer.Raw("\n");
+        writer.Finish();
         return true;
     }
     default: {
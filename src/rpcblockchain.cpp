@@ -9,6 +9,7 @@
 #include "base58.h"
 #include "checkpoints.h"
 #include "clientversion.h"
+#include "jsonstream.h"
 #include "main.h"
 #include "rpcserver.h"
 #include "sync.h"
@@ -54,14 +55,24 @@ double GetDifficulty(const CBlockIndex* blockindex)
     return dDiff;
 }
 
+static UniValue txToJSON(const CTransaction& tx, bool txDetails)
+{
+    if (!txDetails)
+        return tx.GetHash().GetHex();
+    UniValue objTx(UniValue::VOBJ);
+    TxToJSON(tx, uint256(0), objTx);
+    return objTx;
+}
+
 UniValue blockheaderToJSON(const CBlockIndex* blockindex)
 {
+    boost::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
     UniValue result(UniValue::VOBJ);
     result.push_back(Pair("hash", blockindex->GetBlockHash().GetHex()));
     int confirmations = -1;
     // Only report confirmations if the block is on the main chain
-    if (chainActive.Contains(blockindex))
-        confirmations = chainActive.Height() - blockindex->nHeight + 1;
+    if (chain->Contains(blockindex))
+        confirmations = chain->Height() - blockindex->nHeight + 1;
     result.push_back(Pair("confirmations", confirmations));
     result.push_back(Pair("height", blockindex->nHeight));
     result.push_back(Pair("version", blockindex->nVersion));
@@ -75,20 +86,22 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
 
     if (blockindex->pprev)
         result.push_back(Pair("previousblockhash", blockindex->pprev->GetBlockHash().GetHex()));
-    CBlockIndex *pnext = chainActive.Next(blockindex);
+    CBlockIndex *pnext = chain->Next(blockindex);
     if (pnext)
         result.push_back(Pair("nextblockhash", pnext->GetBlockHash().GetHex()));
     return result;
 }
 
-UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false)
+/** Build the JSON for a block; with fTxs false, "tx" is left null to be filled in by the caller */
+static UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, bool fTxs)
 {
+    boost::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
     UniValue result(UniValue::VOBJ);
     result.push_back(Pair("hash", block.GetHash().GetHex()));
     int confirmations = -1;
     // Only report confirmations if the block is on the main chain
-    if (chainActive.Contains(blockindex))
-        confirmations = chainActive.Height() - blockindex->nHeight + 1;
+    if (chain->Contains(blockindex))
+        confirmations = chain->Height() - blockindex->nHeight + 1;
     result.push_back(Pair("confirmations", confirmations));
     result.push_back(Pair("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION)));
     result.push_back(Pair("height", blockindex->nHeight));
@@ -96,14 +109,11 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     result.push_back(Pair("merkleroot", block.hashMerkleRoot.GetHex()));
     result.push_back(Pair("acc_checkpoint", block.nAccumulatorCheckpoint.GetHex()));
     UniValue txs(UniValue::VARR);
-    BOOST_FOREACH (const CTransaction& tx, block.vtx) {
-        if (txDetails) {
-            UniValue objTx(UniValue::VOBJ);
-            TxToJSON(tx, uint256(0), objTx);
-            txs.push_back(objTx);
-        } else
-            txs.push_back(tx.GetHash().GetHex());
-    }
+    if (fTxs) {
+        BOOST_FOREACH (const CTransaction& tx, block.vtx)
+            txs.push_back(txToJSON(tx, txDetails));
+    } else
+        txs.setNull();
     result.push_back(Pair("tx", txs));
     result.push_back(Pair("time", block.GetBlockTime()));
     result.push_back(Pair("nonce", (uint64_t)block.nNonce));
@@ -113,7 +123,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
 
     if (blockindex->pprev)
         result.push_back(Pair("previousblockhash", blockindex->pprev->GetBlockHash().GetHex()));
-    CBlockIndex* pnext = chainActive.Next(blockindex);
+    CBlockIndex* pnext = chain->Next(blockindex);
     if (pnext)
         result.push_back(Pair("nextblockhash", pnext->GetBlockHash().GetHex()));
 
@@ -129,6 +139,33 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     return result;
 }
 
+UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false)
+{
+    return blockToJSON(block, blockindex, txDetails, true);
+}
+
+/** Write the same JSON as blockToJSON() to a stream, one transaction at a time */
+void blockToJSONStream(CJSONStreamWriter& writer, const CBlock& block, const CBlockIndex* blockindex, bool txDetails)
+{
+    UniValue result = blockToJSON(block, blockindex, txDetails, false);
+    const std::vector<std::string>& keys = result.getKeys();
+    const std::vector<UniValue>& values = result.getValues();
+
+    writer.BeginObject();
+    for (unsigned int i = 0; i < keys.size(); i++) {
+        if (keys[i] != "tx") {
+            writer.KeyValue(keys[i], values[i]);
+            continue;
+        }
+        writer.Key("tx");
+        writer.BeginArray();
+        BOOST_FOREACH (const CTransaction& tx, block.vtx)
+            writer.Value(txToJSON(tx, txDetails));
+        writer.EndArray();
+    }
+    writer.EndObject();
+}
+
 UniValue getblockcount(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 0)
@@ -142,8 +179,7 @@ UniValue getblockcount(const UniValue& params, bool fHelp)
             "\nExamples:\n" +
             HelpExampleCli("getblockcount", "") + HelpExampleRpc("getblockcount", ""));
 
-    LOCK(cs_main);
-    return chainActive.Height();
+    return GetChainSnapshot()->Height();
 }
 
 UniValue getbestblockhash(const UniValue& params, bool fHelp)
@@ -159,8 +195,7 @@ UniValue getbestblockhash(const UniValue& params, bool fHelp)
             "\nExamples\n" +
             HelpExampleCli("getbestblockhash", "") + HelpExampleRpc("getbestblockhash", ""));
 
-    LOCK(cs_main);
-    return chainActive.Tip()->GetBlockHash().GetHex();
+    return GetChainSnapshot()->Tip()->GetBlockHash().GetHex();
 }
 
 UniValue getdifficulty(const UniValue& params, bool fHelp)
@@ -181,36 +216,39 @@ UniValue getdifficulty(const UniValue& params, bool fHelp)
 }
 
 
+/** Verbose mempool entry; mempool.cs must be held */
+static UniValue mempoolEntryToJSON(const CTxMemPoolEntry& e, int nChainHeight)
+{
+    UniValue info(UniValue::VOBJ);
+    info.push_back(Pair("size", (int)e.GetTxSize()));
+    info.push_back(Pair("fee", ValueFromAmount(e.GetFee())));
+    info.push_back(Pair("time", e.GetTime()));
+    info.push_back(Pair("height", (int)e.GetHeight()));
+    info.push_back(Pair("startingpriority", e.GetPriority(e.GetHeight())));
+    info.push_back(Pair("currentpriority", e.GetPriority(nChainHeight)));
+    const CTransaction& tx = e.GetTx();
+    set<string> setDepends;
+    BOOST_FOREACH (const CTxIn& txin, tx.vin) {
+        if (mempool.exists(txin.prevout.hash))
+            setDepends.insert(txin.prevout.hash.ToString());
+    }
+
+    UniValue depends(UniValue::VARR);
+    BOOST_FOREACH(const string& dep, setDepends) {
+        depends.push_back(dep);
+    }
+
+    info.push_back(Pair("depends", depends));
+    return info;
+}
+
 UniValue mempoolToJSON(bool fVerbose = false)
 {
     if (fVerbose) {
         LOCK(mempool.cs);
         UniValue o(UniValue::VOBJ);
-        BOOST_FOREACH (const PAIRTYPE(uint256, CTxMemPoolEntry) & entry, mempool.mapTx) {
-            const uint256& hash = entry.first;
-            const CTxMemPoolEntry& e = entry.second;
-            UniValue info(UniValue::VOBJ);
-            info.push_back(Pair("size", (int)e.GetTxSize()));
-            info.push_back(Pair("fee", ValueFromAmount(e.GetFee())));
-            info.push_back(Pair("time", e.GetTime()));
-            info.push_back(Pair("height", (int)e.GetHeight()));
-            info.push_back(Pair("startingpriority", e.GetPriority(e.GetHeight())));
-            info.push_back(Pair("currentpriority", e.GetPriority(chainActive.Height())));
-            const CTransaction& tx = e.GetTx();
-            set<string> setDepends;
-            BOOST_FOREACH (const CTxIn& txin, tx.vin) {
-                if (mempool.exists(txin.prevout.hash))
-                    setDepends.insert(txin.prevout.hash.ToString());
-            }
-
-            UniValue depends(UniValue::VARR);
-            BOOST_FOREACH(const string& dep, setDepends) {
-                depends.push_back(dep);
-            }
-
-            info.push_back(Pair("depends", depends));
-            o.push_back(Pair(hash.ToString(), info));
-        }
+        BOOST_FOREACH (const PAIRTYPE(uint256, CTxMemPoolEntry) & entry, mempool.mapTx)
+            o.push_back(Pair(entry.first.ToString(), mempoolEntryToJSON(entry.second, chainActive.Height())));
         return o;
     } else {
         vector<uint256> vtxid;
@@ -224,6 +262,36 @@ UniValue mempoolToJSON(bool fVerbose = false)
     }
 }
 
+/**
+ * Write the verbose mempool to a stream. Entries are read in small batches so that
+ * no lock is held while the writer waits for the client; transactions that leave
+ * the pool in the meantime are skipped.
+ */
+void mempoolToJSONStream(CJSONStreamWriter& writer)
+{
+    static const unsigned int MEMPOOL_STREAM_BATCH = 1000;
+
+    vector<uint256> vtxid;
+    mempool.queryHashes(vtxid);
+    int nChainHeight = GetChainSnapshot()->Height();
+
+    writer.BeginObject();
+    for (unsigned int nStart = 0; nStart < vtxid.size(); nStart += MEMPOOL_STREAM_BATCH) {
+        vector<pair<uint256, UniValue> > vBatch;
+        {
+            LOCK(mempool.cs);
+            for (unsigned int i = nStart; i < vtxid.size() && i < nStart + MEMPOOL_STREAM_BATCH; i++) {
+                map<uint256, CTxMemPoolEntry>::const_iterator it = mempool.mapTx.find(vtxid[i]);
+                if (it != mempool.mapTx.end())
+                    vBatch.push_back(make_pair(it->first, mempoolEntryToJSON(it->second, nChainHeight)));
+            }
+        }
+        for (unsigned int i = 0; i < vBatch.size(); i++)
+            writer.KeyValue(vBatch[i].first.ToString(), vBatch[i].second);
+    }
+    writer.EndObject();
+}
+
 UniValue getrawmempool(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() > 1)
@@ -267,6 +335,16 @@ UniValue getrawmempool(const UniValue& params, bool fHelp)
     return mempoolToJSON(fVerbose);
 }
 
+void getrawmempool_stream(const UniValue& params, CJSONStreamWriter& writer)
+{
+    // Only the verbose form is large enough to be worth streaming
+    if (params.size() != 1 || !params[0].isBool() || !params[0].get_bool()) {
+        writer.Value(getrawmempool(params, false));
+        return;
+    }
+    mempoolToJSONStream(writer);
+}
+
 UniValue getblockhash(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
@@ -283,16 +361,38 @@ UniValue getblockhash(const UniValue& params, bool fHelp)
             "\nExamples:\n" +
             HelpExampleCli("getblockhash", "1000") + HelpExampleRpc("getblockhash", "1000"));
 
-    LOCK(cs_main);
+    boost::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
 
     int nHeight = params[0].get_int();
-    if (nHeight < 0 || nHeight > chainActive.Height())
+    if (nHeight < 0 || nHeight > chain->Height())
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
 
-    CBlockIndex* pblockindex = chainActive[nHeight];
+    CBlockIndex* pblockindex = (*chain)[nHeight];
     return pblockindex->GetBlockHash().GetHex();
 }
 
+/** Read a block for the lock-free block RPCs */
+static void ReadBlockForRPC(CBlock& block, const CBlockIndex* pblockindex)
+{
+    if (!ReadBlockFromDiskUnlocked(block, pblockindex))
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+}
+
+static UniValue BlockIndexToRPC(const CBlockIndex* pblockindex, bool fVerbose)
+{
+    CBlock block;
+    ReadBlockForRPC(block, pblockindex);
+
+    if (!fVerbose) {
+        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+        ssBlock << block;
+        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
+        return strHex;
+    }
+
+    return blockToJSON(block, pblockindex);
+}
+
 UniValue getblock(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() < 1 || params.size() > 2)
@@ -345,8 +445,6 @@ UniValue getblock(const UniValue& params, bool fHelp)
             HelpExampleCli("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"") +
             HelpExampleRpc("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\""));
 
-    LOCK(cs_main);
-
     std::string strHash = params[0].get_str();
     uint256 hash(strHash);
 
@@ -354,23 +452,34 @@ UniValue getblock(const UniValue& params, bool fHelp)
     if (params.size() > 1)
         fVerbose = params[1].get_bool();
 
-    if (mapBlockIndex.count(hash) == 0)
+    CBlockIndex* pblockindex = LookupBlockIndex(hash);
+    if (pblockindex == NULL)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 
-    CBlock block;
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
-
-    if (!ReadBlockFromDisk(block, pblockindex))
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+    // Entries on the published chain are fully connected and no longer change;
+    // anything else may still be written to by validation
+    if (!GetChainSnapshot()->Contains(pblockindex)) {
+        LOCK(cs_main);
+        return BlockIndexToRPC(pblockindex, fVerbose);
+    }
+    return BlockIndexToRPC(pblockindex, fVerbose);
+}
 
-    if (!fVerbose) {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-        ssBlock << block;
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
-        return strHex;
+void getblock_stream(const UniValue& params, CJSONStreamWriter& writer)
+{
+    // Usage errors, the hex form and blocks off the active chain take the regular path
+    CBlockIndex* pblockindex = NULL;
+    if (params.size() >= 1 && params.size() <= 2 && params[0].isStr() &&
+        (params.size() == 1 || (params[1].isBool() && params[1].get_bool())))
+        pblockindex = LookupBlockIndex(uint256(params[0].get_str()));
+    if (pblockindex == NULL || !GetChainSnapshot()->Contains(pblockindex)) {
+        writer.Value(getblock(params, false));
+        return;
     }
 
-    return blockToJSON(block, pblockindex);
+    CBlock block;
+    ReadBlockForRPC(block, pblockindex);
+    blockToJSONStream(writer, block, pblockindex, false);
 }
 
 UniValue getblockheader(const UniValue& params, bool fHelp)
@@ -409,11 +518,10 @@ UniValue getblockheader(const UniValue& params, bool fHelp)
     if (params.size() > 1)
         fVerbose = params[1].get_bool();
 
-    if (mapBlockIndex.count(hash) == 0)
+    CBlockIndex* pblockindex = LookupBlockIndex(hash);
+    if (pblockindex == NULL)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
-
     if (!fVerbose) {
         CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
         ssBlock << pblockindex->GetBlockHeader();
@@ -426,11 +534,16 @@ UniValue getblockheader(const UniValue& params, bool fHelp)
 
 UniValue gettxoutsetinfo(const UniValue& params, bool fHelp)
 {
-    if (fHelp || params.size() != 0)
+    if (fHelp || params.size() > 1)
         throw runtime_error(
-            "gettxoutsetinfo\n"
+            "gettxoutsetinfo ( hash_serialized )\n"
             "\nReturns statistics about the unspent transaction output set.\n"
-            "Note this call may take some time.\n"
+            "The statistics are maintained incrementally as blocks are connected, so this call is cheap,\n"
+            "except for hash_serialized which takes a scan of the whole set.\n"
+
+            "\nArguments:\n"
+            "1. hash_serialized    (boolean, optional, default=false) Also compute hash_serialized, which flushes the\n"
+            "                      chainstate and scans it. Deprecated, use muhash.\n"
 
             "\nResult:\n"
             "{\n"
@@ -438,32 +551,124 @@ UniValue gettxoutsetinfo(const UniValue& params, bool fHelp)
             "  \"bestblock\": \"hex\",   (string) the best block hash hex\n"
             "  \"transactions\": n,      (numeric) The number of transactions\n"
             "  \"txouts\": n,            (numeric) The number of output transactions\n"
-            "  \"bytes_serialized\": n,  (numeric) The serialized size\n"
-            "  \"hash_serialized\": \"hash\",   (string) The serialized hash\n"
+            "  \"bytes_serialized\": n,  (numeric) The approximate serialized size\n"
+            "  \"hash_serialized\": \"hash\",   (string) The serialized hash (only if hash_serialized is true, deprecated)\n"
+            "  \"muhash\": \"hash\",   (string) The rolling set hash of all unspent outputs\n"
             "  \"total_amount\": x.xxx          (numeric) The total amount\n"
             "}\n"
 
             "\nExamples:\n" +
-            HelpExampleCli("gettxoutsetinfo", "") + HelpExampleRpc("gettxoutsetinfo", ""));
+            HelpExampleCli("gettxoutsetinfo", "") + HelpExampleCli("gettxoutsetinfo", "true") + HelpExampleRpc("gettxoutsetinfo", ""));
+
+    bool fHashSerialized = false;
+    if (params.size() > 0)
+        fHashSerialized = params[0].get_bool();
 
     LOCK(cs_main);
 
     UniValue ret(UniValue::VOBJ);
 
     CCoinsStats stats;
-    FlushStateToDisk();
-    if (pcoinsTip->GetStats(stats)) {
+    // the scan only sees what is in the database
+    if (fHashSerialized)
+        FlushStateToDisk();
+    if (pcoinsTip->GetStats(stats) && (!fHashSerialized || pcoinsTip->GetHashSerialized(stats.hashSerialized))) {
+        BlockMap::const_iterator mi = mapBlockIndex.find(stats.hashBlock);
+        if (mi != mapBlockIndex.end())
+            stats.nHeight = mi->second->nHeight;
         ret.push_back(Pair("height", (int64_t)stats.nHeight));
         ret.push_back(Pair("bestblock", stats.hashBlock.GetHex()));
         ret.push_back(Pair("transactions", (int64_t)stats.nTransactions));
         ret.push_back(Pair("txouts", (int64_t)stats.nTransactionOutputs));
         ret.push_back(Pair("bytes_serialized", (int64_t)stats.nSerializedSize));
-        ret.push_back(Pair("hash_serialized", stats.hashSerialized.GetHex()));
+        if (fHashSerialized)
+            ret.push_back(Pair("hash_serialized", stats.hashSerialized.GetHex()));
+        ret.push_back(Pair("muhash", stats.hashMuHash.GetHex()));
         ret.push_back(Pair("total_amount", ValueFromAmount(stats.nTotalAmount)));
     }
     return ret;
 }
 
+UniValue getdbstats(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getdbstats\n"
+            "\nReturns the settings and LevelDB statistics of every open database.\n"
+
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"name\": \"name\",          (string) Database name, as used by -dboption\n"
+            "    \"path\": \"path\",          (string) Database directory\n"
+            "    \"settings\": {            (json object) Settings the database was opened with\n"
+            "      \"cache\": n,            (numeric) Block cache and write buffer memory, in bytes\n"
+            "      \"cachesplit\": n,       (numeric) Percent of the cache used for the block cache\n"
+            "      \"bloombits\": n,        (numeric) Bloom filter bits per key, 0 if disabled\n"
+            "      \"compression\": true|false, (boolean) Whether table blocks are compressed\n"
+            "      \"blocksize\": n,        (numeric) Table block size, in bytes\n"
+            "      \"maxopenfiles\": n      (numeric) Table files kept open\n"
+            "    },\n"
+            "    \"cachehits\": n,          (numeric) Block cache lookups that found the block\n"
+            "    \"cachemisses\": n,        (numeric) Block cache lookups that had to read the block from disk\n"
+            "    \"cachehitrate\": x.xxx,   (numeric) Share of lookups that hit the cache\n"
+            "    \"levels\": [              (json array) Non-empty levels and their compaction totals\n"
+            "      {\n"
+            "        \"level\": n,          (numeric) Level number\n"
+            "        \"files\": n,          (numeric) Table files in the level\n"
+            "        \"size_mb\": n,        (numeric) Size of the level, in megabytes\n"
+            "        \"compaction_seconds\": n, (numeric) Time spent compacting into the level\n"
+            "        \"read_mb\": n,        (numeric) Data read by those compactions, in megabytes\n"
+            "        \"write_mb\": n        (numeric) Data written by those compactions, in megabytes\n"
+            "      }\n"
+            "      ,...\n"
+            "    ]\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getdbstats", "") + HelpExampleRpc("getdbstats", ""));
+
+    std::vector<CLevelDBStats> vStats = GetLevelDBStats();
+
+    UniValue ret(UniValue::VARR);
+    for (unsigned int i = 0; i < vStats.size(); i++) {
+        const CLevelDBStats& stats = vStats[i];
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("name", stats.strName));
+        obj.push_back(Pair("path", stats.strPath));
+        UniValue settings(UniValue::VOBJ);
+        settings.push_back(Pair("cache", (uint64_t)stats.profile.nCacheSize));
+        settings.push_back(Pair("cachesplit", stats.profile.nBlockCachePercent));
+        settings.push_back(Pair("bloombits", stats.profile.nBloomBits));
+        settings.push_back(Pair("compression", stats.profile.fCompression));
+        settings.push_back(Pair("blocksize", (uint64_t)stats.profile.nBlockSize));
+        settings.push_back(Pair("maxopenfiles", stats.profile.nMaxOpenFiles));
+        obj.push_back(Pair("settings", settings));
+        obj.push_back(Pair("cachehits", stats.nCacheHits));
+        obj.push_back(Pair("cachemisses", stats.nCacheMisses));
+        uint64_t nLookups = stats.nCacheHits + stats.nCacheMisses;
+        obj.push_back(Pair("cachehitrate", nLookups ? (double)stats.nCacheHits / nLookups : 0.0));
+        UniValue levels(UniValue::VARR);
+        for (unsigned int j = 0; j < stats.vLevels.size(); j++) {
+            const CLevelDBLevelStats& level = stats.vLevels[j];
+            UniValue entry(UniValue::VOBJ);
+            entry.push_back(Pair("level", level.nLevel));
+            entry.push_back(Pair("files", level.nFiles));
+            entry.push_back(Pair("size_mb", level.dSizeMB));
+            entry.push_back(Pair("compaction_seconds", level.dCompactionSeconds));
+            entry.push_back(Pair("read_mb", level.dReadMB));
+            entry.push_back(Pair("write_mb", level.dWriteMB));
+            levels.push_back(entry);
+        }
+        obj.push_back(Pair("levels", levels));
+        ret.push_back(obj);
+    }
+
+    return ret;
+}
+
 UniValue gettxout(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() < 2 || params.size() > 3)
@@ -561,6 +766,7 @@ UniValue verifychain(const UniValue& params, bool fHelp)
             "\nExamples:\n" +
             HelpExampleCli("verifychain", "") + HelpExampleRpc("verifychain", ""));
 
+    // cs_main is held throughout, so no block is connected while the verifying flag relaxes the checks
     LOCK(cs_main);
 
     int nCheckLevel = 4;
@@ -569,7 +775,7 @@ UniValue verifychain(const UniValue& params, bool fHelp)
         nCheckDepth = params[1].get_int();
 
     fVerifyingBlocks = true;
-    bool fVerified = CVerifyDB().VerifyDB(pcoinsTip, nCheckLevel, nCheckDepth);
+    bool fVerified = CVerifyDB().VerifyDB(pcoinsTip, nCheckLevel, nCheckDepth, false);
     fVerifyingBlocks = false;
 
     return fVerified;
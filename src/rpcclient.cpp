@@ -31,6 +31,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     {
         {"stop", 0},
         {"setmocktime", 0},
+        {"getlockstats", 0},
         {"getaddednodeinfo", 0},
         {"setgenerate", 0},
         {"setgenerate", 1},
@@ -75,6 +76,12 @@ static const CRPCConvertParam vRPCConvertParams[] =
         {"listunspent", 2},
         {"listunspent", 3},
         {"getblock", 1},
+        {"getaddressbalance", 0},
+        {"getaddressutxos", 0},
+        {"getaddressdeltas", 0},
+        {"getspentinfo", 0},
+        {"zmqreplay", 1},
+        {"zmqreplay", 2},
         {"getblockheader", 1},
         {"gettransaction", 1},
         {"getrawtransaction", 1},
@@ -84,6 +91,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
         {"signrawtransaction", 2},
         {"sendrawtransaction", 1},
         {"sendrawtransaction", 2},
+        {"gettxoutsetinfo", 0},
         {"gettxout", 1},
         {"gettxout", 2},
         {"lockunspent", 0},
@@ -582,6 +582,287 @@ UniValue verifymessage(const UniValue& params, bool fHelp)
     return (pubkey.GetID() == keyID);
 }
 
+static bool GetAddressFromIndex(int type, const uint160& hash, std::string& address)
+{
+    if (type == ADDRESS_INDEX_SCRIPTHASH)
+        address = CBitcoinAddress(CScriptID(hash)).ToString();
+    else if (type == ADDRESS_INDEX_PUBKEYHASH)
+        address = CBitcoinAddress(CKeyID(hash)).ToString();
+    else
+        return false;
+    return true;
+}
+
+static bool GetIndexKey(const CBitcoinAddress& address, uint160& hashBytes, int& type)
+{
+    if (!address.IsValid())
+        return false;
+    CTxDestination dest = address.Get();
+    if (const CKeyID* keyID = boost::get<CKeyID>(&dest)) {
+        hashBytes = *keyID;
+        type = ADDRESS_INDEX_PUBKEYHASH;
+        return true;
+    }
+    if (const CScriptID* scriptID = boost::get<CScriptID>(&dest)) {
+        hashBytes = *scriptID;
+        type = ADDRESS_INDEX_SCRIPTHASH;
+        return true;
+    }
+    return false;
+}
+
+/** Parse a single address string or an object {"addresses": [...]} */
+static void GetAddressesFromParams(const UniValue& params, std::vector<std::pair<uint160, int> >& addresses)
+{
+    std::vector<UniValue> values;
+    if (params[0].isStr()) {
+        values.push_back(params[0]);
+    } else if (params[0].isObject()) {
+        UniValue addressValues = find_value(params[0].get_obj(), "addresses");
+        if (!addressValues.isArray())
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Addresses is expected to be an array");
+        values = addressValues.getValues();
+    } else {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+    }
+
+    for (const UniValue& value : values) {
+        uint160 hashBytes;
+        int type = 0;
+        if (!value.isStr() || !GetIndexKey(CBitcoinAddress(value.get_str()), hashBytes, type))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+        addresses.push_back(std::make_pair(hashBytes, type));
+    }
+}
+
+UniValue getaddressbalance(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 1)
+        throw runtime_error(
+            "getaddressbalance {\"addresses\": [\"address\",...]}\n"
+            "\nReturns the balance for one or more addresses (requires -addressindex).\n"
+
+            "\nArguments:\n"
+            "{\n"
+            "  \"addresses\"    (array, required) The vitae addresses\n"
+            "    [\n"
+            "      \"address\"  (string) The vitae address\n"
+            "      ,...\n"
+            "    ]\n"
+            "}\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"balance\": x.xxx,    (numeric) The current balance\n"
+            "  \"received\": x.xxx    (numeric) The total amount received, including change\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getaddressbalance", "'{\"addresses\": [\"VfMAcjQR1H1xDnfjT2KqMLJUnSwdFpzSQ5\"]}'") +
+            HelpExampleRpc("getaddressbalance", "{\"addresses\": [\"VfMAcjQR1H1xDnfjT2KqMLJUnSwdFpzSQ5\"]}"));
+
+    std::vector<std::pair<uint160, int> > addresses;
+    GetAddressesFromParams(params, addresses);
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    for (std::vector<std::pair<uint160, int> >::const_iterator it = addresses.begin(); it != addresses.end(); it++) {
+        if (!GetAddressIndex(it->first, it->second, addressIndex))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    }
+
+    CAmount nBalance = 0;
+    CAmount nReceived = 0;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it = addressIndex.begin(); it != addressIndex.end(); it++) {
+        if (it->second > 0)
+            nReceived += it->second;
+        nBalance += it->second;
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("balance", ValueFromAmount(nBalance)));
+    result.push_back(Pair("received", ValueFromAmount(nReceived)));
+    return result;
+}
+
+UniValue getaddressutxos(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 1)
+        throw runtime_error(
+            "getaddressutxos {\"addresses\": [\"address\",...]}\n"
+            "\nReturns all unspent outputs for one or more addresses (requires -addressindex).\n"
+
+            "\nArguments:\n"
+            "{\n"
+            "  \"addresses\"    (array, required) The vitae addresses\n"
+            "    [\n"
+            "      \"address\"  (string) The vitae address\n"
+            "      ,...\n"
+            "    ]\n"
+            "}\n"
+
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"address\": \"address\",  (string) The address\n"
+            "    \"txid\": \"hash\",        (string) The output txid\n"
+            "    \"outputIndex\": n,      (numeric) The output index\n"
+            "    \"script\": \"hex\",       (string) The script hex\n"
+            "    \"amount\": x.xxx,       (numeric) The output amount\n"
+            "    \"height\": n            (numeric) The block height\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"VfMAcjQR1H1xDnfjT2KqMLJUnSwdFpzSQ5\"]}'") +
+            HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"VfMAcjQR1H1xDnfjT2KqMLJUnSwdFpzSQ5\"]}"));
+
+    std::vector<std::pair<uint160, int> > addresses;
+    GetAddressesFromParams(params, addresses);
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
+    for (std::vector<std::pair<uint160, int> >::const_iterator it = addresses.begin(); it != addresses.end(); it++) {
+        if (!GetAddressUnspent(it->first, it->second, unspentOutputs))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    }
+
+    UniValue result(UniValue::VARR);
+    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it = unspentOutputs.begin(); it != unspentOutputs.end(); it++) {
+        std::string address;
+        if (!GetAddressFromIndex(it->first.type, it->first.hashBytes, address))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+
+        UniValue output(UniValue::VOBJ);
+        output.push_back(Pair("address", address));
+        output.push_back(Pair("txid", it->first.txhash.GetHex()));
+        output.push_back(Pair("outputIndex", (int)it->first.index));
+        output.push_back(Pair("script", HexStr(it->second.script.begin(), it->second.script.end())));
+        output.push_back(Pair("amount", ValueFromAmount(it->second.satoshis)));
+        output.push_back(Pair("height", it->second.blockHeight));
+        result.push_back(output);
+    }
+    return result;
+}
+
+UniValue getaddressdeltas(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 1 || !params[0].isObject())
+        throw runtime_error(
+            "getaddressdeltas {\"addresses\": [\"address\",...], \"start\": n, \"end\": n}\n"
+            "\nReturns all changes for one or more addresses, optionally within a block height range (requires -addressindex).\n"
+
+            "\nArguments:\n"
+            "{\n"
+            "  \"addresses\"    (array, required) The vitae addresses\n"
+            "    [\n"
+            "      \"address\"  (string) The vitae address\n"
+            "      ,...\n"
+            "    ]\n"
+            "  \"start\"        (numeric, optional) The first block height\n"
+            "  \"end\"          (numeric, optional) The last block height\n"
+            "}\n"
+
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"amount\": x.xxx,       (numeric) The difference in amount, negative when spending\n"
+            "    \"txid\": \"hash\",        (string) The related txid\n"
+            "    \"index\": n,            (numeric) The related input or output index\n"
+            "    \"blockindex\": n,       (numeric) The position of the transaction in the block\n"
+            "    \"height\": n,           (numeric) The block height\n"
+            "    \"address\": \"address\"   (string) The address\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"VfMAcjQR1H1xDnfjT2KqMLJUnSwdFpzSQ5\"], \"start\": 1000, \"end\": 2000}'") +
+            HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"VfMAcjQR1H1xDnfjT2KqMLJUnSwdFpzSQ5\"], \"start\": 1000, \"end\": 2000}"));
+
+    int nStart = 0;
+    int nEnd = 0;
+    UniValue startValue = find_value(params[0].get_obj(), "start");
+    UniValue endValue = find_value(params[0].get_obj(), "end");
+    if (startValue.isNum() && endValue.isNum()) {
+        nStart = startValue.get_int();
+        nEnd = endValue.get_int();
+        if (nStart <= 0 || nEnd < nStart)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Start and end are expected to be greater than zero, with end not below start");
+    }
+
+    std::vector<std::pair<uint160, int> > addresses;
+    GetAddressesFromParams(params, addresses);
+
+    UniValue result(UniValue::VARR);
+    for (std::vector<std::pair<uint160, int> >::const_iterator it = addresses.begin(); it != addresses.end(); it++) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+        if (!GetAddressIndex(it->first, it->second, addressIndex, nStart, nEnd))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+
+        std::string address;
+        if (!GetAddressFromIndex(it->second, it->first, address))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+
+        for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator itIndex = addressIndex.begin(); itIndex != addressIndex.end(); itIndex++) {
+            UniValue delta(UniValue::VOBJ);
+            delta.push_back(Pair("amount", ValueFromAmount(itIndex->second)));
+            delta.push_back(Pair("txid", itIndex->first.txhash.GetHex()));
+            delta.push_back(Pair("index", (int)itIndex->first.index));
+            delta.push_back(Pair("blockindex", (int)itIndex->first.txindex));
+            delta.push_back(Pair("height", itIndex->first.blockHeight));
+            delta.push_back(Pair("address", address));
+            result.push_back(delta);
+        }
+    }
+    return result;
+}
+
+UniValue getspentinfo(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 1 || !params[0].isObject())
+        throw runtime_error(
+            "getspentinfo {\"txid\": \"hash\", \"index\": n}\n"
+            "\nReturns the txid and index where an output is spent (requires -spentindex).\n"
+
+            "\nArguments:\n"
+            "{\n"
+            "  \"txid\"   (string, required) The hex string of the txid\n"
+            "  \"index\"  (numeric, required) The output index\n"
+            "}\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"txid\": \"hash\",   (string) The transaction id of the spending transaction\n"
+            "  \"index\": n,       (numeric) The spending input index\n"
+            "  \"height\": n       (numeric) The height of the block containing the spending transaction\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getspentinfo", "'{\"txid\": \"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", \"index\": 0}'") +
+            HelpExampleRpc("getspentinfo", "{\"txid\": \"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", \"index\": 0}"));
+
+    UniValue txidValue = find_value(params[0].get_obj(), "txid");
+    UniValue indexValue = find_value(params[0].get_obj(), "index");
+    if (!txidValue.isStr() || !indexValue.isNum())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid txid or index");
+
+    uint256 txid = ParseHashV(txidValue, "txid");
+    int outputIndex = indexValue.get_int();
+    if (outputIndex < 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid index");
+
+    CSpentIndexKey key(txid, outputIndex);
+    CSpentIndexValue value;
+    if (!GetSpentIndex(key, value))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unable to get spent info");
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("txid", value.txid.GetHex()));
+    obj.push_back(Pair("index", (int)value.inputIndex));
+    obj.push_back(Pair("height", value.blockHeight));
+    return obj;
+}
+
 UniValue setmocktime(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
@@ -604,6 +885,72 @@ UniValue setmocktime(const UniValue& params, bool fHelp)
     return NullUniValue;
 }
 
+UniValue getlockstats(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() > 1)
+        throw runtime_error(
+            "getlockstats ( reset )\n"
+            "\nReturns acquisition statistics of every lock site taken since startup or the last reset,\n"
+            "sorted by total wait time.\n"
+
+            "\nArguments:\n"
+            "1. reset  (boolean, optional, default=false) Reset the statistics after reading them\n"
+
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"lock\": \"name\",          (string) Name of the lock as written at the locking site\n"
+            "    \"location\": \"file:line\",   (string) Source location of the locking site\n"
+            "    \"acquired\": n,             (numeric) Number of times the lock was taken here\n"
+            "    \"contended\": n,            (numeric) Number of times the lock was held by another thread\n"
+            "    \"waittotal\": n,            (numeric) Total time spent waiting for the lock, in microseconds\n"
+            "    \"waitmax\": n,              (numeric) Longest wait for the lock, in microseconds\n"
+            "    \"holdtotal\": n,            (numeric) Total time the lock was held, in microseconds\n"
+            "    \"holdmax\": n,              (numeric) Longest time the lock was held, in microseconds\n"
+            "    \"holdhistogram\": {         (json object) Number of holds by duration\n"
+            "      \"<10us\": n, \"<100us\": n, \"<1ms\": n, \"<10ms\": n, \"<100ms\": n, \"<1s\": n, \">=1s\": n\n"
+            "    }\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getlockstats", "") + HelpExampleCli("getlockstats", "true") + HelpExampleRpc("getlockstats", "true"));
+
+    static const char* pszBuckets[LOCK_HOLD_BUCKETS] = {"<10us", "<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s"};
+
+    bool fReset = params.size() > 0 && params[0].get_bool();
+    std::vector<CLockStats> vStats = GetLockStats(fReset);
+
+    std::vector<std::pair<uint64_t, unsigned int> > vSorted;
+    for (unsigned int i = 0; i < vStats.size(); i++) {
+        if (vStats[i].nAcquired > 0 || vStats[i].nContended > 0)
+            vSorted.push_back(std::make_pair(vStats[i].nWaitMicros, i));
+    }
+    std::sort(vSorted.rbegin(), vSorted.rend());
+
+    UniValue ret(UniValue::VARR);
+    for (unsigned int i = 0; i < vSorted.size(); i++) {
+        const CLockStats& stats = vStats[vSorted[i].second];
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("lock", stats.strName));
+        obj.push_back(Pair("location", strprintf("%s:%d", stats.strFile, stats.nLine)));
+        obj.push_back(Pair("acquired", stats.nAcquired));
+        obj.push_back(Pair("contended", stats.nContended));
+        obj.push_back(Pair("waittotal", stats.nWaitMicros));
+        obj.push_back(Pair("waitmax", stats.nMaxWaitMicros));
+        obj.push_back(Pair("holdtotal", stats.nHoldMicros));
+        obj.push_back(Pair("holdmax", stats.nMaxHoldMicros));
+        UniValue histogram(UniValue::VOBJ);
+        for (int j = 0; j < LOCK_HOLD_BUCKETS; j++)
+            histogram.push_back(Pair(pszBuckets[j], stats.vHoldBuckets[j]));
+        obj.push_back(Pair("holdhistogram", histogram));
+        ret.push_back(obj);
+    }
+
+    return ret;
+}
+
 #ifdef ENABLE_WALLET
 UniValue getstakingstatus(const UniValue& params, bool fHelp)
 {
@@ -33,6 +33,7 @@ namespace RPCServer
 }
 
 class CBlockIndex;
+class CJSONStreamWriter;
 class CNetAddr;
 
 class JSONRequest
@@ -115,6 +116,8 @@ void RPCUnregisterTimerInterface(RPCTimerInterface *iface);
 void RPCRunLater(const std::string& name, boost::function<void(void)> func, int64_t nSeconds);
 
 typedef UniValue(*rpcfn_type)(const UniValue& params, bool fHelp);
+/** Writes the result of a command to a stream instead of returning it (see CRPCTable::executeStream) */
+typedef void(*rpcstreamfn_type)(const UniValue& params, CJSONStreamWriter& writer);
 
 class CRPCCommand
 {
@@ -125,6 +128,12 @@ public:
     bool okSafeMode;
     bool threadSafe;
     bool reqWallet;
+    rpcstreamfn_type streamActor; //!< optional, for commands with very large results
+
+    CRPCCommand(const std::string& categoryIn, const std::string& nameIn, rpcfn_type actorIn, bool okSafeModeIn,
+                bool threadSafeIn, bool reqWalletIn, rpcstreamfn_type streamActorIn = NULL)
+        : category(categoryIn), name(nameIn), actor(actorIn), okSafeMode(okSafeModeIn),
+          threadSafe(threadSafeIn), reqWallet(reqWalletIn), streamActor(streamActorIn) {}
 };
 
 /**
@@ -149,6 +158,13 @@ public:
      */
     UniValue execute(const std::string &method, const UniValue &params) const;
 
+    /**
+     * Execute a method, writing its result as a single JSON value to writer.
+     * @returns false if the method has no streaming implementation; nothing is written then.
+     * @throws an exception (UniValue) when an error happens.
+     */
+    bool executeStream(const std::string &method, const UniValue &params, CJSONStreamWriter& writer) const;
+
     /**
     * Returns a list of registered commands
     * @returns List of registered commands.
@@ -284,11 +300,14 @@ extern UniValue getdifficulty(const UniValue& params, bool fHelp);
 extern UniValue settxfee(const UniValue& params, bool fHelp);
 extern UniValue getmempoolinfo(const UniValue& params, bool fHelp);
 extern UniValue getrawmempool(const UniValue& params, bool fHelp);
+extern void getrawmempool_stream(const UniValue& params, CJSONStreamWriter& writer);
 extern UniValue getblockhash(const UniValue& params, bool fHelp);
 extern UniValue getblock(const UniValue& params, bool fHelp);
+extern void getblock_stream(const UniValue& params, CJSONStreamWriter& writer);
 extern UniValue getblockheader(const UniValue& params, bool fHelp);
 extern UniValue getfeeinfo(const UniValue& params, bool fHelp);
 extern UniValue gettxoutsetinfo(const UniValue& params, bool fHelp);
+extern UniValue getdbstats(const UniValue& params, bool fHelp);
 extern UniValue gettxout(const UniValue& params, bool fHelp);
 extern UniValue verifychain(const UniValue& params, bool fHelp);
 extern UniValue getchaintips(const UniValue& params, bool fHelp);
@@ -334,7 +353,14 @@ extern UniValue validateaddress(const UniValue& params, bool fHelp);
 extern UniValue createmultisig(const UniValue& params, bool fHelp);
 extern UniValue verifymessage(const UniValue& params, bool fHelp);
 extern UniValue setmocktime(const UniValue& params, bool fHelp);
+extern UniValue getlockstats(const UniValue& params, bool fHelp);
 extern UniValue getstakingstatus(const UniValue& params, bool fHelp);
+extern UniValue getaddressbalance(const UniValue& params, bool fHelp);
+extern UniValue getaddressutxos(const UniValue& params, bool fHelp);
+extern UniValue getaddressdeltas(const UniValue& params, bool fHelp);
+extern UniValue getspentinfo(const UniValue& params, bool fHelp);
+
+extern UniValue zmqreplay(const UniValue& params, bool fHelp); // in zmq/zmqrpc.cpp
 
 extern UniValue mnspork(const UniValue& params, bool fHelp);
 extern UniValue masternode(const UniValue& params, bool fHelp);
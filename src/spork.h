@@ -73,6 +73,8 @@ using namespace boost;
 class CSporkMessage;
 class CSporkManager;
 
+//! Guards mapSporks and mapSporksActive, CheckBlock reads the sporks from the block import workers
+extern CCriticalSection cs_mapSporks;
 extern std::map<uint256, CSporkMessage> mapSporks;
 extern std::map<int, CSporkMessage> mapSporksActive;
 extern CSporkManager sporkManager;
@@ -291,6 +291,53 @@ public:
     }
 };
 
+/** Read-only stream over memory owned by someone else, such as a memory mapped block file.
+ *
+ * Objects are deserialized straight from the span, without copying it into a buffer first.
+ * The span must stay valid while the reader is used.
+ */
+class CSpanReader
+{
+private:
+    const char* pbegin;
+    const char* pend;
+    int nType;
+    int nVersion;
+
+public:
+    CSpanReader(const char* pbeginIn, const char* pendIn, int nTypeIn, int nVersionIn) : pbegin(pbeginIn), pend(pendIn), nType(nTypeIn), nVersion(nVersionIn) {}
+
+    int GetType() const { return nType; }
+    int GetVersion() const { return nVersion; }
+    size_t size() const { return pend - pbegin; }
+    bool empty() const { return pbegin == pend; }
+
+    CSpanReader& read(char* pch, size_t nSize)
+    {
+        if (nSize > size())
+            throw std::ios_base::failure("CSpanReader::read : end of data");
+        memcpy(pch, pbegin, nSize);
+        pbegin += nSize;
+        return (*this);
+    }
+
+    CSpanReader& ignore(size_t nSize)
+    {
+        if (nSize > size())
+            throw std::ios_base::failure("CSpanReader::ignore : end of data");
+        pbegin += nSize;
+        return (*this);
+    }
+
+    template <typename T>
+    CSpanReader& operator>>(T& obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj, nType, nVersion);
+        return (*this);
+    }
+};
+
 
 /** Non-refcounted RAII wrapper for FILE*
  *
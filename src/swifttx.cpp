@@ -26,6 +26,7 @@ std::map<uint256, CTransaction> mapTxLockReq;
 std::map<uint256, CTransaction> mapTxLockReqRejected;
 std::map<uint256, CConsensusVote> mapTxLockVote;
 std::map<uint256, CTransactionLock> mapTxLocks;
+CCriticalSection cs_mapLockedInputs;
 std::map<COutPoint, uint256> mapLockedInputs;
 std::map<uint256, int64_t> mapUnknownVotes; //track votes with no tx for DOS
 int nCompleteTXLocks;
@@ -106,9 +107,12 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
                 pfrom->addr.ToString().c_str(), pfrom->cleanSubVer.c_str(),
                 tx.GetHash().ToString().c_str());
 
-            BOOST_FOREACH (const CTxIn& in, tx.vin) {
-                if (!mapLockedInputs.count(in.prevout)) {
-                    mapLockedInputs.insert(make_pair(in.prevout, tx.GetHash()));
+            {
+                LOCK(cs_mapLockedInputs);
+                BOOST_FOREACH (const CTxIn& in, tx.vin) {
+                    if (!mapLockedInputs.count(in.prevout)) {
+                        mapLockedInputs.insert(make_pair(in.prevout, tx.GetHash()));
+                    }
                 }
             }
 
@@ -370,6 +374,7 @@ bool ProcessConsensusVote(CNode* pnode, CConsensusVote& ctx)
 #endif
 
                 if (mapTxLockReq.count(ctx.txHash)) {
+                    LOCK(cs_mapLockedInputs);
                     BOOST_FOREACH (const CTxIn& in, tx.vin) {
                         if (!mapLockedInputs.count(in.prevout)) {
                             mapLockedInputs.insert(make_pair(in.prevout, ctx.txHash));
@@ -403,11 +408,12 @@ bool CheckForConflictingLocks(CTransaction& tx)
         rescan the blocks and find they're acceptable and then take the chain with the most work.
     */
     BOOST_FOREACH (const CTxIn& in, tx.vin) {
-        if (mapLockedInputs.count(in.prevout)) {
-            if (mapLockedInputs[in.prevout] != tx.GetHash()) {
-                LogPrintf("SwiftX::CheckForConflictingLocks - found two complete conflicting locks - removing both. %s %s", tx.GetHash().ToString().c_str(), mapLockedInputs[in.prevout].ToString().c_str());
+        uint256 txHashLocked;
+        if (GetLockedInputTx(in.prevout, txHashLocked)) {
+            if (txHashLocked != tx.GetHash()) {
+                LogPrintf("SwiftX::CheckForConflictingLocks - found two complete conflicting locks - removing both. %s %s", tx.GetHash().ToString().c_str(), txHashLocked.ToString().c_str());
                 if (mapTxLocks.count(tx.GetHash())) mapTxLocks[tx.GetHash()].nExpiration = GetTime();
-                if (mapTxLocks.count(mapLockedInputs[in.prevout])) mapTxLocks[mapLockedInputs[in.prevout]].nExpiration = GetTime();
+                if (mapTxLocks.count(txHashLocked)) mapTxLocks[txHashLocked].nExpiration = GetTime();
                 return true;
             }
         }
@@ -416,6 +422,16 @@ bool CheckForConflictingLocks(CTransaction& tx)
     return false;
 }
 
+bool GetLockedInputTx(const COutPoint& outpoint, uint256& txHash)
+{
+    LOCK(cs_mapLockedInputs);
+    std::map<COutPoint, uint256>::const_iterator it = mapLockedInputs.find(outpoint);
+    if (it == mapLockedInputs.end())
+        return false;
+    txHash = it->second;
+    return true;
+}
+
 int64_t GetAverageVoteTime()
 {
     std::map<uint256, int64_t>::iterator it = mapUnknownVotes.begin();
@@ -444,8 +460,11 @@ void CleanTransactionLocksList()
             if (mapTxLockReq.count(it->second.txHash)) {
                 CTransaction& tx = mapTxLockReq[it->second.txHash];
 
-                BOOST_FOREACH (const CTxIn& in, tx.vin)
-                    mapLockedInputs.erase(in.prevout);
+                {
+                    LOCK(cs_mapLockedInputs);
+                    BOOST_FOREACH (const CTxIn& in, tx.vin)
+                        mapLockedInputs.erase(in.prevout);
+                }
 
                 mapTxLockReq.erase(it->second.txHash);
                 mapTxLockReqRejected.erase(it->second.txHash);
@@ -10,6 +10,7 @@
 #include "util.h"
 #include "utilstrencodings.h"
 
+#include <chrono>
 #include <stdio.h>
 
 #include <boost/foreach.hpp>
@@ -23,6 +24,89 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+// Lock sites are never unregistered: they are function statics that outlive every lock taken
+static boost::mutex& LockSitesMutex()
+{
+    static boost::mutex* pmutex = new boost::mutex();
+    return *pmutex;
+}
+
+static std::vector<CLockSite*>& LockSites()
+{
+    static std::vector<CLockSite*>* pvSites = new std::vector<CLockSite*>();
+    return *pvSites;
+}
+
+static void UpdateMax(std::atomic<uint64_t>& nMax, uint64_t nValue)
+{
+    uint64_t nPrev = nMax.load(std::memory_order_relaxed);
+    while (nValue > nPrev && !nMax.compare_exchange_weak(nPrev, nValue, std::memory_order_relaxed)) {
+    }
+}
+
+CLockSite::CLockSite(const char* pszNameIn, const char* pszFileIn, int nLineIn) : pszName(pszNameIn), pszFile(pszFileIn), nLine(nLineIn),
+                                                                                   nAcquired(0), nContended(0), nWaitMicros(0), nMaxWaitMicros(0),
+                                                                                   nHoldMicros(0), nMaxHoldMicros(0)
+{
+    for (int i = 0; i < LOCK_HOLD_BUCKETS; i++)
+        vHoldBuckets[i] = 0;
+
+    boost::unique_lock<boost::mutex> lock(LockSitesMutex());
+    LockSites().push_back(this);
+}
+
+void CLockSite::RecordWait(int64_t nMicros)
+{
+    uint64_t nWait = nMicros > 0 ? nMicros : 0;
+    nContended.fetch_add(1, std::memory_order_relaxed);
+    nWaitMicros.fetch_add(nWait, std::memory_order_relaxed);
+    UpdateMax(nMaxWaitMicros, nWait);
+}
+
+void CLockSite::RecordHold(int64_t nMicros)
+{
+    uint64_t nHold = nMicros > 0 ? nMicros : 0;
+    nHoldMicros.fetch_add(nHold, std::memory_order_relaxed);
+    UpdateMax(nMaxHoldMicros, nHold);
+
+    int nBucket = 0;
+    for (uint64_t nLimit = 10; nBucket < LOCK_HOLD_BUCKETS - 1 && nHold >= nLimit; nLimit *= 10)
+        nBucket++;
+    vHoldBuckets[nBucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+static uint64_t ReadStat(std::atomic<uint64_t>& nStat, bool fReset)
+{
+    return fReset ? nStat.exchange(0, std::memory_order_relaxed) : nStat.load(std::memory_order_relaxed);
+}
+
+std::vector<CLockStats> GetLockStats(bool fReset)
+{
+    std::vector<CLockStats> vStats;
+    boost::unique_lock<boost::mutex> lock(LockSitesMutex());
+    BOOST_FOREACH (CLockSite* psite, LockSites()) {
+        CLockStats stats;
+        stats.strName = psite->pszName;
+        stats.strFile = psite->pszFile;
+        stats.nLine = psite->nLine;
+        stats.nAcquired = ReadStat(psite->nAcquired, fReset);
+        stats.nContended = ReadStat(psite->nContended, fReset);
+        stats.nWaitMicros = ReadStat(psite->nWaitMicros, fReset);
+        stats.nMaxWaitMicros = ReadStat(psite->nMaxWaitMicros, fReset);
+        stats.nHoldMicros = ReadStat(psite->nHoldMicros, fReset);
+        stats.nMaxHoldMicros = ReadStat(psite->nMaxHoldMicros, fReset);
+        for (int i = 0; i < LOCK_HOLD_BUCKETS; i++)
+            stats.vHoldBuckets[i] = ReadStat(psite->vHoldBuckets[i], fReset);
+        vStats.push_back(stats);
+    }
+    return vStats;
+}
+
+int64_t GetLockTimeMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
@@ -11,6 +11,11 @@
 
 #include "threadsafety.h"
 
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
@@ -110,59 +115,122 @@ typedef boost::condition_variable CConditionVariable;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/** Number of lock hold time histogram buckets: below 10us, 100us, 1ms, 10ms, 100ms, 1s, and longer */
+static const int LOCK_HOLD_BUCKETS = 7;
+
+/**
+ * Acquisition statistics of one LOCK, LOCK2 or TRY_LOCK site. Each site owns a
+ * static instance that registers itself on first use, so recording a lock only
+ * costs a few relaxed atomic updates. The wait is only timed when the lock was
+ * held by another thread, uncontended acquisitions are just counted.
+ */
+class CLockSite
+{
+public:
+    const char* pszName;
+    const char* pszFile;
+    int nLine;
+
+    std::atomic<uint64_t> nAcquired;
+    std::atomic<uint64_t> nContended;
+    std::atomic<uint64_t> nWaitMicros;
+    std::atomic<uint64_t> nMaxWaitMicros;
+    std::atomic<uint64_t> nHoldMicros;
+    std::atomic<uint64_t> nMaxHoldMicros;
+    std::atomic<uint64_t> vHoldBuckets[LOCK_HOLD_BUCKETS];
+
+    CLockSite(const char* pszNameIn, const char* pszFileIn, int nLineIn);
+
+    void RecordWait(int64_t nMicros);
+    void RecordHold(int64_t nMicros);
+};
+
+/** Snapshot of the statistics of one lock site, as reported by getlockstats */
+struct CLockStats {
+    std::string strName;
+    std::string strFile;
+    int nLine;
+    uint64_t nAcquired;
+    uint64_t nContended;
+    uint64_t nWaitMicros;
+    uint64_t nMaxWaitMicros;
+    uint64_t nHoldMicros;
+    uint64_t nMaxHoldMicros;
+    uint64_t vHoldBuckets[LOCK_HOLD_BUCKETS];
+};
+
+/** Statistics of every lock site used so far, optionally resetting them to zero while reading */
+std::vector<CLockStats> GetLockStats(bool fReset = false);
+
+/** Monotonic clock used to time lock waits and holds */
+int64_t GetLockTimeMicros();
+
 /** Wrapper around boost::unique_lock<CCriticalSection> */
 template <typename Mutex>
 class SCOPED_LOCKABLE CMutexLock
 {
 private:
     boost::unique_lock<Mutex> lock;
+    CLockSite& site;
+    int64_t nLockedTime;
 
-    void Enter(const char* pszName, const char* pszFile, int nLine)
+    void Enter()
     {
-        EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()));
-#ifdef DEBUG_LOCKCONTENTION
+        EnterCritical(site.pszName, site.pszFile, site.nLine, (void*)(lock.mutex()));
         if (!lock.try_lock()) {
-            PrintLockContention(pszName, pszFile, nLine);
+#ifdef DEBUG_LOCKCONTENTION
+            PrintLockContention(site.pszName, site.pszFile, site.nLine);
 #endif
+            int64_t nWaitStart = GetLockTimeMicros();
             lock.lock();
-#ifdef DEBUG_LOCKCONTENTION
+            nLockedTime = GetLockTimeMicros();
+            site.RecordWait(nLockedTime - nWaitStart);
+        } else {
+            nLockedTime = GetLockTimeMicros();
         }
-#endif
+        site.nAcquired.fetch_add(1, std::memory_order_relaxed);
     }
 
-    bool TryEnter(const char* pszName, const char* pszFile, int nLine)
+    bool TryEnter()
     {
-        EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()), true);
+        EnterCritical(site.pszName, site.pszFile, site.nLine, (void*)(lock.mutex()), true);
         lock.try_lock();
-        if (!lock.owns_lock())
+        if (!lock.owns_lock()) {
             LeaveCritical();
-        return lock.owns_lock();
+            site.RecordWait(0);
+            return false;
+        }
+        nLockedTime = GetLockTimeMicros();
+        site.nAcquired.fetch_add(1, std::memory_order_relaxed);
+        return true;
     }
 
 public:
-    CMutexLock(Mutex& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(mutexIn) : lock(mutexIn, boost::defer_lock)
+    CMutexLock(Mutex& mutexIn, CLockSite& siteIn, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(mutexIn) : lock(mutexIn, boost::defer_lock), site(siteIn), nLockedTime(0)
     {
         if (fTry)
-            TryEnter(pszName, pszFile, nLine);
+            TryEnter();
         else
-            Enter(pszName, pszFile, nLine);
+            Enter();
     }
 
-    CMutexLock(Mutex* pmutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(pmutexIn)
+    CMutexLock(Mutex* pmutexIn, CLockSite& siteIn, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(pmutexIn) : site(siteIn), nLockedTime(0)
     {
         if (!pmutexIn) return;
 
         lock = boost::unique_lock<Mutex>(*pmutexIn, boost::defer_lock);
         if (fTry)
-            TryEnter(pszName, pszFile, nLine);
+            TryEnter();
         else
-            Enter(pszName, pszFile, nLine);
+            Enter();
     }
 
     ~CMutexLock() UNLOCK_FUNCTION()
     {
-        if (lock.owns_lock())
+        if (lock.owns_lock()) {
+            site.RecordHold(GetLockTimeMicros() - nLockedTime);
             LeaveCritical();
+        }
     }
 
     operator bool()
@@ -176,9 +244,20 @@ typedef CMutexLock<CCriticalSection> CCriticalBlock;
 #define PASTE(x, y) x ## y
 #define PASTE2(x, y) PASTE(x, y)
 
-#define LOCK(cs) CCriticalBlock PASTE2(criticalblock, __COUNTER__)(cs, #cs, __FILE__, __LINE__)
-#define LOCK2(cs1, cs2) CCriticalBlock criticalblock1(cs1, #cs1, __FILE__, __LINE__), criticalblock2(cs2, #cs2, __FILE__, __LINE__)
-#define TRY_LOCK(cs, name) CCriticalBlock name(cs, #cs, __FILE__, __LINE__, true)
+#define LOCK_SITE(cs, site) static CLockSite site(#cs, __FILE__, __LINE__)
+
+#define LOCK(cs) LOCK_(cs, __COUNTER__)
+#define LOCK_(cs, n) \
+    LOCK_SITE(cs, PASTE2(locksite, n)); \
+    CCriticalBlock PASTE2(criticalblock, n)(cs, PASTE2(locksite, n))
+#define LOCK2(cs1, cs2) LOCK2_(cs1, cs2, __COUNTER__)
+#define LOCK2_(cs1, cs2, n) \
+    LOCK_SITE(cs1, PASTE2(locksite1_, n)); \
+    LOCK_SITE(cs2, PASTE2(locksite2_, n)); \
+    CCriticalBlock criticalblock1(cs1, PASTE2(locksite1_, n)), criticalblock2(cs2, PASTE2(locksite2_, n))
+#define TRY_LOCK(cs, name) \
+    LOCK_SITE(cs, PASTE2(locksite_, name)); \
+    CCriticalBlock name(cs, PASTE2(locksite_, name), true)
 
 #define ENTER_CRITICAL_SECTION(cs)                            \
     {                                                         \
@@ -0,0 +1,176 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "addressindex.h"
+#include "main.h"
+#include "spentindex.h"
+#include "txdb.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+BOOST_AUTO_TEST_CASE(addressindex_key_order)
+{
+    uint160 addressHash = 0x1234;
+    uint256 txhash = 0xabcd;
+
+    CAddressIndexKey key(ADDRESS_INDEX_PUBKEYHASH, addressHash, 0x01020304, 7, txhash, 3, true);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << key;
+    BOOST_CHECK_EQUAL(ss.size(), key.GetSerializeSize(SER_DISK, CLIENT_VERSION));
+
+    // the height follows the type and the address, most significant byte first
+    BOOST_CHECK_EQUAL((unsigned char)ss[21], 0x01);
+    BOOST_CHECK_EQUAL((unsigned char)ss[24], 0x04);
+
+    CAddressIndexKey keyRead;
+    ss >> keyRead;
+    BOOST_CHECK_EQUAL(keyRead.type, (unsigned int)ADDRESS_INDEX_PUBKEYHASH);
+    BOOST_CHECK(keyRead.hashBytes == addressHash);
+    BOOST_CHECK_EQUAL(keyRead.blockHeight, 0x01020304);
+    BOOST_CHECK_EQUAL(keyRead.txindex, 7U);
+    BOOST_CHECK(keyRead.txhash == txhash);
+    BOOST_CHECK_EQUAL(keyRead.index, 3U);
+    BOOST_CHECK(keyRead.spending);
+
+    // keys sort by height, so a byte-wise comparison follows block order
+    CDataStream ssLow(SER_DISK, CLIENT_VERSION), ssHigh(SER_DISK, CLIENT_VERSION);
+    ssLow << CAddressIndexKey(ADDRESS_INDEX_PUBKEYHASH, addressHash, 255, 0, txhash, 0, false);
+    ssHigh << CAddressIndexKey(ADDRESS_INDEX_PUBKEYHASH, addressHash, 256, 0, txhash, 0, false);
+    BOOST_CHECK(ssLow.str() < ssHigh.str());
+
+    CAddressUnspentKey unspentKey(ADDRESS_INDEX_SCRIPTHASH, addressHash, txhash, 5);
+    CAddressUnspentValue unspentValue(42 * COIN, CScript() << OP_TRUE, 100);
+    CDataStream ssUnspent(SER_DISK, CLIENT_VERSION);
+    ssUnspent << unspentKey << unspentValue;
+    CAddressUnspentKey unspentKeyRead;
+    CAddressUnspentValue unspentValueRead;
+    ssUnspent >> unspentKeyRead >> unspentValueRead;
+    BOOST_CHECK_EQUAL(unspentKeyRead.type, (unsigned int)ADDRESS_INDEX_SCRIPTHASH);
+    BOOST_CHECK(unspentKeyRead.txhash == txhash);
+    BOOST_CHECK_EQUAL(unspentKeyRead.index, 5U);
+    BOOST_CHECK_EQUAL(unspentValueRead.satoshis, 42 * COIN);
+    BOOST_CHECK(unspentValueRead.script == unspentValue.script);
+    BOOST_CHECK_EQUAL(unspentValueRead.blockHeight, 100);
+    BOOST_CHECK(CAddressUnspentValue().IsNull());
+    BOOST_CHECK(CSpentIndexValue().IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_extract)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CPubKey pubkey = key.GetPubKey();
+    int addressType;
+    uint160 addressHash;
+
+    // pay to pubkey hash and pay to pubkey are indexed under the same key id
+    BOOST_CHECK(ExtractAddressIndexKey(GetScriptForDestination(pubkey.GetID()), addressType, addressHash));
+    BOOST_CHECK_EQUAL(addressType, ADDRESS_INDEX_PUBKEYHASH);
+    BOOST_CHECK(addressHash == uint160(pubkey.GetID()));
+    BOOST_CHECK(ExtractAddressIndexKey(CScript() << ToByteVector(pubkey) << OP_CHECKSIG, addressType, addressHash));
+    BOOST_CHECK_EQUAL(addressType, ADDRESS_INDEX_PUBKEYHASH);
+    BOOST_CHECK(addressHash == uint160(pubkey.GetID()));
+
+    CScript redeemScript = CScript() << OP_TRUE;
+    BOOST_CHECK(ExtractAddressIndexKey(GetScriptForDestination(CScriptID(redeemScript)), addressType, addressHash));
+    BOOST_CHECK_EQUAL(addressType, ADDRESS_INDEX_SCRIPTHASH);
+    BOOST_CHECK(addressHash == uint160(CScriptID(redeemScript)));
+
+    // empty coinstake markers and zerocoin mints don't pay to an address
+    BOOST_CHECK(!ExtractAddressIndexKey(CScript(), addressType, addressHash));
+    std::vector<unsigned char> vchPubcoin(64, 0x5a);
+    BOOST_CHECK(!ExtractAddressIndexKey(CScript() << OP_ZEROCOINMINT << vchPubcoin, addressType, addressHash));
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_db)
+{
+    CBlockTreeDB db(1 << 20, true);
+    uint160 addressHash = 0x1234;
+    uint160 addressOther = 0x1235;
+
+    // an address receiving at heights 10, 20 and 30 and spending at 20, and another address in between
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vIndex;
+    vIndex.push_back(std::make_pair(CAddressIndexKey(ADDRESS_INDEX_PUBKEYHASH, addressHash, 30, 1, 3, 0, false), 3 * COIN));
+    vIndex.push_back(std::make_pair(CAddressIndexKey(ADDRESS_INDEX_PUBKEYHASH, addressHash, 10, 1, 1, 0, false), 1 * COIN));
+    vIndex.push_back(std::make_pair(CAddressIndexKey(ADDRESS_INDEX_PUBKEYHASH, addressHash, 20, 1, 2, 0, false), 2 * COIN));
+    vIndex.push_back(std::make_pair(CAddressIndexKey(ADDRESS_INDEX_PUBKEYHASH, addressHash, 20, 2, 4, 0, true), -1 * COIN));
+    vIndex.push_back(std::make_pair(CAddressIndexKey(ADDRESS_INDEX_PUBKEYHASH, addressOther, 15, 1, 5, 0, false), 5 * COIN));
+    vIndex.push_back(std::make_pair(CAddressIndexKey(ADDRESS_INDEX_SCRIPTHASH, addressHash, 15, 1, 6, 0, false), 6 * COIN));
+    BOOST_CHECK(db.WriteAddressIndex(vIndex));
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vRead;
+    BOOST_CHECK(db.ReadAddressIndex(addressHash, ADDRESS_INDEX_PUBKEYHASH, vRead));
+    BOOST_CHECK_EQUAL(vRead.size(), 4U);
+    BOOST_CHECK_EQUAL(vRead[0].first.blockHeight, 10);
+    BOOST_CHECK_EQUAL(vRead[1].first.blockHeight, 20);
+    BOOST_CHECK_EQUAL(vRead[1].second, 2 * COIN);
+    BOOST_CHECK(vRead[2].first.spending);
+    BOOST_CHECK_EQUAL(vRead[2].second, -1 * COIN);
+    BOOST_CHECK_EQUAL(vRead[3].first.blockHeight, 30);
+
+    vRead.clear();
+    BOOST_CHECK(db.ReadAddressIndex(addressHash, ADDRESS_INDEX_PUBKEYHASH, vRead, 15, 25));
+    BOOST_CHECK_EQUAL(vRead.size(), 2U);
+    BOOST_CHECK_EQUAL(vRead[0].first.blockHeight, 20);
+    BOOST_CHECK_EQUAL(vRead[1].first.blockHeight, 20);
+
+    vRead.clear();
+    BOOST_CHECK(db.ReadAddressIndex(addressHash, ADDRESS_INDEX_SCRIPTHASH, vRead));
+    BOOST_CHECK_EQUAL(vRead.size(), 1U);
+    BOOST_CHECK_EQUAL(vRead[0].second, 6 * COIN);
+
+    // disconnecting the block at height 30 erases its entries
+    vIndex.resize(1);
+    BOOST_CHECK(db.EraseAddressIndex(vIndex));
+    vRead.clear();
+    BOOST_CHECK(db.ReadAddressIndex(addressHash, ADDRESS_INDEX_PUBKEYHASH, vRead));
+    BOOST_CHECK_EQUAL(vRead.size(), 3U);
+    BOOST_CHECK_EQUAL(vRead.back().first.blockHeight, 20);
+
+    // unspent outputs are written and erased by a null value
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUnspent;
+    vUnspent.push_back(std::make_pair(CAddressUnspentKey(ADDRESS_INDEX_PUBKEYHASH, addressHash, 1, 0), CAddressUnspentValue(1 * COIN, CScript(), 10)));
+    vUnspent.push_back(std::make_pair(CAddressUnspentKey(ADDRESS_INDEX_PUBKEYHASH, addressHash, 2, 0), CAddressUnspentValue(2 * COIN, CScript(), 20)));
+    vUnspent.push_back(std::make_pair(CAddressUnspentKey(ADDRESS_INDEX_PUBKEYHASH, addressOther, 5, 0), CAddressUnspentValue(5 * COIN, CScript(), 15)));
+    BOOST_CHECK(db.UpdateAddressUnspentIndex(vUnspent));
+    vUnspent.clear();
+    vUnspent.push_back(std::make_pair(CAddressUnspentKey(ADDRESS_INDEX_PUBKEYHASH, addressHash, 1, 0), CAddressUnspentValue()));
+    BOOST_CHECK(db.UpdateAddressUnspentIndex(vUnspent));
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUnspentRead;
+    BOOST_CHECK(db.ReadAddressUnspentIndex(addressHash, ADDRESS_INDEX_PUBKEYHASH, vUnspentRead));
+    BOOST_CHECK_EQUAL(vUnspentRead.size(), 1U);
+    BOOST_CHECK(vUnspentRead[0].first.txhash == 2);
+    BOOST_CHECK_EQUAL(vUnspentRead[0].second.satoshis, 2 * COIN);
+    BOOST_CHECK_EQUAL(vUnspentRead[0].second.blockHeight, 20);
+}
+
+BOOST_AUTO_TEST_CASE(spentindex_db)
+{
+    CBlockTreeDB db(1 << 20, true);
+    CSpentIndexKey key(0xabcd, 1);
+    CSpentIndexValue value;
+    BOOST_CHECK(!db.ReadSpentIndex(key, value));
+
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > vSpent;
+    vSpent.push_back(std::make_pair(key, CSpentIndexValue(0xbeef, 2, 50, 7 * COIN, ADDRESS_INDEX_PUBKEYHASH, 0x1234)));
+    BOOST_CHECK(db.UpdateSpentIndex(vSpent));
+    BOOST_CHECK(db.ReadSpentIndex(key, value));
+    BOOST_CHECK(value.txid == 0xbeef);
+    BOOST_CHECK_EQUAL(value.inputIndex, 2U);
+    BOOST_CHECK_EQUAL(value.blockHeight, 50);
+    BOOST_CHECK_EQUAL(value.satoshis, 7 * COIN);
+    BOOST_CHECK_EQUAL(value.addressType, ADDRESS_INDEX_PUBKEYHASH);
+    BOOST_CHECK(value.addressHash == 0x1234);
+    BOOST_CHECK(!db.ReadSpentIndex(CSpentIndexKey(0xabcd, 0), value));
+
+    // disconnecting the spending block erases the entry
+    vSpent[0].second.SetNull();
+    BOOST_CHECK(db.UpdateSpentIndex(vSpent));
+    BOOST_CHECK(!db.ReadSpentIndex(key, value));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
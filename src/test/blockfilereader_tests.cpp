@@ -0,0 +1,84 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilereader.h"
+#include "blockfilewriter.h"
+#include "clientversion.h"
+#include "main.h"
+#include "primitives/transaction.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(blockfilereader_tests)
+
+static const unsigned char pchMagic[4] = {0x90, 0xc4, 0xfd, 0xe9};
+
+static CDataStream MakeRecord(const CMutableTransaction& tx)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    unsigned int nSize = ss.GetSerializeSize(CTransaction(tx));
+    ss << FLATDATA(pchMagic) << nSize << CTransaction(tx);
+    return ss;
+}
+
+BOOST_AUTO_TEST_CASE(blockfilereader_maprecord)
+{
+    CMutableTransaction tx1, tx2;
+    tx1.nLockTime = 1;
+    tx2.vin.resize(3);
+    tx2.vout.resize(2);
+    CDataStream ss1 = MakeRecord(tx1);
+    CDataStream ss2 = MakeRecord(tx2);
+
+    CBlockFileWriter writer;
+    CBlockFileReader reader;
+    BOOST_CHECK(writer.Write(CDiskBlockPos(9100, 0), "blk", ss1));
+
+    // records are read from the mapping, a position without a header can't be
+    CMappedRecord record;
+    BOOST_CHECK(!reader.MapRecord(CDiskBlockPos(9100, 4), "blk", record));
+    BOOST_REQUIRE(reader.MapRecord(CDiskBlockPos(9100, 8), "blk", record));
+    BOOST_CHECK_EQUAL(record.pend - record.pbegin, (int)ss1.size() - 8);
+    CTransaction tx;
+    CSpanReader span = record.GetReader(SER_DISK, CLIENT_VERSION);
+    span >> tx;
+    BOOST_CHECK(span.empty());
+    BOOST_CHECK(tx.GetHash() == CTransaction(tx1).GetHash());
+    BOOST_CHECK_THROW(span >> tx, std::ios_base::failure);
+
+    // a record behind the end of the old mapping maps the grown file again, the old record stays readable
+    BOOST_CHECK(writer.Write(CDiskBlockPos(9100, ss1.size()), "blk", ss2));
+    CMappedRecord record2;
+    BOOST_REQUIRE(reader.MapRecord(CDiskBlockPos(9100, ss1.size() + 8), "blk", record2));
+    BOOST_CHECK(record2.file != record.file);
+    span = record2.GetReader(SER_DISK, CLIENT_VERSION);
+    span >> tx;
+    BOOST_CHECK(tx.GetHash() == CTransaction(tx2).GetHash());
+    span = record.GetReader(SER_DISK, CLIENT_VERSION);
+    span >> tx;
+    BOOST_CHECK(tx.GetHash() == CTransaction(tx1).GetHash());
+
+    // a size beyond the end of the file is refused instead of read
+    CDataStream ssBad(SER_DISK, CLIENT_VERSION);
+    ssBad << FLATDATA(pchMagic) << (unsigned int)1000000;
+    BOOST_CHECK(writer.Write(CDiskBlockPos(9101, 0), "blk", ssBad));
+    BOOST_CHECK(!reader.MapRecord(CDiskBlockPos(9101, 8), "blk", record));
+
+    // a truncated and forgotten file only hands out the records it still holds
+    BOOST_CHECK(writer.Write(CDiskBlockPos(9102, 0), "blk", ss1));
+    BOOST_CHECK(writer.Write(CDiskBlockPos(9102, ss1.size()), "blk", ss2));
+    BOOST_REQUIRE(reader.MapRecord(CDiskBlockPos(9102, ss1.size() + 8), "blk", record2));
+    writer.Flush();
+    boost::filesystem::resize_file(GetBlockPosFilename(CDiskBlockPos(9102, 0), "blk"), ss1.size() + 8);
+    reader.Forget(9102, "blk");
+    BOOST_CHECK(!reader.MapRecord(CDiskBlockPos(9102, ss1.size() + 8), "blk", record2));
+    BOOST_CHECK(reader.MapRecord(CDiskBlockPos(9102, 8), "blk", record2));
+
+    // nothing is mapped once mapping is disabled
+    reader.SetMaxFiles(0);
+    BOOST_CHECK(!reader.MapRecord(CDiskBlockPos(9100, 8), "blk", record));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilewriter.h"
+#include "clientversion.h"
+#include "main.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(blockfilewriter_tests)
+
+static std::vector<char> ReadFile(const CDiskBlockPos& pos, const char* prefix, unsigned int nLength)
+{
+    std::vector<char> vch(nLength);
+    FILE* file = strcmp(prefix, "blk") == 0 ? OpenBlockFile(pos, true) : OpenUndoFile(pos, true);
+    BOOST_REQUIRE(file);
+    BOOST_CHECK_EQUAL(fread(&vch[0], 1, nLength, file), nLength);
+    fclose(file);
+    return vch;
+}
+
+static CDataStream MakeRecord(unsigned int nLength, char c)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    for (unsigned int i = 0; i < nLength; i++)
+        ss << (char)(c + i % 7);
+    return ss;
+}
+
+BOOST_AUTO_TEST_CASE(blockfilewriter_queue)
+{
+    CBlockFileWriter writer;
+    writer.Start();
+
+    CDiskBlockPos pos(9000, 0);
+    CDataStream ss1 = MakeRecord(1000, 'a');
+    CDataStream ss2 = MakeRecord(300, 'k');
+    writer.Allocate(pos, "blk", 4096);
+    BOOST_CHECK(writer.Write(pos, "blk", ss1));
+    BOOST_CHECK(writer.Write(CDiskBlockPos(9000, 1000), "blk", ss2));
+
+    // a queued record is readable from its middle whether or not it reached the file yet
+    CDataStream ssRead(SER_DISK, CLIENT_VERSION);
+    if (writer.ReadPending(CDiskBlockPos(9000, 1100), "blk", ssRead)) {
+        BOOST_CHECK_EQUAL(ssRead.size(), 200U);
+        BOOST_CHECK(std::equal(ssRead.begin(), ssRead.end(), ss2.begin() + 100));
+    }
+
+    // nothing is pending after a flush, and both records are in the file back to back
+    BOOST_CHECK(writer.Flush());
+    BOOST_CHECK(!writer.ReadPending(CDiskBlockPos(9000, 1100), "blk", ssRead));
+    std::vector<char> vch = ReadFile(pos, "blk", 1300);
+    BOOST_CHECK(std::equal(ss1.begin(), ss1.end(), vch.begin()));
+    BOOST_CHECK(std::equal(ss2.begin(), ss2.end(), vch.begin() + 1000));
+
+    // undo files are kept apart, and a finished file loses its preallocated tail
+    BOOST_CHECK(writer.Write(pos, "rev", ss2));
+    writer.Truncate(9000, "blk", 1300);
+    writer.Stop();
+    BOOST_CHECK_EQUAL(boost::filesystem::file_size(GetBlockPosFilename(pos, "blk")), 1300U);
+    vch = ReadFile(pos, "rev", 300);
+    BOOST_CHECK(std::equal(ss2.begin(), ss2.end(), vch.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(blockfilewriter_synchronous)
+{
+    // without a thread every operation is done before it returns
+    CBlockFileWriter writer;
+    CDiskBlockPos pos(9001, 8);
+    CDataStream ss = MakeRecord(500, 'x');
+    BOOST_CHECK(writer.Write(pos, "rev", ss));
+
+    CDataStream ssRead(SER_DISK, CLIENT_VERSION);
+    BOOST_CHECK(!writer.ReadPending(pos, "rev", ssRead));
+    std::vector<char> vch = ReadFile(pos, "rev", 500);
+    BOOST_CHECK(std::equal(ss.begin(), ss.end(), vch.begin()));
+    BOOST_CHECK(writer.Flush());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
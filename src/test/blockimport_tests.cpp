@@ -0,0 +1,112 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockimport.h"
+
+#include "chainparams.h"
+#include "clientversion.h"
+#include "streams.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(blockimport_tests)
+
+static void CheckQueueOrder(int nThreads)
+{
+    CBlockImportQueue queue(nThreads);
+    BOOST_CHECK(queue.IsEmpty());
+
+    std::vector<uint256> vHash;
+    for (unsigned int i = 0; i < 200; i++) {
+        boost::shared_ptr<CImportBlock> entry(new CImportBlock());
+        entry->block.nNonce = i;
+        entry->nSize = 1000;
+        vHash.push_back(entry->block.GetHash());
+        queue.Push(entry);
+
+        // take blocks out while others are still being checked
+        if (i % 3 == 2) {
+            boost::shared_ptr<CImportBlock> entryOut = queue.Pop();
+            BOOST_CHECK(entryOut->hash == vHash[entryOut->block.nNonce]);
+        }
+    }
+    BOOST_CHECK(!queue.IsFull());
+
+    // blocks come out checked and in the order they went in, a block without transactions fails the checks
+    unsigned int nNext = 200 / 3;
+    while (!queue.IsEmpty()) {
+        boost::shared_ptr<CImportBlock> entry = queue.Pop();
+        BOOST_CHECK_EQUAL(entry->block.nNonce, nNext);
+        BOOST_CHECK(entry->hash == vHash[nNext]);
+        BOOST_CHECK(!entry->fChecked);
+        nNext++;
+    }
+    BOOST_CHECK_EQUAL(nNext, 200U);
+}
+
+BOOST_AUTO_TEST_CASE(blockimport_order)
+{
+    CheckQueueOrder(0);
+    CheckQueueOrder(3);
+}
+
+BOOST_AUTO_TEST_CASE(blockimport_checked)
+{
+    // the genesis block passes the checks, on a worker and on the thread taking it out
+    for (int nThreads = 0; nThreads <= 3; nThreads += 3) {
+        CBlockImportQueue queue(nThreads);
+        for (unsigned int i = 0; i < 10; i++) {
+            boost::shared_ptr<CImportBlock> entry(new CImportBlock());
+            entry->block = Params().GenesisBlock();
+            entry->nSize = 1000;
+            queue.Push(entry);
+        }
+        while (!queue.IsEmpty()) {
+            boost::shared_ptr<CImportBlock> entry = queue.Pop();
+            BOOST_CHECK(entry->fChecked);
+            BOOST_CHECK(entry->hash == Params().HashGenesisBlock());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(blockimport_raw)
+{
+    // blocks queued as read from the file are deserialized by the checks, a truncated one is skipped
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << Params().GenesisBlock();
+    for (int nThreads = 0; nThreads <= 3; nThreads += 3) {
+        CBlockImportQueue queue(nThreads);
+        for (unsigned int i = 0; i < 10; i++) {
+            boost::shared_ptr<CImportBlock> entry(new CImportBlock());
+            entry->vchBlock.assign(ss.begin(), i % 2 ? ss.end() - 1 : ss.end());
+            entry->nSize = entry->vchBlock.size();
+            queue.Push(entry);
+        }
+        for (unsigned int i = 0; i < 10; i++) {
+            boost::shared_ptr<CImportBlock> entry = queue.Pop();
+            BOOST_CHECK(entry->vchBlock.empty());
+            BOOST_CHECK_EQUAL(entry->fValid, i % 2 == 0);
+            BOOST_CHECK_EQUAL(entry->fChecked, i % 2 == 0);
+            if (entry->fValid)
+                BOOST_CHECK(entry->hash == Params().HashGenesisBlock());
+        }
+        BOOST_CHECK(queue.IsEmpty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(blockimport_full)
+{
+    CBlockImportQueue queue(0);
+    for (unsigned int i = 0; i < MAX_BLOCK_IMPORT_QUEUE / (1 << 20); i++) {
+        BOOST_CHECK(!queue.IsFull());
+        boost::shared_ptr<CImportBlock> entry(new CImportBlock());
+        entry->nSize = 1 << 20;
+        queue.Push(entry);
+    }
+    BOOST_CHECK(queue.IsFull());
+    queue.Pop();
+    BOOST_CHECK(!queue.IsFull());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,7 @@
 #include "clientversion.h"
 #include "key.h"
 #include "merkleblock.h"
+#include "random.h"
 #include "serialize.h"
 #include "streams.h"
 #include "uint256.h"
@@ -460,4 +461,34 @@ BOOST_AUTO_TEST_CASE(merkle_block_4_test_update_none)
     BOOST_CHECK(!filter.contains(COutPoint(uint256("0x02981fa052f0481dbc5868f4fc2166035a10f27a03cfd2de67326471df5bc041"), 0)));
 }
 
+BOOST_AUTO_TEST_CASE(hash_filter)
+{
+    // an unsized filter can't rule anything out
+    CHashFilter filter;
+    BOOST_CHECK(filter.contains(GetRandHash()));
+    // and doesn't ask to be rebuilt
+    filter.insert(GetRandHash());
+    BOOST_CHECK(!filter.IsFull());
+
+    filter.reset(1000, 0.001);
+    std::vector<uint256> vHash;
+    for (int i = 0; i < 1000; i++) {
+        vHash.push_back(GetRandHash());
+        filter.insert(vHash.back());
+    }
+    BOOST_CHECK(filter.IsFull());
+    BOOST_CHECK_EQUAL(filter.size(), 1000U);
+    for (unsigned int i = 0; i < vHash.size(); i++)
+        BOOST_CHECK(filter.contains(vHash[i]));
+
+    int nFalsePositives = 0;
+    for (int i = 0; i < 10000; i++)
+        nFalsePositives += filter.contains(GetRandHash());
+    BOOST_CHECK(nFalsePositives < 100);
+
+    filter.reset(1000, 0.001);
+    BOOST_CHECK(!filter.IsFull());
+    BOOST_CHECK(!filter.contains(vHash[0]));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
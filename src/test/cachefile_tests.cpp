@@ -0,0 +1,85 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "cachefile.h"
+
+#include "chainparams.h"
+#include "clientversion.h"
+#include "util.h"
+
+#include <stdio.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(cachefile_tests)
+
+BOOST_AUTO_TEST_CASE(cachefile_chunks)
+{
+    std::vector<int> vFirst(100, 7);
+    std::string strSecond = "second chunk";
+    {
+        CCacheFile file("cachefile_test.dat", "CacheFileTest");
+        file.AddChunk("first") << vFirst;
+        file.AddChunk("second") << strSecond;
+        BOOST_CHECK(file.Write());
+    }
+
+    CCacheFile file("cachefile_test.dat", "CacheFileTest");
+    BOOST_CHECK(file.Open() == CCacheFile::Ok);
+
+    // Chunks can be read in any order, missing ones are reported
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    std::string strRead;
+    BOOST_CHECK(file.ReadChunk("second", ss));
+    ss >> strRead;
+    BOOST_CHECK_EQUAL(strRead, strSecond);
+    std::vector<int> vRead;
+    BOOST_CHECK(file.ReadChunk("first", ss));
+    ss >> vRead;
+    BOOST_CHECK(vRead == vFirst);
+    BOOST_CHECK(!file.ReadChunk("third", ss));
+
+    // Another cache type must not accept the file
+    CCacheFile other("cachefile_test.dat", "OtherCache");
+    BOOST_CHECK(other.Open() == CCacheFile::IncorrectMagicMessage);
+}
+
+BOOST_AUTO_TEST_CASE(cachefile_corruption)
+{
+    {
+        CCacheFile file("cachefile_corrupt.dat", "CacheFileTest");
+        file.AddChunk("first") << std::string("first chunk");
+        file.AddChunk("second") << std::string("second chunk");
+        BOOST_CHECK(file.Write());
+    }
+
+    // Flip the last payload byte of the second chunk, in front of its hash and the end marker
+    boost::filesystem::path path = GetDataDir() / "cachefile_corrupt.dat";
+    FILE* f = fopen(path.string().c_str(), "r+b");
+    BOOST_REQUIRE(f != NULL);
+    fseek(f, -(long)(sizeof(uint256) + 2), SEEK_END);
+    int ch = fgetc(f);
+    fseek(f, -(long)(sizeof(uint256) + 2), SEEK_END);
+    fputc(ch ^ 1, f);
+    fclose(f);
+
+    // Only the damaged chunk fails its check
+    CCacheFile file("cachefile_corrupt.dat", "CacheFileTest");
+    BOOST_CHECK(file.Open() == CCacheFile::Ok);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    BOOST_CHECK(file.ReadChunk("first", ss));
+    BOOST_CHECK(!file.ReadChunk("second", ss));
+
+    // A file without the format version is rejected before any chunk is looked at
+    CDataStream ssOld(SER_DISK, CLIENT_VERSION);
+    ssOld << std::string("CacheFileTest") << FLATDATA(Params().MessageStart());
+    f = fopen(path.string().c_str(), "wb");
+    BOOST_REQUIRE(f != NULL);
+    fwrite(&ssOld[0], 1, ssOld.size(), f);
+    fclose(f);
+    BOOST_CHECK(file.Open() == CCacheFile::IncorrectFormat);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
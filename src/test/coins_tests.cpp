@@ -41,7 +41,7 @@ public:
 
     uint256 GetBestBlock() const { return hashBestBlock_; }
 
-    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDelta)
     {
         for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); ) {
             map_[it->first] = it->second.coins;
@@ -58,6 +58,22 @@ public:
 
     bool GetStats(CCoinsStats& stats) const { return false; }
 };
+
+class CCoinsViewCacheTest : public CCoinsViewCache
+{
+public:
+    CCoinsViewCacheTest(CCoinsView* base) : CCoinsViewCache(base) {}
+
+    void SelfTest() const
+    {
+        // Manually recompute the dynamic usage of the whole data, and compare it.
+        size_t ret = memusage::DynamicUsage(cacheCoins);
+        for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end(); it++) {
+            ret += it->second.coins.DynamicMemoryUsage();
+        }
+        BOOST_CHECK_EQUAL(DynamicMemoryUsage(), ret);
+    }
+};
 }
 
 BOOST_AUTO_TEST_SUITE(coins_tests)
@@ -175,4 +191,94 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
     BOOST_CHECK(missed_an_entry);
 }
 
+BOOST_AUTO_TEST_CASE(coins_cache_sync_test)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+
+    std::vector<uint256> txids;
+    for (unsigned int i = 0; i < 100; i++) {
+        txids.push_back(GetRandHash());
+        CCoinsModifier coins = cache.ModifyCoins(txids.back());
+        coins->nVersion = 1;
+        coins->vout.resize(1);
+        coins->vout[0].nValue = i + 1;
+        coins->vout[0].scriptPubKey = CScript() << std::vector<unsigned char>(i + 1, 0x51);
+    }
+    cache.SelfTest();
+
+    // With room for everything, every entry stays cached after being written
+    size_t nUsage = cache.DynamicMemoryUsage();
+    BOOST_CHECK(cache.Sync(nUsage));
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 100U);
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), nUsage);
+
+    // A smaller budget drops entries, which are still found in the base
+    BOOST_CHECK(cache.Sync(nUsage / 2));
+    BOOST_CHECK(cache.GetCacheSize() < 100U);
+    BOOST_CHECK(cache.DynamicMemoryUsage() <= nUsage / 2);
+    cache.SelfTest();
+
+    // Spending a kept entry is written on the next sync
+    cache.ModifyCoins(txids[0])->Clear();
+    BOOST_CHECK(cache.Sync(0));
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    CCoinsViewCacheTest check(&base);
+    for (unsigned int i = 0; i < txids.size(); i++) {
+        const CCoins* coins = check.AccessCoins(txids[i]);
+        if (i == 0) {
+            BOOST_CHECK(!coins || coins->IsPruned());
+        } else {
+            BOOST_CHECK(coins && coins->vout[0].nValue == (CAmount)(i + 1));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(coins_rolling_stats_test)
+{
+    uint256 txid1 = GetRandHash();
+    uint256 txid2 = GetRandHash();
+    CTxOut out1(5 * COIN, CScript() << OP_TRUE);
+    CTxOut out2(7 * COIN, CScript() << OP_TRUE << OP_TRUE);
+
+    // Insertion order does not matter
+    CCoinsRollingStats a, b;
+    a.AddTransaction();
+    a.AddCoin(txid1, 0, out1, 10, false);
+    a.AddTransaction();
+    a.AddCoin(txid2, 1, out2, 11, true);
+    b.AddTransaction();
+    b.AddCoin(txid2, 1, out2, 11, true);
+    b.AddTransaction();
+    b.AddCoin(txid1, 0, out1, 10, false);
+    BOOST_CHECK(a.muhash.Finalize() == b.muhash.Finalize());
+    BOOST_CHECK_EQUAL(a.nTransactions, 2);
+    BOOST_CHECK_EQUAL(a.nTransactionOutputs, 2);
+    BOOST_CHECK_EQUAL(a.nTotalAmount, 12 * COIN);
+
+    // Every part of an output's identity is committed to
+    CCoinsRollingStats c;
+    c.AddCoin(txid1, 0, out1, 10, false);
+    CCoinsRollingStats d;
+    d.AddCoin(txid1, 0, out1, 10, true);
+    BOOST_CHECK(c.muhash.Finalize() != d.muhash.Finalize());
+
+    // A delta recorded separately, e.g. in a child cache, combines with the base
+    CCoinsRollingStats delta;
+    delta.RemoveCoin(txid2, 1, out2, 11, true);
+    delta.RemoveTransaction();
+    a += delta;
+    a.muhash.Normalize();
+    BOOST_CHECK(a.muhash.Finalize() == c.muhash.Finalize());
+    BOOST_CHECK_EQUAL(a.nTransactions, 1);
+    BOOST_CHECK_EQUAL(a.nTransactionOutputs, 1);
+    BOOST_CHECK_EQUAL(a.nTotalAmount, 5 * COIN);
+
+    // Removing everything returns to the empty set
+    a.RemoveCoin(txid1, 0, out1, 10, false);
+    a.RemoveTransaction();
+    BOOST_CHECK(a.muhash.Finalize() == CCoinsRollingStats().muhash.Finalize());
+    BOOST_CHECK_EQUAL(a.nSerializedSize, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,187 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "init.h"
+#include "main.h"
+#include "random.h"
+#include "txdb.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+extern volatile bool fRequestShutdown;
+
+namespace
+{
+CCoins MakeCoins(unsigned int nOutputs, int nHeight)
+{
+    CCoins coins;
+    coins.nVersion = 1;
+    coins.nHeight = nHeight;
+    coins.vout.resize(nOutputs);
+    for (unsigned int i = 0; i < nOutputs; i++) {
+        coins.vout[i].nValue = (i + 1) * COIN;
+        coins.vout[i].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, i) << OP_EQUALVERIFY << OP_CHECKSIG;
+    }
+    return coins;
+}
+
+//! Coin database whose writes fail
+class CCoinsViewFailing : public CCoinsView
+{
+public:
+    uint256 hashBestBlock;
+
+    uint256 GetBestBlock() const { return hashBestBlock; }
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDelta) { return false; }
+};
+
+bool WriteCoins(CCoinsViewDB& db, const uint256& txid, const CCoins& coins, bool fFresh)
+{
+    CCoinsMap mapCoins;
+    CCoinsCacheEntry& entry = mapCoins[txid];
+    entry.coins = coins;
+    entry.flags = CCoinsCacheEntry::DIRTY | (fFresh ? CCoinsCacheEntry::FRESH : 0);
+    return db.BatchWrite(mapCoins, uint256(0), CCoinsRollingStats());
+}
+
+bool ReadCoins(CCoinsViewDB& db, const uint256& txid, const CCoins& coinsExpected)
+{
+    CCoins coins;
+    return db.GetCoins(txid, coins) && coins == coinsExpected && db.HaveCoins(txid);
+}
+}
+
+BOOST_AUTO_TEST_SUITE(coinsdb_tests)
+
+BOOST_AUTO_TEST_CASE(coinsdb_roundtrip)
+{
+    CCoinsViewDB db(1 << 20, true);
+
+    // a coinstake keeps its empty first output, a coinbase its flag, and spent outputs in between are kept as null
+    uint256 txidStake = GetRandHash();
+    CCoins coinsStake = MakeCoins(3, 100);
+    coinsStake.fCoinStake = true;
+    coinsStake.vout[0].SetEmpty();
+    uint256 txidBase = GetRandHash();
+    CCoins coinsBase = MakeCoins(1, (1 << 24) + 5);
+    coinsBase.fCoinBase = true;
+    coinsBase.nVersion = 2;
+    uint256 txidSparse = GetRandHash();
+    CCoins coinsSparse = MakeCoins(4, 7);
+    coinsSparse.vout[1].SetNull();
+
+    BOOST_CHECK(WriteCoins(db, txidStake, coinsStake, true));
+    BOOST_CHECK(WriteCoins(db, txidBase, coinsBase, true));
+    BOOST_CHECK(WriteCoins(db, txidSparse, coinsSparse, true));
+    BOOST_CHECK(ReadCoins(db, txidStake, coinsStake));
+    BOOST_CHECK(ReadCoins(db, txidBase, coinsBase));
+    BOOST_CHECK(ReadCoins(db, txidSparse, coinsSparse));
+
+    // spending the remaining outputs erases the record
+    coinsSparse.Clear();
+    BOOST_CHECK(WriteCoins(db, txidSparse, coinsSparse, false));
+    BOOST_CHECK(!db.HaveCoins(txidSparse));
+
+    CCoins coins;
+    uint256 txidUnknown = GetRandHash();
+    BOOST_CHECK(!db.GetCoins(txidUnknown, coins));
+    BOOST_CHECK(!db.HaveCoins(txidUnknown));
+}
+
+BOOST_AUTO_TEST_CASE(coinsdb_hash_serialized)
+{
+    CCoinsViewDB db(1 << 20, true);
+
+    uint256 txid = GetRandHash();
+    CCoins coins = MakeCoins(300, 12);
+    coins.fCoinBase = true;
+    coins.vout[3].SetNull();
+    BOOST_CHECK(WriteCoins(db, txid, coins, true));
+
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << db.GetBestBlock();
+    ss << txid << VARINT(coins.nVersion) << 'c' << VARINT(coins.nHeight);
+    for (unsigned int i = 0; i < coins.vout.size(); i++) {
+        if (!coins.vout[i].IsNull())
+            ss << VARINT(i + 1) << coins.vout[i];
+    }
+    ss << VARINT(0);
+
+    uint256 hash;
+    BOOST_CHECK(db.GetHashSerialized(hash));
+    BOOST_CHECK(hash == ss.GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(coinsdb_marker)
+{
+    boost::filesystem::path path = GetDataDir() / "chainstate";
+    uint256 txid = GetRandHash();
+    uint256 hashBlock = GetRandHash();
+    CCoins coins = MakeCoins(2, 10);
+
+    // a chainstate written by an older client
+    {
+        CLevelDBWrapper dbOld(path, 1 << 20);
+        BOOST_CHECK(dbOld.Write(std::make_pair('c', txid), coins));
+        BOOST_CHECK(dbOld.Write('B', hashBlock));
+    }
+
+    // is converted once, and keeps its coins
+    {
+        CCoinsViewDB db(1 << 20);
+        BOOST_CHECK(ReadCoins(db, txid, coins));
+        BOOST_CHECK(db.GetBestBlock() == hashBlock);
+    }
+    BOOST_CHECK(!boost::filesystem::exists(GetDataDir() / "chainstate.new"));
+    BOOST_CHECK(!boost::filesystem::exists(GetDataDir() / "chainstate.old"));
+
+    // after that older clients refuse to open it
+    BOOST_CHECK_THROW(CLevelDBWrapper(path, 1 << 20), leveldb_error);
+
+    // a conversion interrupted before its copy was moved in place goes back to the original
+    boost::filesystem::rename(path, GetDataDir() / "chainstate.old");
+    boost::filesystem::create_directories(GetDataDir() / "chainstate.new");
+    {
+        CCoinsViewDB db(1 << 20);
+        BOOST_CHECK(ReadCoins(db, txid, coins));
+    }
+    BOOST_CHECK(!boost::filesystem::exists(GetDataDir() / "chainstate.new"));
+    BOOST_CHECK(!boost::filesystem::exists(GetDataDir() / "chainstate.old"));
+    boost::filesystem::remove_all(path);
+}
+
+BOOST_AUTO_TEST_CASE(coinsdb_writer_failure)
+{
+    CCoinsViewFailing dbFailing;
+    dbFailing.hashBestBlock = GetRandHash();
+    CCoinsViewDBWriter writer(&dbFailing);
+
+    uint256 txid = GetRandHash();
+    uint256 hashBlock = GetRandHash();
+    CCoins coins = MakeCoins(2, 10);
+    CCoinsMap mapCoins;
+    CCoinsCacheEntry& entry = mapCoins[txid];
+    entry.coins = coins;
+    entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+    BOOST_CHECK(writer.BatchWrite(mapCoins, hashBlock, CCoinsRollingStats()));
+    BOOST_CHECK(!writer.Wait());
+    BOOST_CHECK(ShutdownRequested());
+    fRequestShutdown = false;
+
+    // the entries that did not make it are still served instead of the stale database
+    CCoins coinsRead;
+    BOOST_CHECK(writer.GetCoins(txid, coinsRead));
+    BOOST_CHECK(coinsRead == coins);
+    BOOST_CHECK(writer.HaveCoins(txid));
+    BOOST_CHECK(writer.GetBestBlock() == hashBlock);
+
+    // and no further write is accepted
+    CCoinsMap mapNext;
+    mapNext[GetRandHash()].flags = CCoinsCacheEntry::DIRTY;
+    BOOST_CHECK(!writer.BatchWrite(mapNext, GetRandHash(), CCoinsRollingStats()));
+    BOOST_CHECK(writer.GetBestBlock() == hashBlock);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
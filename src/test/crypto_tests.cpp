@@ -3,13 +3,21 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "crypto/rfc6979_hmac_sha256.h"
+#include "crypto/quark.h"
 #include "crypto/ripemd160.h"
 #include "crypto/sha1.h"
 #include "crypto/sha256.h"
 #include "crypto/sha512.h"
 #include "crypto/hmac_sha256.h"
 #include "crypto/hmac_sha512.h"
+#include "crypto/sph_blake.h"
+#include "crypto/sph_bmw.h"
+#include "crypto/sph_groestl.h"
+#include "crypto/sph_jh.h"
+#include "crypto/sph_keccak.h"
+#include "crypto/sph_skein.h"
 #include "random.h"
+#include "serialize.h"
 #include "utilstrencodings.h"
 
 #include <vector>
@@ -131,6 +139,99 @@ BOOST_AUTO_TEST_CASE(sha256_testvectors) {
     TestSHA256(test1, "a316d55510b49662420f49d145d42fb83f31ef8dc016aa4e32df049991a91e26");
 }
 
+BOOST_AUTO_TEST_CASE(sha256d64)
+{
+    // Every block count exercises a different mix of the 8, 4, 2 and 1-way code paths
+    for (int blocks = 0; blocks <= 34; blocks++) {
+        std::vector<unsigned char> in(64 * blocks);
+        for (unsigned int i = 0; i < in.size(); i++)
+            in[i] = insecure_rand() & 0xff;
+        std::vector<unsigned char> out1(32 * blocks), out2(32 * blocks);
+        for (int i = 0; i < blocks; i++) {
+            unsigned char buf[CSHA256::OUTPUT_SIZE];
+            CSHA256().Write(&in[64 * i], 64).Finalize(buf);
+            CSHA256().Write(buf, CSHA256::OUTPUT_SIZE).Finalize(&out1[32 * i]);
+        }
+        SHA256D64(begin_ptr(out2), begin_ptr(in), blocks);
+        BOOST_CHECK(out1 == out2);
+    }
+}
+
+/** The Quark chain written directly against sphlib, as HashQuark used to be */
+static void ReferenceQuark(unsigned char* out, const unsigned char* data, size_t len)
+{
+    unsigned char hash[9][64];
+    sph_blake512_context ctx_blake;
+    sph_bmw512_context ctx_bmw;
+    sph_groestl512_context ctx_groestl;
+    sph_jh512_context ctx_jh;
+    sph_keccak512_context ctx_keccak;
+    sph_skein512_context ctx_skein;
+
+    sph_blake512_init(&ctx_blake);
+    sph_blake512(&ctx_blake, data, len);
+    sph_blake512_close(&ctx_blake, hash[0]);
+    sph_bmw512_init(&ctx_bmw);
+    sph_bmw512(&ctx_bmw, hash[0], 64);
+    sph_bmw512_close(&ctx_bmw, hash[1]);
+    if (hash[1][0] & 8) {
+        sph_groestl512_init(&ctx_groestl);
+        sph_groestl512(&ctx_groestl, hash[1], 64);
+        sph_groestl512_close(&ctx_groestl, hash[2]);
+    } else {
+        sph_skein512_init(&ctx_skein);
+        sph_skein512(&ctx_skein, hash[1], 64);
+        sph_skein512_close(&ctx_skein, hash[2]);
+    }
+    sph_groestl512_init(&ctx_groestl);
+    sph_groestl512(&ctx_groestl, hash[2], 64);
+    sph_groestl512_close(&ctx_groestl, hash[3]);
+    sph_jh512_init(&ctx_jh);
+    sph_jh512(&ctx_jh, hash[3], 64);
+    sph_jh512_close(&ctx_jh, hash[4]);
+    if (hash[4][0] & 8) {
+        sph_blake512_init(&ctx_blake);
+        sph_blake512(&ctx_blake, hash[4], 64);
+        sph_blake512_close(&ctx_blake, hash[5]);
+    } else {
+        sph_bmw512_init(&ctx_bmw);
+        sph_bmw512(&ctx_bmw, hash[4], 64);
+        sph_bmw512_close(&ctx_bmw, hash[5]);
+    }
+    sph_keccak512_init(&ctx_keccak);
+    sph_keccak512(&ctx_keccak, hash[5], 64);
+    sph_keccak512_close(&ctx_keccak, hash[6]);
+    sph_skein512_init(&ctx_skein);
+    sph_skein512(&ctx_skein, hash[6], 64);
+    sph_skein512_close(&ctx_skein, hash[7]);
+    if (hash[7][0] & 8) {
+        sph_keccak512_init(&ctx_keccak);
+        sph_keccak512(&ctx_keccak, hash[7], 64);
+        sph_keccak512_close(&ctx_keccak, hash[8]);
+    } else {
+        sph_jh512_init(&ctx_jh);
+        sph_jh512(&ctx_jh, hash[7], 64);
+        sph_jh512_close(&ctx_jh, hash[8]);
+    }
+    memcpy(out, hash[8], 32);
+}
+
+BOOST_AUTO_TEST_CASE(quark)
+{
+    // Enough messages of every header-like length to take each branch of the chain both ways
+    for (int len = 0; len <= 160; len++) {
+        for (int n = 0; n < 8; n++) {
+            std::vector<unsigned char> in(len);
+            for (unsigned int i = 0; i < in.size(); i++)
+                in[i] = insecure_rand() & 0xff;
+            unsigned char expected[32], out[32];
+            ReferenceQuark(expected, begin_ptr(in), in.size());
+            QuarkHash(out, begin_ptr(in), in.size());
+            BOOST_CHECK(memcmp(out, expected, 32) == 0);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(sha512_testvectors) {
     TestSHA512("",
                "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
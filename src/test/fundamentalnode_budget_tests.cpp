@@ -0,0 +1,75 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "fundamentalnode-budget.h"
+#include "random.h"
+#include "streams.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(fundamentalnode_budget_tests)
+
+static bool AddVote(CBudgetProposal& proposal, const CTxIn& vin, int nVote, int64_t nTime, bool fValid = true)
+{
+    CBudgetVote vote(vin, proposal.GetHash(), nVote);
+    vote.nTime = nTime;
+    vote.fValid = fValid;
+    std::string strError;
+    return proposal.AddOrUpdateVote(vote, strError);
+}
+
+BOOST_AUTO_TEST_CASE(budget_vote_tally)
+{
+    CBudgetProposal proposal;
+    int64_t nTime = GetTime() - 2 * BUDGET_VOTE_UPDATE_MIN;
+
+    std::vector<CTxIn> vVin;
+    for (int i = 0; i < 4; i++)
+        vVin.push_back(CTxIn(COutPoint(GetRandHash(), i)));
+
+    BOOST_CHECK(AddVote(proposal, vVin[0], VOTE_YES, nTime));
+    BOOST_CHECK(AddVote(proposal, vVin[1], VOTE_YES, nTime));
+    BOOST_CHECK(AddVote(proposal, vVin[2], VOTE_NO, nTime));
+    BOOST_CHECK(AddVote(proposal, vVin[3], VOTE_ABSTAIN, nTime));
+    BOOST_CHECK_EQUAL(proposal.GetYeas(), 2);
+    BOOST_CHECK_EQUAL(proposal.GetNays(), 1);
+    BOOST_CHECK_EQUAL(proposal.GetAbstains(), 1);
+
+    // A changed vote moves between the tallies instead of being counted twice
+    BOOST_CHECK(AddVote(proposal, vVin[1], VOTE_NO, nTime + BUDGET_VOTE_UPDATE_MIN));
+    BOOST_CHECK_EQUAL(proposal.GetYeas(), 1);
+    BOOST_CHECK_EQUAL(proposal.GetNays(), 2);
+
+    // A rejected update leaves them alone
+    BOOST_CHECK(!AddVote(proposal, vVin[1], VOTE_YES, nTime + BUDGET_VOTE_UPDATE_MIN + 1));
+    BOOST_CHECK_EQUAL(proposal.GetYeas(), 1);
+    BOOST_CHECK_EQUAL(proposal.GetNays(), 2);
+
+    // Invalid votes are left out of the tallies but not out of the ratio
+    BOOST_CHECK(AddVote(proposal, CTxIn(COutPoint(GetRandHash(), 0)), VOTE_YES, nTime, false));
+    BOOST_CHECK_EQUAL(proposal.GetYeas(), 1);
+    BOOST_CHECK_CLOSE(proposal.GetRatio(), 0.5, 0.0001);
+
+    // Loading a proposal recounts its votes, which count as valid until they are checked again
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << proposal;
+    CBudgetProposal loaded;
+    ss >> loaded;
+    BOOST_CHECK_EQUAL(loaded.GetYeas(), 2);
+    BOOST_CHECK_EQUAL(loaded.GetNays(), 2);
+    BOOST_CHECK_EQUAL(loaded.GetAbstains(), 1);
+    BOOST_CHECK_CLOSE(loaded.GetRatio(), 0.5, 0.0001);
+
+    // Assigning a broadcast swaps the tallies along with the votes
+    CBudgetProposalBroadcast broadcast(proposal);
+    CBudgetProposalBroadcast assigned;
+    assigned = broadcast;
+    BOOST_CHECK_EQUAL(assigned.mapVotes.size(), proposal.mapVotes.size());
+    BOOST_CHECK_EQUAL(assigned.GetYeas(), proposal.GetYeas());
+    BOOST_CHECK_EQUAL(assigned.GetNays(), proposal.GetNays());
+    BOOST_CHECK_EQUAL(assigned.GetAbstains(), proposal.GetAbstains());
+    BOOST_CHECK_CLOSE(assigned.GetRatio(), 0.5, 0.0001);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "fundamentalnode-sigcheck.h"
+
+#include "fundamentalnode.h"
+#include "key.h"
+#include "masternode.h"
+#include "random.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+BOOST_AUTO_TEST_SUITE(fundamentalnode_sigcheck_tests)
+
+static const unsigned int SIGCHECK_TEST_MESSAGES = 30;
+
+/** Queue signed broadcasts, every third one with a broken signature, plus a malformed one and a ping of an unknown node */
+static void MakeChecks(std::vector<CFundamentalnodeSigCheck>& vChecks, bool* vValid, std::vector<CFundamentalnodeBroadcast>& vBroadcasts)
+{
+    for (unsigned int i = 0; i < SIGCHECK_TEST_MESSAGES; i++) {
+        CKey key;
+        key.MakeNewKey(true);
+        CFundamentalnodeBroadcast fnb;
+        fnb.vin = CTxIn(COutPoint(GetRandHash(), 0));
+        fnb.pubKeyCollateralAddress = key.GetPubKey();
+        fnb.pubKeyFundamentalnode = key.GetPubKey();
+        BOOST_CHECK(fnb.Sign(key));
+        if (i % 3 == 0)
+            fnb.sig[10] ^= 1;
+        vBroadcasts.push_back(fnb);
+
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << fnb;
+        vValid[i] = false;
+        vChecks.push_back(CFundamentalnodeSigCheck("fnb", ss, &vValid[i]));
+    }
+
+    CDataStream ssMalformed(SER_NETWORK, PROTOCOL_VERSION);
+    ssMalformed << 42;
+    vValid[SIGCHECK_TEST_MESSAGES] = false;
+    vChecks.push_back(CFundamentalnodeSigCheck("fnb", ssMalformed, &vValid[SIGCHECK_TEST_MESSAGES]));
+
+    CFundamentalnodePing fnp;
+    fnp.vin = CTxIn(COutPoint(GetRandHash(), 0));
+    CDataStream ssPing(SER_NETWORK, PROTOCOL_VERSION);
+    ssPing << fnp;
+    vValid[SIGCHECK_TEST_MESSAGES + 1] = false;
+    vChecks.push_back(CFundamentalnodeSigCheck("fnp", ssPing, &vValid[SIGCHECK_TEST_MESSAGES + 1]));
+}
+
+static void CheckResults(const bool* vValid, std::vector<CFundamentalnodeBroadcast>& vBroadcasts)
+{
+    for (unsigned int i = 0; i < SIGCHECK_TEST_MESSAGES; i++) {
+        BOOST_CHECK_EQUAL(vValid[i], i % 3 != 0);
+        BOOST_CHECK_EQUAL(vBroadcasts[i].VerifySignature(), i % 3 != 0);
+    }
+
+    // what can't be checked ahead is left to ProcessMessage
+    BOOST_CHECK(vValid[SIGCHECK_TEST_MESSAGES]);
+    BOOST_CHECK(vValid[SIGCHECK_TEST_MESSAGES + 1]);
+}
+
+BOOST_AUTO_TEST_CASE(fundamentalnode_sigcheck_batch)
+{
+    bool vValid[SIGCHECK_TEST_MESSAGES + 2];
+    std::vector<CFundamentalnodeSigCheck> vChecks;
+    std::vector<CFundamentalnodeBroadcast> vBroadcasts;
+
+    // without workers (-par=1) the message handler thread runs every check itself
+    MakeChecks(vChecks, vValid, vBroadcasts);
+    CheckFundamentalnodeSignatures(vChecks);
+    CheckResults(vValid, vBroadcasts);
+
+    boost::thread_group threadGroup;
+    for (int i = 0; i < 3; i++)
+        threadGroup.create_thread(&ThreadFundamentalnodeSigCheck);
+
+    vChecks.clear();
+    vBroadcasts.clear();
+    MakeChecks(vChecks, vValid, vBroadcasts);
+    CheckFundamentalnodeSignatures(vChecks);
+    CheckResults(vValid, vBroadcasts);
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+}
+
+BOOST_AUTO_TEST_CASE(fundamentalnode_sigcheck_masternode)
+{
+    // a payment winner is signed with the network's fixed key, a vote with the key of a known masternode
+    CMasternodePaymentWinner winner;
+    winner.vin = CTxIn(COutPoint(GetRandHash(), 0));
+    winner.vchSig.assign(65, 1);
+    CDataStream ssWinner(SER_NETWORK, PROTOCOL_VERSION);
+    ssWinner << winner;
+
+    CDataStream ssVote(SER_NETWORK, PROTOCOL_VERSION);
+    ssVote << CTxIn(COutPoint(GetRandHash(), 0)) << std::vector<unsigned char>(65, 1) << 1;
+
+    bool vValid[2] = {true, false};
+    std::vector<CFundamentalnodeSigCheck> vChecks;
+    vChecks.push_back(CFundamentalnodeSigCheck("mnw", ssWinner, &vValid[0]));
+    vChecks.push_back(CFundamentalnodeSigCheck("mvote", ssVote, &vValid[1]));
+    CheckFundamentalnodeSignatures(vChecks);
+    BOOST_CHECK(!vValid[0]);
+    BOOST_CHECK(vValid[1]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,53 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "fundamentalnodeman.h"
+#include "random.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(fundamentalnodeman_tests)
+
+BOOST_AUTO_TEST_CASE(fundamentalnodeman_shards)
+{
+    CFundamentalnodeMan man;
+    std::vector<CTxIn> vVin;
+    for (int i = 0; i < 100; i++) {
+        CFundamentalnode mn;
+        mn.vin = CTxIn(COutPoint(GetRandHash(), i % 3));
+        CKey key;
+        key.MakeNewKey(true);
+        mn.pubKeyFundamentalnode = key.GetPubKey();
+        BOOST_CHECK(man.Add(mn));
+        vVin.push_back(mn.vin);
+    }
+    BOOST_CHECK_EQUAL(man.size(), 100);
+    BOOST_CHECK_EQUAL(man.GetFullFundamentalnodeVector().size(), 100U);
+
+    // Every entry is found in its shard, and only once
+    for (unsigned int i = 0; i < vVin.size(); i++) {
+        CFundamentalnode* pmn = man.Find(vVin[i]);
+        BOOST_REQUIRE(pmn != NULL);
+        BOOST_CHECK(pmn->vin.prevout == vVin[i].prevout);
+        CPubKey pubKey;
+        BOOST_CHECK(man.GetPubKey(vVin[i], pubKey));
+        BOOST_CHECK(man.Find(pubKey) == pmn);
+
+        CFundamentalnode mn;
+        mn.vin = vVin[i];
+        BOOST_CHECK(!man.Add(mn));
+    }
+    BOOST_CHECK(man.Find(CTxIn(COutPoint(GetRandHash(), 0))) == NULL);
+
+    int64_t nListVersion = man.GetListVersion();
+    man.Remove(vVin[0]);
+    BOOST_CHECK_EQUAL(man.size(), 99);
+    BOOST_CHECK(man.Find(vVin[0]) == NULL);
+    BOOST_CHECK(man.GetListVersion() != nListVersion);
+
+    man.Clear();
+    BOOST_CHECK_EQUAL(man.size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
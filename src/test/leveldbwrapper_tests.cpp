@@ -0,0 +1,85 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "leveldbwrapper.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(leveldbwrapper_tests)
+
+BOOST_AUTO_TEST_CASE(leveldb_profiles)
+{
+    std::vector<std::string>& vOptions = mapMultiArgs["-dboption"];
+    std::string strError;
+    int nExtraFiles;
+
+    vOptions.push_back("chainstate.maxopenfiles=1000");
+    vOptions.push_back("chainstate.cachesplit=75");
+    vOptions.push_back("index.maxopenfiles=100");
+    vOptions.push_back("zerocoin.bloombits=0");
+    BOOST_CHECK(CheckLevelDBOptions(strError, nExtraFiles));
+    BOOST_CHECK_EQUAL(nExtraFiles, (1000 - 64) + (100 - 64));
+
+    CLevelDBProfile profile(8 << 20);
+    profile.Apply("chainstate");
+    BOOST_CHECK_EQUAL(profile.nMaxOpenFiles, 1000);
+    BOOST_CHECK_EQUAL(profile.nBlockCachePercent, 75);
+    BOOST_CHECK_EQUAL(profile.nBloomBits, 10);
+    BOOST_CHECK_EQUAL(profile.nCacheSize, 8U << 20);
+
+    // settings of other databases are left alone, a later setting wins
+    vOptions.push_back("zerocoin.cache=2");
+    vOptions.push_back("zerocoin.bloombits=12");
+    CLevelDBProfile profileZerocoin(0);
+    profileZerocoin.Apply("zerocoin");
+    BOOST_CHECK_EQUAL(profileZerocoin.nBloomBits, 12);
+    BOOST_CHECK_EQUAL(profileZerocoin.nCacheSize, 2U << 20);
+    BOOST_CHECK_EQUAL(profileZerocoin.nMaxOpenFiles, 64);
+
+    // the cache sizes init takes out of -dbcache
+    BOOST_CHECK_EQUAL(GetLevelDBCacheSize("zerocoin", 0), 2U << 20);
+    BOOST_CHECK_EQUAL(GetLevelDBCacheSize("chainstate", 8 << 20), 8U << 20);
+    BOOST_CHECK_EQUAL(GetLevelDBCacheSize("sporks", 0), 0U);
+
+    // malformed options, unknown names and out of range values are refused
+    const char* vBad[] = {"chainstate", "chainstate.maxopenfiles", "wallet.cache=1", "chainstate.foo=1", "chainstate.cachesplit=101", "index.maxopenfiles=10", "sporks.compression=x"};
+    for (unsigned int i = 0; i < sizeof(vBad) / sizeof(vBad[0]); i++) {
+        vOptions.push_back(vBad[i]);
+        BOOST_CHECK(!CheckLevelDBOptions(strError, nExtraFiles));
+        vOptions.pop_back();
+    }
+
+    vOptions.clear();
+}
+
+BOOST_AUTO_TEST_CASE(leveldb_stats)
+{
+    mapMultiArgs["-dboption"].push_back("sporks.cachesplit=100");
+    {
+        CLevelDBWrapper db(GetDataDir() / "sporks", 1 << 20, true);
+        for (int i = 0; i < 1000; i++)
+            BOOST_CHECK(db.Write(i, std::string(100, 'x')));
+        std::string str;
+        BOOST_CHECK(db.Read(5, str));
+
+        std::vector<CLevelDBStats> vStats = GetLevelDBStats();
+        bool fFound = false;
+        for (unsigned int i = 0; i < vStats.size(); i++) {
+            if (vStats[i].strName != "sporks")
+                continue;
+            fFound = true;
+            BOOST_CHECK_EQUAL(vStats[i].profile.nBlockCachePercent, 100);
+            BOOST_CHECK_EQUAL(vStats[i].profile.nCacheSize, 1U << 20);
+        }
+        BOOST_CHECK(fFound);
+    }
+
+    // closed databases are no longer listed
+    std::vector<CLevelDBStats> vStats = GetLevelDBStats();
+    for (unsigned int i = 0; i < vStats.size(); i++)
+        BOOST_CHECK(vStats[i].strName != "sporks");
+    mapMultiArgs["-dboption"].clear();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "messagesigcache.h"
+
+#include "key.h"
+#include "random.h"
+#ifdef ENABLE_WALLET
+#include "obfuscation.h"
+#endif
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(messagesigcache_tests)
+
+static CKeyID RandomKeyID()
+{
+    CKeyID keyID;
+    GetRandBytes(keyID.begin(), 20);
+    return keyID;
+}
+
+BOOST_AUTO_TEST_CASE(messagesigcache_lookup)
+{
+    CMessageSigCache cache;
+    uint256 hash = GetRandHash();
+    std::vector<unsigned char> vchSig(65, 1);
+    CKeyID keyID = RandomKeyID();
+
+    BOOST_CHECK(!cache.Get(hash, vchSig, keyID));
+    cache.Set(hash, vchSig, keyID, 10);
+    BOOST_CHECK(cache.Get(hash, vchSig, keyID));
+
+    // Any part of the triple that differs is a miss
+    BOOST_CHECK(!cache.Get(GetRandHash(), vchSig, keyID));
+    std::vector<unsigned char> vchOtherSig(vchSig);
+    vchOtherSig[64] ^= 1;
+    BOOST_CHECK(!cache.Get(hash, vchOtherSig, keyID));
+    BOOST_CHECK(!cache.Get(hash, vchSig, RandomKeyID()));
+
+    // A disabled cache stores nothing
+    cache.Set(GetRandHash(), vchSig, keyID, 0);
+    BOOST_CHECK_EQUAL(cache.Size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(messagesigcache_bounded)
+{
+    CMessageSigCache cache;
+    std::vector<unsigned char> vchSig(65, 2);
+    CKeyID keyID = RandomKeyID();
+    for (int i = 0; i < 100; i++)
+        cache.Set(GetRandHash(), vchSig, keyID, 25);
+    BOOST_CHECK_EQUAL(cache.Size(), 25U);
+
+    // The newest entry always survives its own insertion
+    uint256 hash = GetRandHash();
+    cache.Set(hash, vchSig, keyID, 25);
+    BOOST_CHECK(cache.Get(hash, vchSig, keyID));
+    BOOST_CHECK_EQUAL(cache.Size(), 25U);
+}
+
+#ifdef ENABLE_WALLET
+BOOST_AUTO_TEST_CASE(messagesigcache_verifymessage)
+{
+    CKey key, otherKey;
+    key.MakeNewKey(true);
+    otherKey.MakeNewKey(true);
+    std::string strMessage = "budget vote " + GetRandHash().ToString();
+    std::string strError;
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(obfuScationSigner.SignMessage(strMessage, strError, vchSig, key));
+
+    // The second check is answered from the cache and must agree with the first
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK(obfuScationSigner.VerifyMessage(key.GetPubKey(), vchSig, strMessage, strError));
+        BOOST_CHECK(!obfuScationSigner.VerifyMessage(otherKey.GetPubKey(), vchSig, strMessage, strError));
+        BOOST_CHECK(!obfuScationSigner.VerifyMessage(key.GetPubKey(), vchSig, strMessage + " ", strError));
+    }
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
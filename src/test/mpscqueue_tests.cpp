@@ -0,0 +1,77 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "mpscqueue.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(mpscqueue_tests)
+
+BOOST_AUTO_TEST_CASE(mpscqueue_bounds)
+{
+    CMPSCQueue<std::string> queue(5);
+    BOOST_CHECK_EQUAL(queue.Capacity(), 8U);
+
+    std::string str;
+    BOOST_CHECK(!queue.Pop(str));
+    for (int i = 0; i < 8; i++)
+        BOOST_CHECK(queue.Push(std::string(1, 'a' + i)));
+    BOOST_CHECK(!queue.Push(std::string("full")));
+
+    // Freed cells are reused in order
+    BOOST_CHECK(queue.Pop(str));
+    BOOST_CHECK_EQUAL(str, "a");
+    BOOST_CHECK(queue.Push(std::string("i")));
+    for (int i = 1; i < 9; i++) {
+        BOOST_CHECK(queue.Pop(str));
+        BOOST_CHECK_EQUAL(str, std::string(1, 'a' + i));
+    }
+    BOOST_CHECK(!queue.Pop(str));
+}
+
+static void PushValues(CMPSCQueue<uint64_t>* pqueue, uint64_t nProducer, uint64_t nCount)
+{
+    for (uint64_t i = 0; i < nCount; i++) {
+        while (!pqueue->Push((nProducer << 32) | i))
+            boost::this_thread::yield();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mpscqueue_producers)
+{
+    static const int PRODUCERS = 4;
+    static const uint64_t COUNT = 20000;
+
+    CMPSCQueue<uint64_t> queue(64);
+    boost::thread_group producers;
+    for (int i = 0; i < PRODUCERS; i++)
+        producers.create_thread(boost::bind(&PushValues, &queue, i, COUNT));
+
+    // Every value arrives exactly once, and each producer's values arrive in order
+    std::vector<uint64_t> vNext(PRODUCERS, 0);
+    uint64_t nReceived = 0;
+    bool fOrdered = true;
+    while (nReceived < PRODUCERS * COUNT) {
+        uint64_t nValue;
+        if (!queue.Pop(nValue)) {
+            boost::this_thread::yield();
+            continue;
+        }
+        uint64_t nProducer = nValue >> 32;
+        if (nProducer >= PRODUCERS || (nValue & 0xffffffff) != vNext[nProducer]++)
+            fOrdered = false;
+        nReceived++;
+    }
+    producers.join_all();
+
+    BOOST_CHECK(fOrdered);
+    uint64_t nValue;
+    BOOST_CHECK(!queue.Pop(nValue));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,10 +7,12 @@
 #include "rpcclient.h"
 
 #include "base58.h"
+#include "jsonstream.h"
 #include "netbase.h"
 #include "util.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 #include <boost/test/unit_test.hpp>
 
 #include <univalue.h>
@@ -182,6 +184,51 @@ BOOST_AUTO_TEST_CASE(json_parse_errors)
     BOOST_CHECK_THROW(ParseNonRFCJSONValue("3J98t1WpEZ73CNmQviecrnyiWrnqRhWNL"), std::runtime_error);
 }
 
+static void AppendChunk(std::vector<std::string>& vChunks, bool& fFinal, const std::string& strChunk, bool fFinalIn)
+{
+    BOOST_CHECK(!fFinal);
+    vChunks.push_back(strChunk);
+    fFinal = fFinalIn;
+}
+
+BOOST_AUTO_TEST_CASE(json_stream_writer)
+{
+    UniValue inner(UniValue::VOBJ);
+    inner.push_back(Pair("key \"quoted\"", "value\n"));
+    inner.push_back(Pair("empty", UniValue(UniValue::VARR)));
+    inner.push_back(Pair("amount", ValueFromAmount(123456789)));
+
+    // Build the same document as a tree and through the writer
+    UniValue expected(UniValue::VOBJ);
+    UniValue array(UniValue::VARR);
+    std::vector<std::string> vChunks;
+    bool fFinal = false;
+    CJSONStreamWriter writer(boost::bind(&AppendChunk, boost::ref(vChunks), boost::ref(fFinal), _1, _2), 16);
+    writer.BeginObject();
+    writer.Key("list");
+    writer.BeginArray();
+    for (int i = 0; i < 100; i++) {
+        array.push_back(inner);
+        writer.Value(inner);
+    }
+    writer.BeginObject();
+    writer.EndObject();
+    array.push_back(UniValue(UniValue::VOBJ));
+    writer.EndArray();
+    expected.push_back(Pair("list", array));
+    writer.KeyValue("null", NullUniValue);
+    expected.push_back(Pair("null", NullUniValue));
+    writer.EndObject();
+    BOOST_CHECK(!fFinal);
+    writer.Finish();
+    BOOST_CHECK(fFinal);
+
+    // Output was delivered in several pieces that add up to UniValue::write()
+    BOOST_CHECK(vChunks.size() > 1);
+    BOOST_CHECK(writer.Started());
+    BOOST_CHECK_EQUAL(boost::algorithm::join(vChunks, ""), expected.write());
+}
+
 BOOST_AUTO_TEST_CASE(rpc_ban)
 {
     BOOST_CHECK_NO_THROW(CallRPC(string("clearbanned")));
@@ -100,4 +100,48 @@ BOOST_AUTO_TEST_CASE(getlocator_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(chainsnapshot_test)
+{
+    // Build a main chain and a side branch that splits off at block 4999.
+    std::vector<CBlockIndex> vBlocksMain(10000);
+    for (unsigned int i=0; i<vBlocksMain.size(); i++) {
+        vBlocksMain[i].nHeight = i;
+        vBlocksMain[i].pprev = i ? &vBlocksMain[i - 1] : NULL;
+        vBlocksMain[i].BuildSkip();
+    }
+    std::vector<CBlockIndex> vBlocksSide(1000);
+    for (unsigned int i=0; i<vBlocksSide.size(); i++) {
+        vBlocksSide[i].nHeight = i + 5000;
+        vBlocksSide[i].pprev = i ? &vBlocksSide[i - 1] : &vBlocksMain[4999];
+        vBlocksSide[i].BuildSkip();
+    }
+
+    CChain chain;
+    chain.SetTip(&vBlocksMain.back());
+    CChainSnapshot snapshot(&vBlocksMain.back());
+
+    // The snapshot must agree with CChain everywhere.
+    BOOST_CHECK(snapshot.Tip() == chain.Tip());
+    BOOST_CHECK_EQUAL(snapshot.Height(), chain.Height());
+    BOOST_CHECK(snapshot[-1] == NULL);
+    BOOST_CHECK(snapshot[chain.Height() + 1] == NULL);
+    for (int n=0; n<1000; n++) {
+        int r = insecure_rand() % 11000;
+        CBlockIndex* pindex = (r < 10000) ? &vBlocksMain[r] : &vBlocksSide[r - 10000];
+        BOOST_CHECK(snapshot[pindex->nHeight] == chain[pindex->nHeight]);
+        BOOST_CHECK_EQUAL(snapshot.Contains(pindex), chain.Contains(pindex));
+        BOOST_CHECK(snapshot.Next(pindex) == chain.Next(pindex));
+    }
+
+    // Moving the chain does not affect a snapshot taken earlier.
+    chain.SetTip(&vBlocksSide.back());
+    BOOST_CHECK(snapshot.Contains(&vBlocksMain[9999]));
+    BOOST_CHECK(!snapshot.Contains(&vBlocksSide[0]));
+
+    CChainSnapshot empty(NULL);
+    BOOST_CHECK(empty.Tip() == NULL);
+    BOOST_CHECK_EQUAL(empty.Height(), -1);
+    BOOST_CHECK(empty[0] == NULL);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sync.h"
+#include "utiltime.h"
+
+#include <boost/foreach.hpp>
+#include <boost/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(sync_tests)
+
+static CCriticalSection csLockStatsTest;
+static std::atomic<bool> fLockStatsTestHeld(false);
+
+static void HoldLockStatsTest()
+{
+    LOCK(csLockStatsTest);
+    fLockStatsTestHeld = true;
+    MilliSleep(50);
+}
+
+static CLockStats SumLockStats(const std::string& strName, bool fReset = false)
+{
+    CLockStats sum = {strName, "", 0, 0, 0, 0, 0, 0, 0, {0}};
+    BOOST_FOREACH (const CLockStats& stats, GetLockStats(fReset)) {
+        if (stats.strName != strName)
+            continue;
+        sum.nAcquired += stats.nAcquired;
+        sum.nContended += stats.nContended;
+        sum.nWaitMicros += stats.nWaitMicros;
+        sum.nHoldMicros += stats.nHoldMicros;
+        for (int i = 0; i < LOCK_HOLD_BUCKETS; i++)
+            sum.vHoldBuckets[i] += stats.vHoldBuckets[i];
+    }
+    return sum;
+}
+
+BOOST_AUTO_TEST_CASE(lockstats_contention)
+{
+    SumLockStats("csLockStatsTest", true);
+
+    boost::thread holder(HoldLockStatsTest);
+    while (!fLockStatsTestHeld)
+        MilliSleep(1);
+    {
+        TRY_LOCK(csLockStatsTest, lockTry);
+        BOOST_CHECK(!lockTry);
+    }
+    {
+        LOCK(csLockStatsTest);
+    }
+    holder.join();
+
+    CLockStats stats = SumLockStats("csLockStatsTest");
+    BOOST_CHECK_EQUAL(stats.nAcquired, 2U);
+    BOOST_CHECK_EQUAL(stats.nContended, 2U);
+    BOOST_CHECK(stats.nWaitMicros > 0);
+    BOOST_CHECK(stats.nHoldMicros >= 10000);
+
+    // Every hold lands in exactly one histogram bucket
+    uint64_t nHolds = 0;
+    for (int i = 0; i < LOCK_HOLD_BUCKETS; i++)
+        nHolds += stats.vHoldBuckets[i];
+    BOOST_CHECK_EQUAL(nHolds, stats.nAcquired);
+
+    SumLockStats("csLockStatsTest", true);
+    stats = SumLockStats("csLockStatsTest");
+    BOOST_CHECK_EQUAL(stats.nAcquired, 0U);
+    BOOST_CHECK_EQUAL(stats.nContended, 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
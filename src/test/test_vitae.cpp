@@ -5,6 +5,8 @@
 
 #define BOOST_TEST_MODULE Vitae Test Suite
 
+#include "crypto/quark.h"
+#include "crypto/sha256.h"
 #include "main.h"
 #include "random.h"
 #include "txdb.h"
@@ -32,6 +34,8 @@ struct TestingSetup {
     ECCVerifyHandle globalVerifyHandle;
 
     TestingSetup() {
+        SHA256AutoDetect();
+        QuarkAutoDetect();
         ECC_Start();
         SetupEnvironment();
         fPrintToDebugLog = false; // don't want to write to debug.log file
@@ -0,0 +1,79 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+BOOST_AUTO_TEST_SUITE(verifydb_tests)
+
+/** A batch of the genesis block, which is on disk, with blocks that have no data at the given positions */
+static std::vector<CVerifyBlockResult> MakeBatch(CBlockIndex* pindexBad, const std::vector<unsigned int>& vBad)
+{
+    CBlockIndex* pindexGenesis;
+    {
+        LOCK(cs_main);
+        pindexGenesis = chainActive.Genesis();
+    }
+    std::vector<CVerifyBlockResult> vResults(10);
+    for (unsigned int i = 0; i < vResults.size(); i++)
+        vResults[i].pindex = pindexGenesis;
+    for (unsigned int i = 0; i < vBad.size(); i++)
+        vResults[vBad[i]].pindex = pindexBad;
+    return vResults;
+}
+
+static void CheckBatch(bool fParallel)
+{
+    CBlockIndex indexBad;
+    std::vector<unsigned int> vBad;
+
+    // every block passes and is kept for the disconnect
+    std::vector<CVerifyBlockResult> vResults = MakeBatch(&indexBad, vBad);
+    BOOST_CHECK_EQUAL(CheckVerifyDBBatch(vResults, 2, fParallel), -1);
+    for (unsigned int i = 0; i < vResults.size(); i++) {
+        BOOST_CHECK(vResults[i].fChecked);
+        BOOST_CHECK_EQUAL(vResults[i].nFailedLevel, -1);
+        BOOST_CHECK(vResults[i].block.GetHash() == vResults[i].pindex->GetBlockHash());
+    }
+
+    // the first failure in chain order is reported, whichever worker found a failure first
+    vBad.push_back(7);
+    vBad.push_back(3);
+    vBad.push_back(8);
+    vResults = MakeBatch(&indexBad, vBad);
+    BOOST_CHECK_EQUAL(CheckVerifyDBBatch(vResults, 2, fParallel), 3);
+    for (unsigned int i = 0; i <= 3; i++)
+        BOOST_CHECK(vResults[i].fChecked);
+    BOOST_CHECK_EQUAL(vResults[3].nFailedLevel, 0);
+
+    // checked one after another, the batch stops at the failure
+    if (!fParallel || !nScriptCheckThreads) {
+        for (unsigned int i = 4; i < vResults.size(); i++)
+            BOOST_CHECK(!vResults[i].fChecked);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(verifydb_batch)
+{
+    int nScriptCheckThreadsPrev = nScriptCheckThreads;
+
+    // without workers (-par=0) and for callers holding cs_main, the checks run inline
+    nScriptCheckThreads = 0;
+    CheckBatch(true);
+    nScriptCheckThreads = 3;
+    CheckBatch(false);
+
+    boost::thread_group threadGroup;
+    for (int i = 0; i < 2; i++)
+        threadGroup.create_thread(&ThreadVerifyBlockCheck);
+    CheckBatch(true);
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+
+    nScriptCheckThreads = nScriptCheckThreadsPrev;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,207 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "primitives/zerocoin.h"
+#include "txdb.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+namespace
+{
+std::pair<libzerocoin::PublicCoin, uint256> MakeMint(int nValue, const uint256& txHash)
+{
+    libzerocoin::PublicCoin pubcoin(Params().Zerocoin_Params(false), CBigNum(nValue), libzerocoin::ZQ_ONE);
+    return std::make_pair(pubcoin, txHash);
+}
+
+bool WriteMint(CZerocoinDB& db, int nValue, const uint256& txHash)
+{
+    return db.WriteCoinMintBatch(std::vector<std::pair<libzerocoin::PublicCoin, uint256> >(1, MakeMint(nValue, txHash)));
+}
+
+bool ReadMint(CZerocoinDB& db, int nValue, uint256& txHash)
+{
+    txHash = 0;
+    return db.ReadCoinMint(CBigNum(nValue), txHash);
+}
+
+bool MintOnDisk(CZerocoinDB& db, int nValue)
+{
+    return db.Exists(std::make_pair('m', GetPubCoinHash(CBigNum(nValue))));
+}
+
+void ReadMintLoop(CZerocoinDB* db, int nValue, bool* pfMissing)
+{
+    uint256 txHash;
+    while (!boost::this_thread::interruption_requested()) {
+        if (!ReadMint(*db, nValue, txHash) || txHash != 100)
+            *pfMissing = true;
+    }
+}
+}
+
+BOOST_AUTO_TEST_SUITE(zerocoindb_tests)
+
+BOOST_AUTO_TEST_CASE(zerocoindb_cache)
+{
+    CZerocoinDB db(1 << 20, true, true);
+    uint256 txHash;
+
+    // a cached mint is read back before it is written to disk
+    BOOST_CHECK(WriteMint(db, 1, 100));
+    BOOST_CHECK(ReadMint(db, 1, txHash));
+    BOOST_CHECK(txHash == 100);
+    BOOST_CHECK(!MintOnDisk(db, 1));
+
+    // erased and written again before the flush, the last write wins
+    BOOST_CHECK(db.EraseCoinMint(CBigNum(1)));
+    BOOST_CHECK(!ReadMint(db, 1, txHash));
+    BOOST_CHECK(WriteMint(db, 1, 101));
+    BOOST_CHECK(ReadMint(db, 1, txHash));
+    BOOST_CHECK(txHash == 101);
+
+    // written and erased before the flush, nothing reaches the disk
+    BOOST_CHECK(WriteMint(db, 2, 200));
+    BOOST_CHECK(db.EraseCoinMint(CBigNum(2)));
+
+    BOOST_CHECK(db.CacheUsage() > 0);
+    BOOST_CHECK(db.FlushCache());
+    BOOST_CHECK_EQUAL(db.CacheUsage(), 0U);
+    BOOST_CHECK(MintOnDisk(db, 1));
+    BOOST_CHECK(!MintOnDisk(db, 2));
+    BOOST_CHECK(ReadMint(db, 1, txHash));
+    BOOST_CHECK(txHash == 101);
+    BOOST_CHECK(!ReadMint(db, 2, txHash));
+
+    // an erase of a record on disk hides it until the flush removes it
+    BOOST_CHECK(db.EraseCoinMint(CBigNum(1)));
+    BOOST_CHECK(!ReadMint(db, 1, txHash));
+    BOOST_CHECK(MintOnDisk(db, 1));
+    BOOST_CHECK(db.FlushCache());
+    BOOST_CHECK(!MintOnDisk(db, 1));
+    BOOST_CHECK(!ReadMint(db, 1, txHash));
+}
+
+BOOST_AUTO_TEST_CASE(zerocoindb_accumulator_values)
+{
+    CZerocoinDB db(1 << 20, true, true);
+    CBigNum bnValue;
+
+    BOOST_CHECK(db.WriteAccumulatorValue(7, CBigNum(42)));
+    BOOST_CHECK(db.ReadAccumulatorValue(7, bnValue));
+    BOOST_CHECK(bnValue == CBigNum(42));
+    BOOST_CHECK(!db.Exists(std::make_pair('2', (uint32_t)7)));
+
+    // the digits of a large value are counted as well
+    size_t nUsageSmall = db.CacheUsage();
+    CBigNum bnLarge;
+    bnLarge.SetHex(std::string(768, 'f'));
+    BOOST_CHECK(db.WriteAccumulatorValue(7, bnLarge));
+    BOOST_CHECK(db.CacheUsage() > nUsageSmall + 300);
+
+    BOOST_CHECK(db.FlushCache());
+    BOOST_CHECK(db.Exists(std::make_pair('2', (uint32_t)7)));
+    BOOST_CHECK(db.ReadAccumulatorValue(7, bnValue));
+    BOOST_CHECK(bnValue == bnLarge);
+
+    // an erased value doesn't fall through to the one on disk
+    BOOST_CHECK(db.EraseAccumulatorValue(7));
+    BOOST_CHECK(!db.ReadAccumulatorValue(7, bnValue));
+    BOOST_CHECK(db.Exists(std::make_pair('2', (uint32_t)7)));
+    BOOST_CHECK(db.FlushCache());
+    BOOST_CHECK(!db.Exists(std::make_pair('2', (uint32_t)7)));
+    BOOST_CHECK(!db.ReadAccumulatorValue(7, bnValue));
+}
+
+BOOST_AUTO_TEST_CASE(zerocoindb_wipe)
+{
+    CZerocoinDB db(1 << 20, true, true);
+    uint256 txHash;
+
+    BOOST_CHECK(WriteMint(db, 1, 100));
+    BOOST_CHECK(db.FlushCache());
+    BOOST_CHECK(ReadMint(db, 1, txHash));
+
+    // mints still in the cache are wiped along with those on disk
+    BOOST_CHECK(WriteMint(db, 2, 200));
+    BOOST_CHECK(WriteMint(db, 3, 300));
+    BOOST_CHECK(db.EraseCoinMint(CBigNum(3)));
+    BOOST_CHECK(db.WipeCoins("mints"));
+    for (int i = 1; i <= 3; i++) {
+        BOOST_CHECK(!ReadMint(db, i, txHash));
+        BOOST_CHECK(!MintOnDisk(db, i));
+    }
+    BOOST_CHECK(db.FlushCache());
+    BOOST_CHECK(!ReadMint(db, 2, txHash));
+
+    // the database is usable after the wipe
+    BOOST_CHECK(WriteMint(db, 2, 201));
+    BOOST_CHECK(ReadMint(db, 2, txHash));
+    BOOST_CHECK(txHash == 201);
+    BOOST_CHECK(!db.WipeCoins("accumulators"));
+}
+
+BOOST_AUTO_TEST_CASE(zerocoindb_lookup_filter)
+{
+    CZerocoinDB db(1 << 20, true, true);
+    uint256 txHash;
+
+    // a mint on disk that is erased, and one that is erased and written again
+    BOOST_CHECK(WriteMint(db, 1, 100));
+    BOOST_CHECK(WriteMint(db, 2, 200));
+    BOOST_CHECK(db.FlushCache());
+    BOOST_CHECK(ReadMint(db, 1, txHash));
+    BOOST_CHECK(ReadMint(db, 2, txHash));
+    BOOST_CHECK(db.EraseCoinMint(CBigNum(1)));
+    BOOST_CHECK(db.EraseCoinMint(CBigNum(2)));
+    BOOST_CHECK(WriteMint(db, 2, 201));
+
+    // filling the filter builds it again from the disk and the cache
+    std::vector<std::pair<libzerocoin::PublicCoin, uint256> > vMints;
+    for (unsigned int i = 0; i < MIN_ZEROCOIN_FILTER_KEYS; i++)
+        vMints.push_back(MakeMint(1000 + i, i));
+    BOOST_CHECK(db.WriteCoinMintBatch(std::vector<std::pair<libzerocoin::PublicCoin, uint256> >(vMints.begin(), vMints.begin() + MIN_ZEROCOIN_FILTER_KEYS / 2)));
+    BOOST_CHECK(db.FlushCache());
+    BOOST_CHECK(db.WriteCoinMintBatch(std::vector<std::pair<libzerocoin::PublicCoin, uint256> >(vMints.begin() + MIN_ZEROCOIN_FILTER_KEYS / 2, vMints.end())));
+
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK(!ReadMint(db, 1, txHash));
+        BOOST_CHECK(ReadMint(db, 2, txHash));
+        BOOST_CHECK(txHash == 201);
+        for (unsigned int j = 0; j < MIN_ZEROCOIN_FILTER_KEYS; j += 997) {
+            BOOST_CHECK(ReadMint(db, 1000 + j, txHash));
+            BOOST_CHECK(txHash == j);
+        }
+        BOOST_CHECK(db.FlushCache());
+    }
+    BOOST_CHECK(!MintOnDisk(db, 1));
+    BOOST_CHECK(!ReadMint(db, 3, txHash));
+}
+
+BOOST_AUTO_TEST_CASE(zerocoindb_concurrent_lookup)
+{
+    CZerocoinDB db(1 << 20, true, true);
+    BOOST_CHECK(WriteMint(db, 1, 100));
+    BOOST_CHECK(db.FlushCache());
+
+    // a mint that stays in the database is found while it is written again and other mints come and go
+    bool fMissing = false;
+    boost::thread reader(boost::bind(&ReadMintLoop, &db, 1, &fMissing));
+    for (int i = 0; i < 200; i++) {
+        BOOST_CHECK(WriteMint(db, 1, 100));
+        BOOST_CHECK(WriteMint(db, 2 + i, i));
+        BOOST_CHECK(db.FlushCache());
+        BOOST_CHECK(db.EraseCoinMint(CBigNum(2 + i)));
+        if (i % 50 == 0)
+            BOOST_CHECK(db.LoadLookupFilters());
+        BOOST_CHECK(db.FlushCache());
+    }
+    reader.interrupt();
+    reader.join();
+    BOOST_CHECK(!fMissing);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,114 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "zmq/zmqnotificationinterface.h"
+#include "zmq/zmqpublishnotifier.h"
+#include "utiltime.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+BOOST_AUTO_TEST_SUITE(zmq_tests)
+
+BOOST_AUTO_TEST_CASE(zmq_replay_buffer)
+{
+    CZMQReplayBuffer replay(100);
+    std::vector<std::pair<uint32_t, std::string> > vMessages;
+
+    // nothing sent yet
+    BOOST_CHECK_EQUAL(replay.Get(0, 10, vMessages), 0U);
+    BOOST_CHECK(vMessages.empty());
+
+    std::string data(40, 'a');
+    for (uint32_t nSequence = 0; nSequence < 5; nSequence++) {
+        data[0] = 'a' + nSequence;
+        replay.Add(nSequence, data.data(), data.size());
+    }
+
+    // only the last two messages fit into 100 bytes
+    BOOST_CHECK_EQUAL(replay.Get(0, 10, vMessages), 3U);
+    BOOST_CHECK_EQUAL(vMessages.size(), 2U);
+    BOOST_CHECK_EQUAL(vMessages[0].first, 3U);
+    BOOST_CHECK_EQUAL(vMessages[0].second[0], 'd');
+    BOOST_CHECK_EQUAL(vMessages[1].first, 4U);
+
+    vMessages.clear();
+    BOOST_CHECK_EQUAL(replay.Get(4, 4, vMessages), 3U);
+    BOOST_CHECK_EQUAL(vMessages.size(), 1U);
+    BOOST_CHECK_EQUAL(vMessages[0].second[0], 'e');
+
+    vMessages.clear();
+    replay.Get(0, 2, vMessages);
+    BOOST_CHECK(vMessages.empty());
+
+    // a message larger than the buffer is not kept, and the next sequence number is reported
+    CZMQReplayBuffer replayEmpty(0);
+    replayEmpty.Add(7, data.data(), data.size());
+    BOOST_CHECK_EQUAL(replayEmpty.Get(0, 10, vMessages), 8U);
+    BOOST_CHECK(vMessages.empty());
+}
+
+static void PushNotifications(CZMQNotificationQueue* queue, int nCount)
+{
+    for (int i = 0; i < nCount; i++)
+        queue->Push(CZMQNotification(CZMQNotification::TRANSACTION, i, NULL));
+}
+
+BOOST_AUTO_TEST_CASE(zmq_queue_order)
+{
+    // a small queue, so the producer has to wait for the consumer
+    CZMQNotificationQueue queue(3);
+    boost::thread producer(boost::bind(&PushNotifications, &queue, 1000));
+
+    std::deque<CZMQNotification> batch;
+    uint64_t nNext = 0;
+    while (nNext < 1000 && queue.PopAll(batch)) {
+        BOOST_CHECK(batch.size() <= 3);
+        for (std::deque<CZMQNotification>::const_iterator it = batch.begin(); it != batch.end(); ++it)
+            BOOST_CHECK(it->hash == nNext++);
+        batch.clear();
+    }
+    producer.join();
+    BOOST_CHECK_EQUAL(nNext, 1000U);
+}
+
+BOOST_AUTO_TEST_CASE(zmq_queue_stop)
+{
+    CZMQNotificationQueue queue(2);
+    PushNotifications(&queue, 2);
+
+    // a producer waiting on a full queue is released by Stop, and its event dropped
+    boost::thread producer(boost::bind(&PushNotifications, &queue, 1));
+    MilliSleep(50);
+    queue.Stop();
+    producer.join();
+
+    // what was queued before stopping is still handed out, then the queue reports the end
+    std::deque<CZMQNotification> batch;
+    BOOST_CHECK(queue.PopAll(batch));
+    BOOST_CHECK_EQUAL(batch.size(), 2U);
+    batch.clear();
+    BOOST_CHECK(!queue.PopAll(batch));
+    PushNotifications(&queue, 1);
+    BOOST_CHECK(!queue.PopAll(batch));
+}
+
+BOOST_AUTO_TEST_CASE(zmq_queue_shared)
+{
+    // the block and transaction handed over by validation reach the publisher without being copied
+    CZMQNotificationQueue queue;
+    CZMQNotification notification(CZMQNotification::BLOCK, 1, NULL);
+    notification.pblock.reset(new CBlock());
+    notification.ptx.reset(new CTransaction());
+    queue.Push(notification);
+
+    std::deque<CZMQNotification> batch;
+    BOOST_CHECK(queue.PopAll(batch));
+    BOOST_CHECK_EQUAL(batch.size(), 1U);
+    BOOST_CHECK(batch[0].pblock == notification.pblock);
+    BOOST_CHECK(batch[0].ptx == notification.ptx);
+    BOOST_CHECK(batch[0].strRaw.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,6 +20,10 @@
 using namespace std;
 using namespace libzerocoin;
 
+//! Marks the chainstate as written by this version. Older clients don't know the name and refuse to open it,
+//! so they can't change the coins without updating the rolling statistics.
+static const CNamedBytewiseComparator chainstateComparator("vitae.ChainstateComparator");
+
 void static BatchWriteCoins(CLevelDBBatch& batch, const uint256& hash, const CCoins& coins)
 {
     if (coins.IsPruned())
@@ -33,7 +37,14 @@ void static BatchWriteHashBestChain(CLevelDBBatch& batch, const uint256& hash)
     batch.Write('B', hash);
 }
 
-CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe)
+void static BatchWriteRollingStats(CLevelDBBatch& batch, const uint256& hashBlock, CCoinsRollingStats& stats)
+{
+    // Stored with the block it describes, so a chainstate written by an older client is detected
+    stats.muhash.Normalize();
+    batch.Write('S', make_pair(hashBlock, stats));
+}
+
+CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, &chainstateComparator)
 {
 }
 
@@ -55,25 +66,166 @@ uint256 CCoinsViewDB::GetBestBlock() const
     return hashBestChain;
 }
 
-bool CCoinsViewDB::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
+bool CCoinsViewDB::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDelta)
 {
+    // mapCoins is only read: CCoinsViewDBWriter serves lookups from it while this runs
     CLevelDBBatch batch;
     size_t count = 0;
     size_t changed = 0;
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+    for (CCoinsMap::const_iterator it = mapCoins.begin(); it != mapCoins.end(); it++) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
             BatchWriteCoins(batch, it->first, it->second.coins);
             changed++;
         }
         count++;
-        CCoinsMap::iterator itOld = it++;
-        mapCoins.erase(itOld);
     }
     if (hashBlock != uint256(0))
         BatchWriteHashBestChain(batch, hashBlock);
 
+    CCoinsRollingStats stats;
+    bool fHaveStats = GetRollingStats(stats);
+    if (fHaveStats) {
+        stats += statsDelta;
+        BatchWriteRollingStats(batch, hashBlock != uint256(0) ? hashBlock : GetBestBlock(), stats);
+    }
+
     LogPrint("coindb", "Committing %u changed transactions (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
-    return db.WriteBatch(batch);
+    if (!db.WriteBatch(batch))
+        return false;
+
+    // without a stored record there was nothing to apply the delta to, so compute it from the records just written
+    if (!fHaveStats) {
+        LogPrintf("%s : The rolling UTXO set statistics are missing, computing them again\n", __func__);
+        // the coins are written, a failure here only leaves the statistics to the next start
+        if (!InitRollingStats())
+            LogPrintf("%s : Failed to compute the rolling UTXO set statistics\n", __func__);
+    }
+    return true;
+}
+
+CCoinsViewDBWriter::CCoinsViewDBWriter(CCoinsView* baseIn) : CCoinsViewBacked(baseIn), hashBlockPending(0), fPending(false), fFailed(false)
+{
+}
+
+CCoinsViewDBWriter::~CCoinsViewDBWriter()
+{
+    if (!Wait())
+        LogPrintf("%s : Failed to write to coin database\n", __func__);
+    if (threadWrite.joinable())
+        threadWrite.join();
+}
+
+bool CCoinsViewDBWriter::GetCoins(const uint256& txid, CCoins& coins) const
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        CCoinsMap::const_iterator it = mapPending.find(txid);
+        if (it != mapPending.end()) {
+            coins = it->second.coins;
+            return true;
+        }
+    }
+    return base->GetCoins(txid, coins);
+}
+
+bool CCoinsViewDBWriter::HaveCoins(const uint256& txid) const
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        CCoinsMap::const_iterator it = mapPending.find(txid);
+        if (it != mapPending.end())
+            return !it->second.coins.IsPruned();
+    }
+    return base->HaveCoins(txid);
+}
+
+uint256 CCoinsViewDBWriter::GetBestBlock() const
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (hashBlockPending != uint256(0))
+            return hashBlockPending;
+    }
+    return base->GetBestBlock();
+}
+
+bool CCoinsViewDBWriter::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDelta)
+{
+    // one write in flight at a time, and none after a failed one
+    if (!Wait())
+        return false;
+    if (threadWrite.joinable())
+        threadWrite.join();
+
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        mapPending.swap(mapCoins);
+        hashBlockPending = hashBlock;
+        statsPending = statsDelta;
+        fPending = true;
+    }
+    threadWrite = boost::thread(boost::bind(&CCoinsViewDBWriter::ThreadWrite, this));
+    return true;
+}
+
+bool CCoinsViewDBWriter::GetStats(CCoinsStats& stats) const
+{
+    return Wait() && base->GetStats(stats);
+}
+
+bool CCoinsViewDBWriter::GetRollingStats(CCoinsRollingStats& stats) const
+{
+    // the base may already include the pending delta before the write is marked done
+    return Wait() && base->GetRollingStats(stats);
+}
+
+bool CCoinsViewDBWriter::GetHashSerialized(uint256& hash) const
+{
+    return Wait() && base->GetHashSerialized(hash);
+}
+
+bool CCoinsViewDBWriter::Wait() const
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    while (fPending)
+        condWritten.wait(lock);
+    return !fFailed;
+}
+
+void CCoinsViewDBWriter::ThreadWrite()
+{
+    RenameThread("vitae-coinwrite");
+
+    int64_t nStart = GetTimeMicros();
+    bool fOk = false;
+    try {
+        fOk = base->BatchWrite(mapPending, hashBlockPending, statsPending);
+    } catch (const std::exception& e) {
+        LogPrintf("%s : %s\n", __func__, e.what());
+    }
+    if (!fOk) {
+        // the database is behind now, keep answering from the entries that did not make it and stop the node
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            fFailed = true;
+            fPending = false;
+            condWritten.notify_all();
+        }
+        AbortNode("Failed to write to coin database");
+        return;
+    }
+    LogPrint("coindb", "%s : wrote %u cache entries in %.2fms\n", __func__, (unsigned int)mapPending.size(), (GetTimeMicros() - nStart) * 0.001);
+
+    // free the written entries outside the lock, lookups fall through to the base from now on
+    CCoinsMap mapWritten;
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        mapWritten.swap(mapPending);
+        hashBlockPending = 0;
+        statsPending.SetNull();
+        fPending = false;
+        condWritten.notify_all();
+    }
 }
 
 CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CLevelDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe)
@@ -119,7 +271,16 @@ bool CBlockTreeDB::ReadLastBlockFile(int& nFile)
     return Read('l', nFile);
 }
 
-bool CCoinsViewDB::GetStats(CCoinsStats& stats) const
+bool CCoinsViewDB::GetRollingStats(CCoinsRollingStats& stats) const
+{
+    std::pair<uint256, CCoinsRollingStats> record;
+    if (!db.Read('S', record))
+        return false;
+    stats = record.second;
+    return true;
+}
+
+bool CCoinsViewDB::ScanRollingStats(CCoinsRollingStats& stats) const
 {
     /* It seems that there are no "const iterators" for LevelDB.  Since we
        only need read operations on it, use a const-cast to get around
@@ -127,10 +288,56 @@ bool CCoinsViewDB::GetStats(CCoinsStats& stats) const
     boost::scoped_ptr<leveldb::Iterator> pcursor(const_cast<CLevelDBWrapper*>(&db)->NewIterator());
     pcursor->SeekToFirst();
 
-    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    stats.SetNull();
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            ssKey >> chType;
+            if (chType == 'c') {
+                leveldb::Slice slValue = pcursor->value();
+                CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+                CCoins coins;
+                ssValue >> coins;
+                uint256 txhash;
+                ssKey >> txhash;
+                stats.AddTransaction();
+                for (unsigned int i = 0; i < coins.vout.size(); i++) {
+                    const CTxOut& out = coins.vout[i];
+                    if (!out.IsNull())
+                        stats.AddCoin(txhash, i, out, coins.nHeight, coins.fCoinBase);
+                }
+            }
+            pcursor->Next();
+        } catch (const std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+    return true;
+}
+
+bool CCoinsViewDB::GetStats(CCoinsStats& stats) const
+{
+    CCoinsRollingStats rolling;
+    if (!ScanRollingStats(rolling))
+        return false;
     stats.hashBlock = GetBestBlock();
-    ss << stats.hashBlock;
-    CAmount nTotalAmount = 0;
+    BlockMap::const_iterator mi = mapBlockIndex.find(stats.hashBlock);
+    if (mi != mapBlockIndex.end())
+        stats.nHeight = mi->second->nHeight;
+    rolling.GetStats(stats);
+    return true;
+}
+
+bool CCoinsViewDB::GetHashSerialized(uint256& hash) const
+{
+    boost::scoped_ptr<leveldb::Iterator> pcursor(const_cast<CLevelDBWrapper*>(&db)->NewIterator());
+    pcursor->SeekToFirst();
+
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << GetBestBlock();
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         try {
@@ -149,17 +356,13 @@ bool CCoinsViewDB::GetStats(CCoinsStats& stats) const
                 ss << VARINT(coins.nVersion);
                 ss << (coins.fCoinBase ? 'c' : 'n');
                 ss << VARINT(coins.nHeight);
-                stats.nTransactions++;
                 for (unsigned int i = 0; i < coins.vout.size(); i++) {
                     const CTxOut& out = coins.vout[i];
                     if (!out.IsNull()) {
-                        stats.nTransactionOutputs++;
                         ss << VARINT(i + 1);
                         ss << out;
-                        nTotalAmount += out.nValue;
                     }
                 }
-                stats.nSerializedSize += 32 + slValue.size();
                 ss << VARINT(0);
             }
             pcursor->Next();
@@ -167,12 +370,26 @@ bool CCoinsViewDB::GetStats(CCoinsStats& stats) const
             return error("%s : Deserialize or I/O error - %s", __func__, e.what());
         }
     }
-    stats.nHeight = mapBlockIndex.find(GetBestBlock())->second->nHeight;
-    stats.hashSerialized = ss.GetHash();
-    stats.nTotalAmount = nTotalAmount;
+    hash = ss.GetHash();
     return true;
 }
 
+bool CCoinsViewDB::InitRollingStats()
+{
+    uint256 hashBestChain = GetBestBlock();
+    std::pair<uint256, CCoinsRollingStats> record;
+    if (db.Read('S', record) && record.first == hashBestChain)
+        return true;
+
+    LogPrintf("Computing rolling UTXO set statistics, this is only done once...\n");
+    CCoinsRollingStats stats;
+    if (!ScanRollingStats(stats))
+        return false;
+    CLevelDBBatch batch;
+    BatchWriteRollingStats(batch, hashBestChain, stats);
+    return db.WriteBatch(batch, true);
+}
+
 bool CBlockTreeDB::ReadTxIndex(const uint256& txid, CDiskTxPos& pos)
 {
     return Read(make_pair('t', txid), pos);
@@ -186,6 +403,124 @@ bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos>
     return WriteBatch(batch);
 }
 
+bool CBlockTreeDB::ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value)
+{
+    return Read(make_pair('p', key), value);
+}
+
+bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& vect)
+{
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >::const_iterator it = vect.begin(); it != vect.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair('p', it->first));
+        else
+            batch.Write(make_pair('p', it->first), it->second);
+    }
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect)
+{
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it = vect.begin(); it != vect.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair('u', it->first));
+        else
+            batch.Write(make_pair('u', it->first), it->second);
+    }
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadAddressUnspentIndex(const uint160& addressHash, int type, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect)
+{
+    boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
+
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << make_pair('u', CAddressIndexIteratorKey(type, addressHash));
+    pcursor->Seek(ssKeySet.str());
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            ssKey >> chType;
+            if (chType != 'u')
+                break;
+            CAddressUnspentKey indexKey;
+            ssKey >> indexKey;
+            if (indexKey.type != (unsigned int)type || indexKey.hashBytes != addressHash)
+                break;
+            leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CAddressUnspentValue value;
+            ssValue >> value;
+            vect.push_back(make_pair(indexKey, value));
+            pcursor->Next();
+        } catch (const std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+    return true;
+}
+
+bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect)
+{
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it = vect.begin(); it != vect.end(); it++)
+        batch.Write(make_pair('a', it->first), it->second);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect)
+{
+    CLevelDBBatch batch;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it = vect.begin(); it != vect.end(); it++)
+        batch.Erase(make_pair('a', it->first));
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadAddressIndex(const uint160& addressHash, int type, std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex, int nStart, int nEnd)
+{
+    boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
+
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    if (nStart > 0)
+        ssKeySet << make_pair('a', CAddressIndexIteratorKey(type, addressHash, nStart));
+    else
+        ssKeySet << make_pair('a', CAddressIndexIteratorKey(type, addressHash));
+    pcursor->Seek(ssKeySet.str());
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chType;
+            ssKey >> chType;
+            if (chType != 'a')
+                break;
+            CAddressIndexKey indexKey;
+            ssKey >> indexKey;
+            if (indexKey.type != (unsigned int)type || indexKey.hashBytes != addressHash)
+                break;
+            if (nEnd > 0 && indexKey.blockHeight > nEnd)
+                break;
+            leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CAmount nValue;
+            ssValue >> nValue;
+            addressIndex.push_back(make_pair(indexKey, nValue));
+            pcursor->Next();
+        } catch (const std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+    return true;
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string& name, bool fValue)
 {
     return Write(std::make_pair('F', name), fValue ? '1' : '0');
@@ -226,6 +561,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
             leveldb::Slice slKey = pcursor->key();
             CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
             char chType;
+            uint256 hash;
             ssKey >> chType;
             if (chType == 'b') {
                 leveldb::Slice slValue = pcursor->value();
@@ -292,23 +628,29 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
     return true;
 }
 
-CZerocoinDB::CZerocoinDB(size_t nCacheSize, bool fMemory, bool fWipe) : CLevelDBWrapper(GetDataDir() / "zerocoin", nCacheSize, fMemory, fWipe)
+CZerocoinDB::CZerocoinDB(size_t nCacheSize, bool fMemory, bool fWipe) : CLevelDBWrapper(GetDataDir() / "zerocoin", nCacheSize, fMemory, fWipe), nWriteSequence(0)
 {
+    // without the filters every lookup goes to disk, which is slower but still correct
+    if (!LoadLookupFilters())
+        LogPrintf("%s : Unable to load the zerocoin lookup filters\n", __func__);
 }
 
 bool CZerocoinDB::WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo)
 {
-    CLevelDBBatch batch;
-    size_t count = 0;
-    for (std::vector<std::pair<libzerocoin::PublicCoin, uint256> >::const_iterator it=mintInfo.begin(); it != mintInfo.end(); it++) {
-        PublicCoin pubCoin = it->first;
-        uint256 hash = GetPubCoinHash(pubCoin.getValue());
-        batch.Write(make_pair('m', hash), it->second);
-        ++count;
+    LOCK(cs_cache);
+    for (std::vector<std::pair<libzerocoin::PublicCoin, uint256> >::const_iterator it = mintInfo.begin(); it != mintInfo.end(); it++) {
+        uint256 hash = GetPubCoinHash(it->first.getValue());
+        mapMintsCached[hash] = it->second;
+        setMintsErased.erase(hash);
+        mapMintsRead.erase(hash);
+        filterMints.insert(hash);
     }
+    // a filter that failed to load stays unsized and lookups go to disk, it isn't scanned for again
+    if (filterMints.IsFull())
+        LoadLookupFilter('m');
 
-    LogPrint("zero", "Writing %u coin mints to db.\n", (unsigned int)count);
-    return WriteBatch(batch, true);
+    LogPrint("zero", "Caching %u coin mints for db.\n", (unsigned int)mintInfo.size());
+    return true;
 }
 
 bool CZerocoinDB::ReadCoinMint(const CBigNum& bnPubcoin, uint256& hashTx)
@@ -318,53 +660,127 @@ bool CZerocoinDB::ReadCoinMint(const CBigNum& bnPubcoin, uint256& hashTx)
 
 bool CZerocoinDB::ReadCoinMint(const uint256& hashPubcoin, uint256& hashTx)
 {
-    return Read(make_pair('m', hashPubcoin), hashTx);
+    return ReadCoinRecord('m', hashPubcoin, hashTx);
 }
 
 bool CZerocoinDB::EraseCoinMint(const CBigNum& bnPubcoin)
 {
     uint256 hash = GetPubCoinHash(bnPubcoin);
-    return Erase(make_pair('m', hash));
+    LOCK(cs_cache);
+    mapMintsCached.erase(hash);
+    setMintsErased.insert(hash);
+    mapMintsRead.erase(hash);
+    return true;
 }
 
 bool CZerocoinDB::WriteCoinSpendBatch(const std::vector<std::pair<libzerocoin::CoinSpend, uint256> >& spendInfo)
 {
-    CLevelDBBatch batch;
-    size_t count = 0;
-    for (std::vector<std::pair<libzerocoin::CoinSpend, uint256> >::const_iterator it=spendInfo.begin(); it != spendInfo.end(); it++) {
-        CBigNum bnSerial = it->first.getCoinSerialNumber();
-        CDataStream ss(SER_GETHASH, 0);
-        ss << bnSerial;
-        uint256 hash = Hash(ss.begin(), ss.end());
-        batch.Write(make_pair('s', hash), it->second);
-        ++count;
+    LOCK(cs_cache);
+    for (std::vector<std::pair<libzerocoin::CoinSpend, uint256> >::const_iterator it = spendInfo.begin(); it != spendInfo.end(); it++) {
+        uint256 hash = GetSerialHash(it->first.getCoinSerialNumber());
+        mapSpendsCached[hash] = it->second;
+        setSpendsErased.erase(hash);
+        mapSpendsRead.erase(hash);
+        filterSpends.insert(hash);
     }
+    if (filterSpends.IsFull())
+        LoadLookupFilter('s');
 
-    LogPrint("zero", "Writing %u coin spends to db.\n", (unsigned int)count);
-    return WriteBatch(batch, true);
+    LogPrint("zero", "Caching %u coin spends for db.\n", (unsigned int)spendInfo.size());
+    return true;
 }
 
 bool CZerocoinDB::ReadCoinSpend(const CBigNum& bnSerial, uint256& txHash)
 {
-    CDataStream ss(SER_GETHASH, 0);
-    ss << bnSerial;
-    uint256 hash = Hash(ss.begin(), ss.end());
-
-    return Read(make_pair('s', hash), txHash);
+    return ReadCoinSpend(GetSerialHash(bnSerial), txHash);
 }
 
 bool CZerocoinDB::ReadCoinSpend(const uint256& hashSerial, uint256 &txHash)
 {
-    return Read(make_pair('s', hashSerial), txHash);
+    return ReadCoinRecord('s', hashSerial, txHash);
 }
 
-bool CZerocoinDB::EraseCoinSpend(const CBigNum& bnSerial)
+bool CZerocoinDB::FindCachedCoinRecord(char chType, const uint256& hash, uint256& txHash, bool& fErased) const
+{
+    AssertLockHeld(cs_cache);
+    const std::map<uint256, uint256>& mapCached = chType == 'm' ? mapMintsCached : mapSpendsCached;
+    const std::set<uint256>& setErased = chType == 'm' ? setMintsErased : setSpendsErased;
+    const std::map<uint256, uint256>& mapFlushing = chType == 'm' ? mapMintsFlushing : mapSpendsFlushing;
+    const std::set<uint256>& setErasedFlushing = chType == 'm' ? setMintsErasedFlushing : setSpendsErasedFlushing;
+
+    // the cached changes are newer than the ones being written
+    std::map<uint256, uint256>::const_iterator it = mapCached.find(hash);
+    fErased = false;
+    if (it != mapCached.end()) {
+        txHash = it->second;
+        return true;
+    }
+    if (setErased.count(hash)) {
+        fErased = true;
+        return true;
+    }
+    it = mapFlushing.find(hash);
+    if (it != mapFlushing.end()) {
+        txHash = it->second;
+        return true;
+    }
+    if (setErasedFlushing.count(hash)) {
+        fErased = true;
+        return true;
+    }
+    return false;
+}
+
+bool CZerocoinDB::ReadCoinRecord(char chType, const uint256& hash, uint256& txHash)
 {
-    CDataStream ss(SER_GETHASH, 0);
-    ss << bnSerial;
-    uint256 hash = Hash(ss.begin(), ss.end());
+    const CHashFilter& filter = chType == 'm' ? filterMints : filterSpends;
+    std::map<uint256, uint256>& mapRead = chType == 'm' ? mapMintsRead : mapSpendsRead;
+
+    unsigned int nSequence;
+    bool fErased;
+    {
+        LOCK(cs_cache);
+        if (FindCachedCoinRecord(chType, hash, txHash, fErased))
+            return !fErased;
+        std::map<uint256, uint256>::const_iterator it = mapRead.find(hash);
+        if (it != mapRead.end()) {
+            txHash = it->second;
+            return true;
+        }
+
+        // an unknown serial or pubcoin, answered without touching the disk
+        if (!filter.contains(hash))
+            return false;
+        nSequence = nWriteSequence;
+    }
 
-    return Erase(make_pair('s', hash));
+    uint256 txHashRead;
+    bool fFound = Read(make_pair(chType, hash), txHashRead);
+
+    // the record may have been written or erased while the database was read
+    LOCK(cs_cache);
+    if (FindCachedCoinRecord(chType, hash, txHash, fErased))
+        return !fErased;
+    if (!fFound)
+        return false;
+    txHash = txHashRead;
+    // a flush or wipe in between may have changed the record on disk, so only keep what is still current
+    if (nSequence == nWriteSequence) {
+        if (mapRead.size() >= MAX_ZEROCOIN_LOOKUP_CACHE)
+            mapRead.erase(mapRead.begin());
+        mapRead[hash] = txHash;
+    }
+    return true;
+}
+
+bool CZerocoinDB::EraseCoinSpend(const CBigNum& bnSerial)
+{
+    uint256 hash = GetSerialHash(bnSerial);
+    LOCK(cs_cache);
+    mapSpendsCached.erase(hash);
+    setSpendsErased.insert(hash);
+    mapSpendsRead.erase(hash);
+    return true;
 }
 
 bool CZerocoinDB::WipeCoins(std::string strType)
@@ -372,6 +788,10 @@ bool CZerocoinDB::WipeCoins(std::string strType)
     if (strType != "spends" && strType != "mints")
         return error("%s: did not recognize type %s", __func__, strType);
 
+    // the iteration below only sees what is on disk
+    if (!FlushCache())
+        return error("%s: failed to write cached changes", __func__);
+
     boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
 
     char type = (strType == "spends" ? 's' : 'm');
@@ -388,10 +808,8 @@ bool CZerocoinDB::WipeCoins(std::string strType)
             char chType;
             ssKey >> chType;
             if (chType == type) {
-                leveldb::Slice slValue = pcursor->value();
-                CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
                 uint256 hash;
-                ssValue >> hash;
+                ssKey >> hash;
                 setDelete.insert(hash);
                 pcursor->Next();
             } else {
@@ -407,22 +825,202 @@ bool CZerocoinDB::WipeCoins(std::string strType)
             LogPrintf("%s: error failed to delete %s\n", __func__, hash.GetHex());
     }
 
+    {
+        LOCK(cs_cache);
+        nWriteSequence++;
+        (type == 's' ? mapSpendsRead : mapMintsRead).clear();
+    }
+
     return true;
 }
 
 bool CZerocoinDB::WriteAccumulatorValue(const uint32_t& nChecksum, const CBigNum& bnValue)
 {
     LogPrint("zero","%s : checksum:%d val:%s\n", __func__, nChecksum, bnValue.GetHex());
-    return Write(make_pair('2', nChecksum), bnValue);
+    LOCK(cs_cache);
+    mapAccumulatorValuesCached[nChecksum] = bnValue;
+    setAccumulatorValuesErased.erase(nChecksum);
+    return true;
 }
 
 bool CZerocoinDB::ReadAccumulatorValue(const uint32_t& nChecksum, CBigNum& bnValue)
 {
+    {
+        LOCK(cs_cache);
+        std::map<uint32_t, CBigNum>::const_iterator it = mapAccumulatorValuesCached.find(nChecksum);
+        if (it != mapAccumulatorValuesCached.end()) {
+            bnValue = it->second;
+            return true;
+        }
+        if (setAccumulatorValuesErased.count(nChecksum))
+            return false;
+        it = mapAccumulatorValuesFlushing.find(nChecksum);
+        if (it != mapAccumulatorValuesFlushing.end()) {
+            bnValue = it->second;
+            return true;
+        }
+        if (setAccumulatorValuesErasedFlushing.count(nChecksum))
+            return false;
+    }
     return Read(make_pair('2', nChecksum), bnValue);
 }
 
 bool CZerocoinDB::EraseAccumulatorValue(const uint32_t& nChecksum)
 {
     LogPrint("zero", "%s : checksum:%d\n", __func__, nChecksum);
-    return Erase(make_pair('2', nChecksum));
+    LOCK(cs_cache);
+    mapAccumulatorValuesCached.erase(nChecksum);
+    setAccumulatorValuesErased.insert(nChecksum);
+    return true;
+}
+
+/** Merge the changes that failed to be written back under the ones cached since */
+template <typename K, typename V>
+static void RestoreUnwrittenChanges(std::map<K, V>& mapCached, std::set<K>& setErased, std::map<K, V>& mapFlushing, std::set<K>& setErasedFlushing)
+{
+    for (typename std::map<K, V>::iterator it = mapFlushing.begin(); it != mapFlushing.end(); ++it) {
+        if (!setErased.count(it->first))
+            mapCached.insert(*it);
+    }
+    for (typename std::set<K>::const_iterator it = setErasedFlushing.begin(); it != setErasedFlushing.end(); ++it) {
+        if (!mapCached.count(*it))
+            setErased.insert(*it);
+    }
+    mapFlushing.clear();
+    setErasedFlushing.clear();
+}
+
+bool CZerocoinDB::FlushCache()
+{
+    // one flush at a time, the in-flight changes belong to it
+    LOCK(cs_flush);
+
+    // Take the changes out of the cache, so readers and writers only wait for the swap and
+    // not for the synced write. Readers find them in the in-flight maps until the write is done.
+    size_t nChanges;
+    {
+        LOCK(cs_cache);
+        nChanges = mapMintsCached.size() + setMintsErased.size() + mapSpendsCached.size() + setSpendsErased.size() +
+                   mapAccumulatorValuesCached.size() + setAccumulatorValuesErased.size();
+        if (nChanges == 0)
+            return true;
+        mapMintsFlushing.swap(mapMintsCached);
+        setMintsErasedFlushing.swap(setMintsErased);
+        mapSpendsFlushing.swap(mapSpendsCached);
+        setSpendsErasedFlushing.swap(setSpendsErased);
+        mapAccumulatorValuesFlushing.swap(mapAccumulatorValuesCached);
+        setAccumulatorValuesErasedFlushing.swap(setAccumulatorValuesErased);
+    }
+
+    // only this flush changes the in-flight maps, so they can be read without cs_cache
+    CLevelDBBatch batch;
+    for (std::map<uint256, uint256>::const_iterator it = mapMintsFlushing.begin(); it != mapMintsFlushing.end(); ++it)
+        batch.Write(make_pair('m', it->first), it->second);
+    for (std::set<uint256>::const_iterator it = setMintsErasedFlushing.begin(); it != setMintsErasedFlushing.end(); ++it)
+        batch.Erase(make_pair('m', *it));
+    for (std::map<uint256, uint256>::const_iterator it = mapSpendsFlushing.begin(); it != mapSpendsFlushing.end(); ++it)
+        batch.Write(make_pair('s', it->first), it->second);
+    for (std::set<uint256>::const_iterator it = setSpendsErasedFlushing.begin(); it != setSpendsErasedFlushing.end(); ++it)
+        batch.Erase(make_pair('s', *it));
+    for (std::map<uint32_t, CBigNum>::const_iterator it = mapAccumulatorValuesFlushing.begin(); it != mapAccumulatorValuesFlushing.end(); ++it)
+        batch.Write(make_pair('2', it->first), it->second);
+    for (std::set<uint32_t>::const_iterator it = setAccumulatorValuesErasedFlushing.begin(); it != setAccumulatorValuesErasedFlushing.end(); ++it)
+        batch.Erase(make_pair('2', *it));
+    bool fWritten = WriteBatch(batch, true);
+
+    // a lookup that read the database during the write may have seen it either way, see nWriteSequence
+    LOCK(cs_cache);
+    if (!fWritten) {
+        // keep the changes for the next flush
+        RestoreUnwrittenChanges(mapMintsCached, setMintsErased, mapMintsFlushing, setMintsErasedFlushing);
+        RestoreUnwrittenChanges(mapSpendsCached, setSpendsErased, mapSpendsFlushing, setSpendsErasedFlushing);
+        RestoreUnwrittenChanges(mapAccumulatorValuesCached, setAccumulatorValuesErased, mapAccumulatorValuesFlushing, setAccumulatorValuesErasedFlushing);
+        return false;
+    }
+    nWriteSequence++;
+    mapMintsFlushing.clear();
+    setMintsErasedFlushing.clear();
+    mapSpendsFlushing.clear();
+    setSpendsErasedFlushing.clear();
+    mapAccumulatorValuesFlushing.clear();
+    setAccumulatorValuesErasedFlushing.clear();
+
+    LogPrint("zero", "%s : wrote %u zerocoin changes\n", __func__, (unsigned int)nChanges);
+    return true;
+}
+
+/** Heap used by a bignum: the BIGNUM itself, opaque in newer OpenSSL, and its digits */
+static size_t BigNumUsage(const CBigNum& bn)
+{
+    return memusage::MallocUsage(sizeof(void*) + 3 * sizeof(int)) + memusage::MallocUsage((bn.bitSize() + 63) / 64 * 8);
+}
+
+size_t CZerocoinDB::CacheUsage() const
+{
+    LOCK(cs_cache);
+    size_t nUsage = memusage::DynamicUsage(mapMintsCached) + memusage::DynamicUsage(setMintsErased) +
+                    memusage::DynamicUsage(mapSpendsCached) + memusage::DynamicUsage(setSpendsErased) +
+                    memusage::DynamicUsage(mapAccumulatorValuesCached) + memusage::DynamicUsage(setAccumulatorValuesErased) +
+                    memusage::DynamicUsage(mapMintsFlushing) + memusage::DynamicUsage(setMintsErasedFlushing) +
+                    memusage::DynamicUsage(mapSpendsFlushing) + memusage::DynamicUsage(setSpendsErasedFlushing) +
+                    memusage::DynamicUsage(mapAccumulatorValuesFlushing) + memusage::DynamicUsage(setAccumulatorValuesErasedFlushing);
+    for (std::map<uint32_t, CBigNum>::const_iterator it = mapAccumulatorValuesCached.begin(); it != mapAccumulatorValuesCached.end(); ++it)
+        nUsage += BigNumUsage(it->second);
+    for (std::map<uint32_t, CBigNum>::const_iterator it = mapAccumulatorValuesFlushing.begin(); it != mapAccumulatorValuesFlushing.end(); ++it)
+        nUsage += BigNumUsage(it->second);
+    return nUsage;
+}
+
+bool CZerocoinDB::LoadLookupFilter(char chType)
+{
+    AssertLockHeld(cs_cache);
+    const std::map<uint256, uint256>& mapCached = chType == 'm' ? mapMintsCached : mapSpendsCached;
+    const std::map<uint256, uint256>& mapFlushing = chType == 'm' ? mapMintsFlushing : mapSpendsFlushing;
+    CHashFilter& filter = chType == 'm' ? filterMints : filterSpends;
+    (chType == 'm' ? mapMintsRead : mapSpendsRead).clear();
+
+    std::vector<uint256> vHash;
+    boost::scoped_ptr<leveldb::Iterator> pcursor(NewIterator());
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << make_pair(chType, uint256(0));
+    pcursor->Seek(ssKeySet.str());
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        try {
+            leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+            char chKeyType;
+            ssKey >> chKeyType;
+            if (chKeyType != chType)
+                break;
+            uint256 hash;
+            ssKey >> hash;
+            vHash.push_back(hash);
+            pcursor->Next();
+        } catch (const std::exception& e) {
+            filter = CHashFilter();
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+
+    // leave room to grow, a filter that fills up is built again twice as large
+    filter.reset(std::max((unsigned int)(vHash.size() + mapCached.size() + mapFlushing.size()) * 2, MIN_ZEROCOIN_FILTER_KEYS), 0.001);
+    for (std::vector<uint256>::const_iterator it = vHash.begin(); it != vHash.end(); ++it)
+        filter.insert(*it);
+    for (std::map<uint256, uint256>::const_iterator it = mapCached.begin(); it != mapCached.end(); ++it)
+        filter.insert(it->first);
+    // a flush may be writing these right now, the cursor doesn't see them yet
+    for (std::map<uint256, uint256>::const_iterator it = mapFlushing.begin(); it != mapFlushing.end(); ++it)
+        filter.insert(it->first);
+
+    LogPrint("zero", "%s : %u keys of type %c\n", __func__, filter.size(), chType);
+    return true;
+}
+
+bool CZerocoinDB::LoadLookupFilters()
+{
+    LOCK(cs_cache);
+    bool fMints = LoadLookupFilter('m');
+    bool fSpends = LoadLookupFilter('s');
+    return fMints && fSpends;
 }
@@ -9,15 +9,21 @@
 #ifndef BITCOIN_TXDB_H
 #define BITCOIN_TXDB_H
 
+#include "addressindex.h"
+#include "bloom.h"
 #include "leveldbwrapper.h"
 #include "main.h"
 #include "primitives/zerocoin.h"
+#include "spentindex.h"
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <boost/thread.hpp>
+
 class CCoins;
 class uint256;
 
@@ -27,6 +33,10 @@ static const int64_t nDefaultDbCache = 100;
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 4096 : 1024;
 //! min. -dbcache in (MiB)
 static const int64_t nMinDbCache = 4;
+//! Number of positive mint and spend lookups from disk kept in memory, per type
+static const unsigned int MAX_ZEROCOIN_LOOKUP_CACHE = 20000;
+//! The zerocoin lookup filters are sized for at least this many keys
+static const unsigned int MIN_ZEROCOIN_FILTER_KEYS = 100000;
 
 /** CCoinsView backed by the LevelDB coin database (chainstate/) */
 class CCoinsViewDB : public CCoinsView
@@ -40,8 +50,58 @@ public:
     bool GetCoins(const uint256& txid, CCoins& coins) const;
     bool HaveCoins(const uint256& txid) const;
     uint256 GetBestBlock() const;
-    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock);
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDelta);
+    bool GetRollingStats(CCoinsRollingStats& stats) const;
+
+    //! Calculate the statistics by scanning the entire database (slow; for verification)
+    bool GetStats(CCoinsStats& stats) const;
+    bool GetHashSerialized(uint256& hash) const;
+
+    //! Scan the database to create the rolling statistics if they are missing (one-time upgrade)
+    bool InitRollingStats();
+
+private:
+    bool ScanRollingStats(CCoinsRollingStats& stats) const;
+};
+
+/**
+ * CCoinsView that writes flushed coins to the coin database on a background
+ * thread, so that validation can go on while the database writes. BatchWrite
+ * takes over the flushed entries and returns right away; until they are on
+ * disk, lookups are answered from them, so readers never see the database
+ * lag behind. One write is in flight at a time: the next BatchWrite waits for
+ * the previous one and fails if it did. A failed write shuts the node down,
+ * and its entries keep answering lookups until then. The base must only read
+ * the map it is given, as CCoinsViewDB does.
+ */
+class CCoinsViewDBWriter : public CCoinsViewBacked
+{
+private:
+    mutable boost::mutex mutex;
+    mutable boost::condition_variable condWritten;
+    CCoinsMap mapPending;
+    uint256 hashBlockPending;
+    CCoinsRollingStats statsPending;
+    bool fPending;
+    bool fFailed;
+    boost::thread threadWrite;
+
+    void ThreadWrite();
+
+public:
+    CCoinsViewDBWriter(CCoinsView* baseIn);
+    ~CCoinsViewDBWriter();
+
+    bool GetCoins(const uint256& txid, CCoins& coins) const;
+    bool HaveCoins(const uint256& txid) const;
+    uint256 GetBestBlock() const;
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CCoinsRollingStats& statsDelta);
     bool GetStats(CCoinsStats& stats) const;
+    bool GetRollingStats(CCoinsRollingStats& stats) const;
+    bool GetHashSerialized(uint256& hash) const;
+
+    //! Wait until the pending write, if any, is on disk. Returns false if any write failed.
+    bool Wait() const;
 };
 
 /** Access to the block database (blocks/index/) */
@@ -64,6 +124,13 @@ public:
     bool ReadReindexing(bool& fReindex);
     bool ReadTxIndex(const uint256& txid, CDiskTxPos& pos);
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> >& list);
+    bool ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value);
+    bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& vect);
+    bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect);
+    bool ReadAddressUnspentIndex(const uint160& addressHash, int type, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect);
+    bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect);
+    bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect);
+    bool ReadAddressIndex(const uint160& addressHash, int type, std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex, int nStart = 0, int nEnd = 0);
     bool WriteFlag(const std::string& name, bool fValue);
     bool ReadFlag(const std::string& name, bool& fValue);
     bool WriteInt(const std::string& name, int nValue);
@@ -71,7 +138,20 @@ public:
     bool LoadBlockIndexGuts();
 };
 
-/** Zerocoin database (zerocoin/) */
+/**
+ * Access to the zerocoin database (zerocoin/).
+ *
+ * Mints, spends and accumulator values written while blocks are connected or
+ * disconnected are kept in a write cache that reads look into first. The
+ * cache is written in one batch by FlushCache, which FlushStateToDisk calls
+ * right before the chainstate is flushed, so the zerocoin state on disk is
+ * never behind the coins. Replaying blocks after a crash writes the same
+ * records again.
+ *
+ * Mint and spend lookups of keys that were never written, the common answer
+ * for double spend checks, are resolved by in-memory filters over all keys in
+ * the database. Recent lookups that hit the disk are kept in a bounded cache.
+ */
 class CZerocoinDB : public CLevelDBWrapper
 {
 public:
@@ -81,6 +161,37 @@ private:
     CZerocoinDB(const CZerocoinDB&);
     void operator=(const CZerocoinDB&);
 
+    //! Changes not written yet, an erased record is in the erased set instead of the map
+    mutable CCriticalSection cs_cache;
+    std::map<uint256, uint256> mapMintsCached;
+    std::set<uint256> setMintsErased;
+    std::map<uint256, uint256> mapSpendsCached;
+    std::set<uint256> setSpendsErased;
+    std::map<uint32_t, CBigNum> mapAccumulatorValuesCached;
+    std::set<uint32_t> setAccumulatorValuesErased;
+    //! Changes FlushCache is writing without cs_cache, still served until the write is done
+    CCriticalSection cs_flush;
+    std::map<uint256, uint256> mapMintsFlushing;
+    std::set<uint256> setMintsErasedFlushing;
+    std::map<uint256, uint256> mapSpendsFlushing;
+    std::set<uint256> setSpendsErasedFlushing;
+    std::map<uint32_t, CBigNum> mapAccumulatorValuesFlushing;
+    std::set<uint32_t> setAccumulatorValuesErasedFlushing;
+
+    //! Filters over the mint and spend keys, a key they don't contain is in neither the cache nor the database
+    CHashFilter filterMints;
+    CHashFilter filterSpends;
+    //! Records recently read from the database
+    std::map<uint256, uint256> mapMintsRead;
+    std::map<uint256, uint256> mapSpendsRead;
+    //! Counts the writes to disk, a lookup that overlaps one is not kept in the read cache
+    unsigned int nWriteSequence;
+
+    bool ReadCoinRecord(char chType, const uint256& hash, uint256& txHash);
+    //! Look a record up in the cached and in-flight changes. Returns false if neither has it.
+    bool FindCachedCoinRecord(char chType, const uint256& hash, uint256& txHash, bool& fErased) const;
+    bool LoadLookupFilter(char chType);
+
 public:
     /** Write zVITAE mints to the zerocoinDB in a batch */
     bool WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo);
@@ -96,6 +207,13 @@ public:
     bool WriteAccumulatorValue(const uint32_t& nChecksum, const CBigNum& bnValue);
     bool ReadAccumulatorValue(const uint32_t& nChecksum, CBigNum& bnValue);
     bool EraseAccumulatorValue(const uint32_t& nChecksum);
+
+    /** Write the cached changes to disk in one synced batch, without holding up readers and writers */
+    bool FlushCache();
+    /** Approximate memory used by the cached changes */
+    size_t CacheUsage() const;
+    /** Build the mint and spend lookup filters from the keys in the database */
+    bool LoadLookupFilters();
 };
 
 #endif // BITCOIN_TXDB_H
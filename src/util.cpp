@@ -13,6 +13,7 @@
 
 #include "allocators.h"
 #include "chainparamsbase.h"
+#include "mpscqueue.h"
 #include "random.h"
 #include "serialize.h"
 #include "sync.h"
@@ -41,6 +42,7 @@
 #endif // __linux__
 
 #include <algorithm>
+#include <exception>
 #include <fcntl.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
@@ -262,39 +264,286 @@ bool LogAcceptCategory(const char* category)
     return true;
 }
 
-int LogPrintStr(const std::string& str)
+/**
+ * Lines are handed to the debug log thread through a lock-free queue once
+ * StartDebugLog has been called; until then, and again after StopDebugLog,
+ * LogPrintStr writes them itself. The queue is never freed, so a late
+ * producer can't touch a deleted queue during shutdown.
+ */
+struct CDebugLogLine {
+    int64_t nTime;
+    std::string str;
+};
+static CMPSCQueue<CDebugLogLine>* pDebugLogQueue = NULL;
+static boost::thread* pDebugLogThread = NULL;
+static std::atomic<bool> fDebugLogAsync(false);
+//! Producers between checking fDebugLogAsync and finishing their push, so StopDebugLog can wait for them
+static std::atomic<int> nDebugLogProducers(0);
+static std::atomic<bool> fDebugLogStop(false);
+static std::atomic<uint64_t> nDebugLogDropped(0);
+static std::atomic<uint64_t> nDebugLogRateLimited(0);
+//! Lines pushed but not drained yet. The logger thread sleeps on condDebugLog while it is 0.
+static std::atomic<int> nDebugLogPending(0);
+static boost::mutex mutexDebugLogWake;
+static boost::condition_variable condDebugLog;
+
+/** Push a line and wake the logger thread if the queue was empty. Returns false if the queue is full. */
+static bool PushDebugLogLine(CDebugLogLine&& line)
+{
+    if (!pDebugLogQueue->Push(std::move(line)))
+        return false;
+    // the lock makes sure the logger is either still before its check of nDebugLogPending or already waiting
+    if (nDebugLogPending++ == 0) {
+        boost::mutex::scoped_lock lock(mutexDebugLogWake);
+        condDebugLog.notify_one();
+    }
+    return true;
+}
+
+/**
+ * Per category line budget for the current second. Categories are hashed into
+ * a fixed table so that checking the limit needs no lock; two categories that
+ * share a slot share their budget.
+ */
+static const int LOG_RATE_SLOTS = 64;
+struct CLogRateSlot {
+    std::atomic<int64_t> nSecond;
+    std::atomic<int> nLines;
+};
+static CLogRateSlot vLogRateSlots[LOG_RATE_SLOTS];
+static int nLogRateLimit = 0;
+
+static bool LogRateLimited(const char* category)
+{
+    if (category == NULL || nLogRateLimit <= 0)
+        return false;
+
+    unsigned int nHash = 0;
+    for (const char* p = category; *p; p++)
+        nHash = nHash * 31 + (unsigned char)*p;
+    CLogRateSlot& slot = vLogRateSlots[nHash % LOG_RATE_SLOTS];
+
+    int64_t nNow = time(NULL);
+    int64_t nSecond = slot.nSecond.load(std::memory_order_relaxed);
+    if (nSecond != nNow && slot.nSecond.compare_exchange_strong(nSecond, nNow, std::memory_order_relaxed))
+        slot.nLines.store(0, std::memory_order_relaxed);
+    return slot.nLines.fetch_add(1, std::memory_order_relaxed) >= nLogRateLimit;
+}
+
+/** Append a line to strBatch, with a timestamp if it starts a new line. mutexDebugLog must be held. */
+static void FormatDebugLogLine(std::string& strBatch, const std::string& str, int64_t nTime)
+{
+    static bool fStartedNewLine = true;
+
+    // Debug print useful for profiling
+    if (fLogTimestamps && fStartedNewLine)
+        strBatch += DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nTime) + " ";
+    fStartedNewLine = !str.empty() && str[str.size() - 1] == '\n';
+    strBatch += str;
+}
+
+/** Write formatted lines to debug.log, reopening it first if requested. mutexDebugLog must be held. */
+static int WriteDebugLog(const std::string& strBatch)
+{
+    // reopen the log file, if requested
+    if (fReopenDebugLog) {
+        fReopenDebugLog = false;
+        boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
+        if (freopen(pathDebug.string().c_str(), "a", fileout) != NULL)
+            setbuf(fileout, NULL); // unbuffered
+    }
+
+    return fwrite(strBatch.data(), 1, strBatch.size(), fileout);
+}
+
+/** Write out everything queued so far, in batches of up to LOG_BATCH_SIZE bytes. mutexDebugLog must be held. */
+static void DrainDebugLogLocked()
+{
+    static const size_t LOG_BATCH_SIZE = 64 * 1024;
+
+    CDebugLogLine line;
+    std::string strBatch;
+    int nPopped = 0;
+    while (pDebugLogQueue->Pop(line)) {
+        nPopped++;
+        FormatDebugLogLine(strBatch, line.str, line.nTime);
+        if (strBatch.size() >= LOG_BATCH_SIZE) {
+            WriteDebugLog(strBatch);
+            strBatch.clear();
+        }
+    }
+    if (!strBatch.empty())
+        WriteDebugLog(strBatch);
+    nDebugLogPending -= nPopped;
+}
+
+static void DrainDebugLog()
+{
+    boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+    DrainDebugLogLocked();
+}
+
+void FlushDebugLog(bool fWait)
+{
+    if (pDebugLogQueue == NULL)
+        return;
+
+    boost::mutex::scoped_lock scoped_lock(*mutexDebugLog, boost::defer_lock);
+    if (fWait) {
+        scoped_lock.lock();
+    } else {
+        // the thread that holds the lock may be the one terminating, give up after a short while
+        for (int i = 0; i < 100 && !scoped_lock.try_lock(); i++)
+            MilliSleep(1);
+        if (!scoped_lock.owns_lock())
+            return;
+    }
+    DrainDebugLogLocked();
+}
+
+static std::terminate_handler prevTerminateHandler = NULL;
+
+/** Write out the lines the logger thread didn't get to before the process dies */
+static void DebugLogTerminateHandler()
+{
+    FlushDebugLog(false);
+    if (prevTerminateHandler != NULL)
+        prevTerminateHandler();
+    std::abort();
+}
+
+static void ThreadDebugLog()
+{
+    RenameThread("vitae-log");
+
+    uint64_t nReportedDropped = 0;
+    uint64_t nReportedRateLimited = 0;
+    int64_t nLastReport = 0;
+    while (true) {
+        // anything queued before the stop request is still written by the last drain
+        bool fStop = fDebugLogStop;
+        DrainDebugLog();
+
+        uint64_t nDropped = nDebugLogDropped;
+        uint64_t nRateLimited = nDebugLogRateLimited;
+        if ((nDropped != nReportedDropped || nRateLimited != nReportedRateLimited) && (fStop || GetTime() - nLastReport >= 10)) {
+            CDebugLogLine line;
+            line.nTime = GetTime();
+            line.str = strprintf("Debug log: dropped %u lines because the log buffer was full and %u lines over the -lograte limit\n",
+                nDropped - nReportedDropped, nRateLimited - nReportedRateLimited);
+            PushDebugLogLine(std::move(line));
+            DrainDebugLog();
+            nReportedDropped = nDropped;
+            nReportedRateLimited = nRateLimited;
+            nLastReport = GetTime();
+        }
+
+        if (fStop)
+            break;
+
+        // sleep until a line is queued or StopDebugLog asks to stop; lines dropped
+        // or rate limited meanwhile are reported within 10 seconds
+        boost::mutex::scoped_lock lock(mutexDebugLogWake);
+        bool fUnreported = nDebugLogDropped != nReportedDropped || nDebugLogRateLimited != nReportedRateLimited;
+        boost::system_time deadline = boost::get_system_time() + boost::posix_time::seconds(10);
+        while (nDebugLogPending == 0 && !fDebugLogStop) {
+            if (!fUnreported)
+                condDebugLog.wait(lock);
+            else if (!condDebugLog.timed_wait(lock, deadline))
+                break;
+        }
+    }
+}
+
+void SetLogRateLimit(int nLines)
+{
+    nLogRateLimit = nLines;
+}
+
+void StartDebugLog(size_t nBufferLines)
+{
+    if (fPrintToConsole || !fPrintToDebugLog || pDebugLogThread != NULL)
+        return;
+
+    boost::call_once(&DebugPrintInit, debugPrintInitFlag);
+    if (fileout == NULL)
+        return;
+
+    if (pDebugLogQueue == NULL) {
+        pDebugLogQueue = new CMPSCQueue<CDebugLogLine>(nBufferLines);
+        prevTerminateHandler = std::set_terminate(DebugLogTerminateHandler);
+    }
+    fDebugLogStop = false;
+    pDebugLogThread = new boost::thread(&ThreadDebugLog);
+    fDebugLogAsync = true;
+}
+
+void StopDebugLog()
+{
+    if (pDebugLogThread == NULL)
+        return;
+
+    // New lines are written directly from here on. A producer that still saw the logger
+    // running registered itself before looking, so once none are left every queued line
+    // is in the queue and the last drain below writes it.
+    fDebugLogAsync = false;
+    while (nDebugLogProducers > 0)
+        boost::this_thread::yield();
+
+    {
+        boost::mutex::scoped_lock lock(mutexDebugLogWake);
+        fDebugLogStop = true;
+        condDebugLog.notify_one();
+    }
+    pDebugLogThread->join();
+    delete pDebugLogThread;
+    pDebugLogThread = NULL;
+
+    DrainDebugLog();
+}
+
+/** Queue a line for the debug log thread. Returns false if it isn't running, so the caller writes the line itself. */
+static bool QueueDebugLogLine(const std::string& str, int& ret)
+{
+    nDebugLogProducers++;
+    bool fQueued = fDebugLogAsync;
+    if (fQueued) {
+        CDebugLogLine line;
+        line.nTime = GetTime();
+        line.str = str;
+        if (PushDebugLogLine(std::move(line)))
+            ret = str.size();
+        else
+            nDebugLogDropped++;
+    }
+    nDebugLogProducers--;
+    return fQueued;
+}
+
+int LogPrintStr(const std::string& str, const char* category)
 {
     int ret = 0; // Returns total number of characters written
+    if (LogRateLimited(category)) {
+        nDebugLogRateLimited++;
+        return ret;
+    }
+
     if (fPrintToConsole) {
         // print to console
         ret = fwrite(str.data(), 1, str.size(), stdout);
         fflush(stdout);
+    } else if (QueueDebugLogLine(str, ret)) {
+        // handed to the debug log thread
     } else if (fPrintToDebugLog && AreBaseParamsConfigured()) {
-        static bool fStartedNewLine = true;
         boost::call_once(&DebugPrintInit, debugPrintInitFlag);
 
         if (fileout == NULL)
             return ret;
 
         boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
-
-        // reopen the log file, if requested
-        if (fReopenDebugLog) {
-            fReopenDebugLog = false;
-            boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
-            if (freopen(pathDebug.string().c_str(), "a", fileout) != NULL)
-                setbuf(fileout, NULL); // unbuffered
-        }
-
-        // Debug print useful for profiling
-        if (fLogTimestamps && fStartedNewLine)
-            ret += fprintf(fileout, "%s ", DateTimeStrFormat("%Y-%m-%d %H:%M:%S", GetTime()).c_str());
-        if (!str.empty() && str[str.size() - 1] == '\n')
-            fStartedNewLine = true;
-        else
-            fStartedNewLine = false;
-
-        ret = fwrite(str.data(), 1, str.size(), fileout);
+        std::string strLine;
+        FormatDebugLogLine(strLine, str, GetTime());
+        ret = WriteDebugLog(strLine);
     }
 
     return ret;
@@ -67,10 +67,23 @@ extern volatile bool fReopenDebugLog;
 void SetupEnvironment();
 bool SetupNetworking();
 
+/** Default number of lines the debug log thread can buffer before lines are dropped */
+static const unsigned int DEFAULT_LOG_BUFFER = 65536;
+/** Default limit of lines per second and debug category, 0 = unlimited */
+static const int DEFAULT_LOG_RATE = 0;
+
 /** Return true if log accepts specified category */
 bool LogAcceptCategory(const char* category);
-/** Send a string to the log output */
-int LogPrintStr(const std::string& str);
+/** Send a string to the log output, subject to the -lograte limit if it belongs to a debug category */
+int LogPrintStr(const std::string& str, const char* category = NULL);
+/** Limit each debug category to nLines lines per second, 0 = unlimited */
+void SetLogRateLimit(int nLines);
+/** Hand debug.log writes to a logger thread that buffers up to nBufferLines lines */
+void StartDebugLog(size_t nBufferLines);
+/** Write out the buffered lines and go back to writing debug.log on the calling thread */
+void StopDebugLog();
+/** Write out the lines buffered so far, e.g. before the node aborts. Without fWait it gives up if the log stays busy. */
+void FlushDebugLog(bool fWait = true);
 
 #define LogPrintf(...) LogPrint(NULL, __VA_ARGS__)
 
@@ -84,7 +97,7 @@ int LogPrintStr(const std::string& str);
     static inline int LogPrint(const char* category, const char* format, TINYFORMAT_VARARGS(n)) \
     {                                                                                           \
         if (!LogAcceptCategory(category)) return 0;                                             \
-        return LogPrintStr(tfm::format(format, TINYFORMAT_PASSARGS(n)));                        \
+        return LogPrintStr(tfm::format(format, TINYFORMAT_PASSARGS(n)), category);              \
     }                                                                                           \
     /**   Log error and return false */                                                         \
     template <TINYFORMAT_ARGTYPES(n)>                                                           \
@@ -103,7 +116,7 @@ TINYFORMAT_FOREACH_ARGNUM(MAKE_ERROR_AND_LOG_FUNC)
 static inline int LogPrint(const char* category, const char* format)
 {
     if (!LogAcceptCategory(category)) return 0;
-    return LogPrintStr(format);
+    return LogPrintStr(format, category);
 }
 static inline bool error(const char* format)
 {
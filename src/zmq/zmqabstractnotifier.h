@@ -7,11 +7,36 @@
 
 #include "zmqconfig.h"
 
+#include <boost/shared_ptr.hpp>
+
 class CBlockIndex;
 class CZMQAbstractNotifier;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
+/** A block or transaction event, queued by validation for the publisher thread */
+struct CZMQNotification
+{
+    enum Type {
+        BLOCK,
+        TRANSACTION,
+        TRANSACTIONLOCK
+    };
+
+    Type type;
+    uint256 hash;
+    //! Block events only
+    const CBlockIndex* pindex;
+    //! The connected block, handed over by validation when raw blocks are published
+    boost::shared_ptr<const CBlock> pblock;
+    //! The transaction of a transaction event when raw transactions are published
+    boost::shared_ptr<const CTransaction> ptx;
+    //! Serialized block or transaction, filled by the first notifier that sends it
+    std::string strRaw;
+
+    CZMQNotification(Type type, const uint256& hash, const CBlockIndex* pindex) : type(type), hash(hash), pindex(pindex) {}
+};
+
 class CZMQAbstractNotifier
 {
 public:
@@ -32,9 +57,10 @@ public:
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
 
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
-    virtual bool NotifyTransaction(const CTransaction &transaction);
-    virtual bool NotifyTransactionLock(const CTransaction &transaction);
+    /** Called on the publisher thread; a notifier that returns false is shut down */
+    virtual bool NotifyBlock(CZMQNotification &notification);
+    virtual bool NotifyTransaction(CZMQNotification &notification);
+    virtual bool NotifyTransactionLock(CZMQNotification &notification);
 
 protected:
     void *psocket;
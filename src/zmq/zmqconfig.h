@@ -19,6 +19,9 @@
 #include "primitives/block.h"
 #include "primitives/transaction.h"
 
+/** Default size of the replay buffer of each publish notifier, in MiB */
+static const unsigned int DEFAULT_ZMQ_REPLAY_SIZE = 16;
+
 void zmqError(const char *str);
 
 #endif // BITCOIN_ZMQ_ZMQCONFIG_H
@@ -10,12 +10,50 @@
 #include "streams.h"
 #include "util.h"
 
+#include <boost/bind.hpp>
+
+CZMQNotificationInterface* pzmqNotificationInterface = NULL;
+
 void zmqError(const char *str)
 {
     LogPrint("zmq", "zmq: Error: %s, errno=%s\n", str, zmq_strerror(errno));
 }
 
-CZMQNotificationInterface::CZMQNotificationInterface() : pcontext(NULL)
+void CZMQNotificationQueue::Push(const CZMQNotification &notification)
+{
+    boost::unique_lock<boost::mutex> lock(cs_queue);
+    while (queue.size() >= nMaxSize && !fStopping)
+        condQueue.wait(lock);
+    if (fStopping)
+        return;
+    queue.push_back(notification);
+    condQueue.notify_all();
+}
+
+bool CZMQNotificationQueue::PopAll(std::deque<CZMQNotification> &batch)
+{
+    boost::unique_lock<boost::mutex> lock(cs_queue);
+    while (queue.empty() && !fStopping)
+        condQueue.wait(lock);
+    if (queue.empty())
+        return false;
+    batch.swap(queue);
+    condQueue.notify_all();
+    return true;
+}
+
+void CZMQNotificationQueue::Stop()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(cs_queue);
+        fStopping = true;
+    }
+    condQueue.notify_all();
+}
+
+CZMQNotificationInterface::CZMQNotificationInterface() : pcontext(NULL),
+                                                         fRawTransactions(false),
+                                                         fRawBlocks(false)
 {
 }
 
@@ -105,6 +143,16 @@ bool CZMQNotificationInterface::Initialize()
         return false;
     }
 
+    for (i=notifiers.begin(); i!=notifiers.end(); ++i)
+    {
+        if ((*i)->GetType() == "pubrawtx" || (*i)->GetType() == "pubrawtxlock")
+            fRawTransactions = true;
+        if ((*i)->GetType() == "pubrawblock")
+            fRawBlocks = true;
+    }
+
+    threadPublish = boost::thread(boost::bind(&TraceThread<boost::function<void()> >, "zmq", boost::function<void()>(boost::bind(&CZMQNotificationInterface::ThreadPublish, this))));
+
     return true;
 }
 
@@ -112,6 +160,12 @@ bool CZMQNotificationInterface::Initialize()
 void CZMQNotificationInterface::Shutdown()
 {
     LogPrint("zmq", "zmq: Shutdown notification interface\n");
+    if (threadPublish.joinable())
+    {
+        // Let the publisher thread send what is still queued, then stop it
+        queue.Stop();
+        threadPublish.join();
+    }
     if (pcontext)
     {
         for (std::list<CZMQAbstractNotifier*>::iterator i=notifiers.begin(); i!=notifiers.end(); ++i)
@@ -126,29 +180,86 @@ void CZMQNotificationInterface::Shutdown()
     }
 }
 
+void CZMQNotificationInterface::QueueNotification(const CZMQNotification &notification)
+{
+    queue.Push(notification);
+}
+
+void CZMQNotificationInterface::QueueTransaction(CZMQNotification::Type type, const CTransaction &tx)
+{
+    CZMQNotification notification(type, tx.GetHash(), NULL);
+    if (fRawTransactions)
+    {
+        // Serialized by the publisher thread, once for every notifier
+        notification.ptx.reset(new CTransaction(tx));
+    }
+    QueueNotification(notification);
+}
+
 void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindex)
 {
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+    CZMQNotification notification(CZMQNotification::BLOCK, pindex->GetBlockHash(), pindex);
     {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyBlock(pindex))
-        {
-            i++;
-        }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
-        }
+        LOCK(cs_blockConnected);
+        if (pblockConnected && pblockConnected->GetHash() == notification.hash)
+            notification.pblock = pblockConnected;
+        pblockConnected.reset();
     }
+    QueueNotification(notification);
 }
 
 void CZMQNotificationInterface::SyncTransaction(const CTransaction &tx, const CBlock *pblock)
 {
+    // A connected block reports its transactions in order, keep it once at the first one.
+    // Tips aren't announced during the initial download, so there is no copy to make then.
+    if (fRawBlocks && pblock && !pblock->vtx.empty() && &tx == &pblock->vtx[0] && !IsInitialBlockDownload())
+    {
+        LOCK(cs_blockConnected);
+        pblockConnected.reset(new CBlock(*pblock));
+    }
+    QueueTransaction(CZMQNotification::TRANSACTION, tx);
+}
+
+void CZMQNotificationInterface::NotifyTransactionLock(const CTransaction &tx)
+{
+    QueueTransaction(CZMQNotification::TRANSACTIONLOCK, tx);
+}
+
+void CZMQNotificationInterface::ThreadPublish()
+{
+    std::deque<CZMQNotification> batch;
+    while (queue.PopAll(batch))
+    {
+        Publish(batch);
+        batch.clear();
+    }
+}
+
+void CZMQNotificationInterface::Publish(std::deque<CZMQNotification> &batch)
+{
+    // Each notifier sends its messages of the whole batch back to back, the serialized
+    // blocks and transactions are kept in the batch for the next notifier
+    LOCK(cs_notifiers);
     for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
     {
         CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransaction(tx))
+        bool fSent = true;
+        for (std::deque<CZMQNotification>::iterator it = batch.begin(); fSent && it != batch.end(); ++it)
+        {
+            switch (it->type)
+            {
+            case CZMQNotification::BLOCK:
+                fSent = notifier->NotifyBlock(*it);
+                break;
+            case CZMQNotification::TRANSACTION:
+                fSent = notifier->NotifyTransaction(*it);
+                break;
+            case CZMQNotification::TRANSACTIONLOCK:
+                fSent = notifier->NotifyTransactionLock(*it);
+                break;
+            }
+        }
+        if (fSent)
         {
             i++;
         }
@@ -160,19 +271,17 @@ void CZMQNotificationInterface::SyncTransaction(const CTransaction &tx, const CB
     }
 }
 
-void CZMQNotificationInterface::NotifyTransactionLock(const CTransaction &tx)
+bool CZMQNotificationInterface::GetReplay(const std::string &type, uint32_t nStart, uint32_t nEnd, uint32_t &nFirst, std::vector<std::pair<uint32_t, std::string> > &vMessages) const
 {
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+    LOCK(cs_notifiers);
+    for (std::list<CZMQAbstractNotifier*>::const_iterator i = notifiers.begin(); i!=notifiers.end(); ++i)
     {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransactionLock(tx))
-        {
-            i++;
-        }
-        else
+        const CZMQAbstractPublishNotifier *notifier = dynamic_cast<const CZMQAbstractPublishNotifier*>(*i);
+        if (notifier && notifier->GetType() == type)
         {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
+            nFirst = notifier->GetReplay(nStart, nEnd, vMessages);
+            return true;
         }
     }
+    return false;
 }
@@ -5,13 +5,58 @@
 #ifndef BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
+#include "sync.h"
 #include "validationinterface.h"
-#include <string>
+#include "zmqabstractnotifier.h"
+
+#include <deque>
+#include <list>
 #include <map>
+#include <string>
+#include <vector>
+
+#include <boost/thread.hpp>
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
 
+/** Maximum number of events waiting for the publisher thread */
+static const size_t MAX_ZMQ_QUEUE_SIZE = 10000;
+
+/** Bounded queue of events between validation and the publisher thread */
+class CZMQNotificationQueue
+{
+private:
+    boost::mutex cs_queue;
+    boost::condition_variable condQueue;
+    std::deque<CZMQNotification> queue;
+    size_t nMaxSize;
+    bool fStopping;
+
+public:
+    explicit CZMQNotificationQueue(size_t nMaxSizeIn = MAX_ZMQ_QUEUE_SIZE) : nMaxSize(nMaxSizeIn), fStopping(false) {}
+
+    /** Add an event, waiting while the queue is full. Events are dropped once stopping. */
+    void Push(const CZMQNotification &notification);
+
+    /**
+     * Wait for events and move everything queued to batch, so bursts are sent back to back.
+     * Returns false once the queue is stopped and drained.
+     */
+    bool PopAll(std::deque<CZMQNotification> &batch);
+
+    /** Wake up all waiters; PopAll still returns what was queued before. */
+    void Stop();
+};
+
+/**
+ * Publishes validation events over ZMQ. Validation only queues the events,
+ * with a shared copy of the connected block or of the transaction when raw
+ * ones are published; a dedicated thread serializes them and sends the
+ * messages, so slow subscribers or large blocks never hold up block
+ * connection. Everything queued is sent as one batch, notifier by notifier.
+ * The queue is bounded: validation waits when it is full.
+ */
 class CZMQNotificationInterface : public CValidationInterface
 {
 public:
@@ -19,6 +64,13 @@ public:
 
     static CZMQNotificationInterface* CreateWithArguments(const std::map<std::string, std::string> &args);
 
+    /**
+     * Copy the messages retained by the notifier of the given type (e.g. "pubrawtx")
+     * with sequence numbers in [nStart, nEnd]. nFirst is set to the oldest sequence
+     * number still retained. Returns false if no such notifier is active.
+     */
+    bool GetReplay(const std::string &type, uint32_t nStart, uint32_t nEnd, uint32_t &nFirst, std::vector<std::pair<uint32_t, std::string> > &vMessages) const;
+
 protected:
     bool Initialize();
     void Shutdown();
@@ -31,8 +83,28 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    void QueueNotification(const CZMQNotification &notification);
+    void QueueTransaction(CZMQNotification::Type type, const CTransaction &tx);
+    void ThreadPublish();
+    void Publish(std::deque<CZMQNotification> &batch);
+
     void *pcontext;
+    mutable CCriticalSection cs_notifiers;
     std::list<CZMQAbstractNotifier*> notifiers;
+
+    //! Whether any notifier publishes raw transactions, so they are handed to the publisher thread
+    bool fRawTransactions;
+    //! Whether any notifier publishes raw blocks, so connected blocks are handed to the publisher thread
+    bool fRawBlocks;
+
+    //! The block validation connected last, for the tip notification that follows it
+    CCriticalSection cs_blockConnected;
+    boost::shared_ptr<const CBlock> pblockConnected;
+
+    CZMQNotificationQueue queue;
+    boost::thread threadPublish;
 };
 
+extern CZMQNotificationInterface* pzmqNotificationInterface;
+
 #endif // BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
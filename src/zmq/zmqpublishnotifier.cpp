@@ -57,6 +57,33 @@ static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
     return 0;
 }
 
+void CZMQReplayBuffer::Add(uint32_t nSequence, const void* data, size_t size)
+{
+    LOCK(cs_replay);
+    dqReplay.push_back(std::make_pair(nSequence, std::string((const char*)data, size)));
+    nReplayBytes += size;
+    while (nReplayBytes > nReplayMaxBytes) {
+        nReplayBytes -= dqReplay.front().second.size();
+        dqReplay.pop_front();
+    }
+    nNext = nSequence + 1;
+}
+
+uint32_t CZMQReplayBuffer::Get(uint32_t nStart, uint32_t nEnd, std::vector<std::pair<uint32_t, std::string> >& vMessages) const
+{
+    LOCK(cs_replay);
+    for (std::deque<std::pair<uint32_t, std::string> >::const_iterator it = dqReplay.begin(); it != dqReplay.end(); ++it) {
+        if (it->first >= nStart && it->first <= nEnd)
+            vMessages.push_back(*it);
+    }
+    return dqReplay.empty() ? nNext : dqReplay.front().first;
+}
+
+CZMQAbstractPublishNotifier::CZMQAbstractPublishNotifier() : nSequence(0),
+                                                             replay((size_t)std::max((int64_t)0, GetArg("-zmqreplaysize", DEFAULT_ZMQ_REPLAY_SIZE)) * 1024 * 1024)
+{
+}
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
 {
     assert(!psocket);
@@ -137,15 +164,63 @@ bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const void* d
     if (rc == -1)
         return false;
 
+    /* keep a copy for zmqreplay */
+    replay.Add(nSequence, data, size);
+
     /* increment memory only sequence number after sending */
     nSequence++;
 
     return true;
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+uint32_t CZMQAbstractPublishNotifier::GetReplay(uint32_t nStart, uint32_t nEnd, std::vector<std::pair<uint32_t, std::string> >& vMessages) const
+{
+    return replay.Get(nStart, nEnd, vMessages);
+}
+
+/**
+ * Serialize the block of a block notification the first time it is needed. Only
+ * a tip validation didn't just connect, e.g. after a block was disconnected, is
+ * read from disk.
+ */
+static bool LoadRawBlock(CZMQNotification &notification)
 {
-    uint256 hash = pindex->GetBlockHash();
+    if (!notification.strRaw.empty())
+        return true;
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    if (notification.pblock)
+    {
+        ss << *notification.pblock;
+    }
+    else
+    {
+        CBlock block;
+        if (!ReadBlockFromDiskUnlocked(block, notification.pindex))
+        {
+            zmqError("Can't read block from disk");
+            return false;
+        }
+        ss << block;
+    }
+    notification.strRaw = ss.str();
+    return true;
+}
+
+/** Serialize the transaction of a transaction notification the first time it is needed */
+static void LoadRawTransaction(CZMQNotification &notification)
+{
+    if (!notification.strRaw.empty() || !notification.ptx)
+        return;
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << *notification.ptx;
+    notification.strRaw = ss.str();
+}
+
+bool CZMQPublishHashBlockNotifier::NotifyBlock(CZMQNotification &notification)
+{
+    const uint256& hash = notification.hash;
     LogPrint("zmq", "zmq: Publish hashblock %s\n", hash.GetHex());
     char data[32];
     for (unsigned int i = 0; i < 32; i++)
@@ -153,9 +228,9 @@ bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
     return SendMessage(MSG_HASHBLOCK, data, 32);
 }
 
-bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
+bool CZMQPublishHashTransactionNotifier::NotifyTransaction(CZMQNotification &notification)
 {
-    uint256 hash = transaction.GetHash();
+    const uint256& hash = notification.hash;
     LogPrint("zmq", "zmq: Publish hashtx %s\n", hash.GetHex());
     char data[32];
     for (unsigned int i = 0; i < 32; i++)
@@ -163,9 +238,9 @@ bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &t
     return SendMessage(MSG_HASHTX, data, 32);
 }
 
-bool CZMQPublishHashTransactionLockNotifier::NotifyTransactionLock(const CTransaction &transaction)
+bool CZMQPublishHashTransactionLockNotifier::NotifyTransactionLock(CZMQNotification &notification)
 {
-    uint256 hash = transaction.GetHash();
+    const uint256& hash = notification.hash;
     LogPrint("zmq", "zmq: Publish hashtxlock %s\n", hash.GetHex());
     char data[32];
     for (unsigned int i = 0; i < 32; i++)
@@ -173,42 +248,26 @@ bool CZMQPublishHashTransactionLockNotifier::NotifyTransactionLock(const CTransa
     return SendMessage(MSG_HASHTXLOCK, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishRawBlockNotifier::NotifyBlock(CZMQNotification &notification)
 {
-    LogPrint("zmq", "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
+    LogPrint("zmq", "zmq: Publish rawblock %s\n", notification.hash.GetHex());
 
-// XX42    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        CBlock block;
-// XX42        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        if(!ReadBlockFromDisk(block, pindex))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
-    }
+    if (!LoadRawBlock(notification))
+        return false;
 
-    return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWBLOCK, notification.strRaw.data(), notification.strRaw.size());
 }
 
-bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
+bool CZMQPublishRawTransactionNotifier::NotifyTransaction(CZMQNotification &notification)
 {
-    uint256 hash = transaction.GetHash();
-    LogPrint("zmq", "zmq: Publish rawtx %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << transaction;
-    return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    LogPrint("zmq", "zmq: Publish rawtx %s\n", notification.hash.GetHex());
+    LoadRawTransaction(notification);
+    return SendMessage(MSG_RAWTX, notification.strRaw.data(), notification.strRaw.size());
 }
 
-bool CZMQPublishRawTransactionLockNotifier::NotifyTransactionLock(const CTransaction &transaction)
+bool CZMQPublishRawTransactionLockNotifier::NotifyTransactionLock(CZMQNotification &notification)
 {
-    uint256 hash = transaction.GetHash();
-    LogPrint("zmq", "zmq: Publish rawtxlock %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << transaction;
-    return SendMessage(MSG_RAWTXLOCK, &(*ss.begin()), ss.size());
+    LogPrint("zmq", "zmq: Publish rawtxlock %s\n", notification.hash.GetHex());
+    LoadRawTransaction(notification);
+    return SendMessage(MSG_RAWTXLOCK, notification.strRaw.data(), notification.strRaw.size());
 }
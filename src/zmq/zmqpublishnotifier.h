@@ -6,15 +6,46 @@
 #define BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
 
 #include "zmqabstractnotifier.h"
+#include "sync.h"
+
+#include <deque>
+#include <vector>
 
 class CBlockIndex;
 
+/** Recently sent messages (sequence number, data part) that zmqreplay can resend */
+class CZMQReplayBuffer
+{
+private:
+    mutable CCriticalSection cs_replay;
+    std::deque<std::pair<uint32_t, std::string> > dqReplay;
+    size_t nReplayBytes;
+    size_t nReplayMaxBytes;
+    //! Sequence number of the next message
+    uint32_t nNext;
+
+public:
+    explicit CZMQReplayBuffer(size_t nMaxBytes) : nReplayBytes(0), nReplayMaxBytes(nMaxBytes), nNext(0) {}
+
+    /** Keep a sent message, dropping the oldest ones beyond the size limit */
+    void Add(uint32_t nSequence, const void* data, size_t size);
+
+    /**
+     * Copy the retained messages with sequence numbers in [nStart, nEnd] to vMessages.
+     * Returns the oldest sequence number still retained, or the next one to be sent
+     * when nothing is.
+     */
+    uint32_t Get(uint32_t nStart, uint32_t nEnd, std::vector<std::pair<uint32_t, std::string> >& vMessages) const;
+};
+
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 {
 private:
     uint32_t nSequence; // upcounting per message sequence number
+    CZMQReplayBuffer replay;
 
 public:
+    CZMQAbstractPublishNotifier();
 
     /* send zmq multipart message
        parts:
@@ -26,42 +57,49 @@ public:
 
     bool Initialize(void *pcontext);
     void Shutdown();
+
+    /**
+     * Copy the retained messages with sequence numbers in [nStart, nEnd] to vMessages.
+     * Returns the oldest sequence number still retained, or the next one to be sent
+     * when nothing is.
+     */
+    uint32_t GetReplay(uint32_t nStart, uint32_t nEnd, std::vector<std::pair<uint32_t, std::string> >& vMessages) const;
 };
 
 class CZMQPublishHashBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex);
+    bool NotifyBlock(CZMQNotification &notification);
 };
 
 class CZMQPublishHashTransactionNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyTransaction(const CTransaction &transaction);
+    bool NotifyTransaction(CZMQNotification &notification);
 };
 
 class CZMQPublishHashTransactionLockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyTransactionLock(const CTransaction &transaction);
+    bool NotifyTransactionLock(CZMQNotification &notification);
 };
 
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex);
+    bool NotifyBlock(CZMQNotification &notification);
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyTransaction(const CTransaction &transaction);
+    bool NotifyTransaction(CZMQNotification &notification);
 };
 
 class CZMQPublishRawTransactionLockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyTransactionLock(const CTransaction &transaction);
+    bool NotifyTransactionLock(CZMQNotification &notification);
 };
 
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
@@ -0,0 +1,62 @@
+// Copyright (c) 2018 The VITAE developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpcserver.h"
+#include "utilstrencodings.h"
+#include "zmq/zmqnotificationinterface.h"
+
+#include <univalue.h>
+
+UniValue zmqreplay(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() < 2 || params.size() > 3)
+        throw std::runtime_error(
+            "zmqreplay \"type\" start ( end )\n"
+            "\nReturns ZMQ messages that were already published, so subscribers can recover from gaps in the sequence numbers.\n"
+            "Only the most recent messages of each notifier are kept (see -zmqreplaysize).\n"
+
+            "\nArguments:\n"
+            "1. \"type\"      (string, required) The notifier, e.g. \"pubrawtx\" or \"pubhashblock\"\n"
+            "2. start       (numeric, required) The first sequence number to return\n"
+            "3. end         (numeric, optional, default=start) The last sequence number to return\n"
+
+            "\nResult:\n"
+            "{\n"
+            "  \"first\": n,          (numeric) The oldest sequence number that is still kept\n"
+            "  \"messages\": [\n"
+            "    {\n"
+            "      \"sequence\": n,   (numeric) The sequence number of the message\n"
+            "      \"data\": \"hex\"    (string) The data part of the message\n"
+            "    }\n"
+            "    ,...\n"
+            "  ]\n"
+            "}\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("zmqreplay", "\"pubrawtx\" 1000 1010") + HelpExampleRpc("zmqreplay", "\"pubrawtx\", 1000, 1010"));
+
+    std::string type = params[0].get_str();
+    int64_t nStart = params[1].get_int64();
+    int64_t nEnd = params.size() > 2 ? params[2].get_int64() : nStart;
+    if (nStart < 0 || nEnd < nStart || nEnd > std::numeric_limits<uint32_t>::max())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid sequence range");
+
+    uint32_t nFirst = 0;
+    std::vector<std::pair<uint32_t, std::string> > vMessages;
+    if (!pzmqNotificationInterface || !pzmqNotificationInterface->GetReplay(type, nStart, nEnd, nFirst, vMessages))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "No active notifier of type " + type);
+
+    UniValue messages(UniValue::VARR);
+    for (std::vector<std::pair<uint32_t, std::string> >::const_iterator it = vMessages.begin(); it != vMessages.end(); ++it) {
+        UniValue message(UniValue::VOBJ);
+        message.push_back(Pair("sequence", (int64_t)it->first));
+        message.push_back(Pair("data", HexStr(it->second.begin(), it->second.end())));
+        messages.push_back(message);
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("first", (int64_t)nFirst));
+    result.push_back(Pair("messages", messages));
+    return result;
+}
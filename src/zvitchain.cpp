@@ -145,7 +145,8 @@ void FindMints(std::vector<CMintMeta> vMintsToFind, std::vector<CMintMeta>& vMin
             continue;
         }
 
-        if (!mapBlockIndex.count(hashBlock)) {
+        CBlockIndex* pindex = LookupBlockIndex(hashBlock);
+        if (!pindex) {
             LogPrintf("%s : cannot find block %s\n", __func__, hashBlock.GetHex());
             vMissingMints.push_back(meta);
             continue;
@@ -191,12 +192,12 @@ void FindMints(std::vector<CMintMeta> vMintsToFind, std::vector<CMintMeta>& vMin
         }
 
         // if meta data is correct, then no need to update
-        if (meta.txid == txHash && meta.nHeight == mapBlockIndex[hashBlock]->nHeight && meta.isUsed == fSpent)
+        if (meta.txid == txHash && meta.nHeight == pindex->nHeight && meta.isUsed == fSpent)
             continue;
 
         //mark this mint for update
         meta.txid = txHash;
-        meta.nHeight = mapBlockIndex[hashBlock]->nHeight;
+        meta.nHeight = pindex->nHeight;
         meta.isUsed = fSpent;
         LogPrintf("%s: found updates for pubcoinhash = %s\n", __func__, meta.hashPubcoin.GetHex());
 
@@ -311,7 +312,7 @@ std::string ReindexZerocoinDB()
 
         // Flush the zerocoinDB to disk every 100 blocks
         if (pindex->nHeight % 100 == 0) {
-            if ((!vSpendInfo.empty() && !zerocoinDB->WriteCoinSpendBatch(vSpendInfo)) || (!vMintInfo.empty() && !zerocoinDB->WriteCoinMintBatch(vMintInfo)))
+            if ((!vSpendInfo.empty() && !zerocoinDB->WriteCoinSpendBatch(vSpendInfo)) || (!vMintInfo.empty() && !zerocoinDB->WriteCoinMintBatch(vMintInfo)) || !zerocoinDB->FlushCache())
                 return _("Error writing zerocoinDB to disk");
             vSpendInfo.clear();
             vMintInfo.clear();
@@ -322,7 +323,7 @@ std::string ReindexZerocoinDB()
     uiInterface.ShowProgress("", 100);
 
     // Final flush to disk in case any remaining information exists
-    if ((!vSpendInfo.empty() && !zerocoinDB->WriteCoinSpendBatch(vSpendInfo)) || (!vMintInfo.empty() && !zerocoinDB->WriteCoinMintBatch(vMintInfo)))
+    if ((!vSpendInfo.empty() && !zerocoinDB->WriteCoinSpendBatch(vSpendInfo)) || (!vMintInfo.empty() && !zerocoinDB->WriteCoinMintBatch(vMintInfo)) || !zerocoinDB->FlushCache())
         return _("Error writing zerocoinDB to disk");
 
     uiInterface.ShowProgress("", 100);